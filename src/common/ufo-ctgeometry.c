@@ -117,3 +117,165 @@ ufo_ctgeometry_free (UfoCTGeometry *geometry)
     ufo_scvector_free (geometry->detector);
     g_free (geometry);
 }
+
+/**
+ * rotate_rows:
+ * @rows: (inout): 3x4 affine map
+ * @axis: 0, 1 or 2 for rotation about x, y or z
+ * @angle: rotation angle
+ *
+ * Compose @rows with a rotation the same way as rotate_x, rotate_y and rotate_z
+ * in the general-backproject kernel definitions do.
+ */
+static void
+rotate_rows (gdouble rows[3][4], guint axis, gdouble angle)
+{
+    /* Rotated coordinate pairs for rotations about x, y and z */
+    const guint first[] = {1, 2, 0};
+    const guint second[] = {2, 0, 1};
+    gdouble a, b, sine, cosine;
+    guint i;
+
+    sine = sin (angle);
+    cosine = cos (angle);
+
+    for (i = 0; i < 4; i++) {
+        a = rows[first[axis]][i];
+        b = rows[second[axis]][i];
+        rows[first[axis]][i] = cosine * a - sine * b;
+        rows[second[axis]][i] = sine * a + cosine * b;
+    }
+}
+
+static void
+combine_rows (gdouble *result, gdouble a, const gdouble *x, gdouble b, const gdouble *y)
+{
+    guint i;
+
+    for (i = 0; i < 4; i++) {
+        result[i] = a * x[i] + b * y[i];
+    }
+}
+
+/**
+ * ufo_ctgeometry_compute_projection_matrix:
+ * @geometry: a #UfoCTGeometry
+ * @index: projection index
+ * @parallel_beam: %TRUE if the source is infinitely far away
+ * @perpendicular_detector: %TRUE if the detector is not rotated
+ * @with_axis: %TRUE if the axis is tilted about x or y
+ * @with_volume: %TRUE if the volume is rotated
+ * @matrix: (out): four rows of four elements
+ *
+ * Compute the matrix which maps a homogeneous voxel to the homogeneous
+ * detector coordinates (rows 0-2) and to the reciprocal FDK weight (row 3). It
+ * reproduces the transformations of the general-backproject kernels, the flags
+ * only skip transformations which are the identity.
+ */
+void
+ufo_ctgeometry_compute_projection_matrix (UfoCTGeometry *geometry,
+                                          guint index,
+                                          gboolean parallel_beam,
+                                          gboolean perpendicular_detector,
+                                          gboolean with_axis,
+                                          gboolean with_volume,
+                                          gfloat *matrix)
+{
+    gdouble rows[3][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};
+    gdouble normal[3][4] = {{0, 0, 0, 0}, {0, 0, 0, -1}, {0, 0, 0, 0}};
+    const gdouble unit[4] = {0, 0, 0, 1};
+    gdouble result[4][4];
+    gdouble source[3], detector[3], center[2], tmp, offset;
+    guint i, j;
+
+    source[0] = ufo_scarray_get_double (geometry->source_position->x, index);
+    source[1] = ufo_scarray_get_double (geometry->source_position->y, index);
+    source[2] = ufo_scarray_get_double (geometry->source_position->z, index);
+    detector[0] = ufo_scarray_get_double (geometry->detector->position->x, index);
+    detector[1] = ufo_scarray_get_double (geometry->detector->position->y, index);
+    detector[2] = ufo_scarray_get_double (geometry->detector->position->z, index);
+    center[0] = ufo_scarray_get_double (geometry->axis->position->x, index);
+    center[1] = ufo_scarray_get_double (geometry->axis->position->z, index);
+
+    /* Voxel to the rotated global coordinates */
+    if (!parallel_beam) {
+        tmp = -source[1] / (detector[1] - source[1]);
+        for (i = 0; i < 3; i++) {
+            rows[i][i] = tmp;
+        }
+    }
+    if (with_volume) {
+        rotate_rows (rows, 2, ufo_scarray_get_double (geometry->volume_angle->z, index));
+        rotate_rows (rows, 1, ufo_scarray_get_double (geometry->volume_angle->y, index));
+        rotate_rows (rows, 0, ufo_scarray_get_double (geometry->volume_angle->x, index));
+    }
+    rotate_rows (rows, 2, ufo_scarray_get_double (geometry->axis->angle->z, index));
+    if (with_axis) {
+        rotate_rows (rows, 1, ufo_scarray_get_double (geometry->axis->angle->y, index));
+        rotate_rows (rows, 0, ufo_scarray_get_double (geometry->axis->angle->x, index));
+    }
+
+    /* Detector normal in the translation column, only the rotation matters */
+    if (!perpendicular_detector) {
+        rotate_rows (normal, 2, ufo_scarray_get_double (geometry->detector->angle->z, index));
+        rotate_rows (normal, 1, ufo_scarray_get_double (geometry->detector->angle->y, index));
+        rotate_rows (normal, 0, ufo_scarray_get_double (geometry->detector->angle->x, index));
+    }
+
+    if (parallel_beam) {
+        if (!perpendicular_detector) {
+            offset = -(detector[0] * normal[0][3] + detector[1] * normal[1][3] + detector[2] * normal[2][3]);
+            combine_rows (rows[1], -normal[0][3] / normal[1][3], rows[0], -normal[2][3] / normal[1][3], rows[2]);
+            rows[1][3] -= offset / normal[1][3];
+            for (i = 0; i < 3; i++) {
+                rows[i][3] -= detector[i];
+            }
+            rotate_rows (rows, 0, -ufo_scarray_get_double (geometry->detector->angle->x, index));
+            rotate_rows (rows, 1, -ufo_scarray_get_double (geometry->detector->angle->y, index));
+            rotate_rows (rows, 2, -ufo_scarray_get_double (geometry->detector->angle->z, index));
+        }
+        combine_rows (result[0], 1, rows[0], center[0], unit);
+        combine_rows (result[1], 1, rows[2], center[1], unit);
+        combine_rows (result[2], 0, rows[0], 1, unit);
+        combine_rows (result[3], 0, rows[0], 1, unit);
+    } else {
+        /* Reciprocal of coeff = (S.y - D.y) / (S.y - V.y) */
+        combine_rows (result[3], 1 / (detector[1] - source[1]), rows[1], -source[1] / (detector[1] - source[1]), unit);
+        if (perpendicular_detector) {
+            combine_rows (result[2], 1, result[3], 0, unit);
+            /* V = S + V * (D.y - S.y) / (V.y - S.y) */
+            combine_rows (result[0], source[0] + center[0], result[2], 1, rows[0]);
+            combine_rows (result[1], source[2] + center[1], result[2], 1, rows[2]);
+        } else {
+            /* w = dot (V - S, n) / dot (D - S, n) */
+            tmp = 0;
+            offset = 0;
+            for (i = 0; i < 4; i++) {
+                result[2][i] = 0;
+            }
+            for (i = 0; i < 3; i++) {
+                tmp += (detector[i] - source[i]) * normal[i][3];
+                offset += source[i] * normal[i][3];
+                combine_rows (result[2], 1, result[2], normal[i][3], rows[i]);
+            }
+            result[2][3] -= offset;
+            combine_rows (result[2], 1 / tmp, result[2], 0, unit);
+            /* w * (P - D) = w * (S - D) + V - S, rotated to the detector plane */
+            for (i = 0; i < 3; i++) {
+                combine_rows (rows[i], source[i] - detector[i], result[2], 1, rows[i]);
+                rows[i][3] -= source[i];
+            }
+            rotate_rows (rows, 0, -ufo_scarray_get_double (geometry->detector->angle->x, index));
+            rotate_rows (rows, 1, -ufo_scarray_get_double (geometry->detector->angle->y, index));
+            rotate_rows (rows, 2, -ufo_scarray_get_double (geometry->detector->angle->z, index));
+            combine_rows (result[0], 1, rows[0], center[0], result[2]);
+            combine_rows (result[1], 1, rows[2], center[1], result[2]);
+        }
+    }
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 4; j++) {
+            matrix[4 * i + j] = (gfloat) result[i][j];
+        }
+    }
+}
@@ -53,5 +53,12 @@ UfoScvector       *ufo_scvector_new                              (UfoScpoint *po
 void               ufo_scvector_free                             (UfoScvector *vector);
 UfoCTGeometry     *ufo_ctgeometry_new                            (void);
 void               ufo_ctgeometry_free                           (UfoCTGeometry *geometry);
+void               ufo_ctgeometry_compute_projection_matrix      (UfoCTGeometry *geometry,
+                                                                  guint index,
+                                                                  gboolean parallel_beam,
+                                                                  gboolean perpendicular_detector,
+                                                                  gboolean with_axis,
+                                                                  gboolean with_volume,
+                                                                  gfloat *matrix);
 
 #endif
@@ -27,24 +27,294 @@
 #include "oclFFT.h"
 #endif
 
+#ifdef HAVE_FFTW
+#include <fftw3.h>
+#endif
+
 #include "ufo-fft.h"
 
-struct _UfoFft {
-    UfoFftParameter seen;
+/*
+ * Plans are shared by all UfoFft objects with the same parameters and command
+ * queue, because baking is expensive. A plan is baked for the device of a
+ * queue and its temporary buffers are used by transforms in that queue, hence
+ * the queue is part of the key. Plans which are no longer used are kept
+ * around in case a pipeline cycles through sizes, up to MAX_UNUSED_PLANS of
+ * them, and all plans are destroyed with the last UfoFft.
+ *
+ * Every task runs in its own thread. clFFT locks a plan while it is enqueued,
+ * but oclFFT sets the arguments of the plan kernels and replaces its temporary
+ * buffer on every execution, so executions of a shared oclFFT plan are
+ * serialized until they are enqueued.
+ */
+#define MAX_UNUSED_PLANS 8
+
+/*
+ * With FFTW, transforms for queues of CPU devices run on the host in mapped
+ * buffers, which is much faster than the generic OpenCL FFT kernels on CPU
+ * runtimes. Host plans are created on first use for each direction and
+ * placement, FFTW wisdom is loaded with the first and stored with the last
+ * UfoFft.
+ */
+
+typedef struct {
+    cl_context context;
+    cl_command_queue queue;
+    UfoFftParameter param;
+    guint refcount;
 
 #ifdef HAVE_AMD
     clfftPlanHandle amd_plan;
-    clfftSetupData amd_setup;
 #else
     clFFT_Plan apple_plan;
+    GMutex execute_mutex;           /* oclFFT sets kernel args on the plan */
 #endif
-};
+
+#ifdef HAVE_FFTW
+    gboolean host;
+    fftwf_plan host_plans[2][2];    /* indexed by direction and in-place */
+#endif
+} UfoFftPlan;
+
+struct _UfoFft {
+    UfoFftParameter seen;
+    UfoFftPlan *plan;
 
 #ifdef HAVE_AMD
-static GMutex amd_mutex;
+    clfftSetupData amd_setup;
+#endif
+};
+
+static GMutex plan_mutex;
 static GList *ffts_created = NULL;
+static GList *plans = NULL;
+
+#ifdef HAVE_FFTW
+/*
+ * The FFTW planner is not thread-safe, so creating and destroying host plans
+ * and wisdom I/O are serialized by their own lock. Measuring a plan can take
+ * seconds and must not hold plan_mutex, which every transform size change of
+ * every task needs. If both are taken, plan_mutex is taken first.
+ */
+static GMutex host_planner_mutex;
+#endif
+
+
+#ifdef HAVE_FFTW
+static gchar *
+get_wisdom_filename (void)
+{
+    return g_build_filename (g_get_user_cache_dir (), "ufo", "fftw3f-wisdom", NULL);
+}
+
+static void
+setup_host_backend (void)
+{
+    gchar *filename;
+
+    g_mutex_lock (&host_planner_mutex);
+    fftwf_init_threads ();
+    fftwf_plan_with_nthreads (g_get_num_processors ());
+
+    filename = get_wisdom_filename ();
+
+    if (!fftwf_import_wisdom_from_filename (filename))
+        g_debug ("INFO No FFTW wisdom in %s", filename);
+
+    g_mutex_unlock (&host_planner_mutex);
+    g_free (filename);
+}
+
+static void
+teardown_host_backend (void)
+{
+    gchar *filename;
+    gchar *dirname;
+
+    filename = get_wisdom_filename ();
+    dirname = g_path_get_dirname (filename);
+
+    g_mutex_lock (&host_planner_mutex);
+
+    if (g_mkdir_with_parents (dirname, 0755) != 0 || !fftwf_export_wisdom_to_filename (filename))
+        g_debug ("INFO Could not store FFTW wisdom in %s", filename);
+
+    fftwf_cleanup_threads ();
+    g_mutex_unlock (&host_planner_mutex);
+    g_free (dirname);
+    g_free (filename);
+}
+
+static gboolean
+is_cpu_queue (cl_command_queue queue)
+{
+    cl_device_id device;
+    cl_device_type type;
+
+    UFO_RESOURCES_CHECK_CLERR (clGetCommandQueueInfo (queue, CL_QUEUE_DEVICE, sizeof (cl_device_id), &device, NULL));
+    UFO_RESOURCES_CHECK_CLERR (clGetDeviceInfo (device, CL_DEVICE_TYPE, sizeof (cl_device_type), &type, NULL));
+
+    return (type & CL_DEVICE_TYPE_CPU) != 0;
+}
+
+/*
+ * FFTW expects the slowest varying dimension first. Returns the number of
+ * elements of one real and one complex batch item.
+ */
+static void
+get_host_layout (UfoFftParameter *param, int *n, int *real_distance, int *complex_distance)
+{
+    const guint rank = param->dimensions;
+
+    *real_distance = 1;
+
+    for (guint i = 0; i < rank; i++) {
+        n[i] = (int) param->size[rank - 1 - i];
+        *real_distance *= n[i];
+    }
+
+    if (param->type == UFO_FFT_COMPLEX_TO_COMPLEX)
+        *complex_distance = *real_distance;
+    else
+        *complex_distance = *real_distance / param->size[0] * (param->size[0] / 2 + 1);
+}
+
+static fftwf_plan
+create_host_plan (UfoFftPlan *plan, UfoFftDirection direction, gboolean in_place)
+{
+    UfoFftParameter *param = &plan->param;
+    const unsigned flags = FFTW_MEASURE | FFTW_UNALIGNED;
+    const int batch = (int) param->batch;
+    fftwf_complex *in;
+    fftwf_complex *out;
+    fftwf_plan host_plan = NULL;
+    int n[3];
+    int real_distance;
+    int complex_distance;
+
+    if (in_place && param->type != UFO_FFT_COMPLEX_TO_COMPLEX) {
+        g_warning ("Real-to-complex transforms must be out-of-place");
+        return NULL;
+    }
+
+    get_host_layout (param, n, &real_distance, &complex_distance);
+
+    /* Measuring overwrites the arrays, so plan on scratch memory */
+    in = fftwf_malloc (sizeof (fftwf_complex) * complex_distance * batch);
+    out = in_place ? in : fftwf_malloc (sizeof (fftwf_complex) * complex_distance * batch);
+
+    switch (param->type) {
+        case UFO_FFT_COMPLEX_TO_COMPLEX:
+            host_plan = fftwf_plan_many_dft (param->dimensions, n, batch,
+                                             in, NULL, 1, complex_distance,
+                                             out, NULL, 1, complex_distance,
+                                             direction == UFO_FFT_FORWARD ? FFTW_FORWARD : FFTW_BACKWARD,
+                                             flags);
+            break;
+        case UFO_FFT_REAL_TO_COMPLEX:
+            host_plan = fftwf_plan_many_dft_r2c (param->dimensions, n, batch,
+                                                 (float *) in, NULL, 1, real_distance,
+                                                 out, NULL, 1, complex_distance,
+                                                 flags);
+            break;
+        case UFO_FFT_COMPLEX_TO_REAL:
+            host_plan = fftwf_plan_many_dft_c2r (param->dimensions, n, batch,
+                                                 in, NULL, 1, complex_distance,
+                                                 (float *) out, NULL, 1, real_distance,
+                                                 flags);
+            break;
+    }
+
+    if (!in_place)
+        fftwf_free (out);
+
+    fftwf_free (in);
+
+    return host_plan;
+}
+
+static cl_int
+execute_host (UfoFft *fft, cl_command_queue queue, cl_mem in_mem, cl_mem out_mem,
+              UfoFftDirection direction, cl_uint num_events, cl_event *event_list, cl_event *event)
+{
+    UfoFftPlan *plan = fft->plan;
+    UfoFftParameter *param = &plan->param;
+    const gboolean in_place = in_mem == out_mem;
+    fftwf_plan host_plan;
+    gpointer in;
+    gpointer out;
+    gsize in_size;
+    gsize out_size;
+    cl_int error;
+
+    g_mutex_lock (&host_planner_mutex);
+
+    if (plan->host_plans[direction][in_place] == NULL)
+        plan->host_plans[direction][in_place] = create_host_plan (plan, direction, in_place);
+
+    host_plan = plan->host_plans[direction][in_place];
+    g_mutex_unlock (&host_planner_mutex);
+
+    if (host_plan == NULL)
+        return CL_INVALID_OPERATION;
+
+    UFO_RESOURCES_CHECK_CLERR (clGetMemObjectInfo (in_mem, CL_MEM_SIZE, sizeof (gsize), &in_size, NULL));
+    UFO_RESOURCES_CHECK_CLERR (clGetMemObjectInfo (out_mem, CL_MEM_SIZE, sizeof (gsize), &out_size, NULL));
+
+    in = clEnqueueMapBuffer (queue, in_mem, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, in_size,
+                             num_events, event_list, NULL, &error);
+
+    if (error != CL_SUCCESS)
+        return error;
+
+    out = in;
+
+    if (!in_place) {
+        out = clEnqueueMapBuffer (queue, out_mem, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, out_size,
+                                  0, NULL, NULL, &error);
+
+        if (error != CL_SUCCESS) {
+            UFO_RESOURCES_CHECK_CLERR (clEnqueueUnmapMemObject (queue, in_mem, in, 0, NULL, NULL));
+            return error;
+        }
+    }
+
+    switch (param->type) {
+        case UFO_FFT_COMPLEX_TO_COMPLEX:
+            fftwf_execute_dft (host_plan, in, out);
+            break;
+        case UFO_FFT_REAL_TO_COMPLEX:
+            fftwf_execute_dft_r2c (host_plan, in, out);
+            break;
+        case UFO_FFT_COMPLEX_TO_REAL:
+            fftwf_execute_dft_c2r (host_plan, in, out);
+            break;
+    }
+
+#ifdef HAVE_AMD
+    if (direction == UFO_FFT_BACKWARD) {
+        /* Scale by 1 / N like clFFT does for the same pipeline on a GPU */
+        int n[3];
+        int real_distance;
+        int complex_distance;
+        gsize num_values;
+        gfloat scale;
+        gfloat *data = out;
+
+        get_host_layout (param, n, &real_distance, &complex_distance);
+        num_values = param->batch * (param->type == UFO_FFT_COMPLEX_TO_REAL ? real_distance : 2 * complex_distance);
+        scale = 1.0f / real_distance;
+
+        for (gsize i = 0; i < num_values; i++)
+            data[i] *= scale;
+    }
 #endif
 
+    if (!in_place)
+        UFO_RESOURCES_CHECK_CLERR (clEnqueueUnmapMemObject (queue, out_mem, out, 0, NULL, NULL));
+
+    return clEnqueueUnmapMemObject (queue, in_mem, in, 0, NULL, event);
+}
+#endif
 
 UfoFft *
 ufo_fft_new (void)
@@ -55,66 +325,274 @@ ufo_fft_new (void)
 
 #ifdef HAVE_AMD
     UFO_RESOURCES_CHECK_CLERR (clfftSetup (&fft->amd_setup));
-
-    g_mutex_lock (&amd_mutex);
-    ffts_created = g_list_append (ffts_created, fft);
-    g_mutex_unlock (&amd_mutex);
     g_debug ("INFO Create new plan using AMD FFT");
 #else
     g_debug ("INFO Create new plan using Apple FFT");
 #endif
 
+    g_mutex_lock (&plan_mutex);
+
+#ifdef HAVE_FFTW
+    if (ffts_created == NULL)
+        setup_host_backend ();
+#endif
+
+    ffts_created = g_list_append (ffts_created, fft);
+    g_mutex_unlock (&plan_mutex);
+
     return fft;
 }
 
-cl_int
-ufo_fft_update (UfoFft *fft, cl_context context, cl_command_queue queue, UfoFftParameter *param)
+/*
+ * Check if @size factors into radices the backend has kernels for: clFFT
+ * implements radix 2, 3, 5 and 7, oclFFT only radix 2.
+ */
+static gboolean
+is_transform_size (gsize size, gboolean smooth)
 {
-    gboolean changed;
-    cl_int error;
+    static const gsize radices[] = { 2, 3, 5, 7 };
 
-    error = CL_SUCCESS;
-    changed = param->size[0] != fft->seen.size[0] || param->size[1] != fft->seen.size[1];
+    if (size == 0)
+        return FALSE;
 
-    if (changed)
-        memcpy (&fft->seen, param, sizeof (UfoFftParameter));
+    for (guint i = 0; i < (smooth ? G_N_ELEMENTS (radices) : 1); i++) {
+        while (size % radices[i] == 0)
+            size /= radices[i];
+    }
+
+    return size == 1;
+}
+
+static gboolean
+plan_matches (UfoFftPlan *plan, cl_context context, cl_command_queue queue, UfoFftParameter *param)
+{
+    return plan->context == context && plan->queue == queue &&
+           plan->param.dimensions == param->dimensions &&
+           plan->param.size[0] == param->size[0] &&
+           plan->param.size[1] == param->size[1] &&
+           plan->param.size[2] == param->size[2] &&
+           plan->param.batch == param->batch &&
+           plan->param.type == param->type &&
+           plan->param.zeropad == param->zeropad;
+}
+
+static cl_int
+bake_plan (UfoFftPlan *plan)
+{
+    UfoFftParameter *param = &plan->param;
+    cl_int error = CL_SUCCESS;
+
+#ifdef HAVE_FFTW
+    /* Host plans are created on first use */
+    if (plan->host)
+        return CL_SUCCESS;
+#endif
 
 #ifdef HAVE_AMD
-    if (fft->amd_plan == 0 || changed) {
-        /* we use param->dimension to index into this array! */
-        clfftDim dimension[4] = { 0, CLFFT_1D, CLFFT_2D, CLFFT_3D };
+    /* we use param->dimension to index into this array! */
+    clfftDim dimension[4] = { 0, CLFFT_1D, CLFFT_2D, CLFFT_3D };
+
+    UFO_RESOURCES_CHECK_CLERR (clfftCreateDefaultPlan (&plan->amd_plan, plan->context, dimension[param->dimensions], param->size));
+    UFO_RESOURCES_CHECK_CLERR (clfftSetPlanBatchSize (plan->amd_plan, param->batch));
+    UFO_RESOURCES_CHECK_CLERR (clfftSetPlanPrecision (plan->amd_plan, CLFFT_SINGLE));
+
+    if (param->type == UFO_FFT_COMPLEX_TO_COMPLEX) {
+        UFO_RESOURCES_CHECK_CLERR (clfftSetLayout (plan->amd_plan, CLFFT_COMPLEX_INTERLEAVED, CLFFT_COMPLEX_INTERLEAVED));
+        UFO_RESOURCES_CHECK_CLERR (clfftSetResultLocation (plan->amd_plan, param->zeropad ? CLFFT_INPLACE : CLFFT_OUTOFPLACE));
+    }
+    else {
+        size_t real_strides[3];
+        size_t hermitian_strides[3];
+        size_t real_distance;
+        size_t hermitian_distance;
+
+        /* Real rows are size[0] long, Hermitian ones size[0] / 2 + 1 */
+        real_strides[0] = hermitian_strides[0] = 1;
 
-        if (fft->amd_plan != 0) {
-            clfftDestroyPlan (&fft->amd_plan);
-            fft->amd_plan = 0;
+        for (guint i = 1; i < 3; i++) {
+            real_strides[i] = real_strides[i - 1] * param->size[i - 1];
+            hermitian_strides[i] = hermitian_strides[i - 1] * (i == 1 ? param->size[0] / 2 + 1 : param->size[i - 1]);
         }
 
-        UFO_RESOURCES_CHECK_CLERR (clfftCreateDefaultPlan (&fft->amd_plan, context, dimension[param->dimensions], param->size));
-        UFO_RESOURCES_CHECK_CLERR (clfftSetPlanBatchSize (fft->amd_plan, param->batch));
-        UFO_RESOURCES_CHECK_CLERR (clfftSetPlanPrecision (fft->amd_plan, CLFFT_SINGLE));
-        UFO_RESOURCES_CHECK_CLERR (clfftSetLayout (fft->amd_plan, CLFFT_COMPLEX_INTERLEAVED, CLFFT_COMPLEX_INTERLEAVED));
-        UFO_RESOURCES_CHECK_CLERR (clfftSetResultLocation (fft->amd_plan, param->zeropad ? CLFFT_INPLACE : CLFFT_OUTOFPLACE));
-        UFO_RESOURCES_CHECK_CLERR (clfftBakePlan (fft->amd_plan, 1, &queue, NULL, NULL));
+        real_distance = param->dimensions == UFO_FFT_3D ? real_strides[2] * param->size[2] : real_strides[param->dimensions];
+        hermitian_distance = param->dimensions == UFO_FFT_3D ? hermitian_strides[2] * param->size[2] : hermitian_strides[param->dimensions];
+
+        if (param->type == UFO_FFT_REAL_TO_COMPLEX) {
+            UFO_RESOURCES_CHECK_CLERR (clfftSetLayout (plan->amd_plan, CLFFT_REAL, CLFFT_HERMITIAN_INTERLEAVED));
+            UFO_RESOURCES_CHECK_CLERR (clfftSetPlanInStride (plan->amd_plan, dimension[param->dimensions], real_strides));
+            UFO_RESOURCES_CHECK_CLERR (clfftSetPlanOutStride (plan->amd_plan, dimension[param->dimensions], hermitian_strides));
+            UFO_RESOURCES_CHECK_CLERR (clfftSetPlanDistance (plan->amd_plan, real_distance, hermitian_distance));
+        }
+        else {
+            UFO_RESOURCES_CHECK_CLERR (clfftSetLayout (plan->amd_plan, CLFFT_HERMITIAN_INTERLEAVED, CLFFT_REAL));
+            UFO_RESOURCES_CHECK_CLERR (clfftSetPlanInStride (plan->amd_plan, dimension[param->dimensions], hermitian_strides));
+            UFO_RESOURCES_CHECK_CLERR (clfftSetPlanOutStride (plan->amd_plan, dimension[param->dimensions], real_strides));
+            UFO_RESOURCES_CHECK_CLERR (clfftSetPlanDistance (plan->amd_plan, hermitian_distance, real_distance));
+        }
+
+        UFO_RESOURCES_CHECK_CLERR (clfftSetResultLocation (plan->amd_plan, CLFFT_OUTOFPLACE));
+    }
+
+    error = clfftBakePlan (plan->amd_plan, 1, &plan->queue, NULL, NULL);
+#else
+    clFFT_Dim3 size;
+
+    /* we use param->dimension to index into this array! */
+    clFFT_Dimension dimension[4] = { 0, clFFT_1D, clFFT_2D, clFFT_3D };
+
+    size.x = param->size[0];
+    size.y = param->size[1];
+    size.z = param->size[2];
+
+    plan->apple_plan = clFFT_CreatePlan (plan->context, size, dimension[param->dimensions], clFFT_InterleavedComplexFormat, &error);
+#endif
+
+    return error;
+}
+
+static void
+destroy_plan (UfoFftPlan *plan)
+{
+#ifdef HAVE_FFTW
+    g_mutex_lock (&host_planner_mutex);
+
+    for (guint i = 0; i < 4; i++) {
+        if (plan->host_plans[i / 2][i % 2] != NULL)
+            fftwf_destroy_plan (plan->host_plans[i / 2][i % 2]);
     }
+
+    g_mutex_unlock (&host_planner_mutex);
+#endif
+
+#ifdef HAVE_AMD
+    if (plan->amd_plan != 0)
+        clfftDestroyPlan (&plan->amd_plan);
 #else
-    if (fft->apple_plan == NULL || changed) {
-        clFFT_Dim3 size;
+    if (plan->apple_plan != NULL)
+        clFFT_DestroyPlan (plan->apple_plan);
+
+    g_mutex_clear (&plan->execute_mutex);
+#endif
+
+    UFO_RESOURCES_CHECK_CLERR (clReleaseCommandQueue (plan->queue));
+    UFO_RESOURCES_CHECK_CLERR (clReleaseContext (plan->context));
+    g_free (plan);
+}
+
+static void
+release_plan (UfoFftPlan *plan)
+{
+    GList *it;
+    guint num_unused = 0;
+
+    plan->refcount--;
 
-        /* we use param->dimension to index into this array! */
-        clFFT_Dimension dimension[4] = { 0, clFFT_1D, clFFT_2D, clFFT_3D };
+    for (it = g_list_first (plans); it != NULL; it = g_list_next (it))
+        num_unused += ((UfoFftPlan *) it->data)->refcount == 0 ? 1 : 0;
 
-        size.x = param->size[0];
-        size.y = param->size[1];
-        size.z = param->size[2];
+    /* Least recently created unused plans go first */
+    it = g_list_first (plans);
 
-        if (fft->apple_plan != NULL) {
-            clFFT_DestroyPlan (fft->apple_plan);
-            fft->apple_plan = NULL;
+    while (num_unused > MAX_UNUSED_PLANS && it != NULL) {
+        GList *next = g_list_next (it);
+
+        if (((UfoFftPlan *) it->data)->refcount == 0) {
+            destroy_plan ((UfoFftPlan *) it->data);
+            plans = g_list_delete_link (plans, it);
+            num_unused--;
         }
 
-        fft->apple_plan = clFFT_CreatePlan (context, size, dimension[param->dimensions], clFFT_InterleavedComplexFormat, &error);
+        it = next;
+    }
+}
+
+static cl_int
+acquire_plan (UfoFft *fft, cl_context context, cl_command_queue queue, UfoFftParameter *param)
+{
+    UfoFftPlan *plan = NULL;
+    cl_int error = CL_SUCCESS;
+
+    for (GList *it = g_list_first (plans); it != NULL; it = g_list_next (it)) {
+        if (plan_matches ((UfoFftPlan *) it->data, context, queue, param)) {
+            plan = (UfoFftPlan *) it->data;
+            break;
+        }
     }
+
+    if (plan == NULL) {
+        plan = g_malloc0 (sizeof (UfoFftPlan));
+        plan->context = context;
+        plan->queue = queue;
+        memcpy (&plan->param, param, sizeof (UfoFftParameter));
+#ifdef HAVE_FFTW
+        plan->host = is_cpu_queue (queue);
+#endif
+#ifndef HAVE_AMD
+        g_mutex_init (&plan->execute_mutex);
 #endif
+        UFO_RESOURCES_CHECK_CLERR (clRetainContext (context));
+        UFO_RESOURCES_CHECK_CLERR (clRetainCommandQueue (queue));
+
+        error = bake_plan (plan);
+
+        if (error != CL_SUCCESS) {
+            destroy_plan (plan);
+            return error;
+        }
+
+        plans = g_list_append (plans, plan);
+    }
+    else {
+        g_debug ("INFO Reuse FFT plan for %zu x %zu x %zu, batch %zu",
+                 param->size[0], param->size[1], param->size[2], param->batch);
+    }
+
+    plan->refcount++;
+    fft->plan = plan;
+
+    return error;
+}
+
+cl_int
+ufo_fft_update (UfoFft *fft, cl_context context, cl_command_queue queue, UfoFftParameter *param)
+{
+    cl_int error;
+
+#ifndef HAVE_AMD
+    gboolean host = FALSE;
+
+#ifdef HAVE_FFTW
+    /* The host backend handles what oclFFT cannot */
+    host = is_cpu_queue (queue);
+#endif
+
+    if (!host && param->type != UFO_FFT_COMPLEX_TO_COMPLEX) {
+        g_warning ("Real-to-complex transforms require clFFT");
+        return CL_INVALID_OPERATION;
+    }
+
+    for (guint i = 0; i < param->dimensions && !host; i++) {
+        if (!is_transform_size (param->size[i], FALSE)) {
+            g_warning ("FFT size %zu is not a power of two, which requires clFFT", param->size[i]);
+            return CL_INVALID_BUFFER_SIZE;
+        }
+    }
+#endif
+
+    memcpy (&fft->seen, param, sizeof (UfoFftParameter));
+
+    if (fft->plan != NULL && plan_matches (fft->plan, context, queue, param))
+        return CL_SUCCESS;
+
+    g_mutex_lock (&plan_mutex);
+
+    if (fft->plan != NULL) {
+        release_plan (fft->plan);
+        fft->plan = NULL;
+    }
+
+    error = acquire_plan (fft, context, queue, param);
+    g_mutex_unlock (&plan_mutex);
 
     return error;
 }
@@ -124,35 +602,104 @@ ufo_fft_execute (UfoFft *fft, cl_command_queue queue, UfoProfiler *profiler,
                  cl_mem in_mem, cl_mem out_mem, UfoFftDirection direction,
                  cl_uint num_events, cl_event *event_list, cl_event *event)
 {
+#ifdef HAVE_FFTW
+    if (fft->plan->host)
+        return execute_host (fft, queue, in_mem, out_mem, direction, num_events, event_list, event);
+#endif
+
 #ifdef HAVE_AMD
-    return clfftEnqueueTransform (fft->amd_plan,
+    return clfftEnqueueTransform (fft->plan->amd_plan,
                                   direction == UFO_FFT_FORWARD ? CLFFT_FORWARD : CLFFT_BACKWARD,
                                   1, &queue,
                                   num_events, event_list, event, &in_mem, &out_mem, NULL);
 #else
-    return clFFT_ExecuteInterleaved_Ufo (queue, fft->apple_plan,
-                                         fft->seen.batch,
-                                         direction == UFO_FFT_FORWARD ? clFFT_Forward : clFFT_Inverse,
-                                         in_mem, out_mem, num_events, event_list, event, profiler);
+    cl_int error;
+
+    g_mutex_lock (&fft->plan->execute_mutex);
+    error = clFFT_ExecuteInterleaved_Ufo (queue, fft->plan->apple_plan,
+                                          fft->seen.batch,
+                                          direction == UFO_FFT_FORWARD ? clFFT_Forward : clFFT_Inverse,
+                                          in_mem, out_mem, num_events, event_list, event, profiler);
+    g_mutex_unlock (&fft->plan->execute_mutex);
+
+    return error;
 #endif
 }
 
 void
 ufo_fft_destroy (UfoFft *fft)
 {
-#ifdef HAVE_AMD
-    g_mutex_lock (&amd_mutex);
+    g_mutex_lock (&plan_mutex);
+
+    if (fft->plan != NULL)
+        release_plan (fft->plan);
 
-    clfftDestroyPlan (&fft->amd_plan);
     ffts_created = g_list_remove (ffts_created, fft);
 
-    if (g_list_length (ffts_created) == 0)
+    if (g_list_length (ffts_created) == 0) {
+        g_list_free_full (plans, (GDestroyNotify) destroy_plan);
+        plans = NULL;
+
+#ifdef HAVE_AMD
         clfftTeardown ();
+#endif
 
-    g_mutex_unlock (&amd_mutex);
-#else
-    clFFT_DestroyPlan (fft->apple_plan);
+#ifdef HAVE_FFTW
+        teardown_host_backend ();
 #endif
+    }
+
+    g_mutex_unlock (&plan_mutex);
 
     g_free (fft);
 }
+
+/**
+ * ufo_fft_get_padded_size:
+ * @size: Minimum size of the transform
+ * @smooth: %TRUE to allow sizes with prime factors 2, 3, 5 and 7, otherwise
+ * only powers of two are returned
+ *
+ * Returns: the smallest size not less than @size for which the backend has
+ * fast kernels. Smooth sizes are only supported by clFFT, with oclFFT the next
+ * power of two is always returned.
+ */
+gsize
+ufo_fft_get_padded_size (gsize size, gboolean smooth)
+{
+    gsize result = 1;
+
+#ifndef HAVE_AMD
+    smooth = FALSE;
+#endif
+
+    if (!smooth) {
+        while (result < size)
+            result *= 2;
+
+        return result;
+    }
+
+    result = MAX (size, 1);
+
+    while (!is_transform_size (result, TRUE))
+        result++;
+
+    return result;
+}
+
+/**
+ * ufo_fft_supports_real:
+ *
+ * Returns: %TRUE if the backend implements real-to-complex and
+ * complex-to-real transforms.
+ */
+gboolean
+ufo_fft_supports_real (void)
+{
+#ifdef HAVE_AMD
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
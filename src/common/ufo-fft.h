@@ -28,6 +28,18 @@
 
 #include <ufo/ufo.h>
 
+/*
+ * Real-to-complex transforms store only the non-redundant half of the
+ * Hermitian spectrum, i.e. size[0] / 2 + 1 complex values per row. They are
+ * always out-of-place and computed in forward direction, complex-to-real
+ * transforms in backward direction.
+ */
+typedef enum {
+    UFO_FFT_COMPLEX_TO_COMPLEX = 0,
+    UFO_FFT_REAL_TO_COMPLEX,
+    UFO_FFT_COMPLEX_TO_REAL
+} UfoFftType;
+
 typedef struct {
     enum {
         UFO_FFT_1D = 1,
@@ -38,6 +50,7 @@ typedef struct {
     gsize size[3];
     gsize batch;
     gboolean zeropad;
+    UfoFftType type;
 } UfoFftParameter;
 
 typedef enum {
@@ -47,6 +60,10 @@ typedef enum {
 
 typedef struct _UfoFft UfoFft;
 
+/* Boolean buffer metadata set by the fft task, TRUE if the buffer holds only
+ * the non-redundant half spectrum of real data */
+#define UFO_FFT_METADATA_HERMITIAN "fft-hermitian"
+
 UfoFft *ufo_fft_new     (void);
 cl_int  ufo_fft_update  (UfoFft            *fft,
                          cl_context         context,
@@ -62,5 +79,10 @@ cl_int  ufo_fft_execute (UfoFft            *fft,
                          cl_event          *event_list,
                          cl_event          *event);
 void    ufo_fft_destroy (UfoFft            *fft);
+gboolean ufo_fft_supports_real
+                        (void);
+gsize   ufo_fft_get_padded_size
+                        (gsize              size,
+                         gboolean           smooth);
 
 #endif
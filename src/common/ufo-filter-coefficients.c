@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2011-2017 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include "ufo-filter-coefficients.h"
+
+typedef void (*SetupFunc)(UfoFilterParameter *param, gfloat *coefficients, guint width);
+
+static void compute_ramp_coefficients (UfoFilterParameter *, gfloat *, guint);
+static void compute_real_space_ramp_coefficients (UfoFilterParameter *, gfloat *, guint);
+static void compute_butterworth_coefficients (UfoFilterParameter *, gfloat *, guint);
+static void compute_faris_byer_coefficients (UfoFilterParameter *, gfloat *, guint);
+static void compute_hamming_coefficients (UfoFilterParameter *, gfloat *, guint);
+static void compute_bh3_coefficients (UfoFilterParameter *, gfloat *, guint);
+static void compute_real_space_shepp_logan_coefficients (UfoFilterParameter *, gfloat *, guint);
+
+GEnumValue ufo_filter_type_values[] = {
+    { UFO_FILTER_RAMP,          "FILTER_RAMP",          "ramp" },
+    { UFO_FILTER_RAMP_FROMREAL, "FILTER_RAMP_FROMREAL", "ramp-fromreal" },
+    { UFO_FILTER_BUTTERWORTH,   "FILTER_BUTTERWORTH",   "butterworth"},
+    { UFO_FILTER_FARIS_BYER,    "FILTER_FARIS_BYER",    "faris-byer"},
+    { UFO_FILTER_HAMMING,       "FILTER_HAMMING",       "hamming"},
+    { UFO_FILTER_BH3,           "FILTER_BH3",           "bh3" },
+    { UFO_FILTER_SHEPP_LOGAN,   "FILTER_SHEPP_LOGAN",   "shepp-logan" },
+    { 0, NULL, NULL}
+};
+
+static SetupFunc filter_funcs[] = {
+    &compute_ramp_coefficients,
+    &compute_real_space_ramp_coefficients,
+    &compute_butterworth_coefficients,
+    &compute_faris_byer_coefficients,
+    &compute_hamming_coefficients,
+    &compute_bh3_coefficients,
+    &compute_real_space_shepp_logan_coefficients,
+};
+
+static void
+mirror_coefficients (gfloat *filter, guint width)
+{
+    const guint size = width / 2;
+
+    /* Negative frequencies of any, also odd, transform size */
+    for (guint k = size / 2 + 1; k < size; k++) {
+        filter[2*k] = filter[2*(size - k)];
+        filter[2*k + 1] = filter[2*(size - k) + 1];
+    }
+}
+
+static void
+compute_ramp_coefficients (UfoFilterParameter *param,
+                           gfloat *filter,
+                           guint width)
+{
+    const gdouble step = 2.0 / width;
+
+    for (guint k = 1; k < width / 4 + 1; k++) {
+        filter[2*k] = k * step * param->scale;
+        filter[2*k + 1] = filter[2*k];
+    }
+}
+
+static void
+compute_real_space_ramp_coefficients (UfoFilterParameter *param,
+                                      gfloat *filter,
+                                      guint width)
+{
+    filter[0] = filter[1] = 0.25 * param->scale;
+
+    for (guint k = 1; k < width / 4 + 1; k++) {
+        filter[2*k] = k % 2 ? - param->scale / (k * k * G_PI * G_PI) : 0.0;
+        filter[2*k + 1] = filter[2*k];
+    }
+}
+
+static void
+compute_real_space_shepp_logan_coefficients (UfoFilterParameter *param,
+                                             gfloat *filter,
+                                             guint width)
+{
+    for (guint k = 0; k < width / 4 + 1; k++) {
+        filter[2*k] = - 2.0 * param->scale / (G_PI * G_PI * (4.0 * k * k - 1.0));
+        filter[2*k + 1] = filter[2*k];
+    }
+}
+
+static void
+compute_butterworth_coefficients (UfoFilterParameter *param,
+                                  gfloat *filter,
+                                  guint width)
+{
+    const gdouble step = 2.0 / width;
+
+    for (guint k = 0; k < (width / 4) + 1; k++) {
+        const gdouble f = k * step;
+        filter[2*k] = (gfloat) (f / (1.0 + pow (f / param->cutoff, 2.0 * param->bw_order)) * param->scale);
+        filter[2*k+1] = filter[2*k];
+    }
+}
+
+static void
+compute_hamming_coefficients (UfoFilterParameter *param,
+                              gfloat *filter,
+                              guint width)
+{
+    const gdouble step = 2.0 / width;
+
+    for (guint k = 0; k < (width / 4) + 1; k++) {
+        const gdouble f = k * step;
+
+        filter[2*k] = f < param->cutoff ? f * (0.54 + 0.46 * cos (G_PI * f / param->cutoff)) * param->scale : 0;
+        filter[2*k+1] = filter[2*k];
+    }
+}
+
+static void
+compute_bh3_coefficients (UfoFilterParameter *param,
+                           gfloat *filter,
+                           guint width)
+{
+    const gdouble step = 2.0 / width;
+    const gdouble a0 = 0.42;
+    const gdouble a1 = 0.5;
+    const gdouble a2 = 0.08;
+    for (guint k = 1; k < width / 4 + 1; k++) {
+        const gdouble f = k * step;
+        filter[2*k] = f * ( a0 + a1 * cos(f * G_PI) + a2 * cos(2.0 * f * G_PI ) ) * param->scale;
+        filter[2*k + 1] = filter[2*k];
+    }
+}
+
+static guint
+get_padding_value (guint x)
+{
+    guint padding = 2 * x;
+    guint result = 1;
+
+    while (result < padding)
+        result *= 2;
+
+    return result;
+}
+
+static void
+compute_faris_byer_coefficients (UfoFilterParameter *param,
+                                 gfloat *filter,
+                                 guint width)
+{
+    const gdouble pi_squared_tau = G_PI * G_PI * param->fb_tau;
+    const gdouble sin_theta_2 = - sin (param->fb_theta) / 2;
+    const guint padding = get_padding_value (width);
+
+    filter[0] = 0;
+
+    for (guint x = 1; x <= width / 2; x++) {
+        if (x % 2 != 0)
+            filter[x] = 1 / (pi_squared_tau * x);
+    }
+
+    for (guint i = width / 2 + 1; i < width; i++) {
+        guint x = width + 1 - i;
+
+        if (x % 2 != 0)
+            filter[padding - width - i - 1] = sin_theta_2 / (x * x * pi_squared_tau);
+    }
+}
+
+/**
+ * ufo_filter_compute_coefficients:
+ * @param: filter parameters
+ * @width: number of floats of an interleaved complex spectrum row
+ *
+ * Returns: the filter coefficients for an interleaved complex spectrum of
+ * @width / 2 values in FFT order, free with g_free(). For filters for which
+ * ufo_filter_is_real_space() is %TRUE these are real space coefficients which
+ * still need to be Fourier transformed.
+ */
+gfloat *
+ufo_filter_compute_coefficients (UfoFilterParameter *param, guint width)
+{
+    gfloat *coefficients;
+
+    coefficients = g_malloc0 (width * sizeof (gfloat));
+    coefficients[0] = 0.5 / width;
+    coefficients[1] = coefficients[0];
+
+    filter_funcs[param->type] (param, coefficients, width);
+    mirror_coefficients (coefficients, width);
+
+    return coefficients;
+}
+
+/**
+ * ufo_filter_is_real_space:
+ * @type: filter type
+ *
+ * Returns: %TRUE if the filter is defined by a real space kernel.
+ */
+gboolean
+ufo_filter_is_real_space (UfoFilterType type)
+{
+    return type == UFO_FILTER_RAMP_FROMREAL || type == UFO_FILTER_SHEPP_LOGAN;
+}
+
+/**
+ * ufo_filter_compute_taps:
+ * @param: filter parameters of a real space filter
+ * @num_taps: number of taps
+ *
+ * Returns: the taps h[0], ..., h[@num_taps - 1] of the symmetric real space
+ * kernel, h[-k] = h[k], free with g_free(). Convolving a row of at most
+ * @num_taps values with them gives the same result as filtering it zero-padded
+ * to at least twice its width in Fourier space.
+ */
+gfloat *
+ufo_filter_compute_taps (UfoFilterParameter *param, guint num_taps)
+{
+    gfloat *interleaved;
+    gfloat *taps;
+
+    g_return_val_if_fail (ufo_filter_is_real_space (param->type), NULL);
+
+    interleaved = g_malloc0 (4 * num_taps * sizeof (gfloat));
+    taps = g_malloc (num_taps * sizeof (gfloat));
+    filter_funcs[param->type] (param, interleaved, 4 * num_taps);
+
+    for (guint k = 0; k < num_taps; k++)
+        taps[k] = interleaved[2*k];
+
+    g_free (interleaved);
+
+    return taps;
+}
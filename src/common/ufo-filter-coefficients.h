@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2011-2017 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UFO_FILTER_COEFFICIENTS_H
+#define UFO_FILTER_COEFFICIENTS_H
+
+#include <glib-object.h>
+
+typedef enum {
+    UFO_FILTER_RAMP = 0,
+    UFO_FILTER_RAMP_FROMREAL,
+    UFO_FILTER_BUTTERWORTH,
+    UFO_FILTER_FARIS_BYER,
+    UFO_FILTER_HAMMING,
+    UFO_FILTER_BH3,
+    UFO_FILTER_SHEPP_LOGAN,
+} UfoFilterType;
+
+typedef struct {
+    UfoFilterType type;
+    gfloat cutoff;
+    gfloat bw_order;
+    gfloat fb_tau;
+    gfloat fb_theta;
+    gfloat scale;
+} UfoFilterParameter;
+
+extern GEnumValue ufo_filter_type_values[];
+
+gfloat  *ufo_filter_compute_coefficients (UfoFilterParameter *param,
+                                          guint               width);
+gboolean ufo_filter_is_real_space        (UfoFilterType       type);
+gfloat  *ufo_filter_compute_taps         (UfoFilterParameter *param,
+                                          guint               num_taps);
+
+#endif
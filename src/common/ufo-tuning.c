@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2015-2017 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <glib/gstdio.h>
+#include <ufo/ufo.h>
+#include "ufo-tuning.h"
+
+/*
+ * Kernel launch parameters found by benchmarking are stored in a key file in
+ * the user's cache directory. Groups are formed by the kernel name and the
+ * device, keys describe the problem shape, so that a new driver or a new
+ * device triggers a new tuning run.
+ */
+
+static gchar *
+get_cache_filename (void)
+{
+    return g_build_filename (g_get_user_cache_dir (), "ufo", "kernel-tuning.ini", NULL);
+}
+
+static GKeyFile *
+load_cache (gchar **filename)
+{
+    GKeyFile *cache;
+
+    *filename = get_cache_filename ();
+    cache = g_key_file_new ();
+
+    /* A missing file just means nothing has been tuned yet */
+    g_key_file_load_from_file (cache, *filename, G_KEY_FILE_NONE, NULL);
+
+    return cache;
+}
+
+static gchar *
+get_group_name (const gchar *kernel_name, const gchar *device_key)
+{
+    return g_strdup_printf ("%s@%s", kernel_name, device_key);
+}
+
+/**
+ * ufo_tuning_get_device_key:
+ * @device: OpenCL device
+ *
+ * Make a string identifying @device and its driver.
+ *
+ * Returns: a newly allocated string.
+ */
+gchar *
+ufo_tuning_get_device_key (cl_device_id device)
+{
+    gchar name[256];
+    gchar driver[256];
+    gchar *key;
+
+    UFO_RESOURCES_CHECK_CLERR (clGetDeviceInfo (device, CL_DEVICE_NAME, sizeof (name), name, NULL));
+    UFO_RESOURCES_CHECK_CLERR (clGetDeviceInfo (device, CL_DRIVER_VERSION, sizeof (driver), driver, NULL));
+
+    /* Brackets and equal signs are not allowed in key file group names */
+    key = g_strdup_printf ("%s %s", g_strstrip (name), g_strstrip (driver));
+    g_strdelimit (key, "[]=", '_');
+
+    return key;
+}
+
+/**
+ * ufo_tuning_lookup:
+ * @kernel_name: name of the tuned kernel
+ * @device_key: device key obtained by ufo_tuning_get_device_key()
+ * @shape: string describing the problem size
+ * @values: (out): location for the tuned parameters
+ * @num_values: number of parameters
+ *
+ * Look up previously tuned parameters.
+ *
+ * Returns: %TRUE if @num_values parameters were found.
+ */
+gboolean
+ufo_tuning_lookup (const gchar *kernel_name,
+                   const gchar *device_key,
+                   const gchar *shape,
+                   gint *values,
+                   gsize num_values)
+{
+    GKeyFile *cache;
+    gchar *filename, *group;
+    gint *stored;
+    gsize length = 0;
+
+    cache = load_cache (&filename);
+    group = get_group_name (kernel_name, device_key);
+    stored = g_key_file_get_integer_list (cache, group, shape, &length, NULL);
+
+    if (stored != NULL && length == num_values)
+        memcpy (values, stored, num_values * sizeof (gint));
+
+    g_free (stored);
+    g_free (group);
+    g_free (filename);
+    g_key_file_free (cache);
+
+    return length == num_values;
+}
+
+/**
+ * ufo_tuning_store:
+ * @kernel_name: name of the tuned kernel
+ * @device_key: device key obtained by ufo_tuning_get_device_key()
+ * @shape: string describing the problem size
+ * @values: tuned parameters
+ * @num_values: number of parameters
+ *
+ * Persist tuned parameters. Failing to write the cache is not an error, the
+ * parameters are just tuned again the next time.
+ */
+void
+ufo_tuning_store (const gchar *kernel_name,
+                  const gchar *device_key,
+                  const gchar *shape,
+                  const gint *values,
+                  gsize num_values)
+{
+    GKeyFile *cache;
+    GError *error = NULL;
+    gchar *filename, *dirname, *group;
+
+    cache = load_cache (&filename);
+    group = get_group_name (kernel_name, device_key);
+    g_key_file_set_integer_list (cache, group, shape, (gint *) values, num_values);
+
+    dirname = g_path_get_dirname (filename);
+    g_mkdir_with_parents (dirname, 0755);
+
+    if (!g_key_file_save_to_file (cache, filename, &error)) {
+        g_warning ("Could not save tuning cache: %s", error->message);
+        g_error_free (error);
+    }
+
+    g_free (dirname);
+    g_free (group);
+    g_free (filename);
+    g_key_file_free (cache);
+}
+
+/**
+ * ufo_tuning_time_kernel:
+ * @cmd_queue: command queue
+ * @kernel: kernel with all arguments set
+ * @num_dims: number of work dimensions
+ * @global_work_size: global work size
+ * @local_work_size: local work size or %NULL
+ * @num_runs: number of timed executions
+ *
+ * Run @kernel once to warm up and then @num_runs times.
+ *
+ * Returns: the mean execution time in seconds or %G_MAXDOUBLE if the kernel
+ * could not be launched with the given configuration.
+ */
+gdouble
+ufo_tuning_time_kernel (cl_command_queue cmd_queue,
+                        cl_kernel kernel,
+                        guint num_dims,
+                        const gsize *global_work_size,
+                        const gsize *local_work_size,
+                        guint num_runs)
+{
+    GTimer *timer;
+    gdouble elapsed;
+
+    /* Invalid local sizes are expected during tuning, hence no error checks */
+    if (clEnqueueNDRangeKernel (cmd_queue, kernel, num_dims, NULL, global_work_size,
+                                local_work_size, 0, NULL, NULL) != CL_SUCCESS ||
+        clFinish (cmd_queue) != CL_SUCCESS)
+        return G_MAXDOUBLE;
+
+    timer = g_timer_new ();
+
+    for (guint i = 0; i < num_runs; i++)
+        clEnqueueNDRangeKernel (cmd_queue, kernel, num_dims, NULL, global_work_size,
+                                local_work_size, 0, NULL, NULL);
+
+    clFinish (cmd_queue);
+    elapsed = g_timer_elapsed (timer, NULL) / num_runs;
+    g_timer_destroy (timer);
+
+    return elapsed;
+}
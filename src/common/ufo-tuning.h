@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2015-2017 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UFO_TUNING_H
+#define UFO_TUNING_H
+
+#include <glib.h>
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+gchar      *ufo_tuning_get_device_key   (cl_device_id       device);
+gboolean    ufo_tuning_lookup           (const gchar       *kernel_name,
+                                         const gchar       *device_key,
+                                         const gchar       *shape,
+                                         gint              *values,
+                                         gsize              num_values);
+void        ufo_tuning_store            (const gchar       *kernel_name,
+                                         const gchar       *device_key,
+                                         const gchar       *shape,
+                                         const gint        *values,
+                                         gsize              num_values);
+gdouble     ufo_tuning_time_kernel      (cl_command_queue   cmd_queue,
+                                         cl_kernel          kernel,
+                                         guint              num_dims,
+                                         const gsize       *global_work_size,
+                                         const gsize       *local_work_size,
+                                         guint              num_runs);
+
+#endif
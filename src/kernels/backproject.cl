@@ -17,6 +17,33 @@
  * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* UNROLL is passed as a build option by the autotuner */
+#define STRINGIFY(x) #x
+#define PRAGMA_UNROLL(n) _Pragma(STRINGIFY(unroll n))
+
+#if defined(UNROLL)
+#define TEXTURE_UNROLL PRAGMA_UNROLL(UNROLL)
+#elif defined(DEVICE_TESLA_K20XM)
+#define TEXTURE_UNROLL PRAGMA_UNROLL(4)
+#elif defined(DEVICE_TESLA_P100_PCIE_16GB)
+#define TEXTURE_UNROLL PRAGMA_UNROLL(2)
+#elif defined(DEVICE_GEFORCE_GTX_TITAN_BLACK)
+#define TEXTURE_UNROLL PRAGMA_UNROLL(8)
+#elif defined(DEVICE_GEFORCE_GTX_TITAN)
+#define TEXTURE_UNROLL PRAGMA_UNROLL(14)
+#elif defined(DEVICE_GEFORCE_GTX_1080_TI)
+#define TEXTURE_UNROLL PRAGMA_UNROLL(10)
+#elif defined(DEVICE_QUADRO_M6000)
+#define TEXTURE_UNROLL PRAGMA_UNROLL(2)
+#else
+#define TEXTURE_UNROLL
+#endif
+
+/*
+ * backproject_nearest and backproject_tex_stack reconstruct a stack of
+ * sinograms, the third dimension of the global work size selects the sinogram.
+ */
+
 constant sampler_t volumeSampler = CLK_NORMALIZED_COORDS_FALSE |
                                    CLK_ADDRESS_CLAMP |
                                    CLK_FILTER_LINEAR;
@@ -30,21 +57,32 @@ backproject_nearest (global float *sinogram,
                      const unsigned int y_offset,
                      const unsigned int angle_offset,
                      const unsigned n_projections,
-                     const float axis_pos)
+                     const float axis_pos,
+                     const unsigned int sino_width,
+                     const unsigned int sino_height)
 {
     const int idx = get_global_id(0);
     const int idy = get_global_id(1);
+    const int idz = get_global_id(2);
     const int width = get_global_size(0);
     const float bx = idx - axis_pos + x_offset + 0.5f;
     const float by = idy - axis_pos + y_offset + 0.5f;
     float sum = 0.0f;
 
+    /* n_projections is the burst, sinograms are stored with all their rows */
+    sinogram += idz * sino_height * sino_width;
+
+#ifdef UNROLL
+    PRAGMA_UNROLL(UNROLL)
+#endif
     for(int proj = 0; proj < n_projections; proj++) {
         float h = axis_pos + bx * cos_lut[angle_offset + proj] + by * sin_lut[angle_offset + proj];
-        sum += sinogram[(int)(proj * width + h)];
+
+        if (h >= 0.0f && h < sino_width)
+            sum += sinogram[proj * sino_width + (int) h];
     }
 
-    slice[idy * width + idx] = sum * M_PI_F / n_projections;
+    slice[(idz * get_global_size(1) + idy) * width + idx] = sum * M_PI_F / n_projections;
 }
 
 kernel void
@@ -64,24 +102,7 @@ backproject_tex (read_only image2d_t sinogram,
     const float by = idy - axis_pos + y_offset + 0.5f;
     float sum = 0.0f;
 
-#ifdef DEVICE_TESLA_K20XM
-#pragma unroll 4
-#endif
-#ifdef DEVICE_TESLA_P100_PCIE_16GB
-#pragma unroll 2
-#endif
-#ifdef DEVICE_GEFORCE_GTX_TITAN_BLACK
-#pragma unroll 8
-#endif
-#ifdef DEVICE_GEFORCE_GTX_TITAN
-#pragma unroll 14
-#endif
-#ifdef DEVICE_GEFORCE_GTX_1080_TI
-#pragma unroll 10
-#endif
-#ifdef DEVICE_QUADRO_M6000
-#pragma unroll 2
-#endif
+    TEXTURE_UNROLL
     for(int proj = 0; proj < n_projections; proj++) {
         float h = by * sin_lut[angle_offset + proj] + bx * cos_lut[angle_offset + proj] + axis_pos;
         sum += read_imagef (sinogram, volumeSampler, (float2)(h, proj + 0.5f)).x;
@@ -90,3 +111,29 @@ backproject_tex (read_only image2d_t sinogram,
     slice[idy * get_global_size(0) + idx] = sum * M_PI_F / n_projections;
 }
 
+kernel void
+backproject_tex_stack (read_only image3d_t sinograms,
+                       global float *slices,
+                       constant float *sin_lut,
+                       constant float *cos_lut,
+                       const unsigned int x_offset,
+                       const unsigned int y_offset,
+                       const unsigned int angle_offset,
+                       const unsigned int n_projections,
+                       const float axis_pos)
+{
+    const int idx = get_global_id(0);
+    const int idy = get_global_id(1);
+    const int idz = get_global_id(2);
+    const float bx = idx - axis_pos + x_offset + 0.5f;
+    const float by = idy - axis_pos + y_offset + 0.5f;
+    float sum = 0.0f;
+
+    TEXTURE_UNROLL
+    for(int proj = 0; proj < n_projections; proj++) {
+        float h = by * sin_lut[angle_offset + proj] + bx * cos_lut[angle_offset + proj] + axis_pos;
+        sum += read_imagef (sinograms, volumeSampler, (float4)(h, proj + 0.5f, idz + 0.5f, 0.0f)).x;
+    }
+
+    slices[(idz * get_global_size(1) + idy) * get_global_size(0) + idx] = sum * M_PI_F / n_projections;
+}
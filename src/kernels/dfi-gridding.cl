@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Spectra of the projections and the Cartesian grid are stored in FFT order,
+ * i.e. frequency k at index k for k >= 0 and at index size + k otherwise. The
+ * projections are padded to the size of the grid, so that radial and Cartesian
+ * frequencies have the same units.
+ */
+
+static float2
+complex_mul (const float2 a, const float2 b)
+{
+    return (float2) (a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+static float
+kaiser_bessel (global const float *table, const int table_size, const float half_width, const float x)
+{
+    const float position = fabs (x) / half_width * table_size;
+    const int index = (int) position;
+
+    if (index >= table_size) {
+        return 0.0f;
+    }
+
+    return mix (table[index], table[index + 1], position - index);
+}
+
+/*
+ * Apply density compensation (ramp) and move the rotation axis to the origin
+ * of the projections and the slice center to the origin of the image.
+ */
+kernel void
+dfi_gridding_weight (global float2 *spectra,
+                     const float angle_offset,
+                     const float angle_step,
+                     const float center,
+                     const float shift,
+                     const float norm)
+{
+    const int idx = get_global_id (0);
+    const int row = get_global_id (1) + get_global_id (2) * get_global_size (1);
+    const int size = get_global_size (0);
+    const int k = idx < size / 2 ? idx : idx - size;
+    const float theta = mad ((float) get_global_id (1), angle_step, angle_offset);
+    const float rho = (float) k / size;
+    /* The DC bin stands for the disk of radius 1 / (2 size) */
+    const float weight = (k ? (float) abs (k) : 0.25f) * norm;
+    float cosine, sine;
+
+    sine = sincos (2.0f * M_PI_F * rho * (center + shift * (cos (theta) + sin (theta))), &cosine);
+    spectra[row * size + idx] = complex_mul (spectra[row * size + idx], (float2) (cosine, sine) * weight);
+}
+
+/*
+ * Interpolate the polar samples onto the Cartesian grid by gathering all
+ * samples within the Kaiser-Bessel footprint of a grid point. Projections
+ * cover 180 degrees, a line beyond is the opposite one with negated radius.
+ */
+kernel void
+dfi_gridding_gather (global const float2 *spectra,
+                     global float2 *grid,
+                     global const float *table,
+                     const int table_size,
+                     const float half_width,
+                     const int num_angles,
+                     const float angle_offset,
+                     const float angle_step)
+{
+    const int idx = get_global_id (0);
+    const int idy = get_global_id (1);
+    const int size = get_global_size (0);
+    const float u = idx < size / 2 ? idx : idx - size;
+    const float v = idy < size / 2 ? idy : idy - size;
+    const float radius = hypot (u, v);
+    const float reach = half_width * M_SQRT2_F;
+    const int nearest = (int) floor ((atan2 (v, u) - angle_offset) / angle_step);
+    global const float2 *projections = spectra + get_global_id (2) * num_angles * size;
+    float2 sum = (float2) (0.0f, 0.0f);
+    int first, last, neighbors;
+
+    /* Lines which pass within reach of the grid point */
+    neighbors = radius > reach ? (int) ceil (asin (reach / radius) / angle_step) : num_angles;
+
+    if (2 * neighbors + 2 > num_angles) {
+        first = nearest - num_angles / 2 + 1;
+        last = first + num_angles - 1;
+    } else {
+        first = nearest - neighbors;
+        last = nearest + neighbors + 1;
+    }
+
+    for (int q = first; q <= last; q++) {
+        const int p = ((q % num_angles) + num_angles) % num_angles;
+        const int sign = ((q - p) / num_angles) % 2 ? -1 : 1;
+        float cosine, sine, along;
+
+        sine = sincos (mad ((float) q, angle_step, angle_offset), &cosine);
+        along = u * cosine + v * sine;
+
+        for (int j = (int) ceil (along - reach); j <= (int) floor (along + reach); j++) {
+            const float dx = u - j * cosine;
+            const float dy = v - j * sine;
+            const int k = sign * j;
+
+            if (fabs (dx) < half_width && fabs (dy) < half_width && k >= -size / 2 && k < size / 2) {
+                sum += projections[p * size + (k < 0 ? k + size : k)] *
+                       kaiser_bessel (table, table_size, half_width, dx) *
+                       kaiser_bessel (table, table_size, half_width, dy);
+            }
+        }
+    }
+
+    grid[(get_global_id (2) * size + idy) * size + idx] = sum;
+}
+
+/*
+ * Crop the slice from the inverse transformed grid whose origin is the slice
+ * center and divide by the transform of the interpolation kernel.
+ */
+kernel void
+dfi_gridding_crop (global const float2 *images,
+                   global float *slices,
+                   global const float *deapodization,
+                   const int grid_size)
+{
+    const int idx = get_global_id (0);
+    const int idy = get_global_id (1);
+    const int idz = get_global_id (2);
+    const int width = get_global_size (0);
+    const int x = (idx - width / 2 + grid_size) % grid_size;
+    const int y = (idy - width / 2 + grid_size) % grid_size;
+
+    slices[(idz * width + idy) * width + idx] = images[(idz * grid_size + y) * grid_size + x].x *
+                                                deapodization[idx] * deapodization[idy];
+}
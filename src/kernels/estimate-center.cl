@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Every row r is correlated in one complex transform z = a + ib of size
+ * @size, where a is the row of the projection at 0 degrees and b the mirrored
+ * row at 180 degrees, both without their mean. The reductions use one work
+ * group of a power of two work items per row.
+ */
+
+static float2
+complex_mul (const float2 a, const float2 b)
+{
+    return (float2) (a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+static float2
+complex_conj (const float2 a)
+{
+    return (float2) (a.x, -a.y);
+}
+
+kernel void
+estimate_center_pack (global const float *proj_0,
+                      global const float *proj_180,
+                      global float2 *rows,
+                      const int width,
+                      const int size,
+                      const int y,
+                      const int y_step,
+                      local float2 *sums)
+{
+    const int lid = get_local_id (0);
+    const int local_size = get_local_size (0);
+    const int r = get_group_id (1);
+    global const float *row_0 = proj_0 + (y + r * y_step) * width;
+    global const float *row_180 = proj_180 + (y + r * y_step) * width;
+    float2 sum = (float2) (0.0f, 0.0f);
+    float2 mean;
+
+    for (int x = lid; x < width; x += local_size)
+        sum += (float2) (row_0[x], row_180[x]);
+
+    sums[lid] = sum;
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    for (int stride = local_size / 2; stride > 0; stride >>= 1) {
+        if (lid < stride)
+            sums[lid] += sums[lid + stride];
+
+        barrier (CLK_LOCAL_MEM_FENCE);
+    }
+
+    mean = sums[0] / width;
+
+    for (int x = lid; x < size; x += local_size) {
+        rows[r * size + x] = x < width ? (float2) (row_0[x], row_180[width - 1 - x]) - mean :
+                                         (float2) (0.0f, 0.0f);
+    }
+}
+
+/*
+ * Separate the spectra A and B of the real rows from Z and compute the cross
+ * power spectrum A * conj (B) = i/4 (Z[k] + conj (Z[-k])) (conj (Z[k]) - Z[-k]).
+ */
+kernel void
+estimate_center_cross_power (global const float2 *rows,
+                             global float2 *power)
+{
+    const int k = get_global_id (0);
+    const int size = get_global_size (0);
+    const int offset = get_global_id (1) * size;
+    const float2 z = rows[offset + k];
+    const float2 z_mirror = rows[offset + (size - k) % size];
+    const float2 product = complex_mul (z + complex_conj (z_mirror), complex_conj (z) - z_mirror);
+
+    power[offset + k] = (float2) (-product.y, product.x) * 0.25f;
+}
+
+/*
+ * Find the shift s in [-width + 1, width - 1] maximizing the cross-correlation
+ * c[s] = sum_x a[x + s] b[x], refine it with a parabola through the
+ * neighbours and convert it to the center 0.5 (s + width), which uses the same
+ * pixel convention as the axis-pos of the backprojectors.
+ */
+kernel void
+estimate_center_peak (global const float2 *correlation,
+                      global float *centers,
+                      const int width,
+                      const int size,
+                      local float *values,
+                      local int *shifts)
+{
+    const int lid = get_local_id (0);
+    const int local_size = get_local_size (0);
+    const int r = get_group_id (1);
+    global const float2 *row = correlation + r * size;
+    float best = -INFINITY;
+    int best_shift = 0;
+
+    for (int s = lid - width + 1; s < width; s += local_size) {
+        const float value = row[(s + size) % size].x;
+
+        if (value > best) {
+            best = value;
+            best_shift = s;
+        }
+    }
+
+    values[lid] = best;
+    shifts[lid] = best_shift;
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    for (int stride = local_size / 2; stride > 0; stride >>= 1) {
+        if (lid < stride && values[lid + stride] > values[lid]) {
+            values[lid] = values[lid + stride];
+            shifts[lid] = shifts[lid + stride];
+        }
+
+        barrier (CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        const int s = shifts[0];
+        const float left = row[(s - 1 + size) % size].x;
+        const float center = row[(s + size) % size].x;
+        const float right = row[(s + 1 + size) % size].x;
+        const float curvature = left - 2.0f * center + right;
+        const float delta = curvature < 0.0f ? 0.5f * (left - right) / curvature : 0.0f;
+
+        centers[r] = 0.5f * (s + clamp (delta, -0.5f, 0.5f) + width);
+    }
+}
@@ -46,6 +46,24 @@ fft_spread (global float *out,
     }
 }
 
+kernel void
+fft_pad_real (global float *out,
+              global float *in,
+              const int width,
+              const int height)
+{
+    const int idx = get_global_id(0);
+    const int idy = get_global_id(1);
+    const int idz = get_global_id(2);
+    const int len_x = get_global_size(0);
+    const int len_y = get_global_size(1);
+
+    if ((idy >= height) || (idx >= width))
+        out[(idz*len_y + idy)*len_x + idx] = 0.0f;
+    else
+        out[(idz*len_y + idy)*len_x + idx] = in[(idz*height + idy)*width + idx];
+}
+
 kernel void
 fft_pack (global float *in,
           global float *out,
@@ -78,3 +96,20 @@ fft_normalize (global float *data)
     const int dim_fft = get_global_size(0);
     data[2*idx] = data[2*idx] / dim_fft;
 }
+
+/* Crop and scale real data, in and out may only be the same without cropping */
+kernel void
+fft_pack_real (global float *in,
+               global float *out,
+               const int in_width,
+               const int in_height,
+               const float scale)
+{
+    const int idx = get_global_id(0);
+    const int idy = get_global_id(1);
+    const int idz = get_global_id(2);
+    const int width = get_global_size(0);
+    const int height = get_global_size(1);
+
+    out[(idz*height + idy)*width + idx] = in[(idz*in_height + idy)*in_width + idx] * scale;
+}
@@ -28,6 +28,45 @@ filter (global float *input,
     output[index] = input[index] * filter[idx];
 }
 
+/*
+ * Convolve every row with the symmetric real space kernel taps[|k|], assuming
+ * zeros outside of the row. One work group filters one row, which is cached in
+ * local memory with num_taps - 1 zeros on either side, so that neighbouring
+ * work items read neighbouring values and all use the same tap at a time.
+ */
+kernel void
+filter_convolve (global const float *input,
+                 global float *output,
+                 global const float *taps,
+                 const int width,
+                 const int num_taps,
+                 local float *row,
+                 local float *local_taps)
+{
+    const int lid = get_local_id(0);
+    const int local_size = get_local_size(0);
+    const int margin = num_taps - 1;
+    const int offset = get_group_id(1) * width;
+
+    for (int x = lid; x < width + 2 * margin; x += local_size)
+        row[x] = x >= margin && x < width + margin ? input[offset + x - margin] : 0.0f;
+
+    for (int k = lid; k < num_taps; k += local_size)
+        local_taps[k] = taps[k];
+
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    for (int x = lid; x < width; x += local_size) {
+        const int center = x + margin;
+        float sum = local_taps[0] * row[center];
+
+        for (int k = 1; k < num_taps; k++)
+            sum = mad (local_taps[k], row[center - k] + row[center + k], sum);
+
+        output[offset + x] = sum;
+    }
+}
+
 kernel void
 stripe_filter (global float *input,
                global float *output,
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * The ray through detector coordinates (u, v) of a projection starts at
+ * rays[0] + u * rays[1] + v * rays[2] and points in the direction rays[3] + u *
+ * rays[4] + v * rays[5]. Coordinates are in voxels with voxel (0, 0, 0)
+ * centered at the origin.
+ */
+
+/* Bilinear interpolation within plane @plane of the dominant axis */
+static float
+interpolate (global const float *volume,
+             const int3 size,
+             const int3 stride,
+             const int plane,
+             const float2 position)
+{
+    const float2 left = floor (position);
+    const float2 weight = position - left;
+    const int b = (int) left.x;
+    const int c = (int) left.y;
+    const int offset = plane * stride.x;
+    /* Both bounds of every tap, the ray may pass beside the volume */
+    const int b_0 = b >= 0 && b < size.y;
+    const int b_1 = b + 1 >= 0 && b + 1 < size.y;
+    const int c_0 = c >= 0 && c < size.z;
+    const int c_1 = c + 1 >= 0 && c + 1 < size.z;
+    float value = 0.0f;
+
+    if (b_0 && c_0) {
+        value += volume[offset + b * stride.y + c * stride.z] * (1.0f - weight.x) * (1.0f - weight.y);
+    }
+    if (b_1 && c_0) {
+        value += volume[offset + (b + 1) * stride.y + c * stride.z] * weight.x * (1.0f - weight.y);
+    }
+    if (b_0 && c_1) {
+        value += volume[offset + b * stride.y + (c + 1) * stride.z] * (1.0f - weight.x) * weight.y;
+    }
+    if (b_1 && c_1) {
+        value += volume[offset + (b + 1) * stride.y + (c + 1) * stride.z] * weight.x * weight.y;
+    }
+
+    return value;
+}
+
+/* Narrow [*first, *last] to the planes where a coordinate is within reach */
+static void
+clip_planes (const float start, const float slope, const int size, float *first, float *last)
+{
+    float a, b;
+
+    if (slope == 0.0f) {
+        if (start <= -1.0f || start >= size) {
+            *last = -1.0f;
+        }
+        return;
+    }
+
+    a = (-1.0f - start) / slope;
+    b = (size - start) / slope;
+    *first = fmax (*first, ceil (fmin (a, b)));
+    *last = fmin (*last, floor (fmax (a, b)));
+}
+
+/*
+ * Joseph's method, the ray steps through the planes of the axis it is most
+ * parallel to and interpolates bilinearly within every plane. One work item
+ * computes one detector pixel of one projection.
+ */
+kernel void
+general_forwardproject (global const float *volume,
+                        global float *projections,
+                        global const float4 *rays,
+                        const int3 volume_size)
+{
+    const int idx = get_global_id (0);
+    const int idy = get_global_id (1);
+    const int idz = get_global_id (2);
+    global const float4 *ray = rays + 6 * idz;
+    const float u = idx + 0.5f;
+    const float v = idy + 0.5f;
+    const float3 origin = ray[0].xyz + u * ray[1].xyz + v * ray[2].xyz;
+    const float3 direction = ray[3].xyz + u * ray[4].xyz + v * ray[5].xyz;
+    const float3 magnitude = fabs (direction);
+    float3 o, d;
+    int3 size, stride;
+    float2 slope, start;
+    float first, last, sum = 0.0f;
+
+    /* Reorder the axes so that x is the dominant one */
+    if (magnitude.x >= magnitude.y && magnitude.x >= magnitude.z) {
+        o = origin;
+        d = direction;
+        size = volume_size;
+        stride = (int3) (1, volume_size.x, volume_size.x * volume_size.y);
+    } else if (magnitude.y >= magnitude.z) {
+        o = origin.yxz;
+        d = direction.yxz;
+        size = volume_size.yxz;
+        stride = (int3) (volume_size.x, 1, volume_size.x * volume_size.y);
+    } else {
+        o = origin.zxy;
+        d = direction.zxy;
+        size = volume_size.zxy;
+        stride = (int3) (volume_size.x * volume_size.y, 1, volume_size.x);
+    }
+
+    /* Position of the ray in the other two coordinates at plane 0 */
+    slope = d.yz / d.x;
+    start = o.yz - o.x * slope;
+    first = 0.0f;
+    last = size.x - 1;
+    clip_planes (start.x, slope.x, size.y, &first, &last);
+    clip_planes (start.y, slope.y, size.z, &first, &last);
+
+    for (int plane = (int) first; plane <= (int) last; plane++) {
+        sum += interpolate (volume, size, stride, plane, start + plane * slope);
+    }
+
+    /* Every plane stands for the length of the ray between two planes */
+    projections[(idz * get_global_size (1) + idy) * get_global_size (0) + idx] = sum * length (d) / fabs (d.x);
+}
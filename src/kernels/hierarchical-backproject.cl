@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Every level of the hierarchy holds one sinogram per sub-image. Sub-image
+ * (x, y) of a level with grid sub-images per side is centered at
+ * ((x, y) + 0.5) * size - shift relative to the rotation axis, the detector
+ * coordinate s of a sinogram is sampled at index s * sampling + center.
+ */
+
+static float
+interpolate (global const float *row, const int width, const float position)
+{
+    const float left = floor (position);
+    const float weight = position - left;
+    const int index = (int) left;
+    float value = 0.0f;
+
+    if (index >= 0 && index < width) {
+        value += row[index] * (1.0f - weight);
+    }
+    if (index + 1 >= 0 && index + 1 < width) {
+        value += row[index + 1] * weight;
+    }
+
+    return value;
+}
+
+static float2
+get_center (const int index, const int grid, const float size, const float shift)
+{
+    return ((float2) ((float) (index % grid), (float) (index / grid)) + 0.5f) * size - shift;
+}
+
+/*
+ * Compute the sinograms of the four quadrants of every parent sub-image. The
+ * sinogram of a quadrant is the sum of @decimation adjacent parent angles
+ * shifted by the projection of the quadrant center offset.
+ */
+kernel void
+hierarchical_decompose (global const float *parent,
+                        global float *child,
+                        global const float2 *parent_angles,
+                        const int parent_num_angles,
+                        const int parent_width,
+                        const int parent_grid,
+                        const float parent_size,
+                        const float parent_shift,
+                        const float parent_sampling,
+                        const float parent_center,
+                        const int child_grid,
+                        const float child_size,
+                        const float child_shift,
+                        const float child_sampling,
+                        const float child_center,
+                        const int decimation)
+{
+    const int idx = get_global_id (0);
+    const int angle = get_global_id (1);
+    const int index = get_global_id (2);
+    const int width = get_global_size (0);
+    const int num_angles = get_global_size (1);
+    const int x = index % child_grid * parent_grid / child_grid;
+    const int y = index / child_grid * parent_grid / child_grid;
+    const int parent_index = y * parent_grid + x;
+    const float2 offset = get_center (index, child_grid, child_size, child_shift) -
+                          get_center (parent_index, parent_grid, parent_size, parent_shift);
+    const float s = (idx - child_center) / child_sampling;
+    const int last = min ((angle + 1) * decimation, parent_num_angles);
+    global const float *sinogram = parent + parent_index * parent_num_angles * parent_width;
+    float sum = 0.0f;
+
+    for (int k = angle * decimation; k < last; k++) {
+        sum += interpolate (sinogram + k * parent_width, parent_width,
+                            mad (s + dot (offset, parent_angles[k]), parent_sampling, parent_center));
+    }
+
+    child[(index * num_angles + angle) * width + idx] = sum;
+}
+
+/*
+ * Backproject the sinograms of the finest level into their sub-images and
+ * write the slice cropped to its actual size.
+ */
+kernel void
+hierarchical_backproject (global const float *sinograms,
+                          global float *slice,
+                          global const float2 *angles,
+                          const int num_angles,
+                          const int width,
+                          const int grid,
+                          const float size,
+                          const float shift,
+                          const float sampling,
+                          const float center,
+                          const float axis_pos,
+                          const float norm)
+{
+    const int idx = get_global_id (0);
+    const int idy = get_global_id (1);
+    const int index = (int) (idy / size) * grid + (int) (idx / size);
+    const float2 voxel = (float2) ((float) idx, (float) idy) + 0.5f - axis_pos - get_center (index, grid, size, shift);
+    global const float *sinogram = sinograms + index * num_angles * width;
+    float sum = 0.0f;
+
+    for (int k = 0; k < num_angles; k++) {
+        sum += interpolate (sinogram + k * width, width, mad (dot (voxel, angles[k]), sampling, center));
+    }
+
+    slice[idy * get_global_size (0) + idx] = sum * norm;
+}
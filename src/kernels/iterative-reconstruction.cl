@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Matched projector pair for parallel beam geometry. The projector is
+ * Joseph's method, i.e. a ray steps along the dominant axis and interpolates
+ * linearly between the two nearest pixels of every row or column. The
+ * backprojector gathers exactly the same weights for every pixel, which are
+ * a triangle of half-width max(|cos|, |sin|) in detector coordinates, so that
+ * both are transposes of each other. Slices are square with the size of the
+ * detector width and centered at the rotation axis. Angle subsets are given by
+ * the first angle and the stride between successive angles.
+ */
+
+kernel void
+ir_project (global const float *image,
+            global const float *reference,
+            global float *sinogram,
+            constant float2 *angles,
+            const int first,
+            const int stride,
+            const float axis_pos,
+            const int residual)
+{
+    const int idx = get_global_id (0);
+    const int width = get_global_size (0);
+    const int angle = first + get_global_id (1) * stride;
+    const int index = angle * width + idx;
+    const float2 direction = angles[angle];
+    const float t = idx + 0.5f - axis_pos;
+    const int along_rows = fabs (direction.x) >= fabs (direction.y);
+    const float step = along_rows ? direction.x : direction.y;
+    const float other = along_rows ? direction.y : direction.x;
+    float sum = 0.0f, weight = 0.0f;
+
+    for (int i = 0; i < width; i++) {
+        const float position = (t - (i + 0.5f - axis_pos) * other) / step + axis_pos - 0.5f;
+        const float left = floor (position);
+        const float fraction = position - left;
+        const int j = (int) left;
+
+        if (j >= 0 && j < width) {
+            sum += image[along_rows ? i * width + j : j * width + i] * (1.0f - fraction);
+            weight += 1.0f - fraction;
+        }
+        if (j + 1 >= 0 && j + 1 < width) {
+            sum += image[along_rows ? i * width + j + 1 : (j + 1) * width + i] * fraction;
+            weight += fraction;
+        }
+    }
+
+    /* Every sample stands for the step length along the ray */
+    sum /= fabs (step);
+    weight /= fabs (step);
+
+    if (residual) {
+        /* Normalized by the row sum, rays missing the slice do not contribute */
+        sinogram[index] = weight > 0.0f ? (reference[index] - sum) / weight : 0.0f;
+    }
+    else {
+        sinogram[index] = sum;
+    }
+}
+
+/* Returns the backprojected sum and the sum of the weights of one pixel */
+static float2
+backproject_pixel (global const float *sinogram,
+                   constant float2 *angles,
+                   const int first,
+                   const int stride,
+                   const int num_angles,
+                   const float axis_pos)
+{
+    const int width = get_global_size (0);
+    const float2 voxel = (float2) ((float) get_global_id (0), (float) get_global_id (1)) + 0.5f - axis_pos;
+    float2 result = (float2) (0.0f, 0.0f);
+
+    for (int k = 0; k < num_angles; k++) {
+        const int angle = first + k * stride;
+        const float2 direction = angles[angle];
+        const float half_width = fmax (fabs (direction.x), fabs (direction.y));
+        const float position = dot (voxel, direction) + axis_pos - 0.5f;
+
+        for (int j = (int) ceil (position - half_width); j <= (int) floor (position + half_width); j++) {
+            if (j >= 0 && j < width) {
+                const float weight = fmax (0.0f, 1.0f - fabs (j - position) / half_width) / half_width;
+                result += (float2) (sinogram[angle * width + j], 1.0f) * weight;
+            }
+        }
+    }
+
+    return result;
+}
+
+kernel void
+ir_backproject (global const float *sinogram,
+                global float *image,
+                constant float2 *angles,
+                const int first,
+                const int stride,
+                const int num_angles,
+                const float axis_pos)
+{
+    const float2 result = backproject_pixel (sinogram, angles, first, stride, num_angles, axis_pos);
+
+    image[get_global_id (1) * get_global_size (0) + get_global_id (0)] = result.x;
+}
+
+/* SIRT update with the residual normalized by the row sums of the subset */
+kernel void
+ir_update (global const float *residual,
+           global float *image,
+           constant float2 *angles,
+           const int first,
+           const int stride,
+           const int num_angles,
+           const float axis_pos,
+           const float relaxation,
+           const int positivity)
+{
+    const int index = get_global_id (1) * get_global_size (0) + get_global_id (0);
+    const float2 result = backproject_pixel (residual, angles, first, stride, num_angles, axis_pos);
+    float value = image[index];
+
+    if (result.y > 0.0f) {
+        value += relaxation * result.x / result.y;
+    }
+
+    image[index] = positivity ? fmax (value, 0.0f) : value;
+}
+
+kernel void
+ir_axpy (global float *y,
+         global const float *x,
+         const float alpha)
+{
+    const int index = get_global_id (0);
+
+    y[index] = mad (alpha, x[index], y[index]);
+}
+
+kernel void
+ir_xpay (global float *y,
+         global const float *x,
+         const float beta)
+{
+    const int index = get_global_id (0);
+
+    y[index] = mad (beta, y[index], x[index]);
+}
+
+/* Partial dot products of every work group, summed up on the host */
+kernel void
+ir_dot (global const float *a,
+        global const float *b,
+        global float *partials,
+        local float *cache,
+        const int size)
+{
+    const int lid = get_local_id (0);
+    float sum = 0.0f;
+
+    for (int i = get_global_id (0); i < size; i += get_global_size (0)) {
+        sum += a[i] * b[i];
+    }
+
+    cache[lid] = sum;
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    for (int block = get_local_size (0) >> 1; block > 0; block >>= 1) {
+        if (lid < block) {
+            cache[lid] += cache[lid + block];
+        }
+        barrier (CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0) {
+        partials[get_group_id (0)] = cache[0];
+    }
+}
@@ -118,3 +118,16 @@ diff (global float *x,
     const size_t idx = get_global_id (1) * get_global_size (0) + get_global_id (0);
     output[idx] = x[idx] - y[idx];
 }
+
+kernel void
+convert_to_projection_image (global float *input,
+                             write_only image2d_t output,
+                             const float scale,
+                             const float offset)
+{
+    const int x = get_global_id (0);
+    const int y = get_global_id (1);
+
+    /* Conversion to unorm16 saturates to [0, 1] */
+    write_imagef (output, (int2) (x, y), (float4) ((input[y * get_global_size (0) + x] - offset) / scale));
+}
@@ -88,3 +88,15 @@ mult_by_value(global float *input, global float *values, global float *output)
      * same filter value. */
     output[idx] = input[idx] * values[idx >> 1];
 }
+
+/* Multiply a stack of complex spectra with a real filter whose rows may be
+ * wider than those of the spectra, i.e. Hermitian spectra of real input. */
+kernel void
+mult_by_filter(global float2 *data, global float *filter, const int filter_width)
+{
+    const int idx = get_global_id(0);
+    const int idy = get_global_id(1);
+    const int index = (get_global_id(2) * get_global_size(1) + idy) * get_global_size(0) + idx;
+
+    data[index] *= filter[idy * filter_width + idx];
+}
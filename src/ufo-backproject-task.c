@@ -24,6 +24,7 @@
 #endif
 
 #include <math.h>
+#include "common/ufo-tuning.h"
 #include "ufo-backproject-task.h"
 
 
@@ -39,9 +40,11 @@ static GEnumValue mode_values[] = {
 };
 
 struct _UfoBackprojectTaskPrivate {
+    UfoResources *resources;
     cl_context context;
     cl_kernel nearest_kernel;
     cl_kernel texture_kernel;
+    cl_kernel stack_kernel;
     cl_mem sin_lut;
     cl_mem cos_lut;
     gfloat *host_sin_lut;
@@ -59,6 +62,9 @@ struct _UfoBackprojectTaskPrivate {
     gint roi_width;
     gint roi_height;
     Mode mode;
+    gboolean autotune;
+    gboolean tuned;
+    gsize local_work_size[3];
 };
 
 static void ufo_task_interface_init (UfoTaskIface *iface);
@@ -81,6 +87,7 @@ enum {
     PROP_ROI_WIDTH,
     PROP_ROI_HEIGHT,
     PROP_MODE,
+    PROP_AUTOTUNE,
     N_PROPERTIES
 };
 
@@ -93,39 +100,43 @@ ufo_backproject_task_new (void)
 }
 
 static gboolean
-ufo_backproject_task_process (UfoTask *task,
-                              UfoBuffer **inputs,
-                              UfoBuffer *output,
-                              UfoRequisition *requisition)
+is_stack (UfoBuffer *input)
 {
-    UfoBackprojectTaskPrivate *priv;
-    UfoGpuNode *node;
-    UfoProfiler *profiler;
-    cl_command_queue cmd_queue;
-    cl_mem in_mem;
-    cl_mem out_mem;
-    cl_kernel kernel;
-    gfloat axis_pos;
+    UfoRequisition in_req;
 
-    priv = UFO_BACKPROJECT_TASK (task)->priv;
-    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
-    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
-    out_mem = ufo_buffer_get_device_array (output, cmd_queue);
+    ufo_buffer_get_requisition (input, &in_req);
+    return in_req.n_dims == 3;
+}
 
+static cl_kernel
+get_input_and_kernel (UfoBackprojectTaskPrivate *priv,
+                      UfoBuffer *input,
+                      cl_command_queue cmd_queue,
+                      cl_mem *in_mem)
+{
     if (priv->mode == MODE_TEXTURE) {
-        in_mem = ufo_buffer_get_device_image (inputs[0], cmd_queue);
-        kernel = priv->texture_kernel;
-    }
-    else {
-        in_mem = ufo_buffer_get_device_array (inputs[0], cmd_queue);
-        kernel = priv->nearest_kernel;
+        *in_mem = ufo_buffer_get_device_image (input, cmd_queue);
+        return is_stack (input) ? priv->stack_kernel : priv->texture_kernel;
     }
 
+    *in_mem = ufo_buffer_get_device_array (input, cmd_queue);
+    return priv->nearest_kernel;
+}
+
+static void
+set_kernel_args (UfoBackprojectTaskPrivate *priv,
+                 cl_kernel kernel,
+                 UfoBuffer *input,
+                 cl_mem in_mem,
+                 cl_mem out_mem)
+{
+    UfoRequisition in_req;
+    gfloat axis_pos;
+
+    ufo_buffer_get_requisition (input, &in_req);
+
     /* Guess axis position if they are not provided by the user. */
     if (priv->axis_pos <= 0.0) {
-        UfoRequisition in_req;
-
-        ufo_buffer_get_requisition (inputs[0], &in_req);
         axis_pos = (gfloat) ((gfloat) in_req.dims[0]) / 2.0f;
     }
     else {
@@ -142,8 +153,51 @@ ufo_backproject_task_process (UfoTask *task,
     UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 7, sizeof (guint),  &priv->burst_projections));
     UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 8, sizeof (gfloat), &axis_pos));
 
+    if (priv->mode != MODE_TEXTURE) {
+        /* The slice can be smaller than the sinograms, which are addressed by their own size */
+        guint sino_width = (guint) in_req.dims[0];
+        guint sino_height = (guint) in_req.dims[1];
+
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 9, sizeof (guint), &sino_width));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 10, sizeof (guint), &sino_height));
+    }
+}
+
+static void
+get_global_work_size (UfoRequisition *requisition, gsize *global_work_size)
+{
+    global_work_size[0] = requisition->dims[0];
+    global_work_size[1] = requisition->dims[1];
+    global_work_size[2] = requisition->n_dims == 3 ? requisition->dims[2] : 1;
+}
+
+static gboolean
+ufo_backproject_task_process (UfoTask *task,
+                              UfoBuffer **inputs,
+                              UfoBuffer *output,
+                              UfoRequisition *requisition)
+{
+    UfoBackprojectTaskPrivate *priv;
+    UfoGpuNode *node;
+    UfoProfiler *profiler;
+    cl_command_queue cmd_queue;
+    cl_mem in_mem;
+    cl_mem out_mem;
+    cl_kernel kernel;
+    gsize global_work_size[3];
+
+    priv = UFO_BACKPROJECT_TASK (task)->priv;
+    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
+    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
+    out_mem = ufo_buffer_get_device_array (output, cmd_queue);
+    kernel = get_input_and_kernel (priv, inputs[0], cmd_queue, &in_mem);
+    set_kernel_args (priv, kernel, inputs[0], in_mem, out_mem);
+
+    /* All sinograms of a stack are backprojected in one launch */
+    get_global_work_size (requisition, global_work_size);
     profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
-    ufo_profiler_call (profiler, cmd_queue, kernel, 2, requisition->dims, NULL);
+    ufo_profiler_call (profiler, cmd_queue, kernel, 3, global_work_size,
+                       priv->local_work_size[0] ? priv->local_work_size : NULL);
 
     return TRUE;
 }
@@ -157,9 +211,11 @@ ufo_backproject_task_setup (UfoTask *task,
 
     priv = UFO_BACKPROJECT_TASK_GET_PRIVATE (task);
 
+    priv->resources = g_object_ref (resources);
     priv->context = ufo_resources_get_context (resources);
     priv->nearest_kernel = ufo_resources_get_kernel (resources, "backproject.cl", "backproject_nearest", NULL, error);
     priv->texture_kernel = ufo_resources_get_kernel (resources, "backproject.cl", "backproject_tex", NULL, error);
+    priv->stack_kernel = ufo_resources_get_kernel (resources, "backproject.cl", "backproject_tex_stack", NULL, error);
 
     UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainContext (priv->context), error);
 
@@ -168,6 +224,9 @@ ufo_backproject_task_setup (UfoTask *task,
 
     if (priv->texture_kernel != NULL)
         UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->texture_kernel), error);
+
+    if (priv->stack_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->stack_kernel), error);
 }
 
 static cl_mem
@@ -208,6 +267,121 @@ release_lut_mems (UfoBackprojectTaskPrivate *priv)
     }
 }
 
+static const gchar *
+get_kernel_name (UfoBackprojectTaskPrivate *priv, gboolean stack)
+{
+    if (priv->mode == MODE_TEXTURE)
+        return stack ? "backproject_tex_stack" : "backproject_tex";
+
+    return "backproject_nearest";
+}
+
+static cl_kernel
+get_unrolled_kernel (UfoBackprojectTaskPrivate *priv, guint unroll, gboolean stack)
+{
+    cl_kernel kernel;
+    gchar *options;
+
+    options = g_strdup_printf ("-DUNROLL=%u", unroll);
+    kernel = ufo_resources_get_kernel (priv->resources, "backproject.cl",
+                                       get_kernel_name (priv, stack), options, NULL);
+    g_free (options);
+
+    return kernel;
+}
+
+static void
+autotune (UfoBackprojectTask *task,
+          UfoBuffer *input,
+          UfoRequisition *requisition)
+{
+    static const guint unrolls[] = {1, 2, 4, 8, 16};
+    static const gsize local_sizes[][3] = {{0, 0, 1}, {16, 16, 1}, {32, 8, 1}, {64, 4, 1}, {8, 8, 1}};
+    UfoBackprojectTaskPrivate *priv;
+    UfoGpuNode *node;
+    UfoRequisition in_req;
+    cl_command_queue cmd_queue;
+    cl_kernel kernel;
+    cl_mem in_mem, out_mem;
+    cl_int errcode;
+    gchar *device_key, *shape;
+    gsize global_work_size[3];
+    gboolean stack;
+    gint best[3] = {0, 0, 0};
+    gdouble best_time = G_MAXDOUBLE;
+
+    priv = task->priv;
+    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
+    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
+    ufo_buffer_get_requisition (input, &in_req);
+    get_global_work_size (requisition, global_work_size);
+    stack = is_stack (input);
+
+    device_key = ufo_tuning_get_device_key (ufo_gpu_node_get_device (node));
+    shape = g_strdup_printf ("%s %zux%zu %zux%zux%zu", mode_values[priv->mode].value_nick,
+                             in_req.dims[0], in_req.dims[1],
+                             global_work_size[0], global_work_size[1], global_work_size[2]);
+
+    if (!ufo_tuning_lookup ("backproject", device_key, shape, best, 3)) {
+        out_mem = clCreateBuffer (priv->context, CL_MEM_WRITE_ONLY,
+                                  global_work_size[0] * global_work_size[1] * global_work_size[2] * sizeof (gfloat),
+                                  NULL, &errcode);
+        UFO_RESOURCES_CHECK_CLERR (errcode);
+
+        for (guint i = 0; i < G_N_ELEMENTS (unrolls); i++) {
+            if ((kernel = get_unrolled_kernel (priv, unrolls[i], stack)) == NULL)
+                continue;
+
+            get_input_and_kernel (priv, input, cmd_queue, &in_mem);
+            set_kernel_args (priv, kernel, input, in_mem, out_mem);
+
+            for (guint j = 0; j < G_N_ELEMENTS (local_sizes); j++) {
+                gdouble elapsed;
+
+                /* The kernel relies on the global size matching the slice */
+                if (local_sizes[j][0] && (requisition->dims[0] % local_sizes[j][0] ||
+                                          requisition->dims[1] % local_sizes[j][1]))
+                    continue;
+
+                elapsed = ufo_tuning_time_kernel (cmd_queue, kernel, 3, global_work_size,
+                                                  local_sizes[j][0] ? local_sizes[j] : NULL, 5);
+                g_debug ("backproject: unroll %u, local size %zux%zu: %g s",
+                         unrolls[i], local_sizes[j][0], local_sizes[j][1], elapsed);
+
+                if (elapsed < best_time) {
+                    best_time = elapsed;
+                    best[0] = unrolls[i];
+                    best[1] = local_sizes[j][0];
+                    best[2] = local_sizes[j][1];
+                }
+            }
+        }
+
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (out_mem));
+
+        if (best[0])
+            ufo_tuning_store ("backproject", device_key, shape, best, 3);
+    }
+
+    if (best[0] && (kernel = get_unrolled_kernel (priv, best[0], stack)) != NULL) {
+        cl_kernel *current = priv->mode == MODE_TEXTURE ?
+                             (stack ? &priv->stack_kernel : &priv->texture_kernel) : &priv->nearest_kernel;
+
+        g_debug ("backproject: using unroll %d, local size %dx%d", best[0], best[1], best[2]);
+        UFO_RESOURCES_CHECK_CLERR (clRetainKernel (kernel));
+
+        if (*current != NULL)
+            UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (*current));
+
+        *current = kernel;
+        priv->local_work_size[0] = best[1];
+        priv->local_work_size[1] = best[2];
+    }
+
+    g_free (shape);
+    g_free (device_key);
+}
+
 static void
 ufo_backproject_task_get_requisition (UfoTask *task,
                                       UfoBuffer **inputs,
@@ -235,13 +409,17 @@ ufo_backproject_task_get_requisition (UfoTask *task,
         return;
     }
 
-    requisition->n_dims = 2;
+    /* A stack of sinograms is reconstructed into a stack of slices */
+    requisition->n_dims = in_req.n_dims == 3 ? 3 : 2;
 
     /* TODO: we should check here, that we might access data outside the
      * projections */
     requisition->dims[0] = priv->roi_width == 0 ? in_req.dims[0] : (gsize) priv->roi_width;
     requisition->dims[1] = priv->roi_height == 0 ? in_req.dims[0] : (gsize) priv->roi_height;
 
+    if (requisition->n_dims == 3)
+        requisition->dims[2] = in_req.dims[2];
+
     if (priv->real_angle_step < 0.0) {
         if (priv->angle_step <= 0.0)
             priv->real_angle_step = G_PI / ((gdouble) priv->n_projections);
@@ -263,6 +441,11 @@ ufo_backproject_task_get_requisition (UfoTask *task,
         priv->cos_lut = create_lut_buffer (priv, &priv->host_cos_lut,
                                            priv->n_projections, cos);
     }
+
+    if (priv->autotune && !priv->tuned) {
+        autotune (UFO_BACKPROJECT_TASK (task), inputs[0], requisition);
+        priv->tuned = TRUE;
+    }
 }
 
 static guint
@@ -315,11 +498,21 @@ ufo_backproject_task_finalize (GObject *object)
         priv->texture_kernel = NULL;
     }
 
+    if (priv->stack_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->stack_kernel));
+        priv->stack_kernel = NULL;
+    }
+
     if (priv->context) {
         UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
         priv->context = NULL;
     }
 
+    if (priv->resources) {
+        g_object_unref (priv->resources);
+        priv->resources = NULL;
+    }
+
     G_OBJECT_CLASS (ufo_backproject_task_parent_class)->finalize (object);
 }
 
@@ -374,6 +567,9 @@ ufo_backproject_task_set_property (GObject *object,
         case PROP_ROI_HEIGHT:
             priv->roi_height = g_value_get_uint (value);
             break;
+        case PROP_AUTOTUNE:
+            priv->autotune = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -419,6 +615,9 @@ ufo_backproject_task_get_property (GObject *object,
         case PROP_ROI_HEIGHT:
             g_value_set_uint (value, priv->roi_height);
             break;
+        case PROP_AUTOTUNE:
+            g_value_set_boolean (value, priv->autotune);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
             break;
@@ -508,6 +707,13 @@ ufo_backproject_task_class_init (UfoBackprojectTaskClass *klass)
             0, G_MAXUINT, 0,
             G_PARAM_READWRITE);
 
+    properties[PROP_AUTOTUNE] =
+        g_param_spec_boolean ("autotune",
+            "Benchmark unroll factors and work group sizes on the device",
+            "Benchmark unroll factors and work group sizes on the device",
+            FALSE,
+            G_PARAM_READWRITE);
+
     for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (oclass, i, properties[i]);
 
@@ -523,6 +729,7 @@ ufo_backproject_task_init (UfoBackprojectTask *self)
     self->priv = priv = UFO_BACKPROJECT_TASK_GET_PRIVATE (self);
     priv->nearest_kernel = NULL;
     priv->texture_kernel = NULL;
+    priv->stack_kernel = NULL;
     priv->n_projections = 0;
     priv->offset = 0;
     priv->axis_pos = -1.0;
@@ -537,4 +744,9 @@ ufo_backproject_task_init (UfoBackprojectTask *self)
     priv->luts_changed = TRUE;
     priv->roi_x = priv->roi_y = 0;
     priv->roi_width = priv->roi_height = 0;
+    priv->resources = NULL;
+    priv->autotune = FALSE;
+    priv->tuned = FALSE;
+    priv->local_work_size[0] = priv->local_work_size[1] = 0;
+    priv->local_work_size[2] = 1;
 }
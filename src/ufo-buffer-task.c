@@ -17,7 +17,12 @@
  * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <glib/gstdio.h>
 #include "ufo-buffer-task.h"
 
 /**
@@ -27,8 +32,18 @@
  *
  * Read input data until stream ends into a local memory buffer. After that
  * output the stream again.
+ *
+ * Data is stored in pages of #UfoBufferTask:number elements. Once the pages
+ * exceed #UfoBufferTask:memory-limit, further pages are placed in extents of
+ * SPILL_EXTENT_SIZE bytes memory-mapped from an unlinked scratch file in
+ * #UfoBufferTask:spill-path, so that streams larger than the main memory can
+ * be buffered and replayed. If the scratch file cannot grow, a warning is
+ * emitted and the remaining pages are kept in memory.
  */
 
+/* Large extents keep the number of mappings far below vm.max_map_count */
+#define SPILL_EXTENT_SIZE   (256 << 20)
+
 struct _UfoMetaData
 {
     GValue *value;
@@ -47,14 +62,22 @@ struct _UfoArray
 typedef struct _UfoArray UfoArray;
 
 struct _UfoBufferTaskPrivate {
-    guchar *data;
-    UfoArray **metadata;
+    GPtrArray *pages;
+    GArray *mapped;
+    GPtrArray *metadata;
     guint n_prealloc;
     gsize n_elements;
     gsize current_element;
     gsize size;
-    gsize current_size;
-    gsize meta_current_size;
+    GPtrArray *extents;
+    gsize extent_size;
+    gsize extent_used;
+    guint n_ram_pages;
+    guint memory_limit;
+    gchar *spill_path;
+    gint spill_fd;
+    gsize spill_size;
+    gboolean spill_failed;
     gsize dup_count;
     gsize loop;
     gsize dup_current;
@@ -73,6 +96,8 @@ enum {
     PROP_NUM_PREALLOC,
     PROP_DUP_COUNT,
     PROP_LOOP,
+    PROP_MEMORY_LIMIT,
+    PROP_SPILL_PATH,
     N_PROPERTIES
 };
 
@@ -89,6 +114,28 @@ ufo_buffer_task_setup (UfoTask *task,
                        UfoResources *resources,
                        GError **error)
 {
+    UfoBufferTaskPrivate *priv;
+    gchar *template;
+
+    priv = UFO_BUFFER_TASK_GET_PRIVATE (task);
+
+    if (priv->memory_limit == 0 || priv->spill_fd >= 0)
+        return;
+
+    template = g_build_filename (priv->spill_path != NULL ? priv->spill_path : g_get_tmp_dir (),
+                                 "ufo-buffer-XXXXXX", NULL);
+    priv->spill_fd = g_mkstemp (template);
+
+    if (priv->spill_fd < 0) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "Could not create spill file `%s': %s", template, g_strerror (errno));
+    }
+    else {
+        /* The file lives as long as the descriptor */
+        g_unlink (template);
+    }
+
+    g_free (template);
 }
 
 static void
@@ -124,6 +171,121 @@ ufo_buffer_task_get_mode (UfoTask *task)
     return UFO_TASK_MODE_REDUCTOR | UFO_TASK_MODE_CPU;
 }
 
+static guchar *
+get_element (UfoBufferTaskPrivate *priv, gsize index)
+{
+    guchar *page;
+
+    page = g_ptr_array_index (priv->pages, index / priv->n_prealloc);
+    return page + (index % priv->n_prealloc) * priv->size;
+}
+
+static guchar *
+map_spill_extent (UfoBufferTaskPrivate *priv, gsize page_bytes)
+{
+    gsize system_page_size;
+    guchar *extent;
+    gint err;
+
+    /* Map offsets must be aligned to the system page size */
+    system_page_size = sysconf (_SC_PAGESIZE);
+    priv->extent_size = MAX (SPILL_EXTENT_SIZE, page_bytes);
+    priv->extent_size = ((priv->extent_size + system_page_size - 1) / system_page_size) * system_page_size;
+
+    /*
+     * Reserve the blocks now, a sparse file running out of disk space would
+     * only fail with SIGBUS when the mapping is written.
+     */
+    err = posix_fallocate (priv->spill_fd, priv->spill_size, priv->extent_size);
+
+    if (err != 0) {
+        g_warning ("Could not grow spill file, keeping further data in memory: %s", g_strerror (err));
+        return NULL;
+    }
+
+    extent = mmap (NULL, priv->extent_size, PROT_READ | PROT_WRITE, MAP_SHARED, priv->spill_fd, priv->spill_size);
+
+    if (extent == MAP_FAILED) {
+        g_warning ("Could not map spill file, keeping further data in memory: %s", g_strerror (errno));
+        return NULL;
+    }
+
+    priv->spill_size += priv->extent_size;
+    priv->extent_used = 0;
+    g_ptr_array_add (priv->extents, extent);
+    return extent;
+}
+
+static guchar *
+map_spill_page (UfoBufferTaskPrivate *priv)
+{
+    gsize page_bytes;
+    guchar *extent;
+
+    page_bytes = priv->n_prealloc * priv->size;
+
+    if (priv->extents->len == 0 || priv->extent_used + page_bytes > priv->extent_size) {
+        if (map_spill_extent (priv, page_bytes) == NULL)
+            return NULL;
+    }
+
+    extent = g_ptr_array_index (priv->extents, priv->extents->len - 1);
+    priv->extent_used += page_bytes;
+
+    return extent + priv->extent_used - page_bytes;
+}
+
+static void
+add_page (UfoBufferTaskPrivate *priv)
+{
+    gsize ram_size;
+    gboolean mapped = FALSE;
+    guchar *page = NULL;
+
+    ram_size = ((gsize) priv->n_ram_pages) * priv->n_prealloc * priv->size;
+
+    if (priv->spill_fd >= 0 && !priv->spill_failed &&
+        ram_size + priv->n_prealloc * priv->size > ((gsize) priv->memory_limit) << 20) {
+        page = map_spill_page (priv);
+        mapped = page != NULL;
+        priv->spill_failed = page == NULL;
+    }
+
+    if (page == NULL) {
+        page = g_malloc (priv->n_prealloc * priv->size);
+        priv->n_ram_pages++;
+    }
+
+    g_ptr_array_add (priv->pages, page);
+    g_array_append_val (priv->mapped, mapped);
+}
+
+static void
+free_pages (UfoBufferTaskPrivate *priv)
+{
+    /* Mapped pages are released with their extents */
+    for (guint i = 0; i < priv->pages->len; i++) {
+        if (!g_array_index (priv->mapped, gboolean, i))
+            g_free (g_ptr_array_index (priv->pages, i));
+    }
+
+    for (guint i = 0; i < priv->extents->len; i++)
+        munmap (g_ptr_array_index (priv->extents, i), priv->extent_size);
+
+}
+
+static void
+free_metadata (UfoArray *metadata)
+{
+    for (unsigned j = 0; j < metadata->nb_elt; ++j) {
+        g_value_unset (metadata->data[j].value);
+        g_free (metadata->data[j].value);
+        g_free (metadata->data[j].name);
+    }
+
+    g_free (metadata);
+}
+
 static void
 ufo_buffer_task_copy_metadata_out (UfoTask *task, UfoBuffer *output)
 {
@@ -132,7 +294,7 @@ ufo_buffer_task_copy_metadata_out (UfoTask *task, UfoBuffer *output)
 
     priv = UFO_BUFFER_TASK_GET_PRIVATE (task);
 
-    meta = priv->metadata[priv->current_element];
+    meta = g_ptr_array_index (priv->metadata, priv->current_element);
 
     for (unsigned i = 0; i < meta->nb_elt; ++i) {
         ufo_buffer_set_metadata (output, meta->data[i].name, meta->data[i].value);
@@ -165,7 +327,8 @@ ufo_buffer_task_copy_metadata_in (UfoTask *task, UfoBuffer *input)
         meta->data[idx].name = g_strdup (it->data);
         ++idx;
     }
-    priv->metadata[priv->n_elements] = meta;
+    g_list_free (names);
+    g_ptr_array_add (priv->metadata, meta);
 }
 
 static gboolean
@@ -178,25 +341,11 @@ ufo_buffer_task_process (UfoTask *task,
 
     priv = UFO_BUFFER_TASK_GET_PRIVATE (task);
 
-    if (priv->data == NULL) {
-        priv->current_size = priv->n_prealloc * priv->size;
-        priv->data = g_malloc0 (priv->current_size);
-    }
-    if (priv->metadata == NULL) {
-        priv->meta_current_size = priv->n_prealloc * sizeof (UfoMetadata *);
-        priv->metadata = g_malloc0 (priv->current_size);
-    }
-
-    if (priv->current_size <= priv->n_elements * priv->size) {
-        priv->current_size *= 2;
-        priv->data = g_realloc (priv->data, priv->current_size);
-    }
-    if (priv->meta_current_size <= priv->n_elements * sizeof (UfoMetadata *)) {
-        priv->meta_current_size *= 2;
-        priv->metadata = g_realloc (priv->metadata, priv->meta_current_size);
-    }
+    /* Grow page-wise instead of doubling to avoid transient copies */
+    if (priv->n_elements == priv->pages->len * priv->n_prealloc)
+        add_page (priv);
 
-    g_memmove (priv->data + priv->n_elements * priv->size,
+    g_memmove (get_element (priv, priv->n_elements),
                ufo_buffer_get_host_array (inputs[0], NULL),
                priv->size);
 
@@ -227,7 +376,7 @@ ufo_buffer_task_generate (UfoTask *task,
         return FALSE;
 
     g_memmove (ufo_buffer_get_host_array (output, NULL),
-               priv->data + priv->current_element * priv->size,
+               get_element (priv, priv->current_element),
                priv->size);
     ufo_buffer_task_copy_metadata_out (task, output);
 
@@ -249,26 +398,19 @@ ufo_buffer_task_finalize (GObject *object)
 
     priv = UFO_BUFFER_TASK_GET_PRIVATE (object);
 
-    if (priv->data != NULL) {
-        g_free (priv->data);
-        priv->data = NULL;
-    }
-    if (priv->metadata) {
-        for (unsigned i = 0; i < priv->n_elements; ++i) {
-            UfoArray *metadata = priv->metadata[i];
-            for (unsigned j = 0; j < metadata->nb_elt; ++j) {
-                g_free (metadata->data[j].value);
-                metadata->data[j].value = NULL;
-                g_free (metadata->data[j].name);
-                metadata->data[j].name = NULL;
-            }
-            g_free (priv->metadata[i]);
-            priv->metadata[i] = NULL;
-        }
-        g_free (priv->metadata);
-        priv->metadata = NULL;
+    free_pages (priv);
+    g_ptr_array_free (priv->pages, TRUE);
+    g_array_free (priv->mapped, TRUE);
+    g_ptr_array_free (priv->extents, TRUE);
+    g_ptr_array_free (priv->metadata, TRUE);
+
+    if (priv->spill_fd >= 0) {
+        close (priv->spill_fd);
+        priv->spill_fd = -1;
     }
 
+    g_free (priv->spill_path);
+
     G_OBJECT_CLASS (ufo_buffer_task_parent_class)->finalize (object);
 }
 
@@ -292,6 +434,13 @@ ufo_buffer_task_set_property (GObject *object,
         case PROP_LOOP:
             priv->loop = (gboolean) g_value_get_boolean (value);
             break;
+        case PROP_MEMORY_LIMIT:
+            priv->memory_limit = g_value_get_uint (value);
+            break;
+        case PROP_SPILL_PATH:
+            g_free (priv->spill_path);
+            priv->spill_path = g_value_dup_string (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -318,6 +467,12 @@ ufo_buffer_task_get_property (GObject *object,
         case PROP_LOOP:
             g_value_set_boolean (value, priv->loop);
             break;
+        case PROP_MEMORY_LIMIT:
+            g_value_set_uint (value, priv->memory_limit);
+            break;
+        case PROP_SPILL_PATH:
+            g_value_set_string (value, priv->spill_path);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -347,8 +502,8 @@ ufo_buffer_task_class_init (UfoBufferTaskClass *klass)
 
     properties[PROP_NUM_PREALLOC] =
         g_param_spec_uint ("number",
-            "Number of pre-allocated \"pages\"",
-            "Number of pre-allocated \"pages\"",
+            "Number of elements per allocated \"page\"",
+            "Number of elements per allocated \"page\"",
             1, 4096, 4,
             G_PARAM_READWRITE);
 
@@ -366,6 +521,20 @@ ufo_buffer_task_class_init (UfoBufferTaskClass *klass)
             0,
             G_PARAM_READWRITE);
 
+    properties[PROP_MEMORY_LIMIT] =
+        g_param_spec_uint ("memory-limit",
+            "Memory in MB used before pages are spilled to disk, 0 disables spilling",
+            "Memory in MB used before pages are spilled to disk, 0 disables spilling",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_SPILL_PATH] =
+        g_param_spec_string ("spill-path",
+            "Directory of the scratch file, by default the temporary directory",
+            "Directory of the scratch file, by default the temporary directory",
+            NULL,
+            G_PARAM_READWRITE);
+
     for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (oclass, i, properties[i]);
 
@@ -376,11 +545,22 @@ static void
 ufo_buffer_task_init(UfoBufferTask *self)
 {
     self->priv = UFO_BUFFER_TASK_GET_PRIVATE(self);
-    self->priv->data = NULL;
+    self->priv->pages = g_ptr_array_new ();
+    self->priv->mapped = g_array_new (FALSE, FALSE, sizeof (gboolean));
+    self->priv->extents = g_ptr_array_new ();
+    self->priv->extent_size = 0;
+    self->priv->extent_used = 0;
+    self->priv->metadata = g_ptr_array_new_with_free_func ((GDestroyNotify) free_metadata);
     self->priv->n_prealloc = 4;
     self->priv->n_elements = 0;
     self->priv->current_element = 0;
     self->priv->dup_count = 1;
     self->priv->loop = 0;
     self->priv->dup_current = 1;
+    self->priv->n_ram_pages = 0;
+    self->priv->memory_limit = 0;
+    self->priv->spill_path = NULL;
+    self->priv->spill_fd = -1;
+    self->priv->spill_size = 0;
+    self->priv->spill_failed = FALSE;
 }
@@ -17,12 +17,26 @@
  * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
 #include <gmodule.h>
 #include <uca/uca-plugin-manager.h>
 #include <uca/uca-camera.h>
 
 #include "ufo-camera-task.h"
 
+/**
+ * SECTION:ufo-camera-task
+ * @Short_description: Grab frames from a libuca camera
+ * @Title: camera
+ *
+ * Records frames with a libuca camera. If #UfoCameraTask:ring-size is larger
+ * than zero, a separate grabber thread keeps calling uca_camera_grab() into a
+ * ring of host buffers, independently of how fast downstream tasks consume
+ * frames. Frames that arrive while the ring is full are grabbed but discarded
+ * and counted in #UfoCameraTask:dropped-frames. In both modes,
+ * #UfoCameraTask:number is the number of frames passed downstream and 0 records
+ * until grabbing fails.
+ */
 
 struct _UfoCameraTaskPrivate {
     UcaPluginManager *pm;
@@ -34,6 +48,23 @@ struct _UfoCameraTaskPrivate {
     guint       n_bits;
     gchar      *name;
     gchar      *properties;
+
+    /* Asynchronous grabbing */
+    guint       ring_size;
+    gsize       frame_size;
+    gpointer   *ring;
+    gpointer    scratch;
+    GThread    *grabber;
+    GMutex      lock;
+    GCond       cond;
+    guint       read_index;
+    guint       n_filled;
+    gboolean    running;
+    gboolean    grabber_done;
+    GError     *grab_error;
+    guint64     grabbed;
+    guint64     dropped;
+    guint       max_filled;
 };
 
 static void ufo_task_interface_init (UfoTaskIface *iface);
@@ -50,6 +81,10 @@ enum {
     PROP_CAMERA_NAME,
     PROP_COUNT,
     PROP_PROPERTIES,
+    PROP_RING_SIZE,
+    PROP_GRABBED_FRAMES,
+    PROP_DROPPED_FRAMES,
+    PROP_MAX_FILL_LEVEL,
     N_PROPERTIES
 };
 
@@ -93,6 +128,106 @@ create_camera (UcaPluginManager *pm,
     return camera;
 }
 
+static gpointer
+grab_frames (UfoCameraTaskPrivate *priv)
+{
+    guint stored = 0;
+    guint write_index = 0;
+
+    while (priv->count == 0 || stored < priv->count) {
+        GError *error = NULL;
+        gboolean full;
+        gpointer data;
+
+        g_mutex_lock (&priv->lock);
+
+        if (!priv->running) {
+            g_mutex_unlock (&priv->lock);
+            break;
+        }
+
+        full = priv->n_filled == priv->ring_size;
+        g_mutex_unlock (&priv->lock);
+
+        /* Keep the camera going even if nobody takes our frames */
+        data = full ? priv->scratch : priv->ring[write_index];
+        uca_camera_grab (priv->camera, data, &error);
+
+        if (error != NULL) {
+            g_mutex_lock (&priv->lock);
+            priv->grab_error = error;
+            g_mutex_unlock (&priv->lock);
+            break;
+        }
+
+        g_mutex_lock (&priv->lock);
+        priv->grabbed++;
+
+        if (full) {
+            priv->dropped++;
+        }
+        else {
+            priv->n_filled++;
+            priv->max_filled = MAX (priv->max_filled, priv->n_filled);
+            write_index = (write_index + 1) % priv->ring_size;
+            stored++;
+            g_cond_signal (&priv->cond);
+        }
+
+        g_mutex_unlock (&priv->lock);
+    }
+
+    g_mutex_lock (&priv->lock);
+    priv->grabber_done = TRUE;
+    g_cond_signal (&priv->cond);
+    g_mutex_unlock (&priv->lock);
+
+    return NULL;
+}
+
+static void
+stop_grabber (UfoCameraTaskPrivate *priv)
+{
+    if (priv->grabber == NULL)
+        return;
+
+    g_mutex_lock (&priv->lock);
+    priv->running = FALSE;
+    g_mutex_unlock (&priv->lock);
+
+    g_thread_join (priv->grabber);
+    priv->grabber = NULL;
+}
+
+static void
+free_ring (UfoCameraTaskPrivate *priv)
+{
+    if (priv->ring != NULL) {
+        for (guint i = 0; i < priv->ring_size; i++)
+            g_free (priv->ring[i]);
+
+        g_free (priv->ring);
+        priv->ring = NULL;
+    }
+
+    g_free (priv->scratch);
+    priv->scratch = NULL;
+}
+
+static void
+allocate_ring (UfoCameraTaskPrivate *priv)
+{
+    /*
+     * Frames are copied into the output buffer anyway, page-locked memory
+     * would not speed up anything here.
+     */
+    priv->ring = g_new0 (gpointer, priv->ring_size);
+    priv->scratch = g_malloc (priv->frame_size);
+
+    for (guint i = 0; i < priv->ring_size; i++)
+        priv->ring[i] = g_malloc (priv->frame_size);
+}
+
 static void
 ufo_camera_task_setup (UfoTask *task,
                        UfoResources *resources,
@@ -100,6 +235,7 @@ ufo_camera_task_setup (UfoTask *task,
 {
     UfoCameraTask *node;
     UfoCameraTaskPrivate *priv;
+    GError *tmp_error = NULL;
 
     node = UFO_CAMERA_TASK (task);
     priv = node->priv;
@@ -107,7 +243,6 @@ ufo_camera_task_setup (UfoTask *task,
     priv->pm = uca_plugin_manager_new ();
 
     if (priv->camera == NULL) {
-        GError *tmp_error = NULL;
         priv->camera = create_camera (priv->pm, priv->name, &tmp_error);
 
         if (tmp_error != NULL) {
@@ -137,7 +272,32 @@ ufo_camera_task_setup (UfoTask *task,
                   "sensor-bitdepth", &priv->n_bits,
                   NULL);
 
-    uca_camera_start_recording (priv->camera, error);
+    stop_grabber (priv);
+    uca_camera_start_recording (priv->camera, &tmp_error);
+
+    if (tmp_error != NULL) {
+        g_propagate_error (error, tmp_error);
+        return;
+    }
+
+    if (priv->ring_size > 0) {
+        guint bytes = priv->n_bits <= 8 ? 1 : (priv->n_bits <= 16 ? 2 : 4);
+
+        free_ring (priv);
+
+        priv->frame_size = ((gsize) priv->width) * priv->height * bytes;
+        priv->read_index = 0;
+        priv->n_filled = 0;
+        priv->grabbed = 0;
+        priv->dropped = 0;
+        priv->max_filled = 0;
+        priv->grabber_done = FALSE;
+        priv->running = TRUE;
+        g_clear_error (&priv->grab_error);
+
+        allocate_ring (priv);
+        priv->grabber = g_thread_new ("camera-grabber", (GThreadFunc) grab_frames, priv);
+    }
 }
 
 static void
@@ -174,6 +334,37 @@ ufo_camera_task_get_mode (UfoTask *task)
     return UFO_TASK_MODE_GENERATOR | UFO_TASK_MODE_CPU;
 }
 
+static gboolean
+generate_from_ring (UfoCameraTaskPrivate *priv, UfoBuffer *output)
+{
+    gpointer data;
+
+    g_mutex_lock (&priv->lock);
+
+    while (priv->n_filled == 0 && !priv->grabber_done)
+        g_cond_wait (&priv->cond, &priv->lock);
+
+    if (priv->n_filled == 0) {
+        if (priv->grab_error != NULL)
+            g_warning ("Could not grab frame: %s", priv->grab_error->message);
+
+        g_mutex_unlock (&priv->lock);
+        return FALSE;
+    }
+
+    data = priv->ring[priv->read_index];
+    g_mutex_unlock (&priv->lock);
+
+    memcpy (ufo_buffer_get_host_array (output, NULL), data, priv->frame_size);
+
+    g_mutex_lock (&priv->lock);
+    priv->read_index = (priv->read_index + 1) % priv->ring_size;
+    priv->n_filled--;
+    g_mutex_unlock (&priv->lock);
+
+    return TRUE;
+}
+
 static gboolean
 ufo_camera_task_generate (UfoTask *task,
                           UfoBuffer *output,
@@ -184,7 +375,21 @@ ufo_camera_task_generate (UfoTask *task,
 
     priv = UFO_CAMERA_TASK_GET_PRIVATE (UFO_CAMERA_TASK (task));
 
-    if (priv->current < priv->count) {
+    if (priv->ring_size > 0) {
+        if (generate_from_ring (priv, output)) {
+            if (priv->n_bits != 32)
+                ufo_buffer_convert (output, priv->n_bits <= 8 ? UFO_BUFFER_DEPTH_8U : UFO_BUFFER_DEPTH_16U);
+
+            priv->current++;
+            return TRUE;
+        }
+
+        stop_grabber (priv);
+        g_debug ("camera: grabbed %" G_GUINT64_FORMAT " frames, dropped %" G_GUINT64_FORMAT
+                 ", maximum ring fill level %u/%u",
+                 priv->grabbed, priv->dropped, priv->max_filled, priv->ring_size);
+    }
+    else if (priv->current < priv->count) {
         gfloat *host_array;
 
         host_array = ufo_buffer_get_host_array (output, NULL);
@@ -202,15 +407,12 @@ ufo_camera_task_generate (UfoTask *task,
         priv->current++;
         return TRUE;
     }
-    else {
-        GError *error = NULL;
 
-        uca_camera_stop_recording (priv->camera, &error);
+    uca_camera_stop_recording (priv->camera, &tmp_error);
 
-        if (error != NULL) {
-            g_warning ("Could not stop camera: %s", error->message);
-            g_error_free (error);
-        }
+    if (tmp_error != NULL) {
+        g_warning ("Could not stop camera: %s", tmp_error->message);
+        g_error_free (tmp_error);
     }
 
     return FALSE;
@@ -244,6 +446,9 @@ ufo_camera_task_set_property (GObject *object,
             g_free (priv->properties);
             priv->properties = g_strdup (g_value_get_string (value));
             break;
+        case PROP_RING_SIZE:
+            priv->ring_size = g_value_get_uint (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -271,6 +476,24 @@ ufo_camera_task_get_property (GObject *object,
         case PROP_PROPERTIES:
             g_value_set_string (value, priv->properties ? priv->properties : "");
             break;
+        case PROP_RING_SIZE:
+            g_value_set_uint (value, priv->ring_size);
+            break;
+        case PROP_GRABBED_FRAMES:
+            g_mutex_lock (&priv->lock);
+            g_value_set_uint64 (value, priv->grabbed);
+            g_mutex_unlock (&priv->lock);
+            break;
+        case PROP_DROPPED_FRAMES:
+            g_mutex_lock (&priv->lock);
+            g_value_set_uint64 (value, priv->dropped);
+            g_mutex_unlock (&priv->lock);
+            break;
+        case PROP_MAX_FILL_LEVEL:
+            g_mutex_lock (&priv->lock);
+            g_value_set_uint (value, priv->max_filled);
+            g_mutex_unlock (&priv->lock);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -282,6 +505,9 @@ ufo_camera_task_dispose (GObject *object)
 {
     UfoCameraTaskPrivate *priv = UFO_CAMERA_TASK_GET_PRIVATE (object);
 
+    stop_grabber (priv);
+    free_ring (priv);
+
     if (priv->camera != NULL) {
         g_object_unref (priv->camera);
         priv->camera = NULL;
@@ -302,6 +528,9 @@ ufo_camera_task_finalize (GObject *object)
 
     g_free (priv->name);
     g_free (priv->properties);
+    g_clear_error (&priv->grab_error);
+    g_mutex_clear (&priv->lock);
+    g_cond_clear (&priv->cond);
 
     G_OBJECT_CLASS (ufo_camera_task_parent_class)->finalize (object);
 }
@@ -343,8 +572,8 @@ ufo_camera_task_class_init(UfoCameraTaskClass *klass)
 
     properties[PROP_COUNT] =
         g_param_spec_uint ("number",
-            "Number of frames to record",
-            "Number of frames to record",
+            "Number of frames to record, 0 records until grabbing fails",
+            "Number of frames to record, 0 records until grabbing fails",
             0, G_MAXUINT, 0,
             G_PARAM_READWRITE);
 
@@ -355,6 +584,34 @@ ufo_camera_task_class_init(UfoCameraTaskClass *klass)
             "",
             G_PARAM_READWRITE);
 
+    properties[PROP_RING_SIZE] =
+        g_param_spec_uint ("ring-size",
+            "Number of buffered frames, 0 grabs synchronously",
+            "Number of frames buffered by the grabber thread, 0 grabs synchronously",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_GRABBED_FRAMES] =
+        g_param_spec_uint64 ("grabbed-frames",
+            "Number of frames grabbed by the grabber thread",
+            "Number of frames grabbed by the grabber thread",
+            0, G_MAXUINT64, 0,
+            G_PARAM_READABLE);
+
+    properties[PROP_DROPPED_FRAMES] =
+        g_param_spec_uint64 ("dropped-frames",
+            "Number of frames dropped because the ring was full",
+            "Number of frames dropped because the ring was full",
+            0, G_MAXUINT64, 0,
+            G_PARAM_READABLE);
+
+    properties[PROP_MAX_FILL_LEVEL] =
+        g_param_spec_uint ("max-fill-level",
+            "Maximum number of frames waiting in the ring",
+            "Maximum number of frames waiting in the ring",
+            0, G_MAXUINT, 0,
+            G_PARAM_READABLE);
+
     for (guint i = PROP_X + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (gobject_class, i, properties[i]);
 
@@ -372,4 +629,14 @@ ufo_camera_task_init (UfoCameraTask *self)
     priv->camera = NULL;
     priv->count = 0;
     priv->properties = NULL;
+    priv->ring_size = 0;
+    priv->ring = NULL;
+    priv->scratch = NULL;
+    priv->grabber = NULL;
+    priv->grab_error = NULL;
+    priv->grabbed = 0;
+    priv->dropped = 0;
+    priv->max_filled = 0;
+    g_mutex_init (&priv->lock);
+    g_cond_init (&priv->cond);
 }
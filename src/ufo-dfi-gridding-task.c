@@ -0,0 +1,567 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <math.h>
+#include "ufo-dfi-gridding-task.h"
+#include "common/ufo-fft.h"
+
+#define KERNEL_TABLE_SIZE 2048
+
+struct _UfoDfiGriddingTaskPrivate {
+    UfoFft *projection_fft;
+    UfoFft *slice_fft;
+    UfoFftParameter projection_param;
+    UfoFftParameter slice_param;
+
+    cl_context context;
+    cl_kernel spread_kernel;
+    cl_kernel weight_kernel;
+    cl_kernel gather_kernel;
+    cl_kernel crop_kernel;
+    cl_mem spectra;
+    cl_mem grid;
+    cl_mem kernel_table;
+    cl_mem deapodization;
+
+    gsize input_dims[3];
+    gsize grid_size;
+    gboolean changed;
+    gfloat real_axis_pos;
+
+    gdouble axis_pos;
+    gdouble angle_offset;
+    gdouble oversampling;
+    guint kernel_width;
+};
+
+static void ufo_task_interface_init (UfoTaskIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (UfoDfiGriddingTask, ufo_dfi_gridding_task, UFO_TYPE_TASK_NODE,
+                         G_IMPLEMENT_INTERFACE (UFO_TYPE_TASK,
+                                                ufo_task_interface_init))
+
+#define UFO_DFI_GRIDDING_TASK_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), UFO_TYPE_DFI_GRIDDING_TASK, UfoDfiGriddingTaskPrivate))
+
+enum {
+    PROP_0,
+    PROP_AXIS_POSITION,
+    PROP_ANGLE_OFFSET,
+    PROP_OVERSAMPLING,
+    PROP_KERNEL_WIDTH,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+UfoNode *
+ufo_dfi_gridding_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_DFI_GRIDDING_TASK, NULL));
+}
+
+static gsize
+pow2round (gsize x)
+{
+    gsize result = 1;
+
+    while (result < x)
+        result <<= 1;
+
+    return result;
+}
+
+static gdouble
+bessel_i0 (gdouble x)
+{
+    gdouble sum = 1.0, term = 1.0;
+
+    for (guint k = 1; term > 1e-16 * sum; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+/*
+ * Kaiser-Bessel window for the oversampled grid, see Beatty et al., "Rapid
+ * gridding reconstruction with a minimal oversampling ratio", IEEE TMI 2005.
+ */
+static gdouble
+kaiser_bessel (gdouble x, gdouble width, gdouble beta)
+{
+    gdouble arg = 1.0 - (2.0 * x / width) * (2.0 * x / width);
+
+    return arg < 0.0 ? 0.0 : bessel_i0 (beta * sqrt (arg)) / bessel_i0 (beta);
+}
+
+static void
+release_mem (cl_mem *mem)
+{
+    if (*mem) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (*mem));
+        *mem = NULL;
+    }
+}
+
+static cl_mem
+create_table (UfoDfiGriddingTaskPrivate *priv, gfloat *host_mem, gsize n)
+{
+    cl_mem mem;
+    cl_int errcode;
+
+    mem = clCreateBuffer (priv->context,
+                          CL_MEM_COPY_HOST_PTR | CL_MEM_READ_ONLY,
+                          n * sizeof (gfloat), host_mem,
+                          &errcode);
+    UFO_RESOURCES_CHECK_CLERR (errcode);
+
+    return mem;
+}
+
+static void
+setup_tables (UfoDfiGriddingTaskPrivate *priv, gsize width)
+{
+    const guint num_steps = 4096;
+    gdouble kernel_width = priv->kernel_width;
+    gdouble sigma = (gdouble) priv->grid_size / width;
+    gdouble beta, x, step, sum;
+    gfloat *table;
+
+    beta = G_PI * sqrt ((kernel_width / sigma) * (kernel_width / sigma) * (sigma - 0.5) * (sigma - 0.5) - 0.8);
+    table = g_new (gfloat, MAX (KERNEL_TABLE_SIZE + 1, width));
+
+    for (guint i = 0; i <= KERNEL_TABLE_SIZE; i++) {
+        table[i] = (gfloat) kaiser_bessel (i * kernel_width / 2.0 / KERNEL_TABLE_SIZE, kernel_width, beta);
+    }
+
+    release_mem (&priv->kernel_table);
+    priv->kernel_table = create_table (priv, table, KERNEL_TABLE_SIZE + 1);
+
+    /* Reciprocal of the kernel's Fourier transform at the slice pixels */
+    step = kernel_width / num_steps;
+
+    for (gsize i = 0; i < width; i++) {
+        gdouble nu = ((gdouble) i - (gdouble) (width / 2)) / priv->grid_size;
+
+        sum = 0.0;
+
+        for (guint j = 0; j <= num_steps; j++) {
+            x = -kernel_width / 2.0 + j * step;
+            sum += (j == 0 || j == num_steps ? 0.5 : 1.0) * kaiser_bessel (x, kernel_width, beta) * cos (2.0 * G_PI * x * nu);
+        }
+
+        table[i] = (gfloat) (1.0 / (sum * step));
+    }
+
+    release_mem (&priv->deapodization);
+    priv->deapodization = create_table (priv, table, width);
+    g_free (table);
+}
+
+static void
+ufo_dfi_gridding_task_setup (UfoTask *task,
+                             UfoResources *resources,
+                             GError **error)
+{
+    UfoDfiGriddingTaskPrivate *priv;
+
+    priv = UFO_DFI_GRIDDING_TASK_GET_PRIVATE (task);
+    priv->context = ufo_resources_get_context (resources);
+    priv->spread_kernel = ufo_resources_get_kernel (resources, "fft.cl", "fft_spread", NULL, error);
+    priv->weight_kernel = ufo_resources_get_kernel (resources, "dfi-gridding.cl", "dfi_gridding_weight", NULL, error);
+    priv->gather_kernel = ufo_resources_get_kernel (resources, "dfi-gridding.cl", "dfi_gridding_gather", NULL, error);
+    priv->crop_kernel = ufo_resources_get_kernel (resources, "dfi-gridding.cl", "dfi_gridding_crop", NULL, error);
+
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainContext (priv->context), error);
+
+    if (priv->spread_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->spread_kernel), error);
+
+    if (priv->weight_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->weight_kernel), error);
+
+    if (priv->gather_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->gather_kernel), error);
+
+    if (priv->crop_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->crop_kernel), error);
+}
+
+static void
+ufo_dfi_gridding_task_get_requisition (UfoTask *task,
+                                       UfoBuffer **inputs,
+                                       UfoRequisition *requisition,
+                                       GError **error)
+{
+    UfoDfiGriddingTaskPrivate *priv;
+    UfoRequisition in_req;
+    cl_command_queue queue;
+    cl_int errcode;
+    gsize batch;
+
+    priv = UFO_DFI_GRIDDING_TASK_GET_PRIVATE (task);
+    ufo_buffer_get_requisition (inputs[0], &in_req);
+    batch = in_req.n_dims == 3 ? in_req.dims[2] : 1;
+
+    /* A stack of sinograms is reconstructed with one batched transform */
+    *requisition = in_req;
+    requisition->dims[1] = in_req.dims[0];
+
+    if (!priv->changed && in_req.dims[0] == priv->input_dims[0] &&
+        in_req.dims[1] == priv->input_dims[1] && batch == priv->input_dims[2])
+        return;
+
+    priv->input_dims[0] = in_req.dims[0];
+    priv->input_dims[1] = in_req.dims[1];
+    priv->input_dims[2] = batch;
+    priv->changed = FALSE;
+    priv->real_axis_pos = priv->axis_pos <= 0.0 ? in_req.dims[0] / 2.0f : (gfloat) priv->axis_pos;
+    priv->grid_size = pow2round ((gsize) ceil (priv->oversampling * in_req.dims[0]));
+
+    if (priv->grid_size < priv->kernel_width * 2) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                     "dfi-gridding: kernel-width %u is too large for sinograms of width %zu",
+                     priv->kernel_width, in_req.dims[0]);
+        return;
+    }
+
+    g_debug ("dfi-gridding: grid size %zu, batch %zu", priv->grid_size, batch);
+    setup_tables (priv, in_req.dims[0]);
+
+    release_mem (&priv->spectra);
+    release_mem (&priv->grid);
+    priv->spectra = clCreateBuffer (priv->context, CL_MEM_READ_WRITE,
+                                    2 * priv->grid_size * in_req.dims[1] * batch * sizeof (gfloat),
+                                    NULL, &errcode);
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (errcode, error);
+    priv->grid = clCreateBuffer (priv->context, CL_MEM_READ_WRITE,
+                                 2 * priv->grid_size * priv->grid_size * batch * sizeof (gfloat),
+                                 NULL, &errcode);
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (errcode, error);
+
+    /* Both transforms are done in-place on the padded data */
+    priv->projection_param.dimensions = UFO_FFT_1D;
+    priv->projection_param.zeropad = TRUE;
+    priv->projection_param.size[0] = priv->grid_size;
+    priv->projection_param.size[1] = 1;
+    priv->projection_param.size[2] = 1;
+    priv->projection_param.batch = in_req.dims[1] * batch;
+
+    priv->slice_param.dimensions = UFO_FFT_2D;
+    priv->slice_param.zeropad = TRUE;
+    priv->slice_param.size[0] = priv->grid_size;
+    priv->slice_param.size[1] = priv->grid_size;
+    priv->slice_param.size[2] = 1;
+    priv->slice_param.batch = batch;
+
+    queue = ufo_gpu_node_get_cmd_queue (UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task))));
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (ufo_fft_update (priv->projection_fft, priv->context, queue,
+                                                        &priv->projection_param), error);
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (ufo_fft_update (priv->slice_fft, priv->context, queue,
+                                                        &priv->slice_param), error);
+}
+
+static guint
+ufo_dfi_gridding_task_get_num_inputs (UfoTask *task)
+{
+    return 1;
+}
+
+static guint
+ufo_dfi_gridding_task_get_num_dimensions (UfoTask *task,
+                                          guint input)
+{
+    g_return_val_if_fail (input == 0, 0);
+    return 2;
+}
+
+static UfoTaskMode
+ufo_dfi_gridding_task_get_mode (UfoTask *task)
+{
+    return UFO_TASK_MODE_PROCESSOR | UFO_TASK_MODE_GPU;
+}
+
+static gboolean
+ufo_dfi_gridding_task_process (UfoTask *task,
+                               UfoBuffer **inputs,
+                               UfoBuffer *output,
+                               UfoRequisition *requisition)
+{
+    UfoDfiGriddingTaskPrivate *priv;
+    UfoProfiler *profiler;
+    cl_command_queue queue;
+    cl_mem in_mem, out_mem;
+    cl_int width, height, num_angles, table_size, grid_size;
+    gfloat angle_offset, angle_step, center, shift, norm, half_width;
+    gsize global_work_size[3];
+
+    priv = UFO_DFI_GRIDDING_TASK_GET_PRIVATE (task);
+    profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
+    queue = ufo_gpu_node_get_cmd_queue (UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task))));
+    in_mem = ufo_buffer_get_device_array (inputs[0], queue);
+    out_mem = ufo_buffer_get_device_array (output, queue);
+
+    width = (cl_int) priv->input_dims[0];
+    height = num_angles = (cl_int) priv->input_dims[1];
+    grid_size = (cl_int) priv->grid_size;
+    table_size = KERNEL_TABLE_SIZE;
+    half_width = priv->kernel_width / 2.0f;
+    angle_offset = (gfloat) priv->angle_offset;
+    angle_step = (gfloat) (G_PI / num_angles);
+    /* Projection samples sit at j + 0.5 - axis-pos like in backproject */
+    center = priv->real_axis_pos - 0.5f;
+    shift = width / 2 - center;
+    norm = (gfloat) (G_PI / num_angles / priv->grid_size / priv->grid_size);
+
+    /* Zero-padded projections, transformed along the detector */
+    global_work_size[0] = priv->grid_size;
+    global_work_size[1] = priv->input_dims[1];
+    global_work_size[2] = priv->input_dims[2];
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->spread_kernel, 0, sizeof (cl_mem), &priv->spectra));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->spread_kernel, 1, sizeof (cl_mem), &in_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->spread_kernel, 2, sizeof (cl_int), &width));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->spread_kernel, 3, sizeof (cl_int), &height));
+    ufo_profiler_call (profiler, queue, priv->spread_kernel, 3, global_work_size, NULL);
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->projection_fft, queue, profiler, priv->spectra, priv->spectra,
+                                                UFO_FFT_FORWARD, 0, NULL, NULL));
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->weight_kernel, 0, sizeof (cl_mem), &priv->spectra));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->weight_kernel, 1, sizeof (gfloat), &angle_offset));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->weight_kernel, 2, sizeof (gfloat), &angle_step));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->weight_kernel, 3, sizeof (gfloat), &center));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->weight_kernel, 4, sizeof (gfloat), &shift));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->weight_kernel, 5, sizeof (gfloat), &norm));
+    ufo_profiler_call (profiler, queue, priv->weight_kernel, 3, global_work_size, NULL);
+
+    /* Polar to Cartesian interpolation and inverse 2D transform */
+    global_work_size[1] = priv->grid_size;
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->gather_kernel, 0, sizeof (cl_mem), &priv->spectra));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->gather_kernel, 1, sizeof (cl_mem), &priv->grid));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->gather_kernel, 2, sizeof (cl_mem), &priv->kernel_table));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->gather_kernel, 3, sizeof (cl_int), &table_size));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->gather_kernel, 4, sizeof (gfloat), &half_width));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->gather_kernel, 5, sizeof (cl_int), &num_angles));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->gather_kernel, 6, sizeof (gfloat), &angle_offset));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->gather_kernel, 7, sizeof (gfloat), &angle_step));
+    ufo_profiler_call (profiler, queue, priv->gather_kernel, 3, global_work_size, NULL);
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->slice_fft, queue, profiler, priv->grid, priv->grid,
+                                                UFO_FFT_BACKWARD, 0, NULL, NULL));
+
+    global_work_size[0] = global_work_size[1] = priv->input_dims[0];
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->crop_kernel, 0, sizeof (cl_mem), &priv->grid));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->crop_kernel, 1, sizeof (cl_mem), &out_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->crop_kernel, 2, sizeof (cl_mem), &priv->deapodization));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->crop_kernel, 3, sizeof (cl_int), &grid_size));
+    ufo_profiler_call (profiler, queue, priv->crop_kernel, 3, global_work_size, NULL);
+
+    return TRUE;
+}
+
+static void
+ufo_dfi_gridding_task_finalize (GObject *object)
+{
+    UfoDfiGriddingTaskPrivate *priv;
+
+    priv = UFO_DFI_GRIDDING_TASK_GET_PRIVATE (object);
+
+    release_mem (&priv->spectra);
+    release_mem (&priv->grid);
+    release_mem (&priv->kernel_table);
+    release_mem (&priv->deapodization);
+
+    if (priv->spread_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->spread_kernel));
+        priv->spread_kernel = NULL;
+    }
+
+    if (priv->weight_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->weight_kernel));
+        priv->weight_kernel = NULL;
+    }
+
+    if (priv->gather_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->gather_kernel));
+        priv->gather_kernel = NULL;
+    }
+
+    if (priv->crop_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->crop_kernel));
+        priv->crop_kernel = NULL;
+    }
+
+    if (priv->context) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
+        priv->context = NULL;
+    }
+
+    if (priv->projection_fft) {
+        ufo_fft_destroy (priv->projection_fft);
+        priv->projection_fft = NULL;
+    }
+
+    if (priv->slice_fft) {
+        ufo_fft_destroy (priv->slice_fft);
+        priv->slice_fft = NULL;
+    }
+
+    G_OBJECT_CLASS (ufo_dfi_gridding_task_parent_class)->finalize (object);
+}
+
+static void
+ufo_task_interface_init (UfoTaskIface *iface)
+{
+    iface->setup = ufo_dfi_gridding_task_setup;
+    iface->get_requisition = ufo_dfi_gridding_task_get_requisition;
+    iface->get_num_inputs = ufo_dfi_gridding_task_get_num_inputs;
+    iface->get_num_dimensions = ufo_dfi_gridding_task_get_num_dimensions;
+    iface->get_mode = ufo_dfi_gridding_task_get_mode;
+    iface->process = ufo_dfi_gridding_task_process;
+}
+
+static void
+ufo_dfi_gridding_task_set_property (GObject *object,
+                                    guint property_id,
+                                    const GValue *value,
+                                    GParamSpec *pspec)
+{
+    UfoDfiGriddingTaskPrivate *priv = UFO_DFI_GRIDDING_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_AXIS_POSITION:
+            priv->axis_pos = g_value_get_double (value);
+            break;
+        case PROP_ANGLE_OFFSET:
+            priv->angle_offset = g_value_get_double (value);
+            break;
+        case PROP_OVERSAMPLING:
+            priv->oversampling = g_value_get_double (value);
+            break;
+        case PROP_KERNEL_WIDTH:
+            priv->kernel_width = g_value_get_uint (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            return;
+    }
+
+    priv->changed = TRUE;
+}
+
+static void
+ufo_dfi_gridding_task_get_property (GObject *object,
+                                    guint property_id,
+                                    GValue *value,
+                                    GParamSpec *pspec)
+{
+    UfoDfiGriddingTaskPrivate *priv = UFO_DFI_GRIDDING_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_AXIS_POSITION:
+            g_value_set_double (value, priv->axis_pos);
+            break;
+        case PROP_ANGLE_OFFSET:
+            g_value_set_double (value, priv->angle_offset);
+            break;
+        case PROP_OVERSAMPLING:
+            g_value_set_double (value, priv->oversampling);
+            break;
+        case PROP_KERNEL_WIDTH:
+            g_value_set_uint (value, priv->kernel_width);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_dfi_gridding_task_class_init (UfoDfiGriddingTaskClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+    oclass->finalize = ufo_dfi_gridding_task_finalize;
+    oclass->set_property = ufo_dfi_gridding_task_set_property;
+    oclass->get_property = ufo_dfi_gridding_task_get_property;
+
+    properties[PROP_AXIS_POSITION] =
+        g_param_spec_double ("axis-pos",
+            "Position of rotation axis",
+            "Position of rotation axis",
+            -1.0, +8192.0, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_ANGLE_OFFSET] =
+        g_param_spec_double ("angle-offset",
+            "Angle offset in radians",
+            "Angle offset in radians determining the first angle position",
+            -G_MAXDOUBLE, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_OVERSAMPLING] =
+        g_param_spec_double ("oversampling",
+            "Minimum oversampling of the Cartesian frequency grid",
+            "Minimum oversampling of the Cartesian frequency grid, rounded up to a power of two grid size",
+            1.25, 4.0, 2.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_KERNEL_WIDTH] =
+        g_param_spec_uint ("kernel-width",
+            "Width of the Kaiser-Bessel interpolation kernel in grid points",
+            "Width of the Kaiser-Bessel interpolation kernel in grid points",
+            2, 16, 6,
+            G_PARAM_READWRITE);
+
+    for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
+        g_object_class_install_property (oclass, i, properties[i]);
+
+    g_type_class_add_private (klass, sizeof (UfoDfiGriddingTaskPrivate));
+}
+
+static void
+ufo_dfi_gridding_task_init (UfoDfiGriddingTask *self)
+{
+    UfoDfiGriddingTaskPrivate *priv;
+    self->priv = priv = UFO_DFI_GRIDDING_TASK_GET_PRIVATE (self);
+    priv->projection_fft = ufo_fft_new ();
+    priv->slice_fft = ufo_fft_new ();
+    priv->context = NULL;
+    priv->spread_kernel = NULL;
+    priv->weight_kernel = NULL;
+    priv->gather_kernel = NULL;
+    priv->crop_kernel = NULL;
+    priv->spectra = NULL;
+    priv->grid = NULL;
+    priv->kernel_table = NULL;
+    priv->deapodization = NULL;
+    priv->input_dims[0] = priv->input_dims[1] = priv->input_dims[2] = 0;
+    priv->grid_size = 0;
+    priv->changed = TRUE;
+    priv->real_axis_pos = 0.0f;
+    priv->axis_pos = -1.0;
+    priv->angle_offset = 0.0;
+    priv->oversampling = 2.0;
+    priv->kernel_width = 6;
+}
@@ -0,0 +1,490 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include "ufo-estimate-center-task.h"
+#include "common/ufo-fft.h"
+
+/**
+ * SECTION:ufo-estimate-center-task
+ * @Short_description: Estimate the center of rotation of every slice
+ * @Title: estimate-center
+ *
+ * Cross-correlates the rows of a projection at 0 degrees with the mirrored
+ * rows of the projection at 180 degrees and outputs one center of rotation
+ * with sub-pixel accuracy per selected row, i.e. per slice. All rows are
+ * correlated in one batch of FFTs on the device.
+ */
+
+struct _UfoEstimateCenterTaskPrivate {
+    cl_context context;
+    cl_kernel pack_kernel;
+    cl_kernel cross_power_kernel;
+    cl_kernel peak_kernel;
+    cl_mem rows;
+    cl_mem power;
+    UfoFft *fft;
+    guint y;
+    guint height;
+    guint y_step;
+    gdouble center;
+    gsize size;
+    gsize num_rows;
+    gsize local_size;
+};
+
+static void ufo_task_interface_init (UfoTaskIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (UfoEstimateCenterTask, ufo_estimate_center_task, UFO_TYPE_TASK_NODE,
+                         G_IMPLEMENT_INTERFACE (UFO_TYPE_TASK,
+                                                ufo_task_interface_init))
+
+#define UFO_ESTIMATE_CENTER_TASK_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), UFO_TYPE_ESTIMATE_CENTER_TASK, UfoEstimateCenterTaskPrivate))
+
+enum {
+    PROP_0,
+    PROP_Y,
+    PROP_HEIGHT,
+    PROP_Y_STEP,
+    PROP_CENTER,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+UfoNode *
+ufo_estimate_center_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_ESTIMATE_CENTER_TASK, NULL));
+}
+
+static void
+release_buffers (UfoEstimateCenterTaskPrivate *priv)
+{
+    if (priv->rows) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->rows));
+        priv->rows = NULL;
+    }
+
+    if (priv->power) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->power));
+        priv->power = NULL;
+    }
+}
+
+static cl_mem
+create_buffer (UfoEstimateCenterTaskPrivate *priv, gsize num_floats, GError **error)
+{
+    cl_mem mem;
+    cl_int cl_error;
+
+    mem = clCreateBuffer (priv->context, CL_MEM_READ_WRITE, num_floats * sizeof (gfloat), NULL, &cl_error);
+    UFO_RESOURCES_CHECK_AND_SET (cl_error, error);
+
+    return cl_error == CL_SUCCESS ? mem : NULL;
+}
+
+/* Work group size of the per-row reductions, which must be a power of two */
+static gsize
+get_local_size (UfoEstimateCenterTaskPrivate *priv, cl_command_queue queue)
+{
+    cl_device_id device;
+    gsize pack_size;
+    gsize peak_size;
+    gsize max_size;
+    gsize local_size = 1;
+
+    UFO_RESOURCES_CHECK_CLERR (clGetCommandQueueInfo (queue, CL_QUEUE_DEVICE, sizeof (cl_device_id), &device, NULL));
+    UFO_RESOURCES_CHECK_CLERR (clGetKernelWorkGroupInfo (priv->pack_kernel, device, CL_KERNEL_WORK_GROUP_SIZE,
+                                                         sizeof (gsize), &pack_size, NULL));
+    UFO_RESOURCES_CHECK_CLERR (clGetKernelWorkGroupInfo (priv->peak_kernel, device, CL_KERNEL_WORK_GROUP_SIZE,
+                                                         sizeof (gsize), &peak_size, NULL));
+    max_size = MIN (MIN (pack_size, peak_size), 256);
+
+    while (2 * local_size <= max_size)
+        local_size *= 2;
+
+    return local_size;
+}
+
+static void
+ufo_estimate_center_task_setup (UfoTask *task,
+                                UfoResources *resources,
+                                GError **error)
+{
+    UfoEstimateCenterTaskPrivate *priv;
+
+    priv = UFO_ESTIMATE_CENTER_TASK_GET_PRIVATE (task);
+
+    priv->context = ufo_resources_get_context (resources);
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainContext (priv->context), error);
+
+    priv->pack_kernel = ufo_resources_get_kernel (resources, "estimate-center.cl", "estimate_center_pack", NULL, error);
+
+    if (priv->pack_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->pack_kernel), error);
+
+    priv->cross_power_kernel = ufo_resources_get_kernel (resources, "estimate-center.cl", "estimate_center_cross_power", NULL, error);
+
+    if (priv->cross_power_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->cross_power_kernel), error);
+
+    priv->peak_kernel = ufo_resources_get_kernel (resources, "estimate-center.cl", "estimate_center_peak", NULL, error);
+
+    if (priv->peak_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->peak_kernel), error);
+}
+
+static void
+ufo_estimate_center_task_get_requisition (UfoTask *task,
+                                          UfoBuffer **inputs,
+                                          UfoRequisition *requisition,
+                                          GError **error)
+{
+    UfoEstimateCenterTaskPrivate *priv;
+    UfoRequisition in_req;
+    UfoRequisition other_req;
+    UfoFftParameter param = { 0, };
+    cl_command_queue queue;
+    gsize last, size, num_rows;
+
+    priv = UFO_ESTIMATE_CENTER_TASK_GET_PRIVATE (task);
+    ufo_buffer_get_requisition (inputs[0], &in_req);
+    ufo_buffer_get_requisition (inputs[1], &other_req);
+
+    if (in_req.dims[0] != other_req.dims[0] || in_req.dims[1] != other_req.dims[1]) {
+        g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                             "estimate-center: projections at 0 and 180 degrees must have the same size");
+        return;
+    }
+
+    if (priv->y >= in_req.dims[1]) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                     "estimate-center: y=%u must be smaller than the projection height %zu",
+                     priv->y, in_req.dims[1]);
+        return;
+    }
+
+    last = priv->height ? MIN (priv->y + priv->height, in_req.dims[1]) : in_req.dims[1];
+    num_rows = (last - priv->y + priv->y_step - 1) / priv->y_step;
+
+    requisition->n_dims = 1;
+    requisition->dims[0] = num_rows;
+
+    /* Pad to at least twice the width, so that all shifts are distinct */
+    size = ufo_fft_get_padded_size (2 * in_req.dims[0], FALSE);
+
+    if (size == priv->size && num_rows == priv->num_rows)
+        return;
+
+    release_buffers (priv);
+    priv->size = size;
+    priv->num_rows = num_rows;
+
+    param.dimensions = UFO_FFT_1D;
+    param.size[0] = size;
+    param.size[1] = 1;
+    param.size[2] = 1;
+    param.batch = num_rows;
+    param.zeropad = TRUE;
+    param.type = UFO_FFT_COMPLEX_TO_COMPLEX;
+
+    queue = ufo_gpu_node_get_cmd_queue (UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task))));
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (ufo_fft_update (priv->fft, priv->context, queue, &param), error);
+
+    if (priv->local_size == 0)
+        priv->local_size = get_local_size (priv, queue);
+
+    priv->rows = create_buffer (priv, 2 * size * num_rows, error);
+
+    if (priv->rows == NULL)
+        return;
+
+    priv->power = create_buffer (priv, 2 * size * num_rows, error);
+}
+
+static guint
+ufo_estimate_center_task_get_num_inputs (UfoTask *task)
+{
+    return 2;
+}
+
+static guint
+ufo_estimate_center_task_get_num_dimensions (UfoTask *task,
+                                             guint input)
+{
+    g_return_val_if_fail (input <= 1, 0);
+    return 2;
+}
+
+static UfoTaskMode
+ufo_estimate_center_task_get_mode (UfoTask *task)
+{
+    return UFO_TASK_MODE_PROCESSOR | UFO_TASK_MODE_GPU;
+}
+
+static gboolean
+ufo_estimate_center_task_process (UfoTask *task,
+                                  UfoBuffer **inputs,
+                                  UfoBuffer *output,
+                                  UfoRequisition *requisition)
+{
+    UfoEstimateCenterTaskPrivate *priv;
+    UfoRequisition in_req;
+    UfoProfiler *profiler;
+    cl_command_queue queue;
+    cl_mem proj_0_mem, proj_180_mem, out_mem;
+    cl_int width, size, y, y_step;
+    gsize global_work_size[2];
+    gsize local_work_size[2];
+    gfloat *centers;
+    gdouble sum;
+
+    priv = UFO_ESTIMATE_CENTER_TASK_GET_PRIVATE (task);
+    profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
+    queue = ufo_gpu_node_get_cmd_queue (UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task))));
+    proj_0_mem = ufo_buffer_get_device_array (inputs[0], queue);
+    proj_180_mem = ufo_buffer_get_device_array (inputs[1], queue);
+    out_mem = ufo_buffer_get_device_array (output, queue);
+
+    ufo_buffer_get_requisition (inputs[0], &in_req);
+    width = (cl_int) in_req.dims[0];
+    size = (cl_int) priv->size;
+    y = (cl_int) priv->y;
+    y_step = (cl_int) priv->y_step;
+
+    /* One work group per row for the reductions */
+    local_work_size[0] = priv->local_size;
+    local_work_size[1] = 1;
+    global_work_size[0] = priv->local_size;
+    global_work_size[1] = priv->num_rows;
+
+    /* Row at 0 degrees as real and mirrored row at 180 degrees as imaginary part */
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 0, sizeof (cl_mem), &proj_0_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 1, sizeof (cl_mem), &proj_180_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 2, sizeof (cl_mem), &priv->rows));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 3, sizeof (cl_int), &width));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 4, sizeof (cl_int), &size));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 5, sizeof (cl_int), &y));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 6, sizeof (cl_int), &y_step));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 7, priv->local_size * sizeof (cl_float2), NULL));
+    ufo_profiler_call (profiler, queue, priv->pack_kernel, 2, global_work_size, local_work_size);
+
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->fft, queue, profiler, priv->rows, priv->rows,
+                                                UFO_FFT_FORWARD, 0, NULL, NULL));
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->cross_power_kernel, 0, sizeof (cl_mem), &priv->rows));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->cross_power_kernel, 1, sizeof (cl_mem), &priv->power));
+
+    global_work_size[0] = priv->size;
+    ufo_profiler_call (profiler, queue, priv->cross_power_kernel, 2, global_work_size, NULL);
+
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->fft, queue, profiler, priv->power, priv->power,
+                                                UFO_FFT_BACKWARD, 0, NULL, NULL));
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->peak_kernel, 0, sizeof (cl_mem), &priv->power));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->peak_kernel, 1, sizeof (cl_mem), &out_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->peak_kernel, 2, sizeof (cl_int), &width));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->peak_kernel, 3, sizeof (cl_int), &size));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->peak_kernel, 4, priv->local_size * sizeof (cl_float), NULL));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->peak_kernel, 5, priv->local_size * sizeof (cl_int), NULL));
+
+    global_work_size[0] = priv->local_size;
+    ufo_profiler_call (profiler, queue, priv->peak_kernel, 2, global_work_size, local_work_size);
+
+    /* The mean of all slices is the center of the whole projection */
+    centers = ufo_buffer_get_host_array (output, queue);
+    sum = 0.0;
+
+    for (gsize i = 0; i < priv->num_rows; i++)
+        sum += centers[i];
+
+    priv->center = sum / priv->num_rows;
+    g_object_notify_by_pspec (G_OBJECT (task), properties[PROP_CENTER]);
+
+    return TRUE;
+}
+
+static void
+ufo_estimate_center_task_set_property (GObject *object,
+                                       guint property_id,
+                                       const GValue *value,
+                                       GParamSpec *pspec)
+{
+    UfoEstimateCenterTaskPrivate *priv = UFO_ESTIMATE_CENTER_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_Y:
+            priv->y = g_value_get_uint (value);
+            break;
+        case PROP_HEIGHT:
+            priv->height = g_value_get_uint (value);
+            break;
+        case PROP_Y_STEP:
+            priv->y_step = g_value_get_uint (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_estimate_center_task_get_property (GObject *object,
+                                       guint property_id,
+                                       GValue *value,
+                                       GParamSpec *pspec)
+{
+    UfoEstimateCenterTaskPrivate *priv = UFO_ESTIMATE_CENTER_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_Y:
+            g_value_set_uint (value, priv->y);
+            break;
+        case PROP_HEIGHT:
+            g_value_set_uint (value, priv->height);
+            break;
+        case PROP_Y_STEP:
+            g_value_set_uint (value, priv->y_step);
+            break;
+        case PROP_CENTER:
+            g_value_set_double (value, priv->center);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_estimate_center_task_finalize (GObject *object)
+{
+    UfoEstimateCenterTaskPrivate *priv;
+
+    priv = UFO_ESTIMATE_CENTER_TASK_GET_PRIVATE (object);
+    release_buffers (priv);
+
+    if (priv->pack_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->pack_kernel));
+        priv->pack_kernel = NULL;
+    }
+
+    if (priv->cross_power_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->cross_power_kernel));
+        priv->cross_power_kernel = NULL;
+    }
+
+    if (priv->peak_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->peak_kernel));
+        priv->peak_kernel = NULL;
+    }
+
+    if (priv->context) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
+        priv->context = NULL;
+    }
+
+    if (priv->fft) {
+        ufo_fft_destroy (priv->fft);
+        priv->fft = NULL;
+    }
+
+    G_OBJECT_CLASS (ufo_estimate_center_task_parent_class)->finalize (object);
+}
+
+static void
+ufo_task_interface_init (UfoTaskIface *iface)
+{
+    iface->setup = ufo_estimate_center_task_setup;
+    iface->get_requisition = ufo_estimate_center_task_get_requisition;
+    iface->get_num_inputs = ufo_estimate_center_task_get_num_inputs;
+    iface->get_num_dimensions = ufo_estimate_center_task_get_num_dimensions;
+    iface->get_mode = ufo_estimate_center_task_get_mode;
+    iface->process = ufo_estimate_center_task_process;
+}
+
+static void
+ufo_estimate_center_task_class_init (UfoEstimateCenterTaskClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+    oclass->finalize = ufo_estimate_center_task_finalize;
+    oclass->set_property = ufo_estimate_center_task_set_property;
+    oclass->get_property = ufo_estimate_center_task_get_property;
+
+    properties[PROP_Y] =
+        g_param_spec_uint ("y",
+            "First row",
+            "First row for which the center is estimated",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_HEIGHT] =
+        g_param_spec_uint ("height",
+            "Number of rows",
+            "Number of rows for which the center is estimated, 0 means all rows from y on",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_Y_STEP] =
+        g_param_spec_uint ("y-step",
+            "Use every \"step\" row",
+            "Use every \"step\" row",
+            1, G_MAXUINT, 1,
+            G_PARAM_READWRITE);
+
+    properties[PROP_CENTER] =
+        g_param_spec_double ("center",
+            "Center of rotation",
+            "Mean center of rotation of all rows of the last projection pair",
+            -G_MAXDOUBLE, G_MAXDOUBLE, 0.0,
+            G_PARAM_READABLE);
+
+    for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
+        g_object_class_install_property (oclass, i, properties[i]);
+
+    g_type_class_add_private (klass, sizeof (UfoEstimateCenterTaskPrivate));
+}
+
+static void
+ufo_estimate_center_task_init (UfoEstimateCenterTask *self)
+{
+    UfoEstimateCenterTaskPrivate *priv;
+
+    self->priv = priv = UFO_ESTIMATE_CENTER_TASK_GET_PRIVATE (self);
+    priv->context = NULL;
+    priv->pack_kernel = NULL;
+    priv->cross_power_kernel = NULL;
+    priv->peak_kernel = NULL;
+    priv->rows = NULL;
+    priv->power = NULL;
+    priv->fft = ufo_fft_new ();
+    priv->y = 0;
+    priv->height = 0;
+    priv->y_step = 1;
+    priv->center = 0.0;
+    priv->size = 0;
+    priv->num_rows = 0;
+    priv->local_size = 0;
+}
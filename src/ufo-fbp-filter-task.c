@@ -0,0 +1,645 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include "ufo-fbp-filter-task.h"
+#include "common/ufo-fft.h"
+#include "common/ufo-filter-coefficients.h"
+
+/**
+ * SECTION:ufo-fbp-filter-task
+ * @Short_description: Filter sinograms for filtered backprojection
+ * @Title: fbp-filter
+ *
+ * Zero-pads all rows of a sinogram or a stack of sinograms, Fourier
+ * transforms them in one batch, multiplies them with the filter selected by
+ * #UfoFbpFilterTask:filter, transforms them back and crops them to the input
+ * width. This is equivalent to zeropadding, fft, filter, ifft and crop
+ * without the intermediate buffers of separate nodes.
+ *
+ * Rows of at most #UfoFbpFilterTask:convolution-width pixels are instead
+ * convolved directly with the real space kernel of the ramp-fromreal and
+ * shepp-logan filters, which is cheaper than padding and transforming them.
+ */
+
+struct _UfoFbpFilterTaskPrivate {
+    cl_context context;
+    cl_kernel pad_kernel;
+    cl_kernel filter_kernel;
+    cl_kernel pack_kernel;
+    cl_kernel convolve_kernel;
+    cl_mem padded;
+    cl_mem spectrum;
+    cl_mem filter_mem;
+    cl_mem taps_mem;
+    UfoFft *forward;
+    UfoFft *backward;
+    UfoFilterParameter filter;
+    gboolean real;
+    gboolean smooth;
+    gboolean convolve;
+    guint convolution_width;
+    gsize local_size;
+    gsize width;
+    gsize size;
+    gsize num_rows;
+};
+
+static void ufo_task_interface_init (UfoTaskIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (UfoFbpFilterTask, ufo_fbp_filter_task, UFO_TYPE_TASK_NODE,
+                         G_IMPLEMENT_INTERFACE (UFO_TYPE_TASK,
+                                                ufo_task_interface_init))
+
+#define UFO_FBP_FILTER_TASK_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), UFO_TYPE_FBP_FILTER_TASK, UfoFbpFilterTaskPrivate))
+
+enum {
+    PROP_0,
+    PROP_FILTER,
+    PROP_CUTOFF,
+    PROP_BW_ORDER,
+    PROP_FB_TAU,
+    PROP_FB_THETA,
+    PROP_SCALE,
+    PROP_SMOOTH_PADDING,
+    PROP_CONVOLUTION_WIDTH,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+UfoNode *
+ufo_fbp_filter_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_FBP_FILTER_TASK, NULL));
+}
+
+static void
+release_buffers (UfoFbpFilterTaskPrivate *priv)
+{
+    if (priv->padded) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->padded));
+        priv->padded = NULL;
+    }
+
+    if (priv->spectrum) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->spectrum));
+        priv->spectrum = NULL;
+    }
+
+    if (priv->filter_mem) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->filter_mem));
+        priv->filter_mem = NULL;
+    }
+
+    if (priv->taps_mem) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->taps_mem));
+        priv->taps_mem = NULL;
+    }
+}
+
+static cl_mem
+create_buffer (UfoFbpFilterTaskPrivate *priv, gsize num_floats, gfloat *host, GError **error)
+{
+    cl_mem mem;
+    cl_int cl_error;
+
+    mem = clCreateBuffer (priv->context,
+                          CL_MEM_READ_WRITE | (host != NULL ? CL_MEM_COPY_HOST_PTR : 0),
+                          num_floats * sizeof (gfloat), host, &cl_error);
+    UFO_RESOURCES_CHECK_AND_SET (cl_error, error);
+
+    return cl_error == CL_SUCCESS ? mem : NULL;
+}
+
+static void
+create_filter (UfoFbpFilterTaskPrivate *priv, cl_command_queue queue, UfoProfiler *profiler, GError **error)
+{
+    gfloat *coefficients;
+
+    /* The same coefficients as the filter task for a spectrum of priv->size */
+    coefficients = ufo_filter_compute_coefficients (&priv->filter, 2 * priv->size);
+    priv->filter_mem = create_buffer (priv, 2 * priv->size, coefficients, error);
+    g_free (coefficients);
+
+    if (priv->filter_mem == NULL)
+        return;
+
+    if (ufo_filter_is_real_space (priv->filter.type)) {
+        UfoFft *fft;
+        UfoFftParameter param = { 0, };
+        cl_int cl_error;
+
+        param.dimensions = UFO_FFT_1D;
+        param.size[0] = priv->size;
+        param.size[1] = 1;
+        param.size[2] = 1;
+        param.batch = 1;
+        param.zeropad = TRUE;
+        param.type = UFO_FFT_COMPLEX_TO_COMPLEX;
+
+        fft = ufo_fft_new ();
+        cl_error = ufo_fft_update (fft, priv->context, queue, &param);
+
+        if (cl_error == CL_SUCCESS) {
+            cl_error = ufo_fft_execute (fft, queue, profiler, priv->filter_mem, priv->filter_mem,
+                                        UFO_FFT_FORWARD, 0, NULL, NULL);
+            UFO_RESOURCES_CHECK_CLERR (clFinish (queue));
+        }
+
+        UFO_RESOURCES_CHECK_AND_SET (cl_error, error);
+        ufo_fft_destroy (fft);
+    }
+}
+
+static gboolean
+use_convolution (UfoFbpFilterTaskPrivate *priv, cl_command_queue queue, gsize width)
+{
+    cl_device_id device;
+    cl_ulong local_mem_size;
+
+    if (!ufo_filter_is_real_space (priv->filter.type) || width > priv->convolution_width)
+        return FALSE;
+
+    UFO_RESOURCES_CHECK_CLERR (clGetCommandQueueInfo (queue, CL_QUEUE_DEVICE, sizeof (cl_device_id), &device, NULL));
+    UFO_RESOURCES_CHECK_CLERR (clGetDeviceInfo (device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof (cl_ulong), &local_mem_size, NULL));
+    UFO_RESOURCES_CHECK_CLERR (clGetKernelWorkGroupInfo (priv->convolve_kernel, device, CL_KERNEL_WORK_GROUP_SIZE,
+                                                         sizeof (gsize), &priv->local_size, NULL));
+    priv->local_size = MIN (priv->local_size, 256);
+
+    /* The row with the kernel support as margins on both sides and the taps */
+    return (4 * width - 2) * sizeof (gfloat) <= local_mem_size;
+}
+
+static void
+ufo_fbp_filter_task_setup (UfoTask *task,
+                           UfoResources *resources,
+                           GError **error)
+{
+    UfoFbpFilterTaskPrivate *priv;
+
+    priv = UFO_FBP_FILTER_TASK_GET_PRIVATE (task);
+
+    /* Without real transforms the rows are spread into complex numbers */
+    priv->real = ufo_fft_supports_real ();
+
+    priv->context = ufo_resources_get_context (resources);
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainContext (priv->context), error);
+
+    priv->pad_kernel = ufo_resources_get_kernel (resources, "fft.cl", priv->real ? "fft_pad_real" : "fft_spread", NULL, error);
+
+    if (priv->pad_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->pad_kernel), error);
+
+    priv->pack_kernel = ufo_resources_get_kernel (resources, "fft.cl", priv->real ? "fft_pack_real" : "fft_pack", NULL, error);
+
+    if (priv->pack_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->pack_kernel), error);
+
+    priv->filter_kernel = ufo_resources_get_kernel (resources, "filter.cl", "filter", NULL, error);
+
+    if (priv->filter_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->filter_kernel), error);
+
+    priv->convolve_kernel = ufo_resources_get_kernel (resources, "filter.cl", "filter_convolve", NULL, error);
+
+    if (priv->convolve_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->convolve_kernel), error);
+}
+
+static void
+ufo_fbp_filter_task_get_requisition (UfoTask *task,
+                                     UfoBuffer **inputs,
+                                     UfoRequisition *requisition,
+                                     GError **error)
+{
+    UfoFbpFilterTaskPrivate *priv;
+    UfoProfiler *profiler;
+    UfoFftParameter param = { 0, };
+    cl_command_queue queue;
+    gsize width, size, num_rows;
+
+    priv = UFO_FBP_FILTER_TASK_GET_PRIVATE (task);
+    ufo_buffer_get_requisition (inputs[0], requisition);
+
+    /* Pad to at least twice the width to avoid wrap-around of the convolution */
+    width = requisition->dims[0];
+    size = ufo_fft_get_padded_size (2 * width, priv->smooth);
+    num_rows = requisition->dims[1] * (requisition->n_dims == 3 ? requisition->dims[2] : 1);
+
+    if (width == priv->width && size == priv->size && num_rows == priv->num_rows)
+        return;
+
+    release_buffers (priv);
+    priv->width = width;
+    priv->size = size;
+    priv->num_rows = num_rows;
+
+    queue = ufo_gpu_node_get_cmd_queue (UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task))));
+    priv->convolve = use_convolution (priv, queue, width);
+
+    if (priv->convolve) {
+        gfloat *taps;
+
+        /* Taps up to the row width, beyond they never overlap the row */
+        taps = ufo_filter_compute_taps (&priv->filter, width);
+        priv->taps_mem = create_buffer (priv, width, taps, error);
+        g_free (taps);
+        return;
+    }
+
+    /* All rows of all sinograms are one batch */
+    param.dimensions = UFO_FFT_1D;
+    param.size[0] = size;
+    param.size[1] = 1;
+    param.size[2] = 1;
+    param.batch = num_rows;
+    param.zeropad = TRUE;
+    param.type = priv->real ? UFO_FFT_REAL_TO_COMPLEX : UFO_FFT_COMPLEX_TO_COMPLEX;
+
+    profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (ufo_fft_update (priv->forward, priv->context, queue, &param), error);
+
+    param.type = priv->real ? UFO_FFT_COMPLEX_TO_REAL : UFO_FFT_COMPLEX_TO_COMPLEX;
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (ufo_fft_update (priv->backward, priv->context, queue, &param), error);
+
+    priv->padded = create_buffer (priv, (priv->real ? 1 : 2) * size * num_rows, NULL, error);
+
+    if (priv->padded == NULL)
+        return;
+
+    if (priv->real) {
+        priv->spectrum = create_buffer (priv, 2 * (size / 2 + 1) * num_rows, NULL, error);
+
+        if (priv->spectrum == NULL)
+            return;
+    }
+
+    create_filter (priv, queue, profiler, error);
+}
+
+static guint
+ufo_fbp_filter_task_get_num_inputs (UfoTask *task)
+{
+    return 1;
+}
+
+static guint
+ufo_fbp_filter_task_get_num_dimensions (UfoTask *task,
+                                        guint input)
+{
+    g_return_val_if_fail (input == 0, 0);
+    return 2;
+}
+
+static UfoTaskMode
+ufo_fbp_filter_task_get_mode (UfoTask *task)
+{
+    return UFO_TASK_MODE_PROCESSOR | UFO_TASK_MODE_GPU;
+}
+
+static gboolean
+ufo_fbp_filter_task_process (UfoTask *task,
+                             UfoBuffer **inputs,
+                             UfoBuffer *output,
+                             UfoRequisition *requisition)
+{
+    UfoFbpFilterTaskPrivate *priv;
+    UfoProfiler *profiler;
+    cl_command_queue queue;
+    cl_mem in_mem, out_mem, spectrum;
+    cl_int width, num_rows, size;
+    gfloat scale;
+    gsize global_work_size[3];
+
+    priv = UFO_FBP_FILTER_TASK_GET_PRIVATE (task);
+    profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
+    queue = ufo_gpu_node_get_cmd_queue (UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task))));
+    in_mem = ufo_buffer_get_device_array (inputs[0], queue);
+    out_mem = ufo_buffer_get_device_array (output, queue);
+
+    width = (cl_int) requisition->dims[0];
+    num_rows = (cl_int) priv->num_rows;
+    size = (cl_int) priv->size;
+    spectrum = priv->real ? priv->spectrum : priv->padded;
+
+    if (priv->convolve) {
+        gsize local_work_size[2];
+        cl_int num_taps = width;
+
+        /* One work group per row */
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convolve_kernel, 0, sizeof (cl_mem), &in_mem));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convolve_kernel, 1, sizeof (cl_mem), &out_mem));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convolve_kernel, 2, sizeof (cl_mem), &priv->taps_mem));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convolve_kernel, 3, sizeof (cl_int), &width));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convolve_kernel, 4, sizeof (cl_int), &num_taps));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convolve_kernel, 5, (width + 2 * (num_taps - 1)) * sizeof (gfloat), NULL));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convolve_kernel, 6, num_taps * sizeof (gfloat), NULL));
+
+        local_work_size[0] = priv->local_size;
+        local_work_size[1] = 1;
+        global_work_size[0] = priv->local_size;
+        global_work_size[1] = priv->num_rows;
+        ufo_profiler_call (profiler, queue, priv->convolve_kernel, 2, global_work_size, local_work_size);
+
+        return TRUE;
+    }
+
+    /* Zero-pad */
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pad_kernel, 0, sizeof (cl_mem), &priv->padded));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pad_kernel, 1, sizeof (cl_mem), &in_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pad_kernel, 2, sizeof (cl_int), &width));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pad_kernel, 3, sizeof (cl_int), &num_rows));
+
+    global_work_size[0] = priv->size;
+    global_work_size[1] = priv->num_rows;
+    global_work_size[2] = 1;
+    ufo_profiler_call (profiler, queue, priv->pad_kernel, 3, global_work_size, NULL);
+
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->forward, queue, profiler, priv->padded, spectrum,
+                                                UFO_FFT_FORWARD, 0, NULL, NULL));
+
+    /* Filter, a Hermitian spectrum holds only the first size / 2 + 1 values */
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->filter_kernel, 0, sizeof (cl_mem), &spectrum));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->filter_kernel, 1, sizeof (cl_mem), &spectrum));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->filter_kernel, 2, sizeof (cl_mem), &priv->filter_mem));
+
+    global_work_size[0] = priv->real ? 2 * (priv->size / 2 + 1) : 2 * priv->size;
+    ufo_profiler_call (profiler, queue, priv->filter_kernel, 2, global_work_size, NULL);
+
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->backward, queue, profiler, spectrum, priv->padded,
+                                                UFO_FFT_BACKWARD, 0, NULL, NULL));
+
+    /* Crop and scale like ifft */
+    scale = 1.0f / size;
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 0, sizeof (cl_mem), &priv->padded));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 1, sizeof (cl_mem), &out_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 2, sizeof (cl_int), priv->real ? &size : &width));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 3, sizeof (cl_int), &num_rows));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 4, sizeof (gfloat), &scale));
+
+    global_work_size[0] = priv->real ? requisition->dims[0] : priv->size;
+    ufo_profiler_call (profiler, queue, priv->pack_kernel, 3, global_work_size, NULL);
+
+    return TRUE;
+}
+
+static void
+ufo_fbp_filter_task_set_property (GObject *object,
+                                  guint property_id,
+                                  const GValue *value,
+                                  GParamSpec *pspec)
+{
+    UfoFbpFilterTaskPrivate *priv = UFO_FBP_FILTER_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_FILTER:
+            priv->filter.type = g_value_get_enum (value);
+            break;
+        case PROP_CUTOFF:
+            priv->filter.cutoff = g_value_get_float (value);
+            break;
+        case PROP_BW_ORDER:
+            priv->filter.bw_order = g_value_get_float (value);
+            break;
+        case PROP_FB_TAU:
+            priv->filter.fb_tau = g_value_get_float (value);
+            break;
+        case PROP_FB_THETA:
+            priv->filter.fb_theta = g_value_get_float (value);
+            break;
+        case PROP_SCALE:
+            priv->filter.scale = g_value_get_float (value);
+            break;
+        case PROP_SMOOTH_PADDING:
+            priv->smooth = g_value_get_boolean (value);
+            break;
+        case PROP_CONVOLUTION_WIDTH:
+            priv->convolution_width = g_value_get_uint (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_fbp_filter_task_get_property (GObject *object,
+                                  guint property_id,
+                                  GValue *value,
+                                  GParamSpec *pspec)
+{
+    UfoFbpFilterTaskPrivate *priv = UFO_FBP_FILTER_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_FILTER:
+            g_value_set_enum (value, priv->filter.type);
+            break;
+        case PROP_CUTOFF:
+            g_value_set_float (value, priv->filter.cutoff);
+            break;
+        case PROP_BW_ORDER:
+            g_value_set_float (value, priv->filter.bw_order);
+            break;
+        case PROP_FB_TAU:
+            g_value_set_float (value, priv->filter.fb_tau);
+            break;
+        case PROP_FB_THETA:
+            g_value_set_float (value, priv->filter.fb_theta);
+            break;
+        case PROP_SCALE:
+            g_value_set_float (value, priv->filter.scale);
+            break;
+        case PROP_SMOOTH_PADDING:
+            g_value_set_boolean (value, priv->smooth);
+            break;
+        case PROP_CONVOLUTION_WIDTH:
+            g_value_set_uint (value, priv->convolution_width);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_fbp_filter_task_finalize (GObject *object)
+{
+    UfoFbpFilterTaskPrivate *priv;
+
+    priv = UFO_FBP_FILTER_TASK_GET_PRIVATE (object);
+    release_buffers (priv);
+
+    if (priv->pad_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->pad_kernel));
+        priv->pad_kernel = NULL;
+    }
+
+    if (priv->filter_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->filter_kernel));
+        priv->filter_kernel = NULL;
+    }
+
+    if (priv->pack_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->pack_kernel));
+        priv->pack_kernel = NULL;
+    }
+
+    if (priv->convolve_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->convolve_kernel));
+        priv->convolve_kernel = NULL;
+    }
+
+    if (priv->context) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
+        priv->context = NULL;
+    }
+
+    if (priv->forward) {
+        ufo_fft_destroy (priv->forward);
+        priv->forward = NULL;
+    }
+
+    if (priv->backward) {
+        ufo_fft_destroy (priv->backward);
+        priv->backward = NULL;
+    }
+
+    G_OBJECT_CLASS (ufo_fbp_filter_task_parent_class)->finalize (object);
+}
+
+static void
+ufo_task_interface_init (UfoTaskIface *iface)
+{
+    iface->setup = ufo_fbp_filter_task_setup;
+    iface->get_requisition = ufo_fbp_filter_task_get_requisition;
+    iface->get_num_inputs = ufo_fbp_filter_task_get_num_inputs;
+    iface->get_num_dimensions = ufo_fbp_filter_task_get_num_dimensions;
+    iface->get_mode = ufo_fbp_filter_task_get_mode;
+    iface->process = ufo_fbp_filter_task_process;
+}
+
+static void
+ufo_fbp_filter_task_class_init (UfoFbpFilterTaskClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+    oclass->finalize = ufo_fbp_filter_task_finalize;
+    oclass->set_property = ufo_fbp_filter_task_set_property;
+    oclass->get_property = ufo_fbp_filter_task_get_property;
+
+    properties[PROP_FILTER] =
+        g_param_spec_enum ("filter",
+            "Type of filter (\"ramp\", \"ramp-fromreal\", \"butterworth\", \"faris-byer\", \"hamming\", \"bh3\", \"shepp-logan\")",
+            "Type of filter (\"ramp\", \"ramp-fromreal\", \"butterworth\", \"faris-byer\", \"hamming\", \"bh3\", \"shepp-logan\")",
+            g_enum_register_static ("fbp-filter", ufo_filter_type_values),
+            UFO_FILTER_RAMP_FROMREAL, G_PARAM_READWRITE);
+
+    properties[PROP_CUTOFF] =
+        g_param_spec_float ("cutoff",
+            "Relative cutoff frequency",
+            "Relative cutoff frequency",
+            0.0f, 1.0f, 0.5f,
+            G_PARAM_READWRITE);
+
+    properties[PROP_BW_ORDER] =
+        g_param_spec_float ("order",
+            "Order of the Butterworth filter",
+            "Order of the Butterworth filter",
+            2.0f, 32.0f, 4.0f,
+            G_PARAM_READWRITE);
+
+    properties[PROP_FB_TAU] =
+        g_param_spec_float ("tau",
+            "Tau parameter for Faris-Byer filter",
+            "Tau parameter for Faris-Byer filter",
+            -G_MAXFLOAT, G_MAXFLOAT, 0.1f,
+            G_PARAM_READWRITE);
+
+    properties[PROP_FB_THETA] =
+        g_param_spec_float ("theta",
+            "Theta parameter for Faris-Byer filter",
+            "Theta parameter for Faris-Byer filter",
+            -G_MAXFLOAT, G_MAXFLOAT, 1.0f,
+            G_PARAM_READWRITE);
+
+    properties[PROP_SCALE] =
+        g_param_spec_float ("scale",
+            "Every component is multiplied by scale",
+            "Every component is multiplied by scale",
+            -G_MAXFLOAT, G_MAXFLOAT, 1.0f,
+            G_PARAM_READWRITE);
+
+    properties[PROP_SMOOTH_PADDING] =
+        g_param_spec_boolean ("smooth-padding",
+            "Pad to the next size with prime factors 2, 3, 5 and 7 instead of the next power of 2",
+            "Pad to the next size with prime factors 2, 3, 5 and 7 instead of the next power of 2",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_CONVOLUTION_WIDTH] =
+        g_param_spec_uint ("convolution-width",
+            "Maximum row width which is convolved in real space instead of filtered in Fourier space",
+            "Maximum row width which is convolved in real space instead of filtered in Fourier space",
+            0, G_MAXUINT, 512,
+            G_PARAM_READWRITE);
+
+    for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
+        g_object_class_install_property (oclass, i, properties[i]);
+
+    g_type_class_add_private (klass, sizeof (UfoFbpFilterTaskPrivate));
+}
+
+static void
+ufo_fbp_filter_task_init (UfoFbpFilterTask *self)
+{
+    UfoFbpFilterTaskPrivate *priv;
+
+    self->priv = priv = UFO_FBP_FILTER_TASK_GET_PRIVATE (self);
+    priv->context = NULL;
+    priv->pad_kernel = NULL;
+    priv->filter_kernel = NULL;
+    priv->pack_kernel = NULL;
+    priv->convolve_kernel = NULL;
+    priv->padded = NULL;
+    priv->spectrum = NULL;
+    priv->filter_mem = NULL;
+    priv->taps_mem = NULL;
+    priv->forward = ufo_fft_new ();
+    priv->backward = ufo_fft_new ();
+    priv->filter.type = UFO_FILTER_RAMP_FROMREAL;
+    priv->filter.cutoff = 0.5f;
+    priv->filter.bw_order = 4.0f;
+    priv->filter.fb_tau = 0.1f;
+    priv->filter.fb_theta = 1.0f;
+    priv->filter.scale = 1.0f;
+    priv->smooth = FALSE;
+    priv->convolve = FALSE;
+    priv->convolution_width = 512;
+    priv->local_size = 0;
+    priv->width = 0;
+    priv->size = 0;
+    priv->num_rows = 0;
+}
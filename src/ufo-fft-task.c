@@ -35,8 +35,12 @@ struct _UfoFftTaskPrivate {
 
     cl_context context;
     cl_kernel kernel;
+    cl_mem padded;
+    gsize padded_size;
 
     gboolean zeropad;
+    gboolean smooth;
+    gboolean hermitian;
 };
 
 static void ufo_task_interface_init (UfoTaskIface *iface);
@@ -54,6 +58,8 @@ enum {
     PROP_SIZE_X,
     PROP_SIZE_Y,
     PROP_SIZE_Z,
+    PROP_HERMITIAN,
+    PROP_SMOOTH_PADDING,
     N_PROPERTIES
 };
 
@@ -65,18 +71,6 @@ ufo_fft_task_new (void)
     return UFO_NODE (g_object_new (UFO_TYPE_FFT_TASK, NULL));
 }
 
-static guint32
-pow2round(guint32 x)
-{
-    --x;
-    x |= x >> 1;
-    x |= x >> 2;
-    x |= x >> 4;
-    x |= x >> 8;
-    x |= x >> 16;
-    return x+1;
-}
-
 static void
 ufo_fft_task_setup (UfoTask *task,
                     UfoResources *resources,
@@ -87,7 +81,9 @@ ufo_fft_task_setup (UfoTask *task,
     priv = UFO_FFT_TASK_GET_PRIVATE (task);
 
     if (priv->zeropad) {
-        priv->kernel = ufo_resources_get_kernel (resources, "fft.cl", "fft_spread", NULL, error);
+        priv->kernel = ufo_resources_get_kernel (resources, "fft.cl",
+                                                 priv->hermitian ? "fft_pad_real" : "fft_spread",
+                                                 NULL, error);
     }
 
     priv->context = ufo_resources_get_context (resources);
@@ -106,12 +102,19 @@ ufo_fft_task_get_requisition (UfoTask *task,
     UfoFftTaskPrivate *priv;
     UfoRequisition in_req;
     cl_command_queue queue;
+    gsize padded_size;
+    cl_int cl_error;
 
     priv = UFO_FFT_TASK_GET_PRIVATE (task);
     ufo_buffer_get_requisition (inputs[0], &in_req);
 
     priv->param.zeropad = priv->zeropad;
-    priv->param.size[0] = priv->zeropad ? pow2round (in_req.dims[0]) : in_req.dims[0] / 2;
+    priv->param.type = priv->hermitian ? UFO_FFT_REAL_TO_COMPLEX : UFO_FFT_COMPLEX_TO_COMPLEX;
+
+    if (priv->zeropad)
+        priv->param.size[0] = ufo_fft_get_padded_size (in_req.dims[0], priv->smooth);
+    else
+        priv->param.size[0] = priv->hermitian ? in_req.dims[0] : in_req.dims[0] / 2;
 
     switch (priv->param.dimensions) {
         case UFO_FFT_1D:
@@ -119,7 +122,7 @@ ufo_fft_task_get_requisition (UfoTask *task,
             break;
 
         case UFO_FFT_2D:
-            priv->param.size[1] = priv->zeropad ? pow2round (in_req.dims[1]) : in_req.dims[1];
+            priv->param.size[1] = priv->zeropad ? ufo_fft_get_padded_size (in_req.dims[1], priv->smooth) : in_req.dims[1];
             priv->param.batch = in_req.n_dims == 3 ? in_req.dims[2] : 1;
             break;
 
@@ -131,8 +134,31 @@ ufo_fft_task_get_requisition (UfoTask *task,
     UFO_RESOURCES_CHECK_SET_AND_RETURN (ufo_fft_update (priv->fft, priv->context, queue, &priv->param), error);
 
     *requisition = in_req;  /* keep third dimension for 2D batching */
-    requisition->dims[0] = 2 * priv->param.size[0];
+    requisition->dims[0] = 2 * (priv->hermitian ? priv->param.size[0] / 2 + 1 : priv->param.size[0]);
     requisition->dims[1] = priv->param.dimensions == UFO_FFT_1D ? in_req.dims[1] : priv->param.size[1];
+
+    /* Real input is transformed out-of-place, so it needs a separate buffer
+     * only if it has to be padded */
+    padded_size = 0;
+
+    if (priv->hermitian && priv->zeropad &&
+        (priv->param.size[0] != in_req.dims[0] || requisition->dims[1] != in_req.dims[1])) {
+        padded_size = priv->param.size[0] * requisition->dims[1] * (in_req.n_dims == 3 ? in_req.dims[2] : 1);
+    }
+
+    if (padded_size != priv->padded_size) {
+        if (priv->padded) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->padded));
+            priv->padded = NULL;
+        }
+
+        if (padded_size) {
+            priv->padded = clCreateBuffer (priv->context, CL_MEM_READ_WRITE, padded_size * sizeof (gfloat), NULL, &cl_error);
+            UFO_RESOURCES_CHECK_SET_AND_RETURN (cl_error, error);
+        }
+
+        priv->padded_size = padded_size;
+    }
 }
 
 static guint
@@ -172,9 +198,11 @@ ufo_fft_task_process (UfoTask *task,
     UfoFftTaskPrivate *priv;
     UfoRequisition in_req;
     UfoProfiler *profiler;
+    GValue hermitian = {0,};
     cl_command_queue queue;
     cl_mem in_mem;
     cl_mem out_mem;
+    cl_mem fft_mem;
     cl_int width;
     cl_int height;
     gsize global_work_size[3];
@@ -188,6 +216,40 @@ ufo_fft_task_process (UfoTask *task,
     ufo_buffer_get_requisition (inputs[0], &in_req);
     ufo_buffer_set_layout (output, UFO_BUFFER_LAYOUT_COMPLEX_INTERLEAVED);
 
+    /* Frequency filters must not mistake a half spectrum for a full one */
+    g_value_init (&hermitian, G_TYPE_BOOLEAN);
+    g_value_set_boolean (&hermitian, priv->hermitian);
+    ufo_buffer_set_metadata (output, UFO_FFT_METADATA_HERMITIAN, &hermitian);
+    g_value_unset (&hermitian);
+
+    if (priv->hermitian) {
+        fft_mem = in_mem;
+
+        if (priv->padded) {
+            width = (cl_int) in_req.dims[0];
+            height = (cl_int) in_req.dims[1];
+
+            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 0, sizeof (cl_mem), (gpointer) &priv->padded));
+            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 1, sizeof (cl_mem), (gpointer) &in_mem));
+            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 2, sizeof (cl_int), &width));
+            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 3, sizeof (cl_int), &height));
+
+            global_work_size[0] = priv->param.size[0];
+            global_work_size[1] = requisition->dims[1];
+            global_work_size[2] = requisition->n_dims == 3 ? requisition->dims[2] : 1;
+
+            UFO_RESOURCES_CHECK_CLERR (clEnqueueNDRangeKernel (queue, priv->kernel,
+                                                               3, NULL, global_work_size, NULL,
+                                                               0, NULL, NULL));
+            fft_mem = priv->padded;
+        }
+
+        UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->fft, queue, profiler,
+                                                    fft_mem, out_mem, UFO_FFT_FORWARD,
+                                                    0, NULL, NULL));
+        return TRUE;
+    }
+
     if (priv->zeropad){
         width = (cl_int) in_req.dims[0];
         height = (cl_int) in_req.dims[1];
@@ -226,6 +288,11 @@ ufo_fft_task_finalize (GObject *object)
         priv->kernel = NULL;
     }
 
+    if (priv->padded) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->padded));
+        priv->padded = NULL;
+    }
+
     if (priv->context) {
         UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
         priv->context = NULL;
@@ -274,6 +341,12 @@ ufo_fft_task_set_property (GObject *object,
         case PROP_SIZE_Z:
             priv->param.size[2] = g_value_get_uint (value);
             break;
+        case PROP_HERMITIAN:
+            priv->hermitian = g_value_get_boolean (value);
+            break;
+        case PROP_SMOOTH_PADDING:
+            priv->smooth = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -304,6 +377,12 @@ ufo_fft_task_get_property (GObject *object,
         case PROP_SIZE_Z:
             g_value_set_uint (value, priv->param.size[2]);
             break;
+        case PROP_HERMITIAN:
+            g_value_set_boolean (value, priv->hermitian);
+            break;
+        case PROP_SMOOTH_PADDING:
+            g_value_set_boolean (value, priv->smooth);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -358,6 +437,20 @@ ufo_fft_task_class_init (UfoFftTaskClass *klass)
             1, 8192, 1,
             G_PARAM_READWRITE);
 
+    properties[PROP_HERMITIAN] =
+        g_param_spec_boolean("hermitian",
+            "Transform real input and output only the non-redundant half spectrum",
+            "Transform real input and output only the non-redundant half spectrum",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_SMOOTH_PADDING] =
+        g_param_spec_boolean("smooth-padding",
+            "Zeropad to the next size with prime factors 2, 3, 5 and 7 instead of the next power of 2",
+            "Zeropad to the next size with prime factors 2, 3, 5 and 7 instead of the next power of 2",
+            FALSE,
+            G_PARAM_READWRITE);
+
     for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (oclass, i, properties[i]);
 
@@ -374,6 +467,10 @@ ufo_fft_task_init (UfoFftTask *self)
     self->priv = priv = UFO_FFT_TASK_GET_PRIVATE (self);
 
     priv->kernel = NULL;
+    priv->padded = NULL;
+    priv->padded_size = 0;
+    priv->hermitian = FALSE;
+    priv->smooth = FALSE;
     priv->zeropad = TRUE;
     priv->fft = ufo_fft_new ();
     priv->param.dimensions = UFO_FFT_1D;
@@ -25,6 +25,7 @@
 #include <math.h>
 
 #include "ufo-filter-stripes-task.h"
+#include "common/ufo-fft.h"
 
 
 struct _UfoFilterStripesTaskPrivate {
@@ -98,6 +99,16 @@ ufo_filter_stripes_task_setup (UfoTask *task,
         UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->kernel), error);
 }
 
+static gboolean
+is_half_spectrum (UfoBuffer *buffer)
+{
+    GValue *value;
+
+    value = ufo_buffer_get_metadata (buffer, UFO_FFT_METADATA_HERMITIAN);
+
+    return value != NULL && g_value_get_boolean (value);
+}
+
 static void
 ufo_filter_stripes_task_get_requisition (UfoTask *task,
                                          UfoBuffer **inputs,
@@ -105,6 +116,12 @@ ufo_filter_stripes_task_get_requisition (UfoTask *task,
                                          GError **error)
 {
     ufo_buffer_get_requisition (inputs[0], requisition);
+
+    if (is_half_spectrum (inputs[0])) {
+        g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                             "filter-stripes: input is a half spectrum, use fft with hermitian=false");
+        return;
+    }
 }
 
 static guint
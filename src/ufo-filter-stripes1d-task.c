@@ -25,6 +25,7 @@
 #include <math.h>
 
 #include "ufo-filter-stripes1d-task.h"
+#include "common/ufo-fft.h"
 
 
 struct _UfoFilterStripes1dTaskPrivate {
@@ -122,6 +123,16 @@ ufo_filter_stripes1d_task_setup (UfoTask *task,
         UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->kernel), error);
 }
 
+static gboolean
+is_half_spectrum (UfoBuffer *buffer)
+{
+    GValue *value;
+
+    value = ufo_buffer_get_metadata (buffer, UFO_FFT_METADATA_HERMITIAN);
+
+    return value != NULL && g_value_get_boolean (value);
+}
+
 static void
 ufo_filter_stripes1d_task_get_requisition (UfoTask *task,
                                            UfoBuffer **inputs,
@@ -133,6 +144,12 @@ ufo_filter_stripes1d_task_get_requisition (UfoTask *task,
     priv = UFO_FILTER_STRIPES1D_TASK_GET_PRIVATE (task);
     ufo_buffer_get_requisition (inputs[0], requisition);
 
+    if (is_half_spectrum (inputs[0])) {
+        g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                             "filter-stripes1d: input is a half spectrum, use fft with hermitian=false");
+        return;
+    }
+
     if (!priv->filter_mem || requisition->dims[0] / 2 != priv->last_width)
         create_coefficients (priv, requisition->dims[0] / 2);
 }
@@ -26,6 +26,7 @@
 
 #include "ufo-filter-task.h"
 #include "common/ufo-fft.h"
+#include "common/ufo-filter-coefficients.h"
 
 /**
  * SECTION:ufo-filter-task
@@ -37,43 +38,7 @@
  * #UfoFilterTask:filter property.
  */
 
-typedef void (*SetupFunc)(UfoFilterTaskPrivate *priv, gfloat *coefficients, guint width);
-
 static void ufo_task_interface_init (UfoTaskIface *iface);
-static void compute_ramp_coefficients (UfoFilterTaskPrivate *, gfloat *, guint);
-static void compute_real_space_ramp_coefficients (UfoFilterTaskPrivate *, gfloat *, guint);
-static void compute_butterworth_coefficients (UfoFilterTaskPrivate *, gfloat *, guint);
-static void compute_faris_byer_coefficients (UfoFilterTaskPrivate *, gfloat *, guint);
-static void compute_hamming_coefficients (UfoFilterTaskPrivate *, gfloat *, guint);
-static void compute_bh3_coefficients (UfoFilterTaskPrivate *, gfloat *, guint);
-
-typedef enum {
-    FILTER_RAMP = 0,
-    FILTER_RAMP_FROMREAL,
-    FILTER_BUTTERWORTH,
-    FILTER_FARIS_BYER,
-    FILTER_HAMMING,
-    FILTER_BH3,
-} Filter;
-
-static GEnumValue filter_values[] = {
-    { FILTER_RAMP,          "FILTER_RAMP",          "ramp" },
-    { FILTER_RAMP_FROMREAL, "FILTER_RAMP_FROMREAL", "ramp-fromreal" },
-    { FILTER_BUTTERWORTH,   "FILTER_BUTTERWORTH",   "butterworth"},
-    { FILTER_FARIS_BYER,    "FILTER_FARIS_BYER",    "faris-byer"},
-    { FILTER_HAMMING,       "FILTER_HAMMING",       "hamming"},
-    { FILTER_BH3,           "FILTER_BH3",           "bh3" },
-    { 0, NULL, NULL}
-};
-
-static SetupFunc filter_funcs[] = {
-    &compute_ramp_coefficients,
-    &compute_real_space_ramp_coefficients,
-    &compute_butterworth_coefficients,
-    &compute_faris_byer_coefficients,
-    &compute_hamming_coefficients,
-    &compute_bh3_coefficients,
-};
 
 struct _UfoFilterTaskPrivate {
     cl_context context;
@@ -84,7 +49,7 @@ struct _UfoFilterTaskPrivate {
     gfloat fb_tau;
     gfloat fb_theta;
     gfloat scale;
-    Filter filter;
+    UfoFilterType filter;
     UfoFft *fft;
 };
 
@@ -158,120 +123,14 @@ ufo_filter_task_setup (UfoTask *task,
         UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->kernel), error);
 }
 
-static void
-mirror_coefficients (gfloat *filter, guint width)
-{
-    for (guint k = width/2 + 2; k < width; k += 2) {
-        filter[k] = filter[width - k];
-        filter[k + 1] = filter[width - k + 1];
-    }
-}
-
-static void
-compute_ramp_coefficients (UfoFilterTaskPrivate *priv,
-                           gfloat *filter,
-                           guint width)
-{
-    const gdouble step = 2.0 / width;
-
-    for (guint k = 1; k < width / 4 + 1; k++) {
-        filter[2*k] = k * step * priv->scale;
-        filter[2*k + 1] = filter[2*k];
-    }
-}
-
-static void
-compute_real_space_ramp_coefficients (UfoFilterTaskPrivate *priv,
-                                      gfloat *filter,
-                                      guint width)
-{
-    filter[0] = filter[1] = 0.25 * priv->scale;
-
-    for (guint k = 1; k < width / 4 + 1; k++) {
-        filter[2*k] = k % 2 ? - priv->scale / (k * k * G_PI * G_PI) : 0.0;
-        filter[2*k + 1] = filter[2*k];
-    }
-}
-
-static void
-compute_butterworth_coefficients (UfoFilterTaskPrivate *priv,
-                                  gfloat *filter,
-                                  guint width)
-{
-    const gdouble step = 2.0 / width;
-
-    for (guint k = 0; k < (width / 4) + 1; k++) {
-        const gdouble f = k * step;
-        filter[2*k] = (gfloat) (f / (1.0 + pow (f / priv->cutoff, 2.0 * priv->bw_order)) * priv->scale);
-        filter[2*k+1] = filter[2*k];
-    }
-}
-
-static void
-compute_hamming_coefficients (UfoFilterTaskPrivate *priv,
-                              gfloat *filter,
-                              guint width)
-{
-    const gdouble step = 2.0 / width;
-
-    for (guint k = 0; k < (width / 4) + 1; k++) {
-        const gdouble f = k * step;
-
-        filter[2*k] = f < priv->cutoff ? f * (0.54 + 0.46 * cos (G_PI * f / priv->cutoff)) * priv->scale : 0;
-        filter[2*k+1] = filter[2*k];
-    }
-}
-
-static void
-compute_bh3_coefficients (UfoFilterTaskPrivate *priv,
-                           gfloat *filter,
-                           guint width)
-{
-    const gdouble step = 2.0 / width;
-    const gdouble a0 = 0.42;
-    const gdouble a1 = 0.5;
-    const gdouble a2 = 0.08;
-    for (guint k = 1; k < width / 4 + 1; k++) {
-        const gdouble f = k * step;
-        filter[2*k] = f * ( a0 + a1 * cos(f * G_PI) + a2 * cos(2.0 * f * G_PI ) ) * priv->scale;
-        filter[2*k + 1] = filter[2*k];
-    }
-}
-
-static guint
-get_padding_value (guint x)
-{
-    guint padding = 2 * x;
-    guint result = 1;
-
-    while (result < padding)
-        result *= 2;
-
-    return result;
-}
-
-static void
-compute_faris_byer_coefficients (UfoFilterTaskPrivate *priv,
-                                 gfloat *filter,
-                                 guint width)
+static gboolean
+is_half_spectrum (UfoBuffer *buffer)
 {
-    const gdouble pi_squared_tau = G_PI * G_PI * priv->fb_tau;
-    const gdouble sin_theta_2 = - sin (priv->fb_theta) / 2;
-    const guint padding = get_padding_value (width);
-
-    filter[0] = 0;
-
-    for (guint x = 1; x <= width / 2; x++) {
-        if (x % 2 != 0)
-            filter[x] = 1 / (pi_squared_tau * x);
-    }
+    GValue *value;
 
-    for (guint i = width / 2 + 1; i < width; i++) {
-        guint x = width + 1 - i;
+    value = ufo_buffer_get_metadata (buffer, UFO_FFT_METADATA_HERMITIAN);
 
-        if (x % 2 != 0)
-            filter[padding - width - i - 1] = sin_theta_2 / (x * x * pi_squared_tau);
-    }
+    return value != NULL && g_value_get_boolean (value);
 }
 
 static void
@@ -285,19 +144,27 @@ ufo_filter_task_get_requisition (UfoTask *task,
     priv = UFO_FILTER_TASK_GET_PRIVATE (task);
     ufo_buffer_get_requisition (inputs[0], requisition);
 
+    if (is_half_spectrum (inputs[0])) {
+        g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                             "filter: input is a half spectrum, use fft with hermitian=false");
+        return;
+    }
+
     if (priv->filter_mem == NULL) {
+        UfoFilterParameter filter_param;
         cl_int cl_err;
         guint width;
         gfloat *coefficients;
 
-        width = (guint) requisition->dims[0];
-        coefficients = g_malloc0 (width * sizeof (gfloat));
-
-        coefficients[0] = 0.5 / width;
-        coefficients[1] = coefficients[0];
+        filter_param.type = priv->filter;
+        filter_param.cutoff = priv->cutoff;
+        filter_param.bw_order = priv->bw_order;
+        filter_param.fb_tau = priv->fb_tau;
+        filter_param.fb_theta = priv->fb_theta;
+        filter_param.scale = priv->scale;
 
-        filter_funcs[priv->filter] (priv, coefficients, width);
-        mirror_coefficients (coefficients, width);
+        width = (guint) requisition->dims[0];
+        coefficients = ufo_filter_compute_coefficients (&filter_param, width);
 
         priv->filter_mem = clCreateBuffer (priv->context,
                                            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
@@ -307,7 +174,7 @@ ufo_filter_task_get_requisition (UfoTask *task,
         UFO_RESOURCES_CHECK_CLERR (cl_err);
         g_free (coefficients);
 
-        if (priv->filter == FILTER_RAMP_FROMREAL) {
+        if (ufo_filter_is_real_space (priv->filter)) {
             UfoFftParameter param;
             cl_command_queue queue;
             UfoProfiler *profiler;
@@ -317,6 +184,8 @@ ufo_filter_task_get_requisition (UfoTask *task,
             param.size[1] = 1;
             param.size[2] = 1;
             param.batch = 1;
+            param.zeropad = TRUE;
+            param.type = UFO_FFT_COMPLEX_TO_COMPLEX;
 
             priv->fft = ufo_fft_new ();
             profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
@@ -473,9 +342,9 @@ ufo_filter_task_class_init (UfoFilterTaskClass *klass)
 
     properties[PROP_FILTER] =
         g_param_spec_enum ("filter",
-            "Type of filter (\"ramp\", \"ramp-fromreal\", \"butterworth\", \"faris-byer\", \"hamming\",\"bh3\")",
-            "Type of filter (\"ramp\", \"ramp-fromreal\", \"butterworth\", \"faris-byer\", \"hamming\",\"bh3\")",
-            g_enum_register_static ("filter", filter_values),
+            "Type of filter (\"ramp\", \"ramp-fromreal\", \"butterworth\", \"faris-byer\", \"hamming\", \"bh3\", \"shepp-logan\")",
+            "Type of filter (\"ramp\", \"ramp-fromreal\", \"butterworth\", \"faris-byer\", \"hamming\", \"bh3\", \"shepp-logan\")",
+            g_enum_register_static ("filter", ufo_filter_type_values),
             0, G_PARAM_READWRITE);
 
     properties[PROP_CUTOFF] =
@@ -528,7 +397,7 @@ ufo_filter_task_init (UfoFilterTask *self)
     self->priv = priv = UFO_FILTER_TASK_GET_PRIVATE (self);
     priv->kernel = NULL;
     priv->filter_mem = NULL;
-    priv->filter = FILTER_RAMP_FROMREAL;
+    priv->filter = UFO_FILTER_RAMP_FROMREAL;
     priv->cutoff = 0.5f;
     priv->bw_order = 4.0f;
     priv->fb_tau = 0.1f;
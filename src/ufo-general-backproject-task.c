@@ -35,6 +35,7 @@
 #include "common/ufo-scarray.h"
 #include "common/ufo-ctgeometry.h"
 #include "common/ufo-addressing.h"
+#include "common/ufo-tuning.h"
 #include "ufo-general-backproject-task.h"
 
 #define NUM_VECTOR_ARGUMENTS 11
@@ -45,6 +46,8 @@
                             ((ufo_scarray_get_int ((region), 1) - ufo_scarray_get_int ((region), 0) - 1) /\
                             ufo_scarray_get_int ((region), 2) + 1)
 #define NEXT_DIVISOR(dividend, divisor) ((dividend) + (divisor) - (dividend) % (divisor))
+/* Slices looped over by one work item of the fast parallel kernel */
+#define FAST_PARALLEL_SLICES 8
 #define DEFINE_FILL_SINCOS(type)                      \
 static void                                           \
 fill_sincos_##type (type *array, const gdouble angle) \
@@ -319,6 +322,10 @@ set_static_args_##type (UfoTask *task,
     for (j = 0; j < burst; j++) {                                                                                        \
         UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, i++, sizeof (cl_mem), &priv->projections[j]));                \
     }                                                                                                                    \
+    if (priv->matrices) {                                                                                                \
+        /* Skip tomographic angles, iteration, volume and region */                                                      \
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, i + burst + 3, sizeof (cl_mem), &priv->matrices));            \
+    }                                                                                                                    \
 }
 
 /*{{{ Enumerations */
@@ -342,6 +349,12 @@ typedef enum {
     ST_UINT
 } StoreType;
 
+typedef enum {
+    PT_FLOAT,
+    PT_HALF,
+    PT_UNORM16
+} ProjectionType;
+
 static const GEnumValue parameter_values[] = {
     { UFO_UNI_RECO_PARAMETER_AXIS_ROTATION_X,     "UFO_UNI_RECO_PARAMETER_AXIS_ROTATION_X",     "axis-angle-x" },
     { UFO_UNI_RECO_PARAMETER_AXIS_ROTATION_Y,     "UFO_UNI_RECO_PARAMETER_AXIS_ROTATION_Y",     "axis-angle-y" },
@@ -386,6 +399,13 @@ static GEnumValue st_values[] = {
     {ST_UINT,   "ST_UINT",   "uint"},
     { 0, NULL, NULL}
 };
+
+static GEnumValue pt_values[] = {
+    {PT_FLOAT,   "PT_FLOAT",   "float"},
+    {PT_HALF,    "PT_HALF",    "half"},
+    {PT_UNORM16, "PT_UNORM16", "unorm16"},
+    { 0, NULL, NULL}
+};
 /*}}}*/
 
 struct _UfoGeneralBackprojectTaskPrivate {
@@ -396,10 +416,37 @@ struct _UfoGeneralBackprojectTaskPrivate {
     UfoCTGeometry *geometry;
     ComputeType compute_type, result_type;
     StoreType store_type;
+    ProjectionType projection_type;
+    gdouble projection_scale, projection_offset;
     UfoUniRecoParameter parameter;
     gdouble gray_map_min, gray_map_max;
+    gboolean autotune;
+    gboolean multi_device;
+    gboolean overlap;
+    gboolean upload_queue;
+    gboolean out_of_core;
+    guint memory_budget;
+    gboolean projection_matrices;
     /* Private */
     gboolean vectorized;
+    gboolean with_axis, with_volume, perpendicular_detector, parallel_beam;
+    gboolean fast_parallel;
+    gboolean tuned;
+    guint max_regcount;
+    gsize local_work_size[3];
+    cl_command_queue *cmd_queues;
+    guint num_devices;
+    guint *chunk_devices;
+    guint num_image_sets, current_set;
+    cl_command_queue transfer_queue;
+    cl_event set_events[2];
+    gchar *host_projections;
+    gchar *staging;
+    cl_event *upload_events;
+    cl_kernel convert_kernel;
+    cl_mem matrices;
+    gsize projection_dims[2];
+    guint chunks_per_pass;
     guint generated;
     UfoResources *resources;
     cl_mem *projections;
@@ -457,6 +504,16 @@ enum {
     PROP_ADDRESSING_MODE,
     PROP_GRAY_MAP_MIN,
     PROP_GRAY_MAP_MAX,
+    PROP_AUTOTUNE,
+    PROP_MULTI_DEVICE,
+    PROP_OVERLAP,
+    PROP_UPLOAD_QUEUE,
+    PROP_OUT_OF_CORE,
+    PROP_MEMORY_BUDGET,
+    PROP_PROJECTION_TYPE,
+    PROP_PROJECTION_SCALE,
+    PROP_PROJECTION_OFFSET,
+    PROP_PROJECTION_MATRICES,
     N_PROPERTIES
 };
 
@@ -499,6 +556,81 @@ get_type_size (StoreType type)
     return size;
 }
 
+static gsize
+get_projection_type_size (ProjectionType type)
+{
+    return type == PT_FLOAT ? sizeof (cl_float) : sizeof (cl_half);
+}
+
+/**
+ * float_to_half:
+ * @value: single precision value
+ *
+ * Convert @value to IEEE 754 half precision with rounding to nearest.
+ */
+static guint16
+float_to_half (gfloat value)
+{
+    union { gfloat f; guint32 u; } bits;
+    guint32 sign, mantissa, half;
+    gint32 exponent;
+
+    bits.f = value;
+    sign = (bits.u >> 16) & 0x8000;
+    exponent = (gint32) ((bits.u >> 23) & 0xFF) - 127 + 15;
+    mantissa = bits.u & 0x7FFFFF;
+
+    if (exponent >= 31) {
+        /* Overflow becomes infinity, NaN stays NaN */
+        return sign | 0x7C00 | ((bits.u & 0x7F800000) == 0x7F800000 && mantissa ? 0x200 : 0);
+    }
+    if (exponent <= 0) {
+        /* Subnormal or zero */
+        if (exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        half = mantissa >> (14 - exponent);
+        if ((mantissa >> (13 - exponent)) & 1) {
+            half++;
+        }
+        return sign | half;
+    }
+
+    half = sign | ((guint32) exponent << 10) | (mantissa >> 13);
+    /* A carry propagates correctly into the exponent */
+    if (mantissa & 0x1000) {
+        half++;
+    }
+
+    return half;
+}
+
+/**
+ * convert_projection:
+ * @priv: task private data
+ * @src: projection in single precision
+ * @dst: (out): projection in the reduced projection type
+ * @n: number of pixels
+ *
+ * Host-side equivalent of the convert_to_projection_image kernel.
+ */
+static void
+convert_projection (UfoGeneralBackprojectTaskPrivate *priv, const gfloat *src, guint16 *dst, gsize n)
+{
+    gfloat value;
+    gsize i;
+
+    for (i = 0; i < n; i++) {
+        value = (src[i] - priv->projection_offset) / priv->projection_scale;
+        if (priv->projection_type == PT_HALF) {
+            dst[i] = float_to_half (value);
+        } else {
+            dst[i] = (guint16) (CLAMP (value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        }
+    }
+}
+
 static gulong
 get_integer_maximum (const gchar *type_name)
 {
@@ -628,7 +760,9 @@ make_template (UfoGeneralBackprojectTaskPrivate *priv)
         g_warning ("Error obtaining general backprojection kernel header template");
         return NULL;
     }
-    if (!(body = ufo_resources_get_kernel_source (priv->resources, "general_bp_body.in", NULL))) {
+    if (!(body = ufo_resources_get_kernel_source (priv->resources,
+                                                  priv->fast_parallel ? "general_bp_parallel_body.in" :
+                                                  "general_bp_body.in", NULL))) {
         g_warning ("Error obtaining general backprojection kernel body template");
         return NULL;
     }
@@ -654,6 +788,12 @@ make_template (UfoGeneralBackprojectTaskPrivate *priv)
             return NULL;
         }
     }
+    if (priv->projection_matrices) {
+        header_1 = replace_substring (header, "constant cfloat2 \\*region\\)",
+                                      "constant cfloat2 *region,\n                         global const float4 *matrices)");
+        g_free (header);
+        header = header_1;
+    }
     template = g_strconcat (definitions, header, body, NULL);
     g_free (definitions);
     g_free (header);
@@ -978,9 +1118,9 @@ make_transformations (UfoUniRecoParameter parameter, gboolean vectorized, gint b
     }
 
     /* Computational data type adjustment */
-    pixel_reading = g_strconcat ("\tresult += read_imagef (projection_%02d, sampler, ",
+    pixel_reading = g_strconcat ("\tresult += PROJECTION_VALUE (projection_%02d, ",
                                  !g_strcmp0 (compute_type, "float") ? "(" : "convert_float2(",
-                                 "voxel.xz + center_position[%d].xz)).x", NULL);
+                                 "voxel.xz + center_position[%d].xz))", NULL);
     current = g_stpcpy (current, pixel_reading);
     g_free (pixel_reading);
 
@@ -1031,6 +1171,91 @@ make_transformations (UfoUniRecoParameter parameter, gboolean vectorized, gint b
     return code;
 }
 
+/**
+ * make_matrix_transformations:
+ * @burst (in): number of processed projections in the kernel
+ * @parallel_beam: (in): is the beam parallel
+ *
+ * Make voxel projection by precomputed projection matrices. Each matrix has
+ * four rows, the first three map the homogeneous voxel to the homogeneous
+ * detector coordinates, the fourth gives the reciprocal FDK weight.
+ */
+static gchar *
+make_matrix_transformations (gint burst, gboolean parallel_beam)
+{
+    gint i;
+    gchar *code, *tmp, *str_index;
+    GString *result;
+    const gchar *code_fmt;
+
+    if (parallel_beam) {
+        code_fmt = "\t/* Tomographic rotation angle %02d */\n"
+                   "\tmatrix = matrices + 4 * (%d);\n"
+                   "\tvoxel.x = dot (matrix[0], voxel_h);\n"
+                   "\tvoxel.y = dot (matrix[1], voxel_h);\n"
+                   "\tresult += PROJECTION_VALUE (projection_%02d, voxel.xy);\n\n";
+    } else {
+        code_fmt = "\t/* Tomographic rotation angle %02d */\n"
+                   "\tmatrix = matrices + 4 * (%d);\n"
+                   "\tvoxel = (float3) (dot (matrix[0], voxel_h), dot (matrix[1], voxel_h), dot (matrix[2], voxel_h));\n"
+                   "\tcoeff = native_recip (dot (matrix[3], voxel_h));\n"
+                   "\tresult += PROJECTION_VALUE (projection_%02d, "
+                   "native_divide (voxel.xy, voxel.z)) * coeff * coeff;\n\n";
+    }
+
+    result = g_string_new (NULL);
+    for (i = 0; i < burst; i++) {
+        str_index = g_strdup_printf ("iteration + %d", i);
+        tmp = replace_substring (code_fmt, "%d", str_index);
+        g_free (str_index);
+        str_index = g_strdup_printf ("%02d", i);
+        code = replace_substring (tmp, "%02d", str_index);
+        g_string_append (result, code);
+        g_free (str_index);
+        g_free (tmp);
+        g_free (code);
+    }
+
+    return g_string_free (result, FALSE);
+}
+
+/**
+ * make_parallel_transformations:
+ * @burst (in): number of processed projections in the kernel
+ * @columns (in): make the detector column computation instead of the pixel fetch
+ *
+ * Make code for the separable parallel beam case, in which the detector column
+ * depends only on the voxel column and the detector row only on the slice.
+ * Columns are computed once per work item, pixels are fetched for every slice.
+ */
+static gchar *
+make_parallel_transformations (gint burst, gboolean columns)
+{
+    gint i;
+    gchar *code, *str_index;
+    GString *result;
+    const gchar *code_fmt;
+
+    if (columns) {
+        code_fmt = "\tconst cfloat column_%02d = mad (tomo_%02d.y, voxel_0.x, "
+                   "mad (-tomo_%02d.x, voxel_0.y, center_position.x));\n";
+    } else {
+        code_fmt = "\t\tresult += PROJECTION_VALUE (projection_%02d, "
+                   "(float2) (column_%02d, row));\n";
+    }
+
+    result = g_string_new (NULL);
+    for (i = 0; i < burst; i++) {
+        str_index = g_strdup_printf ("%02d", i);
+        code = replace_substring (code_fmt, "%02d", str_index);
+        g_string_append (result, code);
+        g_free (str_index);
+        g_free (code);
+    }
+
+    return g_string_free (result, FALSE);
+}
+
 /**
  * make_kernel:
  * @template (in): kernel template string
@@ -1045,18 +1270,21 @@ make_transformations (UfoUniRecoParameter parameter, gboolean vectorized, gint b
  * @store_type (in): data type of the output volume (one of "half", "float", "double",
  * "uchar", "ushort", "uint")
  * @parameter: (in): parameter which represents the third reconstruction axis
+ * @with_matrices: (in): project voxels by precomputed projection matrices
+ * @fast_parallel: (in): use the separable parallel beam kernel
  *
  * Make backprojection kernel.
  */
 static gchar *
 make_kernel (gchar *template, gboolean vectorized, gint burst, gboolean with_axis, gboolean with_volume,
              gboolean perpendicular_detector, gboolean parallel_beam, const gchar *compute_type,
-             const gchar *result_type, const gchar *store_type, UfoUniRecoParameter parameter)
+             const gchar *result_type, const gchar *store_type, UfoUniRecoParameter parameter,
+             gboolean with_matrices, gboolean fast_parallel)
 {
     const gchar *double_pragma_def, *double_pragma, *half_pragma_def, *half_pragma,
           *image_args_fmt, *trigonomoerty_args_fmt;
-    gchar *image_args, *trigonometry_args, *type_conversion, *parameter_assignment, *local_assignment,
-          *static_transformations, *transformations, *code_tmp, *code, *tmp, **parts;
+    gchar *image_args, *trigonometry_args, *type_conversion, *parameter_assignment, *local_assignment = NULL,
+          *static_transformations = NULL, *transformations, *code_tmp, *code, *tmp, **parts;
     gboolean positional_param = is_parameter_positional (parameter);
 
     double_pragma_def = "#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n";
@@ -1102,7 +1330,20 @@ make_kernel (gchar *template, gboolean vectorized, gint burst, gboolean with_axi
         }
     }
 
-    if (!vectorized) {
+    if (fast_parallel) {
+        /* Columns go to the local assignment slot, which the parallel body
+         * template places before the loop over slices */
+        g_free (local_assignment);
+        local_assignment = make_parallel_transformations (burst, TRUE);
+        static_transformations = g_strdup ("\t\trow = voxel_0.z + center_position.z;\n");
+        transformations = make_parallel_transformations (burst, FALSE);
+    } else if (with_matrices) {
+        /* Magnification, volume and axis rotations are part of the matrices */
+        g_free (local_assignment);
+        local_assignment = g_strdup ("\tfloat4 voxel_h;\n\tglobal const float4 *matrix;\n");
+        static_transformations = g_strdup ("\tvoxel_h = (float4) (voxel_0, 1.0f);\n");
+        transformations = make_matrix_transformations (burst, parallel_beam);
+    } else if (!vectorized) {
         if ((static_transformations = make_static_transformations(FALSE, with_volume, perpendicular_detector,
                                                                   parallel_beam)) == NULL) {
             g_warning ("Error making static transformations");
@@ -1112,7 +1353,8 @@ make_kernel (gchar *template, gboolean vectorized, gint burst, gboolean with_axi
         g_free (static_transformations);
         static_transformations = tmp;
     }
-    if ((transformations = make_transformations (parameter, vectorized, burst, with_volume, with_axis,
+    if (!(with_matrices || fast_parallel) &&
+        (transformations = make_transformations (parameter, vectorized, burst, with_volume, with_axis,
                                                  perpendicular_detector, parallel_beam, compute_type)) == NULL) {
         g_warning ("Error making tomographic-angle-based transformations");
         return NULL;
@@ -1130,9 +1372,9 @@ make_kernel (gchar *template, gboolean vectorized, gint burst, gboolean with_axi
     code_tmp = g_strconcat (double_pragma, half_pragma,
                             parts[0], image_args,
                             parts[1], trigonometry_args,
-                            parts[2], vectorized ? local_assignment : "",
+                            parts[2], vectorized || with_matrices || fast_parallel ? local_assignment : "",
                             parts[3], parameter_assignment,
-                            parts[4], vectorized ? "" : static_transformations,
+                            parts[4], vectorized && !with_matrices ? "" : static_transformations,
                             parts[5], transformations,
                             parts[6], type_conversion,
                             parts[7], type_conversion,
@@ -1147,11 +1389,8 @@ make_kernel (gchar *template, gboolean vectorized, gint burst, gboolean with_axi
     g_free (trigonometry_args);
     g_free (type_conversion);
     g_free (parameter_assignment);
-    if (vectorized) {
-        g_free (local_assignment);
-    } else {
-        g_free (static_transformations);
-    }
+    g_free (local_assignment);
+    g_free (static_transformations);
     g_free (transformations);
     g_free (code_tmp);
     g_strfreev (parts);
@@ -1168,19 +1407,29 @@ static void
 create_images (UfoGeneralBackprojectTaskPrivate *priv, gsize width, gsize height)
 {
     cl_image_format image_fmt;
+    cl_mem_flags flags;
     cl_int cl_error;
     guint i;
 
     g_log ("gbp", G_LOG_LEVEL_DEBUG, "Creating images %lu x %lu", width, height);
 
     /* TODO: dangerous, don't rely on the ufo-buffer */
-    image_fmt.image_channel_order = CL_INTENSITY;
-    image_fmt.image_channel_data_type = CL_FLOAT;
+    if (priv->projection_type == PT_FLOAT) {
+        image_fmt.image_channel_order = CL_INTENSITY;
+        image_fmt.image_channel_data_type = CL_FLOAT;
+        flags = CL_MEM_READ_ONLY;
+    } else {
+        /* Reduced types are written by the conversion kernel */
+        image_fmt.image_channel_order = CL_R;
+        image_fmt.image_channel_data_type = priv->projection_type == PT_HALF ? CL_HALF_FLOAT : CL_UNORM_INT16;
+        flags = CL_MEM_READ_WRITE;
+    }
 
-    for (i = 0; i < priv->burst; i++) {
+    /* Every device or buffering stage gets its own set of burst images */
+    for (i = 0; i < priv->burst * priv->num_image_sets; i++) {
         /* TODO: what about the "other" API? */
         priv->projections[i] = clCreateImage2D (priv->context,
-                                                CL_MEM_READ_ONLY,
+                                                flags,
                                                 &image_fmt,
                                                 width,
                                                 height,
@@ -1230,9 +1479,10 @@ copy_to_image (const cl_command_queue cmd_queue,
                UfoBuffer *input,
                cl_mem output,
                gsize width,
-               gsize height)
+               gsize height,
+               cl_event wait_event,
+               cl_event *event)
 {
-    cl_event event;
     cl_int errcode;
     cl_mem input_array;
     const size_t origin[] = {0, 0, 0};
@@ -1243,56 +1493,183 @@ copy_to_image (const cl_command_queue cmd_queue,
                                           input_array,
                                           output,
                                           0, origin, region,
-                                          0, NULL, &event);
+                                          wait_event ? 1 : 0,
+                                          wait_event ? &wait_event : NULL,
+                                          event);
 
     UFO_RESOURCES_CHECK_CLERR (errcode);
-    UFO_RESOURCES_CHECK_CLERR (clWaitForEvents (1, &event));
+}
+
+/**
+ * store_to_image:
+ *
+ * Store the projection in the burst image, converting it to the reduced
+ * projection type on the device if necessary. With a separate transfer queue,
+ * the upload event is put into the wait list of @cmd_queue instead of waiting
+ * for it on the host. This orders the backprojection kernels as well as any
+ * later reuse of the input buffer after the upload.
+ */
+static void
+store_to_image (UfoGeneralBackprojectTaskPrivate *priv,
+                const cl_command_queue cmd_queue,
+                UfoBuffer *input,
+                cl_mem output,
+                gsize width,
+                gsize height,
+                cl_event wait_event)
+{
+    cl_command_queue queue;
+    cl_event event;
+    cl_mem input_array;
+    cl_float scale, offset;
+    const gsize global_work_size[] = {width, height};
+
+    queue = priv->transfer_queue ? priv->transfer_queue : cmd_queue;
+
+    if (priv->projection_type == PT_FLOAT) {
+        copy_to_image (queue, input, output, width, height, wait_event, &event);
+    } else {
+        input_array = ufo_buffer_get_device_array (input, queue);
+        scale = (cl_float) priv->projection_scale;
+        offset = (cl_float) priv->projection_offset;
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convert_kernel, 0, sizeof (cl_mem), &input_array));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convert_kernel, 1, sizeof (cl_mem), &output));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convert_kernel, 2, sizeof (cl_float), &scale));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->convert_kernel, 3, sizeof (cl_float), &offset));
+        UFO_RESOURCES_CHECK_CLERR (clEnqueueNDRangeKernel (queue, priv->convert_kernel, 2, NULL,
+                                                           global_work_size, NULL,
+                                                           wait_event ? 1 : 0,
+                                                           wait_event ? &wait_event : NULL,
+                                                           &event));
+    }
+
+    if (queue != cmd_queue) {
+        UFO_RESOURCES_CHECK_CLERR (clFlush (queue));
+        UFO_RESOURCES_CHECK_CLERR (clEnqueueBarrierWithWaitList (cmd_queue, 1, &event, NULL));
+    }
+
     UFO_RESOURCES_CHECK_CLERR (clReleaseEvent (event));
 }
 
+/**
+ * upload_to_devices:
+ * @priv: task private data
+ * @input: projection
+ * @index: index of the projection within the burst
+ *
+ * Write the projection to the burst images of all devices. The input buffer is
+ * reused as soon as process returns, hence the projection is first copied to a
+ * host staging slot of the burst from which the devices read asynchronously.
+ * A slot is only overwritten after its transfers of the previous burst are
+ * done, all remaining transfers are finished before the first slice is
+ * generated.
+ */
 static void
-node_setup (UfoGeneralBackprojectTaskPrivate *priv,
-            UfoGpuNode *node)
+upload_to_devices (UfoGeneralBackprojectTaskPrivate *priv,
+                   UfoBuffer *input,
+                   guint index,
+                   gsize width,
+                   gsize height)
 {
+    const size_t origin[] = {0, 0, 0};
+    const size_t region[] = {width, height, 1};
+    gsize projection_size;
+    gfloat *host_array;
+    gchar *staging;
+    cl_event *events;
     guint i;
-    gboolean with_axis, with_volume, parallel_beam, perpendicular_detector;
-    gchar *template, *kernel_code, *compiler_options = NULL;
-    const gchar *node_name;
-    GValue *node_name_gvalue;
-    const gchar compiler_options_tmpl[] = "-cl-nv-maxrregcount=%u";
-    UfoUniRecoNodeProps *node_props;
 
-    /* GPU type specific settings */
-    node_name_gvalue = ufo_gpu_node_get_info (node, UFO_GPU_NODE_INFO_NAME);
-    node_name = g_value_get_string (node_name_gvalue);
-    if (!(node_props = g_hash_table_lookup (priv->node_props_table, node_name))) {
-        g_log ("gbp", G_LOG_LEVEL_DEBUG, "GPU with name %s not in database", node_name);
-        node_props = g_hash_table_lookup (priv->node_props_table, "GENERIC");
+    projection_size = width * height * get_projection_type_size (priv->projection_type);
+    staging = priv->staging + index * projection_size;
+    events = priv->upload_events + index * priv->num_devices;
+
+    for (i = 0; i < priv->num_devices; i++) {
+        if (events[i]) {
+            UFO_RESOURCES_CHECK_CLERR (clWaitForEvents (1, &events[i]));
+            UFO_RESOURCES_CHECK_CLERR (clReleaseEvent (events[i]));
+            events[i] = NULL;
+        }
     }
-    if (!priv->burst) {
-        priv->burst = node_props->burst;
+
+    host_array = ufo_buffer_get_host_array (input, NULL);
+    if (priv->projection_type == PT_FLOAT) {
+        memcpy (staging, host_array, projection_size);
+    } else {
+        convert_projection (priv, host_array, (guint16 *) staging, width * height);
     }
-    if (node_props->max_regcount) {
-        compiler_options = g_strdup_printf (compiler_options_tmpl, node_props->max_regcount);
+
+    for (i = 0; i < priv->num_devices; i++) {
+        UFO_RESOURCES_CHECK_CLERR (clEnqueueWriteImage (priv->cmd_queues[i],
+                                                        priv->projections[i * priv->burst + index],
+                                                        CL_FALSE, origin, region, 0, 0, staging,
+                                                        0, NULL, &events[i]));
+        UFO_RESOURCES_CHECK_CLERR (clFlush (priv->cmd_queues[i]));
     }
-    g_log ("gbp", G_LOG_LEVEL_DEBUG,
-           "GPU node %s properties: burst: %u, compiler options: '%s'",
-           node_name, priv->burst, compiler_options);
-    g_value_unset (node_name_gvalue);
+}
+
+static void
+set_projection_args (UfoGeneralBackprojectTaskPrivate *priv, cl_kernel kernel, guint burst, guint set)
+{
+    guint i;
+
+    for (i = 0; i < burst; i++) {
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, STATIC_ARG_OFFSET + i, sizeof (cl_mem),
+                                                   &priv->projections[set * priv->burst + i]));
+    }
+}
+
+static void
+setup_overlap (UfoGeneralBackprojectTaskPrivate *priv, UfoGpuNode *node)
+{
+    cl_int cl_error;
+
+    priv->num_image_sets = 2;
+    priv->current_set = 0;
+
+    if (priv->upload_queue) {
+        priv->transfer_queue = clCreateCommandQueue (priv->context, ufo_gpu_node_get_device (node), 0, &cl_error);
+        UFO_RESOURCES_CHECK_CLERR (cl_error);
+    }
+
+    g_log ("gbp", G_LOG_LEVEL_DEBUG, "Double-buffering projections%s",
+           priv->transfer_queue ? " with a separate upload queue" : "");
+}
+
+static void
+setup_devices (UfoGeneralBackprojectTaskPrivate *priv)
+{
+    GList *queues, *it;
+    guint i = 0;
+
+    queues = ufo_resources_get_cmd_queues (priv->resources);
+    priv->num_devices = g_list_length (queues);
+    priv->cmd_queues = (cl_command_queue *) g_malloc (priv->num_devices * sizeof (cl_command_queue));
+
+    for (it = queues; it != NULL; it = g_list_next (it)) {
+        priv->cmd_queues[i++] = it->data;
+    }
+
+    g_list_free (queues);
+    g_log ("gbp", G_LOG_LEVEL_DEBUG, "Distributing slabs over %u devices", priv->num_devices);
+}
+
+static void
+setup_geometry (UfoGeneralBackprojectTaskPrivate *priv)
+{
+    guint i;
 
-    /* Initialization */
     /* Assume the most efficient geometry, change if necessary */
-    with_axis = is_axis_parameter (priv->parameter) ||
-                !(ufo_scarray_is_almost_zero (priv->geometry->axis->angle->x) &&
-                  ufo_scarray_is_almost_zero (priv->geometry->axis->angle->y));
-    with_volume = is_volume_parameter (priv->parameter) || !ufo_scpoint_are_almost_zero (priv->geometry->volume_angle);
-    perpendicular_detector = !is_detector_rotation_parameter (priv->parameter) &&
-                             !is_detector_position_parameter (priv->parameter) &&
-                             ufo_scpoint_are_almost_zero (priv->geometry->detector->angle);
-    parallel_beam = TRUE;
+    priv->with_axis = is_axis_parameter (priv->parameter) ||
+                      !(ufo_scarray_is_almost_zero (priv->geometry->axis->angle->x) &&
+                        ufo_scarray_is_almost_zero (priv->geometry->axis->angle->y));
+    priv->with_volume = is_volume_parameter (priv->parameter) || !ufo_scpoint_are_almost_zero (priv->geometry->volume_angle);
+    priv->perpendicular_detector = !is_detector_rotation_parameter (priv->parameter) &&
+                                   !is_detector_position_parameter (priv->parameter) &&
+                                   ufo_scpoint_are_almost_zero (priv->geometry->detector->angle);
+    priv->parallel_beam = TRUE;
     /* Actual parameter setup */
     for (i = 0; i < priv->num_projections; i++) {
-        parallel_beam = parallel_beam && isinf (ufo_scarray_get_double (priv->geometry->source_position->y, i));
+        priv->parallel_beam = priv->parallel_beam && isinf (ufo_scarray_get_double (priv->geometry->source_position->y, i));
     }
     priv->vectorized = (ufo_scarray_has_n_values (priv->geometry->axis->angle->x, priv->num_projections) ||
                         ufo_scarray_has_n_values (priv->geometry->axis->angle->y, priv->num_projections) ||
@@ -1310,106 +1687,454 @@ node_setup (UfoGeneralBackprojectTaskPrivate *priv,
                         ufo_scarray_has_n_values (priv->geometry->source_position->z, priv->num_projections) ||
                         ufo_scarray_has_n_values (priv->geometry->axis->position->x, priv->num_projections) ||
                         ufo_scarray_has_n_values (priv->geometry->axis->position->z, priv->num_projections));
+    /* Without tilts the detector column depends only on x, y and the angle and
+     * the row only on z, which a specialized kernel exploits */
+    priv->fast_parallel = priv->parallel_beam && priv->perpendicular_detector &&
+                          !(priv->with_axis || priv->with_volume || priv->vectorized ||
+                            priv->projection_matrices) &&
+                          priv->parameter == UFO_UNI_RECO_PARAMETER_Z &&
+                          priv->compute_type == CT_FLOAT;
 
     g_log ("gbp", G_LOG_LEVEL_DEBUG, "vectorized: %d, parameter: %s with axis: %d, with volume: %d, "
-           "perpendicular detector: %d, parallel beam: %d, "
+           "perpendicular detector: %d, parallel beam: %d, fast parallel: %d, "
            "compute type: %s, result type: %s, store type: %s",
-             priv->vectorized, parameter_values[priv->parameter].value_nick, with_axis, with_volume,
-             perpendicular_detector, parallel_beam,
+             priv->vectorized, parameter_values[priv->parameter].value_nick, priv->with_axis, priv->with_volume,
+             priv->perpendicular_detector, priv->parallel_beam, priv->fast_parallel,
              compute_type_values[priv->compute_type].value_nick,
              ft_values[priv->result_type].value_nick,
              st_values[priv->store_type].value_nick);
+}
 
-    if ((template = make_template (priv)) == NULL) {
+/*{{{ Projection matrices */
+/**
+ * create_projection_matrices:
+ * @priv: task private data with geometry set up by setup_geometry()
+ *
+ * Precompute the projection matrices of all projections on the host and upload
+ * them to the device. Only the non-vectorized float kernel reconstructing along
+ * z is supported, otherwise the regular kernel is used.
+ */
+static void
+create_projection_matrices (UfoGeneralBackprojectTaskPrivate *priv)
+{
+    gfloat *host_matrices;
+    guint i;
+
+    if (priv->parameter != UFO_UNI_RECO_PARAMETER_Z || priv->compute_type != CT_FLOAT) {
+        g_warning ("Projection matrices require parameter=z and compute-type=float, not using them");
+        priv->projection_matrices = FALSE;
         return;
     }
 
+    /* Per-projection geometry is part of the matrices */
+    priv->vectorized = FALSE;
+    host_matrices = g_malloc (priv->num_projections * 16 * sizeof (gfloat));
+
+    for (i = 0; i < priv->num_projections; i++) {
+        ufo_ctgeometry_compute_projection_matrix (priv->geometry, i, priv->parallel_beam,
+                                                  priv->perpendicular_detector, priv->with_axis,
+                                                  priv->with_volume, host_matrices + 16 * i);
+    }
+
+    priv->matrices = transfer_host_to_device (priv->context, host_matrices,
+                                              priv->num_projections * 16 * sizeof (gfloat));
+    g_free (host_matrices);
+}
+/*}}}*/
+
+/**
+ * create_kernel:
+ * @priv: task private data with geometry set up by setup_geometry()
+ * @burst: number of projections processed by the kernel
+ * @max_regcount: maximum number of registers, 0 for no limit
+ *
+ * Make and build a backprojection kernel for the current geometry.
+ *
+ * Returns: a retained kernel or %NULL on error.
+ */
+static cl_kernel
+create_kernel (UfoGeneralBackprojectTaskPrivate *priv, guint burst, guint max_regcount)
+{
+    gchar *template, *kernel_code;
+    GString *compiler_options;
+    cl_kernel kernel;
+
+    if ((template = make_template (priv)) == NULL) {
+        return NULL;
+    }
+
     /* Create kernel source code based on geometry settings */
-    kernel_code = make_kernel (template, priv->vectorized, priv->burst, with_axis, with_volume,
-                               perpendicular_detector, parallel_beam,
+    kernel_code = make_kernel (template, priv->vectorized, burst, priv->with_axis, priv->with_volume,
+                               priv->perpendicular_detector, priv->parallel_beam,
                                compute_type_values[priv->compute_type].value_nick,
                                ft_values[priv->result_type].value_nick,
                                st_values[priv->store_type].value_nick,
-                               priv->parameter);
+                               priv->parameter,
+                               priv->projection_matrices, priv->fast_parallel);
+    g_free (template);
     if (!kernel_code) {
-        g_free (template);
-        g_free (compiler_options);
-        return;
+        return NULL;
     }
-    priv->kernel = ufo_resources_get_kernel_from_source (priv->resources,
-                                                         kernel_code,
-                                                         "backproject",
-                                                         compiler_options,
-                                                         NULL);
-    g_free (kernel_code);
-
-    if (priv->num_projections % priv->burst) {
-        kernel_code = make_kernel (template, priv->vectorized, priv->num_projections % priv->burst,
-                                   with_axis, with_volume,
-                                   perpendicular_detector, parallel_beam,
-                                   compute_type_values[priv->compute_type].value_nick,
-                                   ft_values[priv->result_type].value_nick,
-                                   st_values[priv->store_type].value_nick,
-                                   priv->parameter);
-        if (!kernel_code) {
-            g_free (template);
-            g_free (compiler_options);
-            return;
+    compiler_options = g_string_new (NULL);
+    if (max_regcount) {
+        g_string_append_printf (compiler_options, "-cl-nv-maxrregcount=%u ", max_regcount);
+    }
+    if (priv->projection_type != PT_FLOAT) {
+        /* Undo the scaling applied when the projections were stored */
+        g_string_append_printf (compiler_options, "-DPROJECTION_SCALE=%.9ef -DPROJECTION_OFFSET=%.9ef ",
+                                priv->projection_scale, priv->projection_offset);
+        if (priv->addressing_mode == ADDRESS_CLAMP) {
+            /* Samples outside of the detector read the border color 0 */
+            g_string_append (compiler_options, "-DPROJECTION_BORDER");
         }
-
-        /* If num_projections % priv->burst != 0 we need one more kernel to process the remaining projections */
-        priv->rest_kernel = ufo_resources_get_kernel_from_source (priv->resources,
-                                                                  kernel_code,
-                                                                  "backproject",
-                                                                  compiler_options,
-                                                                  NULL);
-        /* g_printf ("%s", kernel_code); */
-        g_free (kernel_code);
     }
-    g_free (template);
-    g_free (compiler_options);
+    kernel = ufo_resources_get_kernel_from_source (priv->resources,
+                                                   kernel_code,
+                                                   "backproject",
+                                                   compiler_options->len ? compiler_options->str : NULL,
+                                                   NULL);
+    /* g_printf ("%s", kernel_code); */
+    g_free (kernel_code);
+    g_string_free (compiler_options, TRUE);
 
-    if (priv->kernel) {
-        UFO_RESOURCES_CHECK_CLERR (clRetainKernel (priv->kernel));
-    }
-    if (priv->rest_kernel) {
-        UFO_RESOURCES_CHECK_CLERR (clRetainKernel (priv->rest_kernel));
+    if (kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clRetainKernel (kernel));
     }
+
+    return kernel;
 }
-/*}}}*/
 
-UfoNode *
-ufo_general_backproject_task_new (void)
+static void
+node_setup (UfoGeneralBackprojectTaskPrivate *priv,
+            UfoGpuNode *node)
 {
-    return UFO_NODE (g_object_new (UFO_TYPE_GENERAL_BACKPROJECT_TASK, NULL));
+    const gchar *node_name;
+    GValue *node_name_gvalue;
+    UfoUniRecoNodeProps *node_props;
+
+    /* GPU type specific settings, unless they have been tuned */
+    node_name_gvalue = ufo_gpu_node_get_info (node, UFO_GPU_NODE_INFO_NAME);
+    node_name = g_value_get_string (node_name_gvalue);
+    if (!(node_props = g_hash_table_lookup (priv->node_props_table, node_name))) {
+        g_log ("gbp", G_LOG_LEVEL_DEBUG, "GPU with name %s not in database", node_name);
+        node_props = g_hash_table_lookup (priv->node_props_table, "GENERIC");
+    }
+    if (!priv->burst) {
+        priv->burst = node_props->burst;
+    }
+    if (!priv->tuned) {
+        priv->max_regcount = node_props->max_regcount;
+    }
+    g_log ("gbp", G_LOG_LEVEL_DEBUG,
+           "GPU node %s properties: burst: %u, max register count: %u",
+           node_name, priv->burst, priv->max_regcount);
+    g_value_unset (node_name_gvalue);
+
+    priv->kernel = create_kernel (priv, priv->burst, priv->max_regcount);
+
+    if (priv->num_projections % priv->burst) {
+        /* If num_projections % priv->burst != 0 we need one more kernel to process the remaining projections */
+        priv->rest_kernel = create_kernel (priv, priv->num_projections % priv->burst, priv->max_regcount);
+    }
 }
 
 static void
-ufo_general_backproject_task_setup (UfoTask *task,
-                                    UfoResources *resources,
-                                    GError **error)
+release_vector_arguments (UfoGeneralBackprojectTaskPrivate *priv)
 {
-    cl_int cl_error;
     guint i;
-    GValue tomo_angle = G_VALUE_INIT;
-    UfoGeneralBackprojectTaskPrivate *priv = UFO_GENERAL_BACKPROJECT_TASK_GET_PRIVATE (task);
-    priv->resources = g_object_ref (resources);
-    priv->kernel = NULL;
-    priv->rest_kernel = NULL;
-    priv->projections = NULL;
-    priv->chunks = NULL;
-    priv->cl_regions = NULL;
-    priv->vector_arguments = NULL;
 
-    /* Check parameter values */
-    if (!priv->num_projections) {
-        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
-                     "Number of projections not set");
-        return;
+    if (priv->vector_arguments) {
+        for (i = 0; i < NUM_VECTOR_ARGUMENTS; i++) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->vector_arguments[i]));
+        }
+        g_free (priv->vector_arguments);
+        priv->vector_arguments = NULL;
     }
+}
 
-    if (!ufo_scarray_has_n_values (priv->geometry->axis->angle->z, priv->num_projections)) {
-        /* Create equidistant tomographic angles and treat the one specified in
+/**
+ * get_fast_parallel_depth:
+ * @num_slices: number of slices of a chunk
+ * @local_size: local work size along z
+ *
+ * Global work size along z of the fast parallel kernel. Every work item reuses
+ * its detector columns for up to %FAST_PARALLEL_SLICES slices, tall chunks are
+ * still split over several work groups to keep the device occupied.
+ */
+static gsize
+get_fast_parallel_depth (gsize num_slices, gsize local_size)
+{
+    gsize depth = (num_slices + FAST_PARALLEL_SLICES - 1) / FAST_PARALLEL_SLICES;
+
+    return depth % local_size ? NEXT_DIVISOR (depth, local_size) : depth;
+}
+
+static gboolean
+is_nvidia_device (cl_device_id device)
+{
+    gchar vendor[256];
+
+    UFO_RESOURCES_CHECK_CLERR (clGetDeviceInfo (device, CL_DEVICE_VENDOR, sizeof (vendor), vendor, NULL));
+
+    return g_strstr_len (vendor, -1, "NVIDIA") != NULL;
+}
+
+/**
+ * time_kernel:
+ * @task: the task
+ * @cmd_queue: command queue
+ * @requisition: output slice requisition
+ * @kernel: kernel built for @burst projections
+ * @burst: number of projections processed by @kernel
+ * @volume: scratch volume with @num_slices slices
+ * @region: region buffer with @num_slices entries
+ * @num_slices: number of slices in the scratch volume
+ * @local_work_size: local work size to benchmark
+ *
+ * Run one burst of @kernel on the projection images and return the time per
+ * projection.
+ */
+static gdouble
+time_kernel (UfoTask *task, cl_command_queue cmd_queue, UfoRequisition *requisition,
+             cl_kernel kernel, guint burst, cl_mem volume, cl_mem region, guint num_slices,
+             const gsize *local_work_size)
+{
+    UfoGeneralBackprojectTaskPrivate *priv;
+    typedef void (*SetStaticArgsFunc) (UfoTask *, UfoRequisition *, const cl_kernel);
+    SetStaticArgsFunc set_static_args[2] = {set_static_args_cl_float, set_static_args_cl_double};
+    cl_kernel kernel_orig;
+    cl_float f_tomo_angle[2];
+    cl_double d_tomo_angle[2];
+    cl_int iteration = 0;
+    gint real_size[4];
+    gsize global_work_size[3];
+    gdouble elapsed;
+    guint i, ki, burst_orig;
+
+    priv = UFO_GENERAL_BACKPROJECT_TASK_GET_PRIVATE (task);
+
+    /* set_static_args () takes the burst from priv for the main kernel */
+    kernel_orig = priv->kernel;
+    burst_orig = priv->burst;
+    priv->kernel = kernel;
+    priv->burst = burst;
+    set_static_args[priv->compute_type] (task, requisition, kernel);
+    priv->kernel = kernel_orig;
+    priv->burst = burst_orig;
+
+    ki = STATIC_ARG_OFFSET + burst;
+    for (i = 0; i < burst; i++) {
+        if (priv->compute_type == CT_FLOAT) {
+            fill_sincos_cl_float (f_tomo_angle, i * G_PI / burst);
+            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki + i, sizeof (cl_float2), f_tomo_angle));
+        } else {
+            fill_sincos_cl_double (d_tomo_angle, i * G_PI / burst);
+            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki + i, sizeof (cl_double2), d_tomo_angle));
+        }
+    }
+    ki += burst;
+    real_size[0] = requisition->dims[0];
+    real_size[1] = requisition->dims[1];
+    real_size[2] = num_slices;
+    real_size[3] = 0;
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, REAL_SIZE_ARG_INDEX, sizeof (cl_int3), real_size));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki, sizeof (cl_int), &iteration));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki + 1, sizeof (cl_mem), &volume));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki + 2, sizeof (cl_mem), &region));
+
+    for (i = 0; i < 3; i++) {
+        gsize size = i < 2 ? requisition->dims[i] : num_slices;
+        global_work_size[i] = size % local_work_size[i] ? NEXT_DIVISOR (size, local_work_size[i]) : size;
+    }
+    if (priv->fast_parallel) {
+        global_work_size[2] = get_fast_parallel_depth (num_slices, local_work_size[2]);
+    }
+
+    elapsed = ufo_tuning_time_kernel (cmd_queue, kernel, 3, global_work_size, local_work_size, 3) / burst;
+
+    /* The kernel does not retain its buffer arguments, release them only after it ran */
+    release_vector_arguments (priv);
+
+    return elapsed;
+}
+
+/**
+ * autotune:
+ * @task: the task
+ * @node: GPU node the task runs on
+ * @in_req: projection requisition
+ * @requisition: output slice requisition
+ * @region_start: first value of the reconstructed parameter
+ * @region_step: step of the reconstructed parameter
+ *
+ * Find the fastest burst, local work size and register limit by running the
+ * backprojection on a few slices of scratch data. The result is cached on
+ * disk for the device, its driver and the problem shape.
+ */
+static void
+autotune (UfoTask *task, UfoGpuNode *node, UfoRequisition *in_req, UfoRequisition *requisition,
+          gdouble region_start, gdouble region_step)
+{
+    static const guint bursts[] = {4, 8, 16, 24, 32};
+    static const gsize local_sizes[][3] = {{16, 8, 8}, {32, 4, 4}, {16, 16, 1}, {32, 8, 1}, {8, 8, 4}};
+    static const guint regcounts[] = {32, 64};
+    typedef void (*CreateRegionFunc) (UfoGeneralBackprojectTaskPrivate *, const cl_command_queue,
+                                      const gdouble, const gdouble);
+    CreateRegionFunc create_regions[2] = {create_regions_cl_float, create_regions_cl_double};
+    UfoGeneralBackprojectTaskPrivate *priv;
+    cl_command_queue cmd_queue;
+    cl_device_id device;
+    cl_kernel kernel;
+    cl_mem volume, region;
+    cl_int cl_error;
+    gchar *device_key, *shape;
+    gdouble elapsed, best_time = G_MAXDOUBLE;
+    /* burst, max register count, local work size */
+    gint best[5] = {0, 0, 0, 0, 0};
+    guint i, j, num_slices, max_burst, user_burst;
+
+    priv = UFO_GENERAL_BACKPROJECT_TASK_GET_PRIVATE (task);
+    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
+    device = ufo_gpu_node_get_device (node);
+    device_key = ufo_tuning_get_device_key (device);
+    shape = g_strdup_printf ("%zux%zu-%zux%zux%u-%s-%s-%s-%s-%s-%d%d%d%d%d",
+                             in_req->dims[0], in_req->dims[1],
+                             requisition->dims[0], requisition->dims[1], priv->num_slices,
+                             parameter_values[priv->parameter].value_nick,
+                             compute_type_values[priv->compute_type].value_nick,
+                             ft_values[priv->result_type].value_nick,
+                             st_values[priv->store_type].value_nick,
+                             pt_values[priv->projection_type].value_nick,
+                             priv->vectorized, priv->with_axis, priv->with_volume,
+                             priv->perpendicular_detector, priv->parallel_beam);
+
+    if (!ufo_tuning_lookup ("general-backproject", device_key, shape, best, 5)) {
+        /* A few slices are enough to saturate the device */
+        num_slices = MIN (priv->num_slices, 32);
+        user_burst = priv->burst;
+        max_burst = user_burst ? user_burst : MIN (bursts[G_N_ELEMENTS (bursts) - 1], priv->num_projections);
+        volume = clCreateBuffer (priv->context, CL_MEM_WRITE_ONLY,
+                                 requisition->dims[0] * requisition->dims[1] * num_slices *
+                                 get_type_size (priv->store_type),
+                                 NULL, &cl_error);
+        UFO_RESOURCES_CHECK_CLERR (cl_error);
+        priv->projections = (cl_mem *) g_malloc (max_burst * sizeof (cl_mem));
+        priv->num_chunks = 1;
+        priv->num_slices_per_chunk = num_slices;
+        priv->cl_regions = &region;
+        create_regions[priv->compute_type] (priv, cmd_queue, region_start, region_step);
+        priv->cl_regions = NULL;
+        priv->burst = max_burst;
+        create_images (priv, in_req->dims[0], in_req->dims[1]);
+        priv->burst = user_burst;
+
+        for (i = 0; i < G_N_ELEMENTS (bursts) && (i == 0 || bursts[i] <= max_burst); i++) {
+            guint burst = (i + 1 == G_N_ELEMENTS (bursts) || bursts[i + 1] > max_burst) ? max_burst : bursts[i];
+
+            /* A burst given by the user is kept, only the launch parameters are tuned */
+            if (user_burst && burst != user_burst) {
+                continue;
+            }
+            if ((kernel = create_kernel (priv, burst, 0)) == NULL) {
+                continue;
+            }
+            for (j = 0; j < G_N_ELEMENTS (local_sizes); j++) {
+                elapsed = time_kernel (task, cmd_queue, requisition, kernel, burst,
+                                       volume, region, num_slices, local_sizes[j]);
+                g_log ("gbp", G_LOG_LEVEL_DEBUG, "Tuning burst %u, local size %zu %zu %zu: %g s",
+                       burst, local_sizes[j][0], local_sizes[j][1], local_sizes[j][2], elapsed);
+                if (elapsed < best_time) {
+                    best_time = elapsed;
+                    best[0] = burst;
+                    best[2] = local_sizes[j][0];
+                    best[3] = local_sizes[j][1];
+                    best[4] = local_sizes[j][2];
+                }
+            }
+            UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (kernel));
+        }
+
+        if (best[0] && is_nvidia_device (device)) {
+            const gsize local_work_size[3] = {best[2], best[3], best[4]};
+
+            for (i = 0; i < G_N_ELEMENTS (regcounts); i++) {
+                if ((kernel = create_kernel (priv, best[0], regcounts[i])) == NULL) {
+                    continue;
+                }
+                elapsed = time_kernel (task, cmd_queue, requisition, kernel, best[0],
+                                       volume, region, num_slices, local_work_size);
+                g_log ("gbp", G_LOG_LEVEL_DEBUG, "Tuning max register count %u: %g s", regcounts[i], elapsed);
+                if (elapsed < best_time) {
+                    best_time = elapsed;
+                    best[1] = regcounts[i];
+                }
+                UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (kernel));
+            }
+        }
+
+        for (i = 0; i < max_burst; i++) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->projections[i]));
+        }
+        g_free (priv->projections);
+        priv->projections = NULL;
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (region));
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (volume));
+
+        if (best[0]) {
+            ufo_tuning_store ("general-backproject", device_key, shape, best, 5);
+        }
+    }
+
+    if (best[0]) {
+        g_log ("gbp", G_LOG_LEVEL_DEBUG, "Tuned burst: %d, max register count: %d, local work size: %d %d %d",
+               best[0], best[1], best[2], best[3], best[4]);
+        priv->burst = best[0];
+        priv->max_regcount = best[1];
+        priv->local_work_size[0] = best[2];
+        priv->local_work_size[1] = best[3];
+        priv->local_work_size[2] = best[4];
+        priv->tuned = TRUE;
+    } else {
+        g_warning ("Autotuning backprojection failed, using defaults");
+    }
+
+    g_free (shape);
+    g_free (device_key);
+}
+/*}}}*/
+
+UfoNode *
+ufo_general_backproject_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_GENERAL_BACKPROJECT_TASK, NULL));
+}
+
+static void
+ufo_general_backproject_task_setup (UfoTask *task,
+                                    UfoResources *resources,
+                                    GError **error)
+{
+    cl_int cl_error;
+    guint i;
+    GValue tomo_angle = G_VALUE_INIT;
+    UfoGeneralBackprojectTaskPrivate *priv = UFO_GENERAL_BACKPROJECT_TASK_GET_PRIVATE (task);
+    priv->resources = g_object_ref (resources);
+    priv->kernel = NULL;
+    priv->rest_kernel = NULL;
+    priv->projections = NULL;
+    priv->chunks = NULL;
+    priv->cl_regions = NULL;
+    priv->vector_arguments = NULL;
+
+    /* Check parameter values */
+    if (!priv->num_projections) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "Number of projections not set");
+        return;
+    }
+
+    if (!ufo_scarray_has_n_values (priv->geometry->axis->angle->z, priv->num_projections)) {
+        /* Create equidistant tomographic angles and treat the one specified in
          * the current priv->geometry->axis->angle->z as offset */
         ufo_scarray_free (priv->geometry->axis->angle->z);
         priv->geometry->axis->angle->z = ufo_scarray_new (priv->num_projections, G_TYPE_DOUBLE, NULL);
@@ -1483,14 +2208,6 @@ ufo_general_backproject_task_get_requisition (UfoTask *task,
     }
 
     if (!priv->kernel) {
-        /* First iteration, setup kernels */
-        node_setup (priv, node);
-        if (!priv->kernel) {
-            g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
-                                 "Error creating backprojection kernels");
-            return;
-        }
-
         if (UFO_MATH_ARE_ALMOST_EQUAL (ufo_scarray_get_double (priv->region, 2), 0)) {
             /* Conservative approach, reconstruct just one slice */
             region_start = 0.0f;
@@ -1503,23 +2220,95 @@ ufo_general_backproject_task_get_requisition (UfoTask *task,
         }
         g_log ("gbp", G_LOG_LEVEL_DEBUG, "region: %g %g %g", region_start, region_stop, region_step);
         priv->num_slices = (gsize) ceil ((region_stop - region_start) / region_step);
+
+        /* First iteration, setup kernels */
+        setup_geometry (priv);
+        if (priv->projection_matrices) {
+            create_projection_matrices (priv);
+        }
+        if (priv->autotune) {
+            autotune (task, node, &in_req, requisition, region_start, region_step);
+        }
+        node_setup (priv, node);
+        if (!priv->kernel) {
+            g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                                 "Error creating backprojection kernels");
+            return;
+        }
+        if (priv->projection_type != PT_FLOAT) {
+            if (priv->projection_scale == 0.0) {
+                g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                                     "projection-scale must not be zero");
+                return;
+            }
+            priv->convert_kernel = ufo_resources_get_kernel (priv->resources, "opencl.cl",
+                                                             "convert_to_projection_image", NULL, error);
+            if (!priv->convert_kernel) {
+                return;
+            }
+            UFO_RESOURCES_CHECK_CLERR (clRetainKernel (priv->convert_kernel));
+        }
+
         max_global_mem_size_gvalue = ufo_gpu_node_get_info (node, UFO_GPU_NODE_INFO_GLOBAL_MEM_SIZE);
         max_global_mem_size = g_value_get_ulong (max_global_mem_size_gvalue);
         g_value_unset (max_global_mem_size_gvalue);
-        projections_size = priv->burst * in_req.dims[0] * in_req.dims[1] * sizeof (cl_float);
+        projections_size = priv->burst * in_req.dims[0] * in_req.dims[1] * get_projection_type_size (priv->projection_type);
         slice_size = requisition->dims[0] * requisition->dims[1] * get_type_size (priv->store_type);
         volume_size = slice_size * priv->num_slices;
         max_mem_alloc_size_gvalue = ufo_gpu_node_get_info (node, UFO_GPU_NODE_INFO_MAX_MEM_ALLOC_SIZE);
         max_mem_alloc_size = g_value_get_ulong (max_mem_alloc_size_gvalue);
         g_value_unset (max_mem_alloc_size_gvalue);
         priv->num_slices_per_chunk = (guint) floor ((gdouble) MIN (max_mem_alloc_size, volume_size) / ((gdouble) slice_size));
+        if (priv->out_of_core) {
+            if (priv->memory_budget) {
+                max_global_mem_size = MIN (max_global_mem_size, (cl_ulong) priv->memory_budget << 20);
+            }
+            if (projections_size + slice_size > max_global_mem_size) {
+                g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                             "Memory budget of %lu bytes is too small for one slice", max_global_mem_size);
+                return;
+            }
+            /* Reduced projection types halve the host cache as well */
+            priv->host_projections = g_try_malloc (priv->num_projections * in_req.dims[0] * in_req.dims[1] *
+                                                   get_projection_type_size (priv->projection_type));
+            if (!priv->host_projections) {
+                g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                                     "Error allocating host projection cache");
+                return;
+            }
+            priv->projection_dims[0] = in_req.dims[0];
+            priv->projection_dims[1] = in_req.dims[1];
+            priv->num_slices_per_chunk = MIN (priv->num_slices_per_chunk,
+                                              (max_global_mem_size - projections_size) / slice_size);
+            /* Only one pass has to fit, not the whole volume */
+            volume_size = MIN (volume_size, (max_global_mem_size - projections_size) / slice_size * slice_size);
+            if (priv->multi_device || priv->overlap) {
+                g_warning ("general-backproject: out-of-core mode uses one device without overlap, "
+                           "ignoring multi-device and overlap");
+            }
+        }
+        if (priv->multi_device && !priv->out_of_core) {
+            /* Every device needs at least one chunk, devices only hold their own chunks */
+            setup_devices (priv);
+            priv->staging = g_malloc (projections_size);
+            priv->upload_events = g_new0 (cl_event, priv->burst * priv->num_devices);
+            priv->num_slices_per_chunk = MIN (priv->num_slices_per_chunk, (priv->num_slices - 1) / priv->num_devices + 1);
+            volume_size = ((priv->num_slices - 1) / priv->num_devices + 1) * slice_size;
+        }
+        if (priv->overlap && !priv->multi_device && !priv->out_of_core) {
+            setup_overlap (priv, node);
+            projections_size *= priv->num_image_sets;
+        } else {
+            priv->num_image_sets = priv->num_devices;
+        }
         if (projections_size + volume_size > max_global_mem_size) {
             g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
                                  "Volume size doesn't fit to memory");
             return;
         }
 
-        priv->projections = (cl_mem *) g_malloc (priv->burst * sizeof (cl_mem));
+        volume_size = slice_size * priv->num_slices;
+        priv->projections = (cl_mem *) g_malloc (priv->burst * priv->num_image_sets * sizeof (cl_mem));
         /* Create subvolumes (because one large volume might be larger than the maximum allocatable memory chunk */
         priv->num_chunks = (priv->num_slices - 1) / priv->num_slices_per_chunk + 1;
         chunk_size = priv->num_slices_per_chunk * slice_size;
@@ -1527,7 +2316,12 @@ ufo_general_backproject_task_get_requisition (UfoTask *task,
         g_log ("gbp", G_LOG_LEVEL_DEBUG, "Num chunks: %d, chunk size: %lu, num slices per chunk: %u",
                priv->num_chunks, chunk_size, priv->num_slices_per_chunk);
         g_log ("gbp", G_LOG_LEVEL_DEBUG, "Volume size: %lu, num slices: %u", volume_size, priv->num_slices);
-        priv->chunks = (cl_mem *) g_malloc (priv->num_chunks * sizeof (cl_mem));
+        priv->chunks = (cl_mem *) g_malloc0 (priv->num_chunks * sizeof (cl_mem));
+        priv->chunk_devices = (guint *) g_malloc (priv->num_chunks * sizeof (guint));
+        for (i = 0; i < priv->num_chunks; i++) {
+            /* Contiguous slabs per device keep the output order trivial */
+            priv->chunk_devices[i] = i * priv->num_devices / priv->num_chunks;
+        }
         if (!priv->chunks) {
             g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
                                  "Error allocating volume chunks");
@@ -1539,7 +2333,11 @@ ufo_general_backproject_task_get_requisition (UfoTask *task,
                                  "Error allocating volume chunks");
             return;
         }
-        for (i = 0; i < priv->num_chunks; i++) {
+        if (priv->out_of_core) {
+            priv->chunks_per_pass = MAX (1, (max_global_mem_size - projections_size) / chunk_size);
+            g_log ("gbp", G_LOG_LEVEL_DEBUG, "Out-of-core: %u chunks per pass", priv->chunks_per_pass);
+        }
+        for (i = 0; i < priv->num_chunks && !priv->out_of_core; i++) {
             g_log ("gbp", G_LOG_LEVEL_DEBUG, "Creating chunk %d with size %lu",
                    i, MIN (volume_size, (i + 1) * chunk_size) - i * chunk_size);
             priv->chunks[i] = clCreateBuffer (priv->context,
@@ -1581,43 +2379,71 @@ ufo_general_backproject_task_get_mode (UfoTask *task)
     return UFO_TASK_MODE_REDUCTOR | UFO_TASK_MODE_GPU;
 }
 
-static gboolean
-ufo_general_backproject_task_process (UfoTask *task,
-                                      UfoBuffer **inputs,
-                                      UfoBuffer *output,
-                                      UfoRequisition *requisition)
+static cl_kernel
+get_burst_kernel (UfoGeneralBackprojectTaskPrivate *priv, guint count, guint *burst, guint *index)
+{
+    if (count >= priv->num_projections / priv->burst * priv->burst) {
+        *burst = priv->num_projections % priv->burst;
+        *index = (count - priv->num_projections / priv->burst * priv->burst) % *burst;
+        return priv->rest_kernel;
+    }
+
+    *burst = priv->burst;
+    *index = count % *burst;
+
+    return priv->kernel;
+}
+
+static void
+set_angle_arg (UfoGeneralBackprojectTaskPrivate *priv, cl_kernel kernel, guint burst, guint index, guint count)
 {
-    UfoGeneralBackprojectTaskPrivate *priv;
-    UfoRequisition in_req;
-    UfoGpuNode *node;
-    UfoProfiler *profiler;
-    guint i, index, ki;
-    guint count, burst, num_slices_current_chunk;
-    cl_kernel kernel;
-    cl_command_queue cmd_queue;
     gdouble rot_angle;
     cl_float f_tomo_angle[2];
     cl_double d_tomo_angle[2];
+    guint ki = STATIC_ARG_OFFSET + burst + index;
+
+    /* Setup tomographic rotation angle dependent arguments */
+    rot_angle = ufo_scarray_get_double (priv->geometry->axis->angle->z, count);
+    if (priv->compute_type == CT_FLOAT) {
+        fill_sincos_cl_float (f_tomo_angle, rot_angle);
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki, sizeof (cl_float2), f_tomo_angle));
+    } else {
+        fill_sincos_cl_double (d_tomo_angle, rot_angle);
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki, sizeof (cl_double2), d_tomo_angle));
+    }
+}
+
+/**
+ * backproject_burst:
+ * @count: index of the last projection of the burst
+ * @first_chunk: first chunk to backproject into
+ * @last_chunk: one past the last chunk to backproject into
+ *
+ * Backproject the projections currently stored in the burst images into the
+ * given range of chunks.
+ */
+static void
+backproject_burst (UfoTask *task,
+                   UfoRequisition *requisition,
+                   cl_command_queue cmd_queue,
+                   cl_kernel kernel,
+                   guint burst,
+                   guint count,
+                   guint first_chunk,
+                   guint last_chunk)
+{
+    UfoGeneralBackprojectTaskPrivate *priv;
+    UfoProfiler *profiler;
+    guint i, ki, device;
+    guint num_slices_current_chunk;
     cl_int iteration;
-    const gsize local_work_size[3] = {16, 8, 8};
+    const gsize *local_work_size;
     gsize global_work_size[3];
     gint real_size[4];
 
     priv = UFO_GENERAL_BACKPROJECT_TASK_GET_PRIVATE (task);
-    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
-    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
-    ufo_buffer_get_requisition (inputs[0], &in_req);
-    g_object_get (task, "num_processed", &count, NULL);
-
-    if (count >= priv->num_projections / priv->burst * priv->burst) {
-        kernel = priv->rest_kernel;
-        burst = priv->num_projections % priv->burst;
-        index = (count - priv->num_projections / priv->burst * priv->burst) % burst;
-    } else {
-        kernel = priv->kernel;
-        burst = priv->burst;
-        index = count % burst;
-    }
+    profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
+    local_work_size = priv->local_work_size;
 
     global_work_size[0] = requisition->dims[0] % local_work_size[0] ?
                           NEXT_DIVISOR (requisition->dims[0], local_work_size[0]) :
@@ -1625,44 +2451,190 @@ ufo_general_backproject_task_process (UfoTask *task,
     global_work_size[1] = requisition->dims[1] % local_work_size[1] ?
                           NEXT_DIVISOR (requisition->dims[1], local_work_size[1]) :
                           requisition->dims[1];
-    global_work_size[2] = priv->num_slices_per_chunk % local_work_size[2] ?
-                          NEXT_DIVISOR (priv->num_slices_per_chunk, local_work_size[2]) :
-                          priv->num_slices_per_chunk;
+    if (priv->fast_parallel) {
+        /* The kernel loops over the slices of the chunk to reuse the detector columns */
+        global_work_size[2] = get_fast_parallel_depth (priv->num_slices_per_chunk, local_work_size[2]);
+    } else {
+        global_work_size[2] = priv->num_slices_per_chunk % local_work_size[2] ?
+                              NEXT_DIVISOR (priv->num_slices_per_chunk, local_work_size[2]) :
+                              priv->num_slices_per_chunk;
+    }
     real_size[0] = requisition->dims[0];
     real_size[1] = requisition->dims[1];
     real_size[3] = 0;
-    if (!count) {
+    if (count + 1 == burst && !first_chunk) {
         g_log ("gbp", G_LOG_LEVEL_DEBUG, "Global work size: %lu %lu %lu, local: %lu %lu %lu",
                global_work_size[0], global_work_size[1], global_work_size[2],
                local_work_size[0], local_work_size[1], local_work_size[2]);
     }
 
-    /* Setup tomographic rotation angle dependent arguments */
-    ki = STATIC_ARG_OFFSET + burst;
-    rot_angle = ufo_scarray_get_double (priv->geometry->axis->angle->z, count);
-    if (priv->compute_type == CT_FLOAT) {
-        fill_sincos_cl_float (f_tomo_angle, rot_angle);
-        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki + index, sizeof (cl_float2), f_tomo_angle));
+    ki = STATIC_ARG_OFFSET + 2 * burst;
+    iteration = (cl_int) (count + 1 - burst);
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki++, sizeof (cl_int), &iteration));
+    for (i = first_chunk; i < last_chunk; i++) {
+        /* The last chunk might be smaller */
+        num_slices_current_chunk = MIN (priv->num_slices,  (i + 1) * priv->num_slices_per_chunk) - i * priv->num_slices_per_chunk;
+        real_size[2] = (gint) num_slices_current_chunk;
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, REAL_SIZE_ARG_INDEX, sizeof (cl_int3), real_size));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki, sizeof (cl_mem), &priv->chunks[i]));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki + 1, sizeof (cl_mem), &priv->cl_regions[i]));
+        if (priv->upload_events) {
+            /* Kernel arguments are captured at enqueue time, so the
+             * devices can work on their slabs concurrently */
+            device = priv->chunk_devices[i];
+            set_projection_args (priv, kernel, burst, device);
+            ufo_profiler_call (profiler, priv->cmd_queues[device], kernel, 3, global_work_size, local_work_size);
+        } else if (priv->num_image_sets > 1) {
+            if (i == first_chunk) {
+                set_projection_args (priv, kernel, burst, priv->current_set);
+            }
+            ufo_profiler_call (profiler, cmd_queue, kernel, 3, global_work_size, local_work_size);
+        } else {
+            ufo_profiler_call_blocking (profiler, cmd_queue, kernel, 3, global_work_size, local_work_size);
+        }
+    }
+    if (priv->num_image_sets > 1 && !priv->upload_events) {
+        /* Mark the end of this burst and switch to the other image set */
+        if (priv->set_events[priv->current_set]) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseEvent (priv->set_events[priv->current_set]));
+        }
+        UFO_RESOURCES_CHECK_CLERR (clEnqueueMarkerWithWaitList (cmd_queue, 0, NULL,
+                                                                &priv->set_events[priv->current_set]));
+        UFO_RESOURCES_CHECK_CLERR (clFlush (cmd_queue));
+        priv->current_set = 1 - priv->current_set;
+    }
+}
+
+static void
+release_chunks (UfoGeneralBackprojectTaskPrivate *priv)
+{
+    guint i;
+
+    for (i = 0; i < priv->num_chunks; i++) {
+        if (priv->chunks[i]) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->chunks[i]));
+            priv->chunks[i] = NULL;
+        }
+    }
+}
+
+/**
+ * reconstruct_pass:
+ * @first_chunk: first chunk of the pass
+ *
+ * Out-of-core mode: allocate the chunks of one pass and backproject all
+ * projections cached on the host into them.
+ */
+static void
+reconstruct_pass (UfoTask *task,
+                  UfoRequisition *requisition,
+                  cl_command_queue cmd_queue,
+                  guint first_chunk)
+{
+    UfoGeneralBackprojectTaskPrivate *priv;
+    guint i, count, burst, index, last_chunk, num_slices_current_chunk;
+    gsize slice_size, projection_size;
+    cl_kernel kernel;
+    cl_int cl_error;
+    const size_t origin[] = {0, 0, 0};
+    size_t region[3];
+
+    priv = UFO_GENERAL_BACKPROJECT_TASK_GET_PRIVATE (task);
+    last_chunk = MIN (priv->num_chunks, first_chunk + priv->chunks_per_pass);
+    slice_size = requisition->dims[0] * requisition->dims[1] * get_type_size (priv->store_type);
+    projection_size = priv->projection_dims[0] * priv->projection_dims[1] *
+                      get_projection_type_size (priv->projection_type);
+    region[0] = priv->projection_dims[0];
+    region[1] = priv->projection_dims[1];
+    region[2] = 1;
+    g_log ("gbp", G_LOG_LEVEL_DEBUG, "Reconstructing chunks %u-%u", first_chunk, last_chunk - 1);
+
+    release_chunks (priv);
+    for (i = first_chunk; i < last_chunk; i++) {
+        num_slices_current_chunk = MIN (priv->num_slices,  (i + 1) * priv->num_slices_per_chunk) - i * priv->num_slices_per_chunk;
+        priv->chunks[i] = clCreateBuffer (priv->context,
+                                          CL_MEM_WRITE_ONLY,
+                                          num_slices_current_chunk * slice_size,
+                                          NULL,
+                                          &cl_error);
+        UFO_RESOURCES_CHECK_CLERR (cl_error);
+    }
+
+    for (count = 0; count < priv->num_projections; count++) {
+        kernel = get_burst_kernel (priv, count, &burst, &index);
+        /* The host cache outlives the transfer, no need to wait for it */
+        UFO_RESOURCES_CHECK_CLERR (clEnqueueWriteImage (cmd_queue, priv->projections[index],
+                                                        CL_FALSE, origin, region, 0, 0,
+                                                        priv->host_projections + count * projection_size,
+                                                        0, NULL, NULL));
+        set_angle_arg (priv, kernel, burst, index, count);
+        if (index + 1 == burst) {
+            backproject_burst (task, requisition, cmd_queue, kernel, burst, count, first_chunk, last_chunk);
+        }
+    }
+}
+
+static gboolean
+ufo_general_backproject_task_process (UfoTask *task,
+                                      UfoBuffer **inputs,
+                                      UfoBuffer *output,
+                                      UfoRequisition *requisition)
+{
+    UfoGeneralBackprojectTaskPrivate *priv;
+    UfoRequisition in_req;
+    UfoGpuNode *node;
+    guint index, count, burst;
+    gsize projection_size;
+    cl_kernel kernel;
+    cl_command_queue cmd_queue;
+
+    priv = UFO_GENERAL_BACKPROJECT_TASK_GET_PRIVATE (task);
+    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
+    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
+    ufo_buffer_get_requisition (inputs[0], &in_req);
+    g_object_get (task, "num_processed", &count, NULL);
+
+    if (priv->out_of_core) {
+        /* The host cache holds exactly num-projections projections */
+        if (count >= priv->num_projections) {
+            if (count == priv->num_projections)
+                g_warning ("general-backproject: ignoring projections beyond num-projections=%u in out-of-core mode",
+                           priv->num_projections);
+
+            return TRUE;
+        }
+
+        /* Backprojection happens pass by pass in generate */
+        projection_size = in_req.dims[0] * in_req.dims[1];
+        if (priv->projection_type == PT_FLOAT) {
+            memcpy (priv->host_projections + count * projection_size * sizeof (gfloat),
+                    ufo_buffer_get_host_array (inputs[0], NULL),
+                    projection_size * sizeof (gfloat));
+        } else {
+            convert_projection (priv, ufo_buffer_get_host_array (inputs[0], NULL),
+                                (guint16 *) (priv->host_projections + count * projection_size * sizeof (guint16)),
+                                projection_size);
+        }
+        return TRUE;
+    }
+
+    kernel = get_burst_kernel (priv, count, &burst, &index);
+    set_angle_arg (priv, kernel, burst, index, count);
+
+    if (priv->upload_events) {
+        upload_to_devices (priv, inputs[0], index, in_req.dims[0], in_req.dims[1]);
+    } else if (priv->num_image_sets > 1) {
+        /* Overwrite the image set only after the kernels of two bursts ago
+         * are done with it, the previous burst may still be running */
+        store_to_image (priv, cmd_queue, inputs[0],
+                        priv->projections[priv->current_set * priv->burst + index],
+                        in_req.dims[0], in_req.dims[1], priv->set_events[priv->current_set]);
     } else {
-        fill_sincos_cl_double (d_tomo_angle, rot_angle);
-        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki + index, sizeof (cl_double2), d_tomo_angle));
+        store_to_image (priv, cmd_queue, inputs[0], priv->projections[index], in_req.dims[0], in_req.dims[1], NULL);
     }
-    copy_to_image (cmd_queue, inputs[0], priv->projections[index], in_req.dims[0], in_req.dims[1]);
 
     if (index + 1 == burst) {
-        profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
-        ki += index + 1;
-        iteration = (cl_int) (count + 1 - burst);
-        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki++, sizeof (cl_int), &iteration));
-        for (i = 0; i < priv->num_chunks; i++) {
-            /* The last chunk might be smaller */
-            num_slices_current_chunk = MIN (priv->num_slices,  (i + 1) * priv->num_slices_per_chunk) - i * priv->num_slices_per_chunk;
-            real_size[2] = (gint) num_slices_current_chunk;
-            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, REAL_SIZE_ARG_INDEX, sizeof (cl_int3), real_size));
-            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki, sizeof (cl_mem), &priv->chunks[i]));
-            UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, ki + 1, sizeof (cl_mem), &priv->cl_regions[i]));
-            ufo_profiler_call_blocking (profiler, cmd_queue, kernel, 3, global_work_size, local_work_size);
-        }
+        backproject_burst (task, requisition, cmd_queue, kernel, burst, count, 0, priv->num_chunks);
     }
 
     return TRUE;
@@ -1677,7 +2649,7 @@ ufo_general_backproject_task_generate (UfoTask *task,
     UfoGpuNode *node;
     cl_command_queue cmd_queue;
     cl_mem out_mem;
-    guint count, chunk_index;
+    guint i, count, chunk_index;
     /* TODO: handle other data types */
     size_t bpp;
     size_t src_row_pitch, src_slice_pitch;
@@ -1698,6 +2670,17 @@ ufo_general_backproject_task_generate (UfoTask *task,
         return FALSE;
     }
 
+    if (priv->upload_events && !priv->generated) {
+        for (i = 0; i < priv->num_devices; i++) {
+            UFO_RESOURCES_CHECK_CLERR (clFinish (priv->cmd_queues[i]));
+        }
+    }
+
+    if (priv->out_of_core && !(priv->generated % priv->num_slices_per_chunk) &&
+        !(chunk_index % priv->chunks_per_pass)) {
+        reconstruct_pass (task, requisition, cmd_queue, chunk_index);
+    }
+
     src_row_pitch = requisition->dims[0] * bpp;
     src_slice_pitch = src_row_pitch * requisition->dims[1];
     src_origin[2] = priv->generated % priv->num_slices_per_chunk;
@@ -1823,6 +2806,36 @@ ufo_general_backproject_task_set_property (GObject *object,
         case PROP_GRAY_MAP_MAX:
             priv->gray_map_max = g_value_get_double (value);
             break;
+        case PROP_AUTOTUNE:
+            priv->autotune = g_value_get_boolean (value);
+            break;
+        case PROP_MULTI_DEVICE:
+            priv->multi_device = g_value_get_boolean (value);
+            break;
+        case PROP_OVERLAP:
+            priv->overlap = g_value_get_boolean (value);
+            break;
+        case PROP_UPLOAD_QUEUE:
+            priv->upload_queue = g_value_get_boolean (value);
+            break;
+        case PROP_OUT_OF_CORE:
+            priv->out_of_core = g_value_get_boolean (value);
+            break;
+        case PROP_MEMORY_BUDGET:
+            priv->memory_budget = g_value_get_uint (value);
+            break;
+        case PROP_PROJECTION_TYPE:
+            priv->projection_type = g_value_get_enum (value);
+            break;
+        case PROP_PROJECTION_SCALE:
+            priv->projection_scale = g_value_get_double (value);
+            break;
+        case PROP_PROJECTION_OFFSET:
+            priv->projection_offset = g_value_get_double (value);
+            break;
+        case PROP_PROJECTION_MATRICES:
+            priv->projection_matrices = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -1928,6 +2941,36 @@ ufo_general_backproject_task_get_property (GObject *object,
         case PROP_GRAY_MAP_MAX:
             g_value_set_double (value, priv->gray_map_max);
             break;
+        case PROP_AUTOTUNE:
+            g_value_set_boolean (value, priv->autotune);
+            break;
+        case PROP_MULTI_DEVICE:
+            g_value_set_boolean (value, priv->multi_device);
+            break;
+        case PROP_OVERLAP:
+            g_value_set_boolean (value, priv->overlap);
+            break;
+        case PROP_UPLOAD_QUEUE:
+            g_value_set_boolean (value, priv->upload_queue);
+            break;
+        case PROP_OUT_OF_CORE:
+            g_value_set_boolean (value, priv->out_of_core);
+            break;
+        case PROP_MEMORY_BUDGET:
+            g_value_set_uint (value, priv->memory_budget);
+            break;
+        case PROP_PROJECTION_TYPE:
+            g_value_set_enum (value, priv->projection_type);
+            break;
+        case PROP_PROJECTION_SCALE:
+            g_value_set_double (value, priv->projection_scale);
+            break;
+        case PROP_PROJECTION_OFFSET:
+            g_value_set_double (value, priv->projection_offset);
+            break;
+        case PROP_PROJECTION_MATRICES:
+            g_value_set_boolean (value, priv->projection_matrices);
+            break;
         case PROP_ADDRESSING_MODE:
             g_value_set_enum (value, priv->addressing_mode);
             break;
@@ -1952,7 +2995,7 @@ ufo_general_backproject_task_finalize (GObject *object)
     g_hash_table_destroy (priv->node_props_table);
 
     if (priv->projections) {
-        for (i = 0; i < priv->burst; i++) {
+        for (i = 0; i < priv->burst * priv->num_image_sets; i++) {
             if (priv->projections[i] != NULL) {
                 UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->projections[i]));
                 priv->projections[i] = NULL;
@@ -1964,9 +3007,7 @@ ufo_general_backproject_task_finalize (GObject *object)
 
 
     if (priv->chunks) {
-        for (i = 0; i < priv->num_chunks; i++) {
-            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->chunks[i]));
-        }
+        release_chunks (priv);
         g_free (priv->chunks);
         priv->chunks = NULL;
     }
@@ -1979,12 +3020,42 @@ ufo_general_backproject_task_finalize (GObject *object)
         priv->cl_regions = NULL;
     }
 
-    if (priv->vector_arguments) {
-        for (i = 0; i < NUM_VECTOR_ARGUMENTS; i++) {
-            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->vector_arguments[i]));
+    release_vector_arguments (priv);
+    g_free (priv->chunk_devices);
+    g_free (priv->cmd_queues);
+    g_free (priv->host_projections);
+    g_free (priv->staging);
+
+    if (priv->upload_events) {
+        for (i = 0; i < priv->burst * priv->num_devices; i++) {
+            if (priv->upload_events[i]) {
+                UFO_RESOURCES_CHECK_CLERR (clReleaseEvent (priv->upload_events[i]));
+            }
         }
-        g_free (priv->vector_arguments);
-        priv->vector_arguments = NULL;
+        g_free (priv->upload_events);
+        priv->upload_events = NULL;
+    }
+
+    if (priv->convert_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->convert_kernel));
+        priv->convert_kernel = NULL;
+    }
+
+    if (priv->matrices) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->matrices));
+        priv->matrices = NULL;
+    }
+
+    for (i = 0; i < 2; i++) {
+        if (priv->set_events[i]) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseEvent (priv->set_events[i]));
+            priv->set_events[i] = NULL;
+        }
+    }
+
+    if (priv->transfer_queue) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseCommandQueue (priv->transfer_queue));
+        priv->transfer_queue = NULL;
     }
 
     if (priv->kernel) {
@@ -2271,6 +3342,79 @@ ufo_general_backproject_task_class_init (UfoGeneralBackprojectTaskClass *klass)
             0, 16384, 0,
             G_PARAM_READWRITE);
 
+    properties[PROP_AUTOTUNE] =
+        g_param_spec_boolean ("autotune",
+            "Benchmark burst, local work size and register limit on the device",
+            "Benchmark burst, local work size and register limit on the device",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_MULTI_DEVICE] =
+        g_param_spec_boolean ("multi-device",
+            "Distribute the reconstructed slabs over all OpenCL devices",
+            "Distribute the reconstructed slabs over all OpenCL devices, ignored in out-of-core mode",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_OVERLAP] =
+        g_param_spec_boolean ("overlap",
+            "Double-buffer projections so that uploads overlap with backprojection",
+            "Double-buffer projections so that uploads overlap with backprojection, "
+            "ignored with multiple devices and in out-of-core mode",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_UPLOAD_QUEUE] =
+        g_param_spec_boolean ("upload-queue",
+            "Use a separate command queue for projection uploads if overlap is enabled",
+            "Use a separate command queue for projection uploads if overlap is enabled",
+            TRUE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_OUT_OF_CORE] =
+        g_param_spec_boolean ("out-of-core",
+            "Cache projections on the host and reconstruct the volume in passes",
+            "Cache projections on the host and reconstruct the volume in passes on one "
+            "device, multi-device and overlap are ignored in this mode",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_MEMORY_BUDGET] =
+        g_param_spec_uint ("memory-budget",
+            "Device memory in MB used in out-of-core mode (0 for all)",
+            "Device memory in MB used in out-of-core mode (0 for all)",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_PROJECTION_TYPE] =
+        g_param_spec_enum ("projection-type",
+            "Data type of the projection textures",
+            "Data type of the projection textures (\"float\", \"half\", \"unorm16\")",
+            g_enum_register_static ("projection-type", pt_values),
+            PT_FLOAT,
+            G_PARAM_READWRITE);
+
+    properties[PROP_PROJECTION_SCALE] =
+        g_param_spec_double ("projection-scale",
+            "Scale of reduced projection types",
+            "Scale of reduced projection types, stored value = (value - offset) / scale",
+            -G_MAXDOUBLE, G_MAXDOUBLE, 1.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_PROJECTION_OFFSET] =
+        g_param_spec_double ("projection-offset",
+            "Offset of reduced projection types",
+            "Offset of reduced projection types, stored value = (value - offset) / scale",
+            -G_MAXDOUBLE, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_PROJECTION_MATRICES] =
+        g_param_spec_boolean ("projection-matrices",
+            "Project voxels by precomputed per-projection matrices",
+            "Project voxels by precomputed per-projection matrices",
+            FALSE,
+            G_PARAM_READWRITE);
+
     for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (oclass, i, properties[i]);
 
@@ -2294,6 +3438,12 @@ ufo_general_backproject_task_init(UfoGeneralBackprojectTask *self)
     self->priv->addressing_mode = CL_ADDRESS_CLAMP;
     self->priv->gray_map_min = 0.0;
     self->priv->gray_map_max = 0.0;
+    self->priv->autotune = FALSE;
+    self->priv->multi_device = FALSE;
+    self->priv->overlap = FALSE;
+    self->priv->upload_queue = TRUE;
+    self->priv->out_of_core = FALSE;
+    self->priv->memory_budget = 0;
 
     /* Value arrays */
     self->priv->region = ufo_scarray_new (3, G_TYPE_DOUBLE, NULL);
@@ -2303,8 +3453,32 @@ ufo_general_backproject_task_init(UfoGeneralBackprojectTask *self)
 
     /* Private */
     self->priv->vectorized = FALSE;
+    self->priv->fast_parallel = FALSE;
     self->priv->num_slices = 0;
     self->priv->num_slices_per_chunk = 0;
     self->priv->generated = 0;
+    self->priv->tuned = FALSE;
+    self->priv->num_devices = 1;
+    self->priv->cmd_queues = NULL;
+    self->priv->chunk_devices = NULL;
+    self->priv->num_image_sets = 1;
+    self->priv->current_set = 0;
+    self->priv->transfer_queue = NULL;
+    self->priv->set_events[0] = NULL;
+    self->priv->set_events[1] = NULL;
+    self->priv->host_projections = NULL;
+    self->priv->staging = NULL;
+    self->priv->upload_events = NULL;
+    self->priv->convert_kernel = NULL;
+    self->priv->projection_matrices = FALSE;
+    self->priv->matrices = NULL;
+    self->priv->projection_type = PT_FLOAT;
+    self->priv->projection_scale = 1.0;
+    self->priv->projection_offset = 0.0;
+    self->priv->chunks_per_pass = 0;
+    self->priv->max_regcount = 0;
+    self->priv->local_work_size[0] = 16;
+    self->priv->local_work_size[1] = 8;
+    self->priv->local_work_size[2] = 8;
 }
 /*}}}*/
@@ -0,0 +1,731 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <math.h>
+#include "common/ufo-scarray.h"
+#include "common/ufo-ctgeometry.h"
+#include "ufo-general-forwardproject-task.h"
+
+
+struct _UfoGeneralForwardprojectTaskPrivate {
+    cl_context context;
+    cl_kernel kernel;
+    cl_mem rays;
+    UfoCTGeometry *geometry;
+    gsize volume_dims[3];
+    gboolean geometry_changed;
+    guint num_projections;
+    gdouble overall_angle;
+    guint detector_width;
+    guint detector_height;
+};
+
+static void ufo_task_interface_init (UfoTaskIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (UfoGeneralForwardprojectTask, ufo_general_forwardproject_task, UFO_TYPE_TASK_NODE,
+                         G_IMPLEMENT_INTERFACE (UFO_TYPE_TASK,
+                                                ufo_task_interface_init))
+
+#define UFO_GENERAL_FORWARDPROJECT_TASK_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), UFO_TYPE_GENERAL_FORWARDPROJECT_TASK, UfoGeneralForwardprojectTaskPrivate))
+
+enum {
+    PROP_0,
+    PROP_NUM_PROJECTIONS,
+    PROP_OVERALL_ANGLE,
+    PROP_DETECTOR_WIDTH,
+    PROP_DETECTOR_HEIGHT,
+    PROP_CENTER_POSITION_X,
+    PROP_CENTER_POSITION_Z,
+    PROP_SOURCE_POSITION_X,
+    PROP_SOURCE_POSITION_Y,
+    PROP_SOURCE_POSITION_Z,
+    PROP_DETECTOR_POSITION_X,
+    PROP_DETECTOR_POSITION_Y,
+    PROP_DETECTOR_POSITION_Z,
+    PROP_DETECTOR_ANGLE_X,
+    PROP_DETECTOR_ANGLE_Y,
+    PROP_DETECTOR_ANGLE_Z,
+    PROP_AXIS_ANGLE_X,
+    PROP_AXIS_ANGLE_Y,
+    PROP_AXIS_ANGLE_Z,
+    PROP_VOLUME_ANGLE_X,
+    PROP_VOLUME_ANGLE_Y,
+    PROP_VOLUME_ANGLE_Z,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+UfoNode *
+ufo_general_forwardproject_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_GENERAL_FORWARDPROJECT_TASK, NULL));
+}
+
+static gboolean
+invert (gdouble m[3][3], gdouble inverse[3][3])
+{
+    gdouble determinant;
+    guint i, j;
+
+    determinant = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                  m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                  m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+    if (fabs (determinant) < 1e-12)
+        return FALSE;
+
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) {
+            inverse[i][j] = (m[(j + 1) % 3][(i + 1) % 3] * m[(j + 2) % 3][(i + 2) % 3] -
+                             m[(j + 1) % 3][(i + 2) % 3] * m[(j + 2) % 3][(i + 1) % 3]) / determinant;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * compute_rays:
+ * @priv: task private data
+ * @flat: %TRUE if the volume is a single slice
+ * @error: return location for a GError
+ *
+ * Invert the projection matrices of all projections into the rays through
+ * the detector pixels. For a parallel beam the rays through (u, v) are the
+ * voxels which project onto (u, v), for a cone beam the rays start at the
+ * source. A single slice is projected onto the detector row of its center.
+ */
+static void
+compute_rays (UfoGeneralForwardprojectTaskPrivate *priv, gboolean flat, GError **error)
+{
+    gfloat matrix[16];
+    gfloat *host_rays;
+    gdouble m[3][3], inverse[3][3], b[3], start[3], vectors[6][3], row;
+    gboolean parallel_beam = TRUE, perpendicular_detector;
+    cl_int errcode;
+    guint i, j, k;
+
+    for (i = 0; i < priv->num_projections; i++) {
+        parallel_beam = parallel_beam && isinf (ufo_scarray_get_double (priv->geometry->source_position->y, i));
+    }
+
+    perpendicular_detector = ufo_scpoint_are_almost_zero (priv->geometry->detector->angle);
+
+    /* Voxel coordinates of the first voxel, same as general-backproject regions */
+    for (k = 0; k < 3; k++) {
+        start[k] = -((gdouble) (priv->volume_dims[k] / 2));
+    }
+
+    host_rays = g_new0 (gfloat, 24 * priv->num_projections);
+
+    for (i = 0; i < priv->num_projections; i++) {
+        ufo_ctgeometry_compute_projection_matrix (priv->geometry, i, parallel_beam, perpendicular_detector,
+                                                  TRUE, TRUE, matrix);
+
+        for (j = 0; j < 3; j++) {
+            for (k = 0; k < 3; k++) {
+                m[j][k] = matrix[4 * j + k];
+            }
+            b[j] = matrix[4 * j + 3];
+        }
+
+        if (parallel_beam) {
+            /* The projection is affine, complete it with the beam direction */
+            m[2][0] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+            m[2][1] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+            m[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+            b[2] = 0.0;
+        }
+
+        if (!invert (m, inverse)) {
+            g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                         "Geometry of projection %u is degenerate", i);
+            g_free (host_rays);
+            return;
+        }
+
+        for (k = 0; k < 3; k++) {
+            vectors[0][k] = -(inverse[k][0] * b[0] + inverse[k][1] * b[1] + inverse[k][2] * b[2]) - start[k];
+
+            if (parallel_beam) {
+                vectors[1][k] = inverse[k][0];
+                vectors[2][k] = inverse[k][1];
+                vectors[3][k] = m[2][k];
+                vectors[4][k] = vectors[5][k] = 0.0;
+            } else {
+                vectors[1][k] = vectors[2][k] = 0.0;
+                vectors[3][k] = inverse[k][2];
+                vectors[4][k] = inverse[k][0];
+                vectors[5][k] = inverse[k][1];
+            }
+        }
+
+        if (flat) {
+            /* The only row, which the kernel samples at 0.5, becomes the one
+             * onto which the volume origin projects */
+            row = (parallel_beam ? b[1] : b[1] / b[2]) - 0.5;
+
+            for (k = 0; k < 3; k++) {
+                vectors[0][k] += row * vectors[2][k];
+                vectors[3][k] += row * vectors[5][k];
+                vectors[2][k] = vectors[5][k] = 0.0;
+            }
+        }
+
+        for (j = 0; j < 6; j++) {
+            for (k = 0; k < 3; k++) {
+                host_rays[24 * i + 4 * j + k] = (gfloat) vectors[j][k];
+            }
+        }
+    }
+
+    if (priv->rays) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->rays));
+    }
+
+    priv->rays = clCreateBuffer (priv->context,
+                                 CL_MEM_COPY_HOST_PTR | CL_MEM_READ_ONLY,
+                                 24 * priv->num_projections * sizeof (gfloat), host_rays,
+                                 &errcode);
+    UFO_RESOURCES_CHECK_CLERR (errcode);
+    g_free (host_rays);
+}
+
+static void
+ufo_general_forwardproject_task_setup (UfoTask *task,
+                                       UfoResources *resources,
+                                       GError **error)
+{
+    UfoGeneralForwardprojectTaskPrivate *priv;
+    GValue tomo_angle = G_VALUE_INIT;
+
+    priv = UFO_GENERAL_FORWARDPROJECT_TASK_GET_PRIVATE (task);
+
+    if (!priv->num_projections) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "Number of projections not set");
+        return;
+    }
+
+    if (!ufo_scarray_has_n_values (priv->geometry->axis->angle->z, priv->num_projections)) {
+        /* Equidistant tomographic angles like in general-backproject */
+        ufo_scarray_free (priv->geometry->axis->angle->z);
+        priv->geometry->axis->angle->z = ufo_scarray_new (priv->num_projections, G_TYPE_DOUBLE, NULL);
+        g_value_init (&tomo_angle, G_TYPE_DOUBLE);
+
+        for (guint i = 0; i < priv->num_projections; i++) {
+            g_value_set_double (&tomo_angle, ((gdouble) i) / priv->num_projections * priv->overall_angle);
+            ufo_scarray_insert (priv->geometry->axis->angle->z, i, &tomo_angle);
+        }
+
+        g_value_unset (&tomo_angle);
+    }
+
+    priv->context = ufo_resources_get_context (resources);
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainContext (priv->context), error);
+    priv->kernel = ufo_resources_get_kernel (resources, "general-forwardproject.cl", "general_forwardproject", NULL, error);
+
+    if (priv->kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->kernel), error);
+}
+
+static void
+ufo_general_forwardproject_task_get_requisition (UfoTask *task,
+                                                 UfoBuffer **inputs,
+                                                 UfoRequisition *requisition,
+                                                 GError **error)
+{
+    UfoGeneralForwardprojectTaskPrivate *priv;
+    UfoRequisition in_req;
+    gsize depth;
+
+    priv = UFO_GENERAL_FORWARDPROJECT_TASK_GET_PRIVATE (task);
+    ufo_buffer_get_requisition (inputs[0], &in_req);
+    depth = in_req.n_dims == 3 ? in_req.dims[2] : 1;
+
+    /* A slice gives a sinogram, a volume a stack of projections */
+    requisition->n_dims = in_req.n_dims == 3 ? 3 : 2;
+    requisition->dims[0] = priv->detector_width ? priv->detector_width : in_req.dims[0];
+
+    if (in_req.n_dims == 3) {
+        requisition->dims[1] = priv->detector_height ? priv->detector_height : depth;
+        requisition->dims[2] = priv->num_projections;
+    } else {
+        requisition->dims[1] = priv->num_projections;
+    }
+
+    if (priv->geometry_changed || priv->volume_dims[0] != in_req.dims[0] ||
+        priv->volume_dims[1] != in_req.dims[1] || priv->volume_dims[2] != depth) {
+        priv->volume_dims[0] = in_req.dims[0];
+        priv->volume_dims[1] = in_req.dims[1];
+        priv->volume_dims[2] = depth;
+        priv->geometry_changed = FALSE;
+        compute_rays (priv, in_req.n_dims != 3, error);
+    }
+}
+
+static guint
+ufo_general_forwardproject_task_get_num_inputs (UfoTask *task)
+{
+    return 1;
+}
+
+static guint
+ufo_general_forwardproject_task_get_num_dimensions (UfoTask *task,
+                                                    guint input)
+{
+    g_return_val_if_fail (input == 0, 0);
+    return 2;
+}
+
+static UfoTaskMode
+ufo_general_forwardproject_task_get_mode (UfoTask *task)
+{
+    return UFO_TASK_MODE_PROCESSOR | UFO_TASK_MODE_GPU;
+}
+
+static gboolean
+ufo_general_forwardproject_task_process (UfoTask *task,
+                                         UfoBuffer **inputs,
+                                         UfoBuffer *output,
+                                         UfoRequisition *requisition)
+{
+    UfoGeneralForwardprojectTaskPrivate *priv;
+    UfoGpuNode *node;
+    UfoProfiler *profiler;
+    cl_command_queue cmd_queue;
+    cl_mem in_mem, out_mem;
+    cl_int volume_size[4];
+    gsize global_work_size[3];
+
+    priv = UFO_GENERAL_FORWARDPROJECT_TASK_GET_PRIVATE (task);
+    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
+    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
+    profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
+    in_mem = ufo_buffer_get_device_array (inputs[0], cmd_queue);
+    out_mem = ufo_buffer_get_device_array (output, cmd_queue);
+
+    for (guint i = 0; i < 3; i++) {
+        volume_size[i] = (cl_int) priv->volume_dims[i];
+    }
+    volume_size[3] = 0;
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 0, sizeof (cl_mem), &in_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 1, sizeof (cl_mem), &out_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 2, sizeof (cl_mem), &priv->rays));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 3, sizeof (cl_int3), volume_size));
+
+    /* All projections and detector rows in one launch */
+    global_work_size[0] = requisition->dims[0];
+    global_work_size[1] = requisition->n_dims == 3 ? requisition->dims[1] : 1;
+    global_work_size[2] = priv->num_projections;
+    ufo_profiler_call (profiler, cmd_queue, priv->kernel, 3, global_work_size, NULL);
+
+    return TRUE;
+}
+
+static void
+ufo_general_forwardproject_task_set_property (GObject *object,
+                                              guint property_id,
+                                              const GValue *value,
+                                              GParamSpec *pspec)
+{
+    UfoGeneralForwardprojectTaskPrivate *priv = UFO_GENERAL_FORWARDPROJECT_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_NUM_PROJECTIONS:
+            priv->num_projections = g_value_get_uint (value);
+            break;
+        case PROP_OVERALL_ANGLE:
+            priv->overall_angle = g_value_get_double (value);
+            break;
+        case PROP_DETECTOR_WIDTH:
+            priv->detector_width = g_value_get_uint (value);
+            break;
+        case PROP_DETECTOR_HEIGHT:
+            priv->detector_height = g_value_get_uint (value);
+            break;
+        case PROP_CENTER_POSITION_X:
+            ufo_scarray_get_value (priv->geometry->axis->position->x, value);
+            break;
+        case PROP_CENTER_POSITION_Z:
+            ufo_scarray_get_value (priv->geometry->axis->position->z, value);
+            break;
+        case PROP_SOURCE_POSITION_X:
+            ufo_scarray_get_value (priv->geometry->source_position->x, value);
+            break;
+        case PROP_SOURCE_POSITION_Y:
+            ufo_scarray_get_value (priv->geometry->source_position->y, value);
+            break;
+        case PROP_SOURCE_POSITION_Z:
+            ufo_scarray_get_value (priv->geometry->source_position->z, value);
+            break;
+        case PROP_DETECTOR_POSITION_X:
+            ufo_scarray_get_value (priv->geometry->detector->position->x, value);
+            break;
+        case PROP_DETECTOR_POSITION_Y:
+            ufo_scarray_get_value (priv->geometry->detector->position->y, value);
+            break;
+        case PROP_DETECTOR_POSITION_Z:
+            ufo_scarray_get_value (priv->geometry->detector->position->z, value);
+            break;
+        case PROP_DETECTOR_ANGLE_X:
+            ufo_scarray_get_value (priv->geometry->detector->angle->x, value);
+            break;
+        case PROP_DETECTOR_ANGLE_Y:
+            ufo_scarray_get_value (priv->geometry->detector->angle->y, value);
+            break;
+        case PROP_DETECTOR_ANGLE_Z:
+            ufo_scarray_get_value (priv->geometry->detector->angle->z, value);
+            break;
+        case PROP_AXIS_ANGLE_X:
+            ufo_scarray_get_value (priv->geometry->axis->angle->x, value);
+            break;
+        case PROP_AXIS_ANGLE_Y:
+            ufo_scarray_get_value (priv->geometry->axis->angle->y, value);
+            break;
+        case PROP_AXIS_ANGLE_Z:
+            ufo_scarray_get_value (priv->geometry->axis->angle->z, value);
+            break;
+        case PROP_VOLUME_ANGLE_X:
+            ufo_scarray_get_value (priv->geometry->volume_angle->x, value);
+            break;
+        case PROP_VOLUME_ANGLE_Y:
+            ufo_scarray_get_value (priv->geometry->volume_angle->y, value);
+            break;
+        case PROP_VOLUME_ANGLE_Z:
+            ufo_scarray_get_value (priv->geometry->volume_angle->z, value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            return;
+    }
+
+    priv->geometry_changed = TRUE;
+}
+
+static void
+ufo_general_forwardproject_task_get_property (GObject *object,
+                                              guint property_id,
+                                              GValue *value,
+                                              GParamSpec *pspec)
+{
+    UfoGeneralForwardprojectTaskPrivate *priv = UFO_GENERAL_FORWARDPROJECT_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_NUM_PROJECTIONS:
+            g_value_set_uint (value, priv->num_projections);
+            break;
+        case PROP_OVERALL_ANGLE:
+            g_value_set_double (value, priv->overall_angle);
+            break;
+        case PROP_DETECTOR_WIDTH:
+            g_value_set_uint (value, priv->detector_width);
+            break;
+        case PROP_DETECTOR_HEIGHT:
+            g_value_set_uint (value, priv->detector_height);
+            break;
+        case PROP_CENTER_POSITION_X:
+            ufo_scarray_set_value (priv->geometry->axis->position->x, value);
+            break;
+        case PROP_CENTER_POSITION_Z:
+            ufo_scarray_set_value (priv->geometry->axis->position->z, value);
+            break;
+        case PROP_SOURCE_POSITION_X:
+            ufo_scarray_set_value (priv->geometry->source_position->x, value);
+            break;
+        case PROP_SOURCE_POSITION_Y:
+            ufo_scarray_set_value (priv->geometry->source_position->y, value);
+            break;
+        case PROP_SOURCE_POSITION_Z:
+            ufo_scarray_set_value (priv->geometry->source_position->z, value);
+            break;
+        case PROP_DETECTOR_POSITION_X:
+            ufo_scarray_set_value (priv->geometry->detector->position->x, value);
+            break;
+        case PROP_DETECTOR_POSITION_Y:
+            ufo_scarray_set_value (priv->geometry->detector->position->y, value);
+            break;
+        case PROP_DETECTOR_POSITION_Z:
+            ufo_scarray_set_value (priv->geometry->detector->position->z, value);
+            break;
+        case PROP_DETECTOR_ANGLE_X:
+            ufo_scarray_set_value (priv->geometry->detector->angle->x, value);
+            break;
+        case PROP_DETECTOR_ANGLE_Y:
+            ufo_scarray_set_value (priv->geometry->detector->angle->y, value);
+            break;
+        case PROP_DETECTOR_ANGLE_Z:
+            ufo_scarray_set_value (priv->geometry->detector->angle->z, value);
+            break;
+        case PROP_AXIS_ANGLE_X:
+            ufo_scarray_set_value (priv->geometry->axis->angle->x, value);
+            break;
+        case PROP_AXIS_ANGLE_Y:
+            ufo_scarray_set_value (priv->geometry->axis->angle->y, value);
+            break;
+        case PROP_AXIS_ANGLE_Z:
+            ufo_scarray_set_value (priv->geometry->axis->angle->z, value);
+            break;
+        case PROP_VOLUME_ANGLE_X:
+            ufo_scarray_set_value (priv->geometry->volume_angle->x, value);
+            break;
+        case PROP_VOLUME_ANGLE_Y:
+            ufo_scarray_set_value (priv->geometry->volume_angle->y, value);
+            break;
+        case PROP_VOLUME_ANGLE_Z:
+            ufo_scarray_set_value (priv->geometry->volume_angle->z, value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_general_forwardproject_task_finalize (GObject *object)
+{
+    UfoGeneralForwardprojectTaskPrivate *priv;
+
+    priv = UFO_GENERAL_FORWARDPROJECT_TASK_GET_PRIVATE (object);
+    ufo_ctgeometry_free (priv->geometry);
+
+    if (priv->rays) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->rays));
+        priv->rays = NULL;
+    }
+
+    if (priv->kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->kernel));
+        priv->kernel = NULL;
+    }
+
+    if (priv->context) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
+        priv->context = NULL;
+    }
+
+    G_OBJECT_CLASS (ufo_general_forwardproject_task_parent_class)->finalize (object);
+}
+
+static void
+ufo_task_interface_init (UfoTaskIface *iface)
+{
+    iface->setup = ufo_general_forwardproject_task_setup;
+    iface->get_requisition = ufo_general_forwardproject_task_get_requisition;
+    iface->get_num_inputs = ufo_general_forwardproject_task_get_num_inputs;
+    iface->get_num_dimensions = ufo_general_forwardproject_task_get_num_dimensions;
+    iface->get_mode = ufo_general_forwardproject_task_get_mode;
+    iface->process = ufo_general_forwardproject_task_process;
+}
+
+static void
+ufo_general_forwardproject_task_class_init (UfoGeneralForwardprojectTaskClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+    oclass->finalize = ufo_general_forwardproject_task_finalize;
+    oclass->set_property = ufo_general_forwardproject_task_set_property;
+    oclass->get_property = ufo_general_forwardproject_task_get_property;
+
+    GParamSpec *double_region_vals = g_param_spec_double ("double-region-values",
+                                                          "Double Region values",
+                                                          "Elements in double regions",
+                                                          -INFINITY,
+                                                          INFINITY,
+                                                          0.0,
+                                                          G_PARAM_READWRITE);
+
+    properties[PROP_NUM_PROJECTIONS] =
+        g_param_spec_uint ("num-projections",
+            "Number of projections",
+            "Number of projections",
+            0, 16384, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_OVERALL_ANGLE] =
+        g_param_spec_double ("overall-angle",
+            "Angle covered by all projections [rad]",
+            "Angle covered by all projections [rad] (can be negative for negative steps "
+            "in case only num-projections is specified",
+            -G_MAXDOUBLE, G_MAXDOUBLE, 2 * G_PI,
+            G_PARAM_READWRITE);
+
+    properties[PROP_DETECTOR_WIDTH] =
+        g_param_spec_uint ("detector-width",
+            "Detector width in pixels, 0 for the volume width",
+            "Detector width in pixels, 0 for the volume width",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_DETECTOR_HEIGHT] =
+        g_param_spec_uint ("detector-height",
+            "Detector height in pixels, 0 for the number of slices",
+            "Detector height in pixels, 0 for the number of slices",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_CENTER_POSITION_X] =
+        g_param_spec_value_array ("center-position-x",
+            "Global x center (horizontal in a projection) of the volume with respect to projections",
+            "Global x center (horizontal in a projection) of the volume with respect to projections",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_CENTER_POSITION_Z] =
+        g_param_spec_value_array ("center-position-z",
+            "Global z center (vertical in a projection) of the volume with respect to projections",
+            "Global z center (vertical in a projection) of the volume with respect to projections",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_SOURCE_POSITION_X] =
+        g_param_spec_value_array ("source-position-x",
+            "X source position (horizontal) in global coordinates [pixels]",
+            "X source position (horizontal) in global coordinates [pixels]",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_SOURCE_POSITION_Y] =
+        g_param_spec_value_array ("source-position-y",
+            "Y source position (beam direction) in global coordinates [pixels]",
+            "Y source position (beam direction) in global coordinates [pixels]",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_SOURCE_POSITION_Z] =
+        g_param_spec_value_array ("source-position-z",
+            "Z source position (vertical) in global coordinates [pixels]",
+            "Z source position (vertical) in global coordinates [pixels]",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_DETECTOR_POSITION_X] =
+        g_param_spec_value_array ("detector-position-x",
+            "X detector position (horizontal) in global coordinates [pixels]",
+            "X detector position (horizontal) in global coordinates [pixels]",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_DETECTOR_POSITION_Y] =
+        g_param_spec_value_array ("detector-position-y",
+            "Y detector position (along beam direction) in global coordinates [pixels]",
+            "Y detector position (along beam direction) in global coordinates [pixels]",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_DETECTOR_POSITION_Z] =
+        g_param_spec_value_array ("detector-position-z",
+            "Z detector position (vertical) in global coordinates [pixels]",
+            "Z detector position (vertical) in global coordinates [pixels]",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_DETECTOR_ANGLE_X] =
+        g_param_spec_value_array("detector-angle-x",
+            "Detector rotation around the x axis [rad] (horizontal)",
+            "Detector rotation around the x axis [rad] (horizontal)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_DETECTOR_ANGLE_Y] =
+        g_param_spec_value_array("detector-angle-y",
+            "Detector rotation around the y axis [rad] (along beam direction)",
+            "Detector rotation around the y axis [rad] (balong eam direction)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_DETECTOR_ANGLE_Z] =
+        g_param_spec_value_array("detector-angle-z",
+            "Detector rotation around the z axis [rad] (vertical)",
+            "Detector rotation around the z axis [rad] (vertical)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_AXIS_ANGLE_X] =
+        g_param_spec_value_array("axis-angle-x",
+            "Rotation axis rotation around the x axis [rad] (laminographic angle, 0 = tomography)",
+            "Rotation axis rotation around the x axis [rad] (laminographic angle, 0 = tomography)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_AXIS_ANGLE_Y] =
+        g_param_spec_value_array("axis-angle-y",
+            "Rotation axis rotation around the y axis [rad] (along beam direction)",
+            "Rotation axis rotation around the y axis [rad] (along beam direction)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_AXIS_ANGLE_Z] =
+        g_param_spec_value_array("axis-angle-z",
+            "Rotation axis rotation around the z axis [rad] (vertical)",
+            "Rotation axis rotation around the z axis [rad] (vertical)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_VOLUME_ANGLE_X] =
+        g_param_spec_value_array("volume-angle-x",
+            "Volume rotation around the x axis [rad] (horizontal)",
+            "Volume rotation around the x axis [rad] (horizontal)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_VOLUME_ANGLE_Y] =
+        g_param_spec_value_array("volume-angle-y",
+            "Volume rotation around the y axis [rad] (along beam direction)",
+            "Volume rotation around the y axis [rad] (along beam direction)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    properties[PROP_VOLUME_ANGLE_Z] =
+        g_param_spec_value_array("volume-angle-z",
+            "Volume rotation around the z axis [rad] (vertical)",
+            "Volume rotation around the z axis [rad] (vertical)",
+            double_region_vals,
+            G_PARAM_READWRITE);
+
+    for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
+        g_object_class_install_property (oclass, i, properties[i]);
+
+    g_type_class_add_private (klass, sizeof (UfoGeneralForwardprojectTaskPrivate));
+}
+
+static void
+ufo_general_forwardproject_task_init (UfoGeneralForwardprojectTask *self)
+{
+    UfoGeneralForwardprojectTaskPrivate *priv;
+    self->priv = priv = UFO_GENERAL_FORWARDPROJECT_TASK_GET_PRIVATE (self);
+    priv->context = NULL;
+    priv->kernel = NULL;
+    priv->rays = NULL;
+    priv->geometry = ufo_ctgeometry_new ();
+    priv->volume_dims[0] = priv->volume_dims[1] = priv->volume_dims[2] = 0;
+    priv->geometry_changed = TRUE;
+    priv->num_projections = 0;
+    priv->overall_angle = 2 * G_PI;
+    priv->detector_width = 0;
+    priv->detector_height = 0;
+}
@@ -0,0 +1,623 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <math.h>
+#include "ufo-hierarchical-backproject-task.h"
+
+/*
+ * One level of the quadtree. Level 0 is the input sinogram which belongs to
+ * the whole (padded) slice, every further level splits the sub-images of the
+ * previous one into quadrants and merges @decimation adjacent angles.
+ */
+typedef struct {
+    guint num_angles;
+    guint width;
+    guint grid;
+    gfloat size;
+    gfloat shift;
+    gfloat sampling;
+    gfloat center;
+    guint decimation;
+    cl_mem angles;
+} Level;
+
+struct _UfoHierarchicalBackprojectTaskPrivate {
+    UfoResources *resources;
+    cl_context context;
+    cl_kernel decompose_kernel;
+    cl_kernel backproject_kernel;
+    cl_mem sinograms[2];
+    Level *levels;
+    guint num_levels;
+    gsize input_dims[2];
+    gboolean levels_changed;
+    gfloat real_axis_pos;
+    gdouble axis_pos;
+    gdouble angle_step;
+    gdouble angle_offset;
+    guint n_projections;
+    guint leaf_size;
+    guint undecimated_levels;
+    guint oversampling;
+};
+
+static void ufo_task_interface_init (UfoTaskIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (UfoHierarchicalBackprojectTask, ufo_hierarchical_backproject_task, UFO_TYPE_TASK_NODE,
+                         G_IMPLEMENT_INTERFACE (UFO_TYPE_TASK,
+                                                ufo_task_interface_init))
+
+#define UFO_HIERARCHICAL_BACKPROJECT_TASK_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), UFO_TYPE_HIERARCHICAL_BACKPROJECT_TASK, UfoHierarchicalBackprojectTaskPrivate))
+
+enum {
+    PROP_0,
+    PROP_NUM_PROJECTIONS,
+    PROP_AXIS_POSITION,
+    PROP_ANGLE_STEP,
+    PROP_ANGLE_OFFSET,
+    PROP_LEAF_SIZE,
+    PROP_UNDECIMATED_LEVELS,
+    PROP_OVERSAMPLING,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+UfoNode *
+ufo_hierarchical_backproject_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_HIERARCHICAL_BACKPROJECT_TASK, NULL));
+}
+
+static void
+release_levels (UfoHierarchicalBackprojectTaskPrivate *priv)
+{
+    for (guint i = 0; i < priv->num_levels; i++) {
+        if (priv->levels[i].angles) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->levels[i].angles));
+        }
+    }
+
+    for (guint i = 0; i < 2; i++) {
+        if (priv->sinograms[i]) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->sinograms[i]));
+            priv->sinograms[i] = NULL;
+        }
+    }
+
+    g_free (priv->levels);
+    priv->levels = NULL;
+    priv->num_levels = 0;
+}
+
+static cl_mem
+create_angles (UfoHierarchicalBackprojectTaskPrivate *priv, const gdouble *sums, const guint *counts, guint n)
+{
+    cl_float *host_mem;
+    cl_mem mem;
+    cl_int errcode;
+    gdouble angle;
+
+    host_mem = g_new (cl_float, 2 * n);
+
+    /* Merged angles are represented by their mean */
+    for (guint i = 0; i < n; i++) {
+        angle = sums[i] / counts[i];
+        host_mem[2 * i] = (cl_float) cos (angle);
+        host_mem[2 * i + 1] = (cl_float) sin (angle);
+    }
+
+    mem = clCreateBuffer (priv->context,
+                          CL_MEM_COPY_HOST_PTR | CL_MEM_READ_ONLY,
+                          2 * n * sizeof (cl_float), host_mem,
+                          &errcode);
+    UFO_RESOURCES_CHECK_CLERR (errcode);
+    g_free (host_mem);
+
+    return mem;
+}
+
+static gboolean
+setup_levels (UfoHierarchicalBackprojectTaskPrivate *priv, UfoGpuNode *node,
+              guint width, guint height, GError **error)
+{
+    Level *level, *parent;
+    GValue *max_mem_alloc_size_gvalue;
+    gdouble *sums;
+    guint *counts;
+    guint padded_size, num_levels = 1;
+    gsize size, max_size = 0;
+    gulong max_mem_alloc_size;
+    gdouble angle_step;
+    cl_int errcode;
+
+    release_levels (priv);
+
+    /* Pad the slice to leaf-size times a power of two */
+    for (padded_size = priv->leaf_size; padded_size < width; padded_size *= 2) {
+        num_levels++;
+    }
+
+    priv->levels = g_new0 (Level, num_levels);
+    priv->num_levels = num_levels;
+    priv->real_axis_pos = priv->axis_pos <= 0.0 ? width / 2.0f : (gfloat) priv->axis_pos;
+    angle_step = priv->angle_step <= 0.0 ? G_PI / priv->n_projections : priv->angle_step;
+
+    sums = g_new (gdouble, height);
+    counts = g_new (guint, height);
+
+    for (guint i = 0; i < height; i++) {
+        sums[i] = priv->angle_offset + i * angle_step;
+        counts[i] = 1;
+    }
+
+    /* The input sinogram is centered at the rotation axis */
+    level = &priv->levels[0];
+    level->num_angles = height;
+    level->width = width;
+    level->grid = 1;
+    level->size = padded_size;
+    level->shift = padded_size / 2.0f;
+    level->sampling = 1.0f;
+    level->center = priv->real_axis_pos - 0.5f;
+    level->decimation = 1;
+    level->angles = create_angles (priv, sums, counts, height);
+
+    for (guint l = 1; l < num_levels; l++) {
+        parent = &priv->levels[l - 1];
+        level = &priv->levels[l];
+        level->decimation = l <= priv->undecimated_levels ? 1 : 2;
+        level->num_angles = (parent->num_angles + level->decimation - 1) / level->decimation;
+
+        /* In-place is fine because an angle never moves to a higher index */
+        for (guint i = 0; i < level->num_angles; i++) {
+            guint first = i * level->decimation;
+            guint last = MIN (first + level->decimation, parent->num_angles);
+            gdouble sum = 0.0;
+            guint count = 0;
+
+            for (guint j = first; j < last; j++) {
+                sum += sums[j];
+                count += counts[j];
+            }
+
+            sums[i] = sum;
+            counts[i] = count;
+        }
+
+        level->grid = 1 << l;
+        level->size = (gfloat) padded_size / level->grid;
+        level->shift = priv->real_axis_pos;
+        level->sampling = priv->oversampling;
+        /* Cover the diagonal of the sub-image plus interpolation margin */
+        level->width = (guint) ceil (level->size * G_SQRT2 * level->sampling) + 4;
+        level->center = (level->width - 1) / 2.0f;
+        level->angles = create_angles (priv, sums, counts, level->num_angles);
+
+        size = (gsize) level->grid * level->grid * level->num_angles * level->width;
+        max_size = MAX (max_size, size);
+    }
+
+    g_debug ("hierarchical-backproject: %u levels, padded size %u, %u angles on the finest level",
+             num_levels, padded_size, priv->levels[num_levels - 1].num_angles);
+
+    g_free (sums);
+    g_free (counts);
+
+    max_mem_alloc_size_gvalue = ufo_gpu_node_get_info (node, UFO_GPU_NODE_INFO_MAX_MEM_ALLOC_SIZE);
+    max_mem_alloc_size = g_value_get_ulong (max_mem_alloc_size_gvalue);
+    g_value_unset (max_mem_alloc_size_gvalue);
+
+    if (max_size * sizeof (gfloat) > max_mem_alloc_size) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                     "Intermediate sinograms need %zu bytes but the device allocates at most %lu bytes, "
+                     "increase leaf-size or decrease oversampling",
+                     max_size * sizeof (gfloat), max_mem_alloc_size);
+        release_levels (priv);
+        return FALSE;
+    }
+
+    /* Levels alternate between two buffers */
+    for (guint i = 0; i < 2 && max_size; i++) {
+        priv->sinograms[i] = clCreateBuffer (priv->context, CL_MEM_READ_WRITE,
+                                             max_size * sizeof (gfloat), NULL, &errcode);
+
+        if (errcode != CL_SUCCESS) {
+            UFO_RESOURCES_CHECK_AND_SET (errcode, error);
+            release_levels (priv);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static void
+set_level_args (cl_kernel kernel, guint index, const Level *level)
+{
+    cl_int num_angles = level->num_angles;
+    cl_int width = level->width;
+    cl_int grid = level->grid;
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, index++, sizeof (cl_int), &num_angles));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, index++, sizeof (cl_int), &width));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, index++, sizeof (cl_int), &grid));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, index++, sizeof (cl_float), &level->size));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, index++, sizeof (cl_float), &level->shift));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, index++, sizeof (cl_float), &level->sampling));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, index++, sizeof (cl_float), &level->center));
+}
+
+static gboolean
+ufo_hierarchical_backproject_task_process (UfoTask *task,
+                                           UfoBuffer **inputs,
+                                           UfoBuffer *output,
+                                           UfoRequisition *requisition)
+{
+    UfoHierarchicalBackprojectTaskPrivate *priv;
+    UfoGpuNode *node;
+    UfoProfiler *profiler;
+    cl_command_queue cmd_queue;
+    cl_mem parent_mem, child_mem, out_mem;
+    cl_int grid, decimation;
+    Level *parent, *level;
+    gsize global_work_size[3];
+    gfloat norm;
+
+    priv = UFO_HIERARCHICAL_BACKPROJECT_TASK_GET_PRIVATE (task);
+    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
+    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
+    profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
+    parent_mem = ufo_buffer_get_device_array (inputs[0], cmd_queue);
+    out_mem = ufo_buffer_get_device_array (output, cmd_queue);
+
+    for (guint l = 1; l < priv->num_levels; l++) {
+        parent = &priv->levels[l - 1];
+        level = &priv->levels[l];
+        child_mem = priv->sinograms[l % 2];
+        grid = level->grid;
+        decimation = level->decimation;
+
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 0, sizeof (cl_mem), &parent_mem));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 1, sizeof (cl_mem), &child_mem));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 2, sizeof (cl_mem), &parent->angles));
+        set_level_args (priv->decompose_kernel, 3, parent);
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 10, sizeof (cl_int), &grid));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 11, sizeof (cl_float), &level->size));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 12, sizeof (cl_float), &level->shift));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 13, sizeof (cl_float), &level->sampling));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 14, sizeof (cl_float), &level->center));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->decompose_kernel, 15, sizeof (cl_int), &decimation));
+
+        global_work_size[0] = level->width;
+        global_work_size[1] = level->num_angles;
+        global_work_size[2] = level->grid * level->grid;
+        ufo_profiler_call (profiler, cmd_queue, priv->decompose_kernel, 3, global_work_size, NULL);
+        parent_mem = child_mem;
+    }
+
+    level = &priv->levels[priv->num_levels - 1];
+    norm = (gfloat) (G_PI / priv->n_projections);
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->backproject_kernel, 0, sizeof (cl_mem), &parent_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->backproject_kernel, 1, sizeof (cl_mem), &out_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->backproject_kernel, 2, sizeof (cl_mem), &level->angles));
+    set_level_args (priv->backproject_kernel, 3, level);
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->backproject_kernel, 10, sizeof (cl_float), &priv->real_axis_pos));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->backproject_kernel, 11, sizeof (cl_float), &norm));
+    ufo_profiler_call (profiler, cmd_queue, priv->backproject_kernel, 2, requisition->dims, NULL);
+
+    return TRUE;
+}
+
+static void
+ufo_hierarchical_backproject_task_setup (UfoTask *task,
+                                         UfoResources *resources,
+                                         GError **error)
+{
+    UfoHierarchicalBackprojectTaskPrivate *priv;
+
+    priv = UFO_HIERARCHICAL_BACKPROJECT_TASK_GET_PRIVATE (task);
+
+    priv->resources = g_object_ref (resources);
+    priv->context = ufo_resources_get_context (resources);
+    priv->decompose_kernel = ufo_resources_get_kernel (resources, "hierarchical-backproject.cl",
+                                                       "hierarchical_decompose", NULL, error);
+    priv->backproject_kernel = ufo_resources_get_kernel (resources, "hierarchical-backproject.cl",
+                                                         "hierarchical_backproject", NULL, error);
+
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainContext (priv->context), error);
+
+    if (priv->decompose_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->decompose_kernel), error);
+
+    if (priv->backproject_kernel != NULL)
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->backproject_kernel), error);
+}
+
+static void
+ufo_hierarchical_backproject_task_get_requisition (UfoTask *task,
+                                                   UfoBuffer **inputs,
+                                                   UfoRequisition *requisition,
+                                                   GError **error)
+{
+    UfoHierarchicalBackprojectTaskPrivate *priv;
+    UfoGpuNode *node;
+    UfoRequisition in_req;
+
+    priv = UFO_HIERARCHICAL_BACKPROJECT_TASK_GET_PRIVATE (task);
+    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
+    ufo_buffer_get_requisition (inputs[0], &in_req);
+
+    /* If the number of projections is not specified use the input size */
+    if (priv->n_projections == 0) {
+        priv->n_projections = (guint) in_req.dims[1];
+    }
+
+    if (in_req.dims[1] > priv->n_projections) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                     "Total number of projections (%u) must be greater than "
+                     "or equal to sinogram height (%zu)",
+                     priv->n_projections, in_req.dims[1]);
+        return;
+    }
+
+    requisition->n_dims = 2;
+    requisition->dims[0] = in_req.dims[0];
+    requisition->dims[1] = in_req.dims[0];
+
+    if (priv->levels_changed || in_req.dims[0] != priv->input_dims[0] || in_req.dims[1] != priv->input_dims[1]) {
+        if (!setup_levels (priv, node, (guint) in_req.dims[0], (guint) in_req.dims[1], error))
+            return;
+
+        priv->input_dims[0] = in_req.dims[0];
+        priv->input_dims[1] = in_req.dims[1];
+        priv->levels_changed = FALSE;
+    }
+}
+
+static guint
+ufo_hierarchical_backproject_task_get_num_inputs (UfoTask *task)
+{
+    return 1;
+}
+
+static guint
+ufo_hierarchical_backproject_task_get_num_dimensions (UfoTask *task,
+                                                      guint input)
+{
+    g_return_val_if_fail (input == 0, 0);
+    return 2;
+}
+
+static UfoTaskMode
+ufo_hierarchical_backproject_task_get_mode (UfoTask *task)
+{
+    return UFO_TASK_MODE_PROCESSOR | UFO_TASK_MODE_GPU;
+}
+
+static void
+ufo_hierarchical_backproject_task_finalize (GObject *object)
+{
+    UfoHierarchicalBackprojectTaskPrivate *priv;
+
+    priv = UFO_HIERARCHICAL_BACKPROJECT_TASK_GET_PRIVATE (object);
+
+    release_levels (priv);
+
+    if (priv->decompose_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->decompose_kernel));
+        priv->decompose_kernel = NULL;
+    }
+
+    if (priv->backproject_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->backproject_kernel));
+        priv->backproject_kernel = NULL;
+    }
+
+    if (priv->context) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
+        priv->context = NULL;
+    }
+
+    if (priv->resources) {
+        g_object_unref (priv->resources);
+        priv->resources = NULL;
+    }
+
+    G_OBJECT_CLASS (ufo_hierarchical_backproject_task_parent_class)->finalize (object);
+}
+
+static void
+ufo_task_interface_init (UfoTaskIface *iface)
+{
+    iface->setup = ufo_hierarchical_backproject_task_setup;
+    iface->get_requisition = ufo_hierarchical_backproject_task_get_requisition;
+    iface->get_num_inputs = ufo_hierarchical_backproject_task_get_num_inputs;
+    iface->get_num_dimensions = ufo_hierarchical_backproject_task_get_num_dimensions;
+    iface->get_mode = ufo_hierarchical_backproject_task_get_mode;
+    iface->process = ufo_hierarchical_backproject_task_process;
+}
+
+static void
+ufo_hierarchical_backproject_task_set_property (GObject *object,
+                                                guint property_id,
+                                                const GValue *value,
+                                                GParamSpec *pspec)
+{
+    UfoHierarchicalBackprojectTaskPrivate *priv = UFO_HIERARCHICAL_BACKPROJECT_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_NUM_PROJECTIONS:
+            priv->n_projections = g_value_get_uint (value);
+            break;
+        case PROP_AXIS_POSITION:
+            priv->axis_pos = g_value_get_double (value);
+            break;
+        case PROP_ANGLE_STEP:
+            priv->angle_step = g_value_get_double (value);
+            break;
+        case PROP_ANGLE_OFFSET:
+            priv->angle_offset = g_value_get_double (value);
+            break;
+        case PROP_LEAF_SIZE:
+            priv->leaf_size = g_value_get_uint (value);
+            break;
+        case PROP_UNDECIMATED_LEVELS:
+            priv->undecimated_levels = g_value_get_uint (value);
+            break;
+        case PROP_OVERSAMPLING:
+            priv->oversampling = g_value_get_uint (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            return;
+    }
+
+    priv->levels_changed = TRUE;
+}
+
+static void
+ufo_hierarchical_backproject_task_get_property (GObject *object,
+                                                guint property_id,
+                                                GValue *value,
+                                                GParamSpec *pspec)
+{
+    UfoHierarchicalBackprojectTaskPrivate *priv = UFO_HIERARCHICAL_BACKPROJECT_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_NUM_PROJECTIONS:
+            g_value_set_uint (value, priv->n_projections);
+            break;
+        case PROP_AXIS_POSITION:
+            g_value_set_double (value, priv->axis_pos);
+            break;
+        case PROP_ANGLE_STEP:
+            g_value_set_double (value, priv->angle_step);
+            break;
+        case PROP_ANGLE_OFFSET:
+            g_value_set_double (value, priv->angle_offset);
+            break;
+        case PROP_LEAF_SIZE:
+            g_value_set_uint (value, priv->leaf_size);
+            break;
+        case PROP_UNDECIMATED_LEVELS:
+            g_value_set_uint (value, priv->undecimated_levels);
+            break;
+        case PROP_OVERSAMPLING:
+            g_value_set_uint (value, priv->oversampling);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_hierarchical_backproject_task_class_init (UfoHierarchicalBackprojectTaskClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+    oclass->finalize = ufo_hierarchical_backproject_task_finalize;
+    oclass->set_property = ufo_hierarchical_backproject_task_set_property;
+    oclass->get_property = ufo_hierarchical_backproject_task_get_property;
+
+    properties[PROP_NUM_PROJECTIONS] =
+        g_param_spec_uint ("num-projections",
+            "Number of projections between 0 and 180 degrees",
+            "Number of projections between 0 and 180 degrees",
+            0, +8192, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_AXIS_POSITION] =
+        g_param_spec_double ("axis-pos",
+            "Position of rotation axis",
+            "Position of rotation axis",
+            -1.0, +8192.0, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_ANGLE_STEP] =
+        g_param_spec_double ("angle-step",
+            "Increment of angle in radians",
+            "Increment of angle in radians",
+            -G_MAXDOUBLE, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_ANGLE_OFFSET] =
+        g_param_spec_double ("angle-offset",
+            "Angle offset in radians",
+            "Angle offset in radians determining the first angle position",
+            0.0, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_LEAF_SIZE] =
+        g_param_spec_uint ("leaf-size",
+            "Side length of the sub-images which are backprojected directly",
+            "Side length of the sub-images which are backprojected directly",
+            1, 1024, 8,
+            G_PARAM_READWRITE);
+
+    properties[PROP_UNDECIMATED_LEVELS] =
+        g_param_spec_uint ("undecimated-levels",
+            "Number of coarsest subdivisions which keep all angles",
+            "Number of coarsest subdivisions which keep all angles, higher is more accurate but slower",
+            0, 32, 1,
+            G_PARAM_READWRITE);
+
+    properties[PROP_OVERSAMPLING] =
+        g_param_spec_uint ("oversampling",
+            "Detector oversampling of the intermediate sinograms",
+            "Detector oversampling of the intermediate sinograms, higher is more accurate but slower",
+            1, 16, 2,
+            G_PARAM_READWRITE);
+
+    for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
+        g_object_class_install_property (oclass, i, properties[i]);
+
+    g_type_class_add_private (klass, sizeof (UfoHierarchicalBackprojectTaskPrivate));
+}
+
+static void
+ufo_hierarchical_backproject_task_init (UfoHierarchicalBackprojectTask *self)
+{
+    UfoHierarchicalBackprojectTaskPrivate *priv;
+    self->priv = priv = UFO_HIERARCHICAL_BACKPROJECT_TASK_GET_PRIVATE (self);
+    priv->resources = NULL;
+    priv->context = NULL;
+    priv->decompose_kernel = NULL;
+    priv->backproject_kernel = NULL;
+    priv->sinograms[0] = priv->sinograms[1] = NULL;
+    priv->levels = NULL;
+    priv->num_levels = 0;
+    priv->input_dims[0] = priv->input_dims[1] = 0;
+    priv->levels_changed = TRUE;
+    priv->real_axis_pos = 0.0f;
+    priv->n_projections = 0;
+    priv->axis_pos = -1.0;
+    priv->angle_step = -1.0;
+    priv->angle_offset = 0.0;
+    priv->leaf_size = 8;
+    priv->undecimated_levels = 1;
+    priv->oversampling = 2;
+}
@@ -33,9 +33,12 @@ struct _UfoIfftTaskPrivate {
 
     cl_context context;
     cl_kernel kernel;
+    cl_mem real;
+    gsize real_size;
 
     gint crop_width;
     gint crop_height;
+    gboolean hermitian;
 };
 
 static void ufo_task_interface_init (UfoTaskIface *iface);
@@ -51,6 +54,7 @@ enum {
     PROP_DIMENSIONS,
     PROP_CROP_WIDTH,
     PROP_CROP_HEIGHT,
+    PROP_HERMITIAN,
     N_PROPERTIES
 };
 
@@ -70,7 +74,9 @@ ufo_ifft_task_setup (UfoTask *task,
     UfoIfftTaskPrivate *priv;
 
     priv = UFO_IFFT_TASK_GET_PRIVATE (task);
-    priv->kernel = ufo_resources_get_kernel (resources, "fft.cl", "fft_pack", NULL, error);
+    priv->kernel = ufo_resources_get_kernel (resources, "fft.cl",
+                                             priv->hermitian ? "fft_pack_real" : "fft_pack",
+                                             NULL, error);
     priv->context = ufo_resources_get_context (resources);
 
     UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainContext (priv->context), error);
@@ -88,6 +94,8 @@ ufo_ifft_task_get_requisition (UfoTask *task,
     UfoIfftTaskPrivate *priv;
     UfoRequisition in_req;
     cl_command_queue queue;
+    gsize real_size;
+    cl_int cl_error;
 
     if (ufo_buffer_get_layout (inputs[0]) != UFO_BUFFER_LAYOUT_COMPLEX_INTERLEAVED) {
         g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
@@ -99,7 +107,10 @@ ufo_ifft_task_get_requisition (UfoTask *task,
     ufo_buffer_get_requisition (inputs[0], &in_req);
 
     priv->param.zeropad = FALSE;
-    priv->param.size[0] = in_req.dims[0] / 2;
+    priv->param.type = priv->hermitian ? UFO_FFT_COMPLEX_TO_REAL : UFO_FFT_COMPLEX_TO_COMPLEX;
+
+    /* A half spectrum of n / 2 + 1 values stems from an even real size n */
+    priv->param.size[0] = priv->hermitian ? 2 * (in_req.dims[0] / 2 - 1) : in_req.dims[0] / 2;
 
     switch (priv->param.dimensions) {
         case UFO_FFT_1D:
@@ -121,6 +132,26 @@ ufo_ifft_task_get_requisition (UfoTask *task,
     *requisition = in_req;  /* keep third dimension for 2-D batching */
     requisition->dims[0] = priv->crop_width > 0 ? (gsize) priv->crop_width : priv->param.size[0];
     requisition->dims[1] = priv->crop_height > 0 ? (gsize) priv->crop_height : in_req.dims[1];
+
+    /* The real result needs a separate buffer only if it is cropped */
+    real_size = 0;
+
+    if (priv->hermitian && (requisition->dims[0] != priv->param.size[0] || requisition->dims[1] != in_req.dims[1]))
+        real_size = priv->param.size[0] * in_req.dims[1] * (in_req.n_dims == 3 ? in_req.dims[2] : 1);
+
+    if (real_size != priv->real_size) {
+        if (priv->real) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->real));
+            priv->real = NULL;
+        }
+
+        if (real_size) {
+            priv->real = clCreateBuffer (priv->context, CL_MEM_READ_WRITE, real_size * sizeof (gfloat), NULL, &cl_error);
+            UFO_RESOURCES_CHECK_SET_AND_RETURN (cl_error, error);
+        }
+
+        priv->real_size = real_size;
+    }
 }
 
 static guint
@@ -162,6 +193,7 @@ ufo_ifft_task_process (UfoTask *task,
     UfoRequisition in_req;
     cl_mem in_mem;
     cl_mem out_mem;
+    cl_mem real_mem;
     cl_int width;
     cl_int height;
     cl_command_queue queue;
@@ -177,10 +209,6 @@ ufo_ifft_task_process (UfoTask *task,
     if (ufo_buffer_get_layout (inputs[0]) != UFO_BUFFER_LAYOUT_COMPLEX_INTERLEAVED)
         g_warning ("ifft: input is not complex");
 
-    /* In-place IFFT */
-    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->fft, queue, profiler, in_mem, in_mem, UFO_FFT_BACKWARD,
-                                                0, NULL, NULL));
-
     /* Scale and reshape if necessary */
     scale = 1.0f / ((gfloat) priv->param.size[0]);
 
@@ -188,12 +216,41 @@ ufo_ifft_task_process (UfoTask *task,
         scale /= (gfloat) priv->param.size[1];
     }
 
-    width = (cl_int) requisition->dims[0];
-    height = (cl_int) requisition->dims[1];
-
     ufo_buffer_get_requisition (inputs[0], &in_req);
     ufo_buffer_set_layout (output, UFO_BUFFER_LAYOUT_REAL);
 
+    if (priv->hermitian) {
+        /* Out-of-place IFFT into the output unless it needs to be cropped */
+        real_mem = priv->real != NULL ? priv->real : out_mem;
+        UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->fft, queue, profiler, in_mem, real_mem, UFO_FFT_BACKWARD,
+                                                    0, NULL, NULL));
+
+        width = (cl_int) priv->param.size[0];
+        height = (cl_int) in_req.dims[1];
+
+        global_work_size[0] = requisition->dims[0];
+        global_work_size[1] = requisition->dims[1];
+        global_work_size[2] = requisition->n_dims == 3 ? in_req.dims[2] : 1;
+
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 0, sizeof (cl_mem), (gpointer) &real_mem));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 1, sizeof (cl_mem), (gpointer) &out_mem));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 2, sizeof (cl_int), &width));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 3, sizeof (cl_int), &height));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->kernel, 4, sizeof (gfloat), &scale));
+
+        UFO_RESOURCES_CHECK_CLERR (clEnqueueNDRangeKernel (queue, priv->kernel,
+                                                           3, NULL, global_work_size, NULL,
+                                                           0, NULL, NULL));
+        return TRUE;
+    }
+
+    /* In-place IFFT */
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->fft, queue, profiler, in_mem, in_mem, UFO_FFT_BACKWARD,
+                                                0, NULL, NULL));
+
+    width = (cl_int) requisition->dims[0];
+    height = (cl_int) requisition->dims[1];
+
     global_work_size[0] = in_req.dims[0] >> 1;
     global_work_size[1] = in_req.dims[1];
     global_work_size[2] = requisition->n_dims == 3 ? in_req.dims[2] : 1;
@@ -222,6 +279,11 @@ ufo_ifft_task_finalize (GObject *object)
         priv->kernel = NULL;
     }
 
+    if (priv->real) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->real));
+        priv->real = NULL;
+    }
+
     if (priv->context) {
         UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
         priv->context = NULL;
@@ -264,6 +326,9 @@ ufo_ifft_task_set_property (GObject *object,
         case PROP_CROP_HEIGHT:
             priv->crop_height = g_value_get_int (value);
             break;
+        case PROP_HERMITIAN:
+            priv->hermitian = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -288,6 +353,9 @@ ufo_ifft_task_get_property (GObject *object,
         case PROP_CROP_HEIGHT:
             g_value_set_int (value, priv->crop_height);
             break;
+        case PROP_HERMITIAN:
+            g_value_set_boolean (value, priv->hermitian);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -328,6 +396,13 @@ ufo_ifft_task_class_init (UfoIfftTaskClass *klass)
             -1, G_MAXINT, -1,
             G_PARAM_READWRITE);
 
+    properties[PROP_HERMITIAN] =
+        g_param_spec_boolean ("hermitian",
+            "Input is the non-redundant half spectrum of real data",
+            "Input is the non-redundant half spectrum of real data",
+            FALSE,
+            G_PARAM_READWRITE);
+
     for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (oclass, i, properties[i]);
 
@@ -343,7 +418,10 @@ ufo_ifft_task_init (UfoIfftTask *self)
     self->priv = priv = UFO_IFFT_TASK_GET_PRIVATE (self);
     priv->crop_width = -1;
     priv->crop_height = -1;
+    priv->hermitian = FALSE;
     priv->kernel = NULL;
+    priv->real = NULL;
+    priv->real_size = 0;
     priv->context = NULL;
     priv->fft = ufo_fft_new ();
     priv->param.dimensions = UFO_FFT_1D;
@@ -0,0 +1,679 @@
+/*
+ * Copyright (C) 2011-2013 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <math.h>
+#include "ufo-iterative-reconstruction-task.h"
+
+/* Work groups of the dot product, the partial sums are added on the host */
+#define DOT_NUM_GROUPS 64
+#define DOT_LOCAL_SIZE 128
+
+typedef enum {
+    METHOD_SIRT,
+    METHOD_SART,
+    METHOD_CGLS
+} Method;
+
+static GEnumValue method_values[] = {
+    { METHOD_SIRT, "METHOD_SIRT", "sirt" },
+    { METHOD_SART, "METHOD_SART", "sart" },
+    { METHOD_CGLS, "METHOD_CGLS", "cgls" },
+    { 0, NULL, NULL}
+};
+
+struct _UfoIterativeReconstructionTaskPrivate {
+    UfoResources *resources;
+    cl_context context;
+    cl_kernel project_kernel;
+    cl_kernel backproject_kernel;
+    cl_kernel update_kernel;
+    cl_kernel axpy_kernel;
+    cl_kernel xpay_kernel;
+    cl_kernel dot_kernel;
+    cl_mem angles;
+    cl_mem sinograms[2];
+    cl_mem images[2];
+    cl_mem partials;
+    gsize input_dims[2];
+    gboolean geometry_changed;
+    gfloat real_axis_pos;
+    gdouble axis_pos;
+    gdouble angle_step;
+    gdouble angle_offset;
+    Method method;
+    guint num_iterations;
+    guint num_subsets;
+    gdouble relaxation;
+    gboolean positivity;
+};
+
+static void ufo_task_interface_init (UfoTaskIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (UfoIterativeReconstructionTask, ufo_iterative_reconstruction_task, UFO_TYPE_TASK_NODE,
+                         G_IMPLEMENT_INTERFACE (UFO_TYPE_TASK,
+                                                ufo_task_interface_init))
+
+#define UFO_ITERATIVE_RECONSTRUCTION_TASK_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), UFO_TYPE_ITERATIVE_RECONSTRUCTION_TASK, UfoIterativeReconstructionTaskPrivate))
+
+enum {
+    PROP_0,
+    PROP_AXIS_POSITION,
+    PROP_ANGLE_STEP,
+    PROP_ANGLE_OFFSET,
+    PROP_METHOD,
+    PROP_NUM_ITERATIONS,
+    PROP_NUM_SUBSETS,
+    PROP_RELAXATION,
+    PROP_POSITIVITY,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+UfoNode *
+ufo_iterative_reconstruction_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_ITERATIVE_RECONSTRUCTION_TASK, NULL));
+}
+
+static void
+release_mem (cl_mem *mem)
+{
+    if (*mem) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (*mem));
+        *mem = NULL;
+    }
+}
+
+static void
+release_buffers (UfoIterativeReconstructionTaskPrivate *priv)
+{
+    release_mem (&priv->angles);
+    release_mem (&priv->partials);
+
+    for (guint i = 0; i < 2; i++) {
+        release_mem (&priv->sinograms[i]);
+        release_mem (&priv->images[i]);
+    }
+}
+
+static cl_mem
+create_buffer (UfoIterativeReconstructionTaskPrivate *priv, gsize size)
+{
+    cl_mem mem;
+    cl_int errcode;
+
+    mem = clCreateBuffer (priv->context, CL_MEM_READ_WRITE, size, NULL, &errcode);
+    UFO_RESOURCES_CHECK_CLERR (errcode);
+
+    return mem;
+}
+
+static void
+setup_geometry (UfoIterativeReconstructionTaskPrivate *priv, guint width, guint height)
+{
+    cl_float *host_mem;
+    cl_int errcode;
+    gdouble angle_step, angle;
+
+    release_buffers (priv);
+
+    priv->real_axis_pos = priv->axis_pos <= 0.0 ? width / 2.0f : (gfloat) priv->axis_pos;
+    angle_step = priv->angle_step <= 0.0 ? G_PI / height : priv->angle_step;
+    host_mem = g_new (cl_float, 2 * height);
+
+    for (guint i = 0; i < height; i++) {
+        angle = priv->angle_offset + i * angle_step;
+        host_mem[2 * i] = (cl_float) cos (angle);
+        host_mem[2 * i + 1] = (cl_float) sin (angle);
+    }
+
+    priv->angles = clCreateBuffer (priv->context,
+                                   CL_MEM_COPY_HOST_PTR | CL_MEM_READ_ONLY,
+                                   2 * height * sizeof (cl_float), host_mem,
+                                   &errcode);
+    UFO_RESOURCES_CHECK_CLERR (errcode);
+    g_free (host_mem);
+
+    /* Residual and search direction, CGLS needs the second ones as well */
+    for (guint i = 0; i < 2; i++) {
+        priv->sinograms[i] = create_buffer (priv, width * height * sizeof (gfloat));
+        priv->images[i] = create_buffer (priv, width * width * sizeof (gfloat));
+    }
+
+    priv->partials = create_buffer (priv, DOT_NUM_GROUPS * sizeof (gfloat));
+}
+
+static void
+project (UfoIterativeReconstructionTaskPrivate *priv,
+         UfoProfiler *profiler,
+         cl_command_queue cmd_queue,
+         cl_mem image,
+         cl_mem reference,
+         cl_mem sinogram,
+         cl_int first,
+         cl_int stride,
+         cl_int residual)
+{
+    gsize global_work_size[2];
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->project_kernel, 0, sizeof (cl_mem), &image));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->project_kernel, 1, sizeof (cl_mem), &reference));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->project_kernel, 2, sizeof (cl_mem), &sinogram));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->project_kernel, 3, sizeof (cl_mem), &priv->angles));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->project_kernel, 4, sizeof (cl_int), &first));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->project_kernel, 5, sizeof (cl_int), &stride));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->project_kernel, 6, sizeof (cl_float), &priv->real_axis_pos));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->project_kernel, 7, sizeof (cl_int), &residual));
+
+    global_work_size[0] = priv->input_dims[0];
+    global_work_size[1] = (priv->input_dims[1] - first + stride - 1) / stride;
+    ufo_profiler_call (profiler, cmd_queue, priv->project_kernel, 2, global_work_size, NULL);
+}
+
+static void
+set_backproject_args (UfoIterativeReconstructionTaskPrivate *priv,
+                      cl_kernel kernel,
+                      cl_mem sinogram,
+                      cl_mem image,
+                      cl_int first,
+                      cl_int stride)
+{
+    cl_int num_angles = (priv->input_dims[1] - first + stride - 1) / stride;
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 0, sizeof (cl_mem), &sinogram));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 1, sizeof (cl_mem), &image));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 2, sizeof (cl_mem), &priv->angles));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 3, sizeof (cl_int), &first));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 4, sizeof (cl_int), &stride));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 5, sizeof (cl_int), &num_angles));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 6, sizeof (cl_float), &priv->real_axis_pos));
+}
+
+static void
+vector_op (UfoIterativeReconstructionTaskPrivate *priv,
+           UfoProfiler *profiler,
+           cl_command_queue cmd_queue,
+           cl_kernel kernel,
+           cl_mem y,
+           cl_mem x,
+           gfloat scalar,
+           gsize size)
+{
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 0, sizeof (cl_mem), &y));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 1, sizeof (cl_mem), &x));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (kernel, 2, sizeof (cl_float), &scalar));
+    ufo_profiler_call (profiler, cmd_queue, kernel, 1, &size, NULL);
+}
+
+static gdouble
+dot (UfoIterativeReconstructionTaskPrivate *priv,
+     UfoProfiler *profiler,
+     cl_command_queue cmd_queue,
+     cl_mem a,
+     cl_mem b,
+     gsize size)
+{
+    gfloat partials[DOT_NUM_GROUPS];
+    gsize global_work_size = DOT_NUM_GROUPS * DOT_LOCAL_SIZE;
+    gsize local_work_size = DOT_LOCAL_SIZE;
+    cl_int real_size = (cl_int) size;
+    gdouble sum = 0.0;
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->dot_kernel, 0, sizeof (cl_mem), &a));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->dot_kernel, 1, sizeof (cl_mem), &b));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->dot_kernel, 2, sizeof (cl_mem), &priv->partials));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->dot_kernel, 3, DOT_LOCAL_SIZE * sizeof (cl_float), NULL));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->dot_kernel, 4, sizeof (cl_int), &real_size));
+    ufo_profiler_call (profiler, cmd_queue, priv->dot_kernel, 1, &global_work_size, &local_work_size);
+
+    UFO_RESOURCES_CHECK_CLERR (clEnqueueReadBuffer (cmd_queue, priv->partials, CL_TRUE, 0,
+                                                    DOT_NUM_GROUPS * sizeof (gfloat), partials,
+                                                    0, NULL, NULL));
+
+    for (guint i = 0; i < DOT_NUM_GROUPS; i++)
+        sum += partials[i];
+
+    return sum;
+}
+
+/*
+ * (Ordered subsets) SIRT, the residual of every subset is normalized by the
+ * row sums and its backprojection by the column sums of the system matrix.
+ * SART is the special case of one projection per subset.
+ */
+static void
+reconstruct_sirt (UfoIterativeReconstructionTaskPrivate *priv,
+                  UfoProfiler *profiler,
+                  cl_command_queue cmd_queue,
+                  cl_mem in_mem,
+                  cl_mem out_mem,
+                  guint num_subsets)
+{
+    cl_float relaxation = (cl_float) priv->relaxation;
+    cl_int positivity = priv->positivity;
+    cl_int stride = num_subsets;
+    gsize global_work_size[2];
+
+    global_work_size[0] = global_work_size[1] = priv->input_dims[0];
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->update_kernel, 7, sizeof (cl_float), &relaxation));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->update_kernel, 8, sizeof (cl_int), &positivity));
+
+    for (guint i = 0; i < priv->num_iterations; i++) {
+        for (cl_int first = 0; first < stride; first++) {
+            project (priv, profiler, cmd_queue, out_mem, in_mem, priv->sinograms[0], first, stride, 1);
+            set_backproject_args (priv, priv->update_kernel, priv->sinograms[0], out_mem, first, stride);
+            ufo_profiler_call (profiler, cmd_queue, priv->update_kernel, 2, global_work_size, NULL);
+        }
+    }
+}
+
+/* Conjugate gradients on the normal equations A^T A x = A^T b */
+static void
+reconstruct_cgls (UfoIterativeReconstructionTaskPrivate *priv,
+                  UfoProfiler *profiler,
+                  cl_command_queue cmd_queue,
+                  cl_mem in_mem,
+                  cl_mem out_mem)
+{
+    cl_mem residual = priv->sinograms[0];
+    cl_mem projected = priv->sinograms[1];
+    cl_mem direction = priv->images[0];
+    cl_mem gradient = priv->images[1];
+    gsize sinogram_size = priv->input_dims[0] * priv->input_dims[1];
+    gsize image_size = priv->input_dims[0] * priv->input_dims[0];
+    gsize global_work_size[2];
+    gdouble gamma, gamma_new, norm;
+
+    global_work_size[0] = global_work_size[1] = priv->input_dims[0];
+
+    UFO_RESOURCES_CHECK_CLERR (clEnqueueCopyBuffer (cmd_queue, in_mem, residual, 0, 0,
+                                                    sinogram_size * sizeof (gfloat), 0, NULL, NULL));
+    set_backproject_args (priv, priv->backproject_kernel, residual, direction, 0, 1);
+    ufo_profiler_call (profiler, cmd_queue, priv->backproject_kernel, 2, global_work_size, NULL);
+    gamma = dot (priv, profiler, cmd_queue, direction, direction, image_size);
+
+    for (guint i = 0; i < priv->num_iterations && gamma > 0.0; i++) {
+        project (priv, profiler, cmd_queue, direction, in_mem, projected, 0, 1, 0);
+        norm = dot (priv, profiler, cmd_queue, projected, projected, sinogram_size);
+
+        if (norm <= 0.0)
+            break;
+
+        vector_op (priv, profiler, cmd_queue, priv->axpy_kernel, out_mem, direction, gamma / norm, image_size);
+        vector_op (priv, profiler, cmd_queue, priv->axpy_kernel, residual, projected, -gamma / norm, sinogram_size);
+
+        set_backproject_args (priv, priv->backproject_kernel, residual, gradient, 0, 1);
+        ufo_profiler_call (profiler, cmd_queue, priv->backproject_kernel, 2, global_work_size, NULL);
+        gamma_new = dot (priv, profiler, cmd_queue, gradient, gradient, image_size);
+
+        vector_op (priv, profiler, cmd_queue, priv->xpay_kernel, direction, gradient, gamma_new / gamma, image_size);
+        gamma = gamma_new;
+    }
+}
+
+static gboolean
+ufo_iterative_reconstruction_task_process (UfoTask *task,
+                                           UfoBuffer **inputs,
+                                           UfoBuffer *output,
+                                           UfoRequisition *requisition)
+{
+    UfoIterativeReconstructionTaskPrivate *priv;
+    UfoGpuNode *node;
+    UfoProfiler *profiler;
+    cl_command_queue cmd_queue;
+    cl_mem in_mem, out_mem;
+    gfloat zero = 0.0f;
+
+    priv = UFO_ITERATIVE_RECONSTRUCTION_TASK_GET_PRIVATE (task);
+    node = UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task)));
+    cmd_queue = ufo_gpu_node_get_cmd_queue (node);
+    profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
+    in_mem = ufo_buffer_get_device_array (inputs[0], cmd_queue);
+    out_mem = ufo_buffer_get_device_array (output, cmd_queue);
+
+    /* The estimate lives in the output buffer and starts at zero */
+    UFO_RESOURCES_CHECK_CLERR (clEnqueueFillBuffer (cmd_queue, out_mem, &zero, sizeof (zero), 0,
+                                                    ufo_buffer_get_size (output), 0, NULL, NULL));
+
+    switch (priv->method) {
+        case METHOD_SIRT:
+            reconstruct_sirt (priv, profiler, cmd_queue, in_mem, out_mem,
+                              MIN (priv->num_subsets, (guint) priv->input_dims[1]));
+            break;
+        case METHOD_SART:
+            reconstruct_sirt (priv, profiler, cmd_queue, in_mem, out_mem, (guint) priv->input_dims[1]);
+            break;
+        case METHOD_CGLS:
+            reconstruct_cgls (priv, profiler, cmd_queue, in_mem, out_mem);
+            break;
+    }
+
+    return TRUE;
+}
+
+static void
+ufo_iterative_reconstruction_task_setup (UfoTask *task,
+                                         UfoResources *resources,
+                                         GError **error)
+{
+    UfoIterativeReconstructionTaskPrivate *priv;
+    cl_kernel *kernels[6];
+    const gchar *names[6] = {"ir_project", "ir_backproject", "ir_update", "ir_axpy", "ir_xpay", "ir_dot"};
+
+    priv = UFO_ITERATIVE_RECONSTRUCTION_TASK_GET_PRIVATE (task);
+    kernels[0] = &priv->project_kernel;
+    kernels[1] = &priv->backproject_kernel;
+    kernels[2] = &priv->update_kernel;
+    kernels[3] = &priv->axpy_kernel;
+    kernels[4] = &priv->xpay_kernel;
+    kernels[5] = &priv->dot_kernel;
+
+    priv->resources = g_object_ref (resources);
+    priv->context = ufo_resources_get_context (resources);
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainContext (priv->context), error);
+
+    for (guint i = 0; i < G_N_ELEMENTS (names); i++) {
+        *kernels[i] = ufo_resources_get_kernel (resources, "iterative-reconstruction.cl", names[i], NULL, error);
+
+        if (*kernels[i] == NULL)
+            return;
+
+        UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (*kernels[i]), error);
+    }
+}
+
+static void
+ufo_iterative_reconstruction_task_get_requisition (UfoTask *task,
+                                                   UfoBuffer **inputs,
+                                                   UfoRequisition *requisition,
+                                                   GError **error)
+{
+    UfoIterativeReconstructionTaskPrivate *priv;
+    UfoRequisition in_req;
+
+    priv = UFO_ITERATIVE_RECONSTRUCTION_TASK_GET_PRIVATE (task);
+    ufo_buffer_get_requisition (inputs[0], &in_req);
+
+    requisition->n_dims = 2;
+    requisition->dims[0] = in_req.dims[0];
+    requisition->dims[1] = in_req.dims[0];
+
+    if (priv->geometry_changed || in_req.dims[0] != priv->input_dims[0] || in_req.dims[1] != priv->input_dims[1]) {
+        setup_geometry (priv, (guint) in_req.dims[0], (guint) in_req.dims[1]);
+        priv->input_dims[0] = in_req.dims[0];
+        priv->input_dims[1] = in_req.dims[1];
+        priv->geometry_changed = FALSE;
+    }
+}
+
+static guint
+ufo_iterative_reconstruction_task_get_num_inputs (UfoTask *task)
+{
+    return 1;
+}
+
+static guint
+ufo_iterative_reconstruction_task_get_num_dimensions (UfoTask *task,
+                                                      guint input)
+{
+    g_return_val_if_fail (input == 0, 0);
+    return 2;
+}
+
+static UfoTaskMode
+ufo_iterative_reconstruction_task_get_mode (UfoTask *task)
+{
+    return UFO_TASK_MODE_PROCESSOR | UFO_TASK_MODE_GPU;
+}
+
+static void
+ufo_iterative_reconstruction_task_finalize (GObject *object)
+{
+    UfoIterativeReconstructionTaskPrivate *priv;
+    cl_kernel *kernels[6];
+
+    priv = UFO_ITERATIVE_RECONSTRUCTION_TASK_GET_PRIVATE (object);
+    kernels[0] = &priv->project_kernel;
+    kernels[1] = &priv->backproject_kernel;
+    kernels[2] = &priv->update_kernel;
+    kernels[3] = &priv->axpy_kernel;
+    kernels[4] = &priv->xpay_kernel;
+    kernels[5] = &priv->dot_kernel;
+
+    release_buffers (priv);
+
+    for (guint i = 0; i < G_N_ELEMENTS (kernels); i++) {
+        if (*kernels[i]) {
+            UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (*kernels[i]));
+            *kernels[i] = NULL;
+        }
+    }
+
+    if (priv->context) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
+        priv->context = NULL;
+    }
+
+    if (priv->resources) {
+        g_object_unref (priv->resources);
+        priv->resources = NULL;
+    }
+
+    G_OBJECT_CLASS (ufo_iterative_reconstruction_task_parent_class)->finalize (object);
+}
+
+static void
+ufo_task_interface_init (UfoTaskIface *iface)
+{
+    iface->setup = ufo_iterative_reconstruction_task_setup;
+    iface->get_requisition = ufo_iterative_reconstruction_task_get_requisition;
+    iface->get_num_inputs = ufo_iterative_reconstruction_task_get_num_inputs;
+    iface->get_num_dimensions = ufo_iterative_reconstruction_task_get_num_dimensions;
+    iface->get_mode = ufo_iterative_reconstruction_task_get_mode;
+    iface->process = ufo_iterative_reconstruction_task_process;
+}
+
+static void
+ufo_iterative_reconstruction_task_set_property (GObject *object,
+                                                guint property_id,
+                                                const GValue *value,
+                                                GParamSpec *pspec)
+{
+    UfoIterativeReconstructionTaskPrivate *priv = UFO_ITERATIVE_RECONSTRUCTION_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_AXIS_POSITION:
+            priv->axis_pos = g_value_get_double (value);
+            priv->geometry_changed = TRUE;
+            break;
+        case PROP_ANGLE_STEP:
+            priv->angle_step = g_value_get_double (value);
+            priv->geometry_changed = TRUE;
+            break;
+        case PROP_ANGLE_OFFSET:
+            priv->angle_offset = g_value_get_double (value);
+            priv->geometry_changed = TRUE;
+            break;
+        case PROP_METHOD:
+            priv->method = g_value_get_enum (value);
+            break;
+        case PROP_NUM_ITERATIONS:
+            priv->num_iterations = g_value_get_uint (value);
+            break;
+        case PROP_NUM_SUBSETS:
+            priv->num_subsets = g_value_get_uint (value);
+            break;
+        case PROP_RELAXATION:
+            priv->relaxation = g_value_get_double (value);
+            break;
+        case PROP_POSITIVITY:
+            priv->positivity = g_value_get_boolean (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_iterative_reconstruction_task_get_property (GObject *object,
+                                                guint property_id,
+                                                GValue *value,
+                                                GParamSpec *pspec)
+{
+    UfoIterativeReconstructionTaskPrivate *priv = UFO_ITERATIVE_RECONSTRUCTION_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_AXIS_POSITION:
+            g_value_set_double (value, priv->axis_pos);
+            break;
+        case PROP_ANGLE_STEP:
+            g_value_set_double (value, priv->angle_step);
+            break;
+        case PROP_ANGLE_OFFSET:
+            g_value_set_double (value, priv->angle_offset);
+            break;
+        case PROP_METHOD:
+            g_value_set_enum (value, priv->method);
+            break;
+        case PROP_NUM_ITERATIONS:
+            g_value_set_uint (value, priv->num_iterations);
+            break;
+        case PROP_NUM_SUBSETS:
+            g_value_set_uint (value, priv->num_subsets);
+            break;
+        case PROP_RELAXATION:
+            g_value_set_double (value, priv->relaxation);
+            break;
+        case PROP_POSITIVITY:
+            g_value_set_boolean (value, priv->positivity);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_iterative_reconstruction_task_class_init (UfoIterativeReconstructionTaskClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+    oclass->finalize = ufo_iterative_reconstruction_task_finalize;
+    oclass->set_property = ufo_iterative_reconstruction_task_set_property;
+    oclass->get_property = ufo_iterative_reconstruction_task_get_property;
+
+    properties[PROP_AXIS_POSITION] =
+        g_param_spec_double ("axis-pos",
+            "Position of rotation axis",
+            "Position of rotation axis",
+            -1.0, +8192.0, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_ANGLE_STEP] =
+        g_param_spec_double ("angle-step",
+            "Increment of angle in radians",
+            "Increment of angle in radians",
+            -G_MAXDOUBLE, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_ANGLE_OFFSET] =
+        g_param_spec_double ("angle-offset",
+            "Angle offset in radians",
+            "Angle offset in radians determining the first angle position",
+            0.0, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_METHOD] =
+        g_param_spec_enum ("method",
+            "Reconstruction method (\"sirt\", \"sart\", \"cgls\")",
+            "Reconstruction method (\"sirt\", \"sart\", \"cgls\")",
+            g_enum_register_static ("ir-method", method_values),
+            METHOD_SIRT, G_PARAM_READWRITE);
+
+    properties[PROP_NUM_ITERATIONS] =
+        g_param_spec_uint ("num-iterations",
+            "Number of iterations",
+            "Number of iterations",
+            0, G_MAXUINT, 10,
+            G_PARAM_READWRITE);
+
+    properties[PROP_NUM_SUBSETS] =
+        g_param_spec_uint ("num-subsets",
+            "Number of ordered subsets of projections for SIRT",
+            "Number of ordered subsets of projections for SIRT",
+            1, G_MAXUINT, 1,
+            G_PARAM_READWRITE);
+
+    properties[PROP_RELAXATION] =
+        g_param_spec_double ("relaxation",
+            "Relaxation factor of SIRT and SART updates",
+            "Relaxation factor of SIRT and SART updates",
+            0.0, 2.0, 1.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_POSITIVITY] =
+        g_param_spec_boolean ("positivity",
+            "Clip negative values after every SIRT and SART update",
+            "Clip negative values after every SIRT and SART update",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
+        g_object_class_install_property (oclass, i, properties[i]);
+
+    g_type_class_add_private (klass, sizeof (UfoIterativeReconstructionTaskPrivate));
+}
+
+static void
+ufo_iterative_reconstruction_task_init (UfoIterativeReconstructionTask *self)
+{
+    UfoIterativeReconstructionTaskPrivate *priv;
+    self->priv = priv = UFO_ITERATIVE_RECONSTRUCTION_TASK_GET_PRIVATE (self);
+    priv->resources = NULL;
+    priv->context = NULL;
+    priv->project_kernel = NULL;
+    priv->backproject_kernel = NULL;
+    priv->update_kernel = NULL;
+    priv->axpy_kernel = NULL;
+    priv->xpay_kernel = NULL;
+    priv->dot_kernel = NULL;
+    priv->angles = NULL;
+    priv->partials = NULL;
+    priv->sinograms[0] = priv->sinograms[1] = NULL;
+    priv->images[0] = priv->images[1] = NULL;
+    priv->input_dims[0] = priv->input_dims[1] = 0;
+    priv->geometry_changed = TRUE;
+    priv->real_axis_pos = 0.0f;
+    priv->axis_pos = -1.0;
+    priv->angle_step = -1.0;
+    priv->angle_offset = 0.0;
+    priv->method = METHOD_SIRT;
+    priv->num_iterations = 10;
+    priv->num_subsets = 1;
+    priv->relaxation = 1.0;
+    priv->positivity = FALSE;
+}
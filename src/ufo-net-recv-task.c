@@ -0,0 +1,939 @@
+/*
+ * Copyright (C) 2011-2015 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "ufo-net-recv-task.h"
+
+/**
+ * SECTION:ufo-net-recv-task
+ * @Short_description: Receive raw frames from a TCP or UDP socket
+ * @Title: net-recv
+ *
+ * Receives frames of #UfoNetRecvTask:width times #UfoNetRecvTask:height
+ * pixels from a plain TCP connection or UDP datagrams. Every TCP frame and
+ * every UDP packet is preceded by a #NetHeader. UDP packets are received in
+ * batches and reassembled into a small ring of preallocated frame buffers,
+ * missing packets and frames are accounted in #UfoNetRecvTask:lost-packets
+ * and #UfoNetRecvTask:lost-frames.
+ */
+
+#define NET_MAGIC           0x4e4f4655  /* "UFON" in little endian */
+#define NET_MAX_PACKET_SIZE 65536
+#define NET_MIN_PAYLOAD     256         /* bounds the number of packets per frame */
+
+typedef struct {
+    guint32 magic;
+    guint32 frame;
+    guint32 packet;
+    guint32 n_packets;
+    guint32 offset;
+    guint32 size;
+} __attribute__((packed)) NetHeader;
+
+typedef enum {
+    PROTOCOL_TCP = 0,
+    PROTOCOL_UDP,
+} Protocol;
+
+static GEnumValue protocol_values[] = {
+    { PROTOCOL_TCP, "PROTOCOL_TCP", "tcp" },
+    { PROTOCOL_UDP, "PROTOCOL_UDP", "udp" },
+    { 0, NULL, NULL}
+};
+
+typedef struct {
+    gchar *data;
+    guint8 *seen;
+    guint32 frame;
+    guint32 n_packets;
+    guint32 received;
+    gsize bytes;
+    gboolean used;
+} FrameSlot;
+
+struct _UfoNetRecvTaskPrivate {
+    Protocol protocol;
+    gchar *address;
+    guint port;
+    gsize width;
+    gsize height;
+    gsize bytes_per_pixel;
+    gsize frame_size;
+    UfoBufferDepth bitdepth;
+    gboolean convert;
+    guint number;
+    guint timeout;
+    guint n_slots;
+    guint batch_size;
+    guint32 max_packets;
+
+    gint fd;
+    FrameSlot *slots;
+    gchar *packets;
+#ifdef __linux__
+    struct mmsghdr *msgs;
+    struct iovec *iovecs;
+#endif
+    guint current;
+    gboolean have_last;
+    guint32 last_frame;
+    gboolean have_released;
+    guint32 released_frame;
+    guint64 received_packets;
+    guint64 lost_packets;
+    guint64 lost_frames;
+};
+
+static void ufo_task_interface_init (UfoTaskIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (UfoNetRecvTask, ufo_net_recv_task, UFO_TYPE_TASK_NODE,
+                         G_IMPLEMENT_INTERFACE (UFO_TYPE_TASK,
+                                                ufo_task_interface_init))
+
+#define UFO_NET_RECV_TASK_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), UFO_TYPE_NET_RECV_TASK, UfoNetRecvTaskPrivate))
+
+enum {
+    PROP_0,
+    PROP_PROTOCOL,
+    PROP_ADDRESS,
+    PROP_PORT,
+    PROP_WIDTH,
+    PROP_HEIGHT,
+    PROP_BITDEPTH,
+    PROP_CONVERT,
+    PROP_NUMBER,
+    PROP_TIMEOUT,
+    PROP_NUM_BUFFERS,
+    PROP_BATCH_SIZE,
+    PROP_RECEIVED_PACKETS,
+    PROP_LOST_PACKETS,
+    PROP_LOST_FRAMES,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+UfoNode *
+ufo_net_recv_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_NET_RECV_TASK, NULL));
+}
+
+static void
+free_slots (UfoNetRecvTaskPrivate *priv)
+{
+    if (priv->slots != NULL) {
+        for (guint i = 0; i < priv->n_slots; i++) {
+            g_free (priv->slots[i].data);
+            g_free (priv->slots[i].seen);
+        }
+
+        g_free (priv->slots);
+        priv->slots = NULL;
+    }
+
+    g_free (priv->packets);
+    priv->packets = NULL;
+
+#ifdef __linux__
+    g_free (priv->msgs);
+    g_free (priv->iovecs);
+    priv->msgs = NULL;
+    priv->iovecs = NULL;
+#endif
+}
+
+static gint
+open_socket (UfoNetRecvTaskPrivate *priv, GError **error)
+{
+    struct addrinfo hints;
+    struct addrinfo *result;
+    struct addrinfo *rp;
+    gchar *port;
+    gint fd = -1;
+    gint err;
+
+    memset (&hints, 0, sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = priv->protocol == PROTOCOL_UDP ? SOCK_DGRAM : SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    port = g_strdup_printf ("%u", priv->port);
+    err = getaddrinfo (priv->address, port, &hints, &result);
+    g_free (port);
+
+    if (err != 0) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "Could not resolve `%s': %s", priv->address, gai_strerror (err));
+        return -1;
+    }
+
+    for (rp = result; rp != NULL; rp = rp->ai_next) {
+        gint reuse = 1;
+
+        fd = socket (rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+
+        if (fd < 0)
+            continue;
+
+        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof (reuse));
+
+        if (bind (fd, rp->ai_addr, rp->ai_addrlen) == 0)
+            break;
+
+        close (fd);
+        fd = -1;
+    }
+
+    freeaddrinfo (result);
+
+    if (fd < 0) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "Could not bind to %s:%u: %s", priv->address, priv->port, g_strerror (errno));
+        return -1;
+    }
+
+    if (priv->protocol == PROTOCOL_TCP) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        gint connection;
+        gint ready;
+
+        if (listen (fd, 1) != 0) {
+            g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                         "Could not listen on %s:%u: %s", priv->address, priv->port, g_strerror (errno));
+            close (fd);
+            return -1;
+        }
+
+        /* The timeout also bounds waiting for the sender to connect */
+        do {
+            ready = poll (&pfd, 1, priv->timeout > 0 ? (gint) priv->timeout * 1000 : -1);
+        } while (ready < 0 && errno == EINTR);
+
+        if (ready == 0) {
+            g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                         "No connection on %s:%u within %u s", priv->address, priv->port, priv->timeout);
+            close (fd);
+            return -1;
+        }
+
+        if (ready < 0 || (connection = accept (fd, NULL, NULL)) < 0) {
+            g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                         "Could not accept connection: %s", g_strerror (errno));
+            close (fd);
+            return -1;
+        }
+
+        close (fd);
+        fd = connection;
+    }
+    else {
+        /* Best effort, large socket buffers absorb bursts while we process */
+        gint buffer_size = 64 * 1024 * 1024;
+        setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof (buffer_size));
+    }
+
+    if (priv->timeout > 0) {
+        struct timeval tv;
+
+        tv.tv_sec = priv->timeout;
+        tv.tv_usec = 0;
+        setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+    }
+
+    return fd;
+}
+
+static void
+ufo_net_recv_task_setup (UfoTask *task,
+                         UfoResources *resources,
+                         GError **error)
+{
+    UfoNetRecvTaskPrivate *priv;
+
+    priv = UFO_NET_RECV_TASK_GET_PRIVATE (task);
+    priv->frame_size = priv->bytes_per_pixel * priv->width * priv->height;
+
+    if (priv->frame_size == 0) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "net-recv: width and height must be set");
+        return;
+    }
+
+    priv->max_packets = (guint32) ((priv->frame_size + NET_MIN_PAYLOAD - 1) / NET_MIN_PAYLOAD);
+
+    if (priv->fd >= 0)
+        close (priv->fd);
+
+    free_slots (priv);
+    priv->fd = open_socket (priv, error);
+
+    if (priv->fd < 0)
+        return;
+
+    if (priv->protocol == PROTOCOL_UDP) {
+        priv->slots = g_new0 (FrameSlot, priv->n_slots);
+
+        for (guint i = 0; i < priv->n_slots; i++) {
+            priv->slots[i].data = g_malloc (priv->frame_size);
+            priv->slots[i].seen = g_malloc ((priv->max_packets + 7) / 8);
+        }
+
+        priv->packets = g_malloc (((gsize) priv->batch_size) * NET_MAX_PACKET_SIZE);
+
+#ifdef __linux__
+        priv->msgs = g_new0 (struct mmsghdr, priv->batch_size);
+        priv->iovecs = g_new0 (struct iovec, priv->batch_size);
+
+        for (guint i = 0; i < priv->batch_size; i++) {
+            priv->iovecs[i].iov_base = priv->packets + ((gsize) i) * NET_MAX_PACKET_SIZE;
+            priv->iovecs[i].iov_len = NET_MAX_PACKET_SIZE;
+            priv->msgs[i].msg_hdr.msg_iov = &priv->iovecs[i];
+            priv->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+#endif
+    }
+
+    priv->current = 0;
+    priv->have_last = FALSE;
+    priv->have_released = FALSE;
+    priv->received_packets = 0;
+    priv->lost_packets = 0;
+    priv->lost_frames = 0;
+}
+
+static void
+ufo_net_recv_task_get_requisition (UfoTask *task,
+                                   UfoBuffer **inputs,
+                                   UfoRequisition *requisition,
+                                   GError **error)
+{
+    UfoNetRecvTaskPrivate *priv;
+
+    priv = UFO_NET_RECV_TASK_GET_PRIVATE (task);
+    requisition->n_dims = 2;
+    requisition->dims[0] = priv->width;
+    requisition->dims[1] = priv->height;
+}
+
+static guint
+ufo_net_recv_task_get_num_inputs (UfoTask *task)
+{
+    return 0;
+}
+
+static guint
+ufo_net_recv_task_get_num_dimensions (UfoTask *task,
+                                      guint input)
+{
+    return 2;
+}
+
+static UfoTaskMode
+ufo_net_recv_task_get_mode (UfoTask *task)
+{
+    return UFO_TASK_MODE_GENERATOR | UFO_TASK_MODE_CPU;
+}
+
+static gboolean
+check_header (UfoNetRecvTaskPrivate *priv, NetHeader *header)
+{
+    header->magic = GUINT32_FROM_LE (header->magic);
+    header->frame = GUINT32_FROM_LE (header->frame);
+    header->packet = GUINT32_FROM_LE (header->packet);
+    header->n_packets = GUINT32_FROM_LE (header->n_packets);
+    header->offset = GUINT32_FROM_LE (header->offset);
+    header->size = GUINT32_FROM_LE (header->size);
+
+    /* n_packets sizes the packet bitmap and must not come from the wire unchecked */
+    return header->magic == NET_MAGIC &&
+           header->n_packets <= priv->max_packets &&
+           header->packet < header->n_packets &&
+           ((gsize) header->offset) + header->size <= priv->frame_size;
+}
+
+static void
+account_frame (UfoNetRecvTaskPrivate *priv, guint32 frame)
+{
+    if (priv->have_last && frame > priv->last_frame + 1)
+        priv->lost_frames += frame - priv->last_frame - 1;
+
+    priv->last_frame = frame;
+    priv->have_last = TRUE;
+}
+
+static gboolean
+recv_all (gint fd, gchar *data, gsize size)
+{
+    gsize total = 0;
+
+    while (total < size) {
+        gssize n = recv (fd, data + total, size - total, MSG_WAITALL);
+
+        if (n == 0)
+            return FALSE;
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                g_warning ("net-recv: %s", g_strerror (errno));
+
+            return FALSE;
+        }
+
+        total += n;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+generate_tcp (UfoNetRecvTaskPrivate *priv, gchar *data)
+{
+    NetHeader header;
+
+    if (!recv_all (priv->fd, (gchar *) &header, sizeof (NetHeader)))
+        return FALSE;
+
+    if (!check_header (priv, &header) || header.size != priv->frame_size) {
+        g_warning ("net-recv: invalid frame header, expected %zu bytes", priv->frame_size);
+        return FALSE;
+    }
+
+    if (!recv_all (priv->fd, data, priv->frame_size))
+        return FALSE;
+
+    priv->received_packets++;
+    account_frame (priv, header.frame);
+    return TRUE;
+}
+
+static void
+release_slot (UfoNetRecvTaskPrivate *priv, FrameSlot *slot)
+{
+    if (slot->received < slot->n_packets)
+        priv->lost_packets += slot->n_packets - slot->received;
+
+    if (!priv->have_released || slot->frame > priv->released_frame)
+        priv->released_frame = slot->frame;
+
+    priv->have_released = TRUE;
+    slot->used = FALSE;
+}
+
+static gboolean
+is_finished_frame (UfoNetRecvTaskPrivate *priv, guint32 frame)
+{
+    /* Delivered or given up, missing packets are already accounted */
+    return (priv->have_last && frame <= priv->last_frame) ||
+           (priv->have_released && frame <= priv->released_frame);
+}
+
+static FrameSlot *
+get_slot (UfoNetRecvTaskPrivate *priv, NetHeader *header)
+{
+    FrameSlot *free_slot = NULL;
+    FrameSlot *oldest = NULL;
+
+    for (guint i = 0; i < priv->n_slots; i++) {
+        FrameSlot *slot = &priv->slots[i];
+
+        if (!slot->used) {
+            free_slot = free_slot == NULL ? slot : free_slot;
+            continue;
+        }
+
+        if (slot->frame == header->frame)
+            return slot->n_packets == header->n_packets ? slot : NULL;
+
+        if (slot->received < slot->n_packets && (oldest == NULL || slot->frame < oldest->frame))
+            oldest = slot;
+    }
+
+    if (free_slot == NULL) {
+        /* All buffers busy, give up the oldest incomplete frame */
+        if (oldest == NULL || oldest->frame > header->frame)
+            return NULL;
+
+        release_slot (priv, oldest);
+        free_slot = oldest;
+    }
+
+    memset (free_slot->seen, 0, (header->n_packets + 7) / 8);
+    free_slot->frame = header->frame;
+    free_slot->n_packets = header->n_packets;
+    free_slot->received = 0;
+    free_slot->bytes = 0;
+    free_slot->used = TRUE;
+
+    return free_slot;
+}
+
+static void
+handle_packet (UfoNetRecvTaskPrivate *priv, const gchar *packet, gsize length)
+{
+    NetHeader header;
+    FrameSlot *slot;
+
+    if (length < sizeof (NetHeader))
+        return;
+
+    memcpy (&header, packet, sizeof (NetHeader));
+
+    if (!check_header (priv, &header) || sizeof (NetHeader) + header.size > length)
+        return;
+
+    priv->received_packets++;
+
+    /* Late or duplicate packets of frames which are done are no losses */
+    if (is_finished_frame (priv, header.frame))
+        return;
+
+    slot = get_slot (priv, &header);
+
+    if (slot == NULL) {
+        priv->lost_packets++;
+        return;
+    }
+
+    if (slot->seen[header.packet / 8] & (1 << (header.packet % 8)))
+        return;
+
+    memcpy (slot->data + header.offset, packet + sizeof (NetHeader), header.size);
+    slot->seen[header.packet / 8] |= 1 << (header.packet % 8);
+    slot->received++;
+    slot->bytes += header.size;
+
+    /* All packets but not all bytes, the rest of the slot is stale data */
+    if (slot->received == slot->n_packets && slot->bytes != priv->frame_size) {
+        g_warning ("net-recv: packets of frame %u carry %zu instead of %zu bytes",
+                   slot->frame, slot->bytes, priv->frame_size);
+        release_slot (priv, slot);
+    }
+}
+
+static gint
+receive_batch (UfoNetRecvTaskPrivate *priv)
+{
+#ifdef __linux__
+    gint n;
+
+    do {
+        n = recvmmsg (priv->fd, priv->msgs, priv->batch_size, MSG_WAITFORONE, NULL);
+    } while (n < 0 && errno == EINTR);
+
+    for (gint i = 0; i < n; i++)
+        handle_packet (priv, (gchar *) priv->iovecs[i].iov_base, priv->msgs[i].msg_len);
+#else
+    gssize n;
+
+    do {
+        n = recv (priv->fd, priv->packets, NET_MAX_PACKET_SIZE, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n > 0)
+        handle_packet (priv, priv->packets, n);
+#endif
+
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        g_warning ("net-recv: %s", g_strerror (errno));
+
+    return (gint) n;
+}
+
+static FrameSlot *
+find_complete_slot (UfoNetRecvTaskPrivate *priv)
+{
+    FrameSlot *result = NULL;
+
+    for (guint i = 0; i < priv->n_slots; i++) {
+        FrameSlot *slot = &priv->slots[i];
+
+        if (slot->used && slot->received == slot->n_packets &&
+            (result == NULL || slot->frame < result->frame))
+            result = slot;
+    }
+
+    return result;
+}
+
+static gboolean
+generate_udp (UfoNetRecvTaskPrivate *priv, gchar *data)
+{
+    FrameSlot *slot;
+
+    while ((slot = find_complete_slot (priv)) == NULL) {
+        if (receive_batch (priv) <= 0) {
+            /* End of stream, everything still pending is incomplete */
+            for (guint i = 0; i < priv->n_slots; i++) {
+                if (priv->slots[i].used) {
+                    release_slot (priv, &priv->slots[i]);
+                    priv->lost_frames++;
+                }
+            }
+
+            return FALSE;
+        }
+    }
+
+    /* Frames older than this one cannot be completed anymore */
+    for (guint i = 0; i < priv->n_slots; i++) {
+        if (priv->slots[i].used && priv->slots[i].frame < slot->frame)
+            release_slot (priv, &priv->slots[i]);
+    }
+
+    memcpy (data, slot->data, priv->frame_size);
+    account_frame (priv, slot->frame);
+    slot->used = FALSE;
+
+    return TRUE;
+}
+
+static gboolean
+ufo_net_recv_task_generate (UfoTask *task,
+                            UfoBuffer *output,
+                            UfoRequisition *requisition)
+{
+    UfoNetRecvTaskPrivate *priv;
+    gchar *data;
+    gboolean succeeded;
+
+    priv = UFO_NET_RECV_TASK_GET_PRIVATE (task);
+
+    if (priv->number > 0 && priv->current >= priv->number)
+        return FALSE;
+
+    data = (gchar *) ufo_buffer_get_host_array (output, NULL);
+
+    if (priv->protocol == PROTOCOL_UDP)
+        succeeded = generate_udp (priv, data);
+    else
+        succeeded = generate_tcp (priv, data);
+
+    if (!succeeded) {
+        g_debug ("net-recv: received %" G_GUINT64_FORMAT " packets, lost %" G_GUINT64_FORMAT
+                 " packets and %" G_GUINT64_FORMAT " frames",
+                 priv->received_packets, priv->lost_packets, priv->lost_frames);
+        return FALSE;
+    }
+
+    if (priv->convert && priv->bitdepth != UFO_BUFFER_DEPTH_32F)
+        ufo_buffer_convert (output, priv->bitdepth);
+
+    priv->current++;
+    return TRUE;
+}
+
+static void
+ufo_net_recv_task_set_property (GObject *object,
+                                guint property_id,
+                                const GValue *value,
+                                GParamSpec *pspec)
+{
+    UfoNetRecvTaskPrivate *priv = UFO_NET_RECV_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_PROTOCOL:
+            priv->protocol = g_value_get_enum (value);
+            break;
+        case PROP_ADDRESS:
+            g_free (priv->address);
+            priv->address = g_value_dup_string (value);
+            break;
+        case PROP_PORT:
+            priv->port = g_value_get_uint (value);
+            break;
+        case PROP_WIDTH:
+            priv->width = (gsize) g_value_get_uint (value);
+            break;
+        case PROP_HEIGHT:
+            priv->height = (gsize) g_value_get_uint (value);
+            break;
+        case PROP_BITDEPTH:
+            switch (g_value_get_uint (value)) {
+                case 8:
+                    priv->bitdepth = UFO_BUFFER_DEPTH_8U;
+                    priv->bytes_per_pixel = 1;
+                    break;
+                case 16:
+                    priv->bitdepth = UFO_BUFFER_DEPTH_16U;
+                    priv->bytes_per_pixel = 2;
+                    break;
+                case 32:
+                    priv->bitdepth = UFO_BUFFER_DEPTH_32F;
+                    priv->bytes_per_pixel = 4;
+                    break;
+                default:
+                    g_warning ("Cannot set bitdepth other than 8, 16 or 32.");
+            }
+            break;
+        case PROP_CONVERT:
+            priv->convert = g_value_get_boolean (value);
+            break;
+        case PROP_NUMBER:
+            priv->number = g_value_get_uint (value);
+            break;
+        case PROP_TIMEOUT:
+            priv->timeout = g_value_get_uint (value);
+            break;
+        case PROP_NUM_BUFFERS:
+            priv->n_slots = g_value_get_uint (value);
+            break;
+        case PROP_BATCH_SIZE:
+            priv->batch_size = g_value_get_uint (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_net_recv_task_get_property (GObject *object,
+                                guint property_id,
+                                GValue *value,
+                                GParamSpec *pspec)
+{
+    UfoNetRecvTaskPrivate *priv = UFO_NET_RECV_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_PROTOCOL:
+            g_value_set_enum (value, priv->protocol);
+            break;
+        case PROP_ADDRESS:
+            g_value_set_string (value, priv->address);
+            break;
+        case PROP_PORT:
+            g_value_set_uint (value, priv->port);
+            break;
+        case PROP_WIDTH:
+            g_value_set_uint (value, (guint) priv->width);
+            break;
+        case PROP_HEIGHT:
+            g_value_set_uint (value, (guint) priv->height);
+            break;
+        case PROP_BITDEPTH:
+            g_value_set_uint (value, (guint) priv->bytes_per_pixel * 8);
+            break;
+        case PROP_CONVERT:
+            g_value_set_boolean (value, priv->convert);
+            break;
+        case PROP_NUMBER:
+            g_value_set_uint (value, priv->number);
+            break;
+        case PROP_TIMEOUT:
+            g_value_set_uint (value, priv->timeout);
+            break;
+        case PROP_NUM_BUFFERS:
+            g_value_set_uint (value, priv->n_slots);
+            break;
+        case PROP_BATCH_SIZE:
+            g_value_set_uint (value, priv->batch_size);
+            break;
+        case PROP_RECEIVED_PACKETS:
+            g_value_set_uint64 (value, priv->received_packets);
+            break;
+        case PROP_LOST_PACKETS:
+            g_value_set_uint64 (value, priv->lost_packets);
+            break;
+        case PROP_LOST_FRAMES:
+            g_value_set_uint64 (value, priv->lost_frames);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_net_recv_task_finalize (GObject *object)
+{
+    UfoNetRecvTaskPrivate *priv;
+
+    priv = UFO_NET_RECV_TASK_GET_PRIVATE (object);
+
+    if (priv->fd >= 0)
+        close (priv->fd);
+
+    free_slots (priv);
+    g_free (priv->address);
+
+    G_OBJECT_CLASS (ufo_net_recv_task_parent_class)->finalize (object);
+}
+
+static void
+ufo_task_interface_init (UfoTaskIface *iface)
+{
+    iface->setup = ufo_net_recv_task_setup;
+    iface->get_num_inputs = ufo_net_recv_task_get_num_inputs;
+    iface->get_num_dimensions = ufo_net_recv_task_get_num_dimensions;
+    iface->get_mode = ufo_net_recv_task_get_mode;
+    iface->get_requisition = ufo_net_recv_task_get_requisition;
+    iface->generate = ufo_net_recv_task_generate;
+}
+
+static void
+ufo_net_recv_task_class_init (UfoNetRecvTaskClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+    oclass->set_property = ufo_net_recv_task_set_property;
+    oclass->get_property = ufo_net_recv_task_get_property;
+    oclass->finalize = ufo_net_recv_task_finalize;
+
+    properties[PROP_PROTOCOL] =
+        g_param_spec_enum ("protocol",
+            "Transport protocol (tcp, udp)",
+            "Transport protocol (tcp, udp)",
+            g_enum_register_static ("net-recv-protocol", protocol_values),
+            PROTOCOL_TCP,
+            G_PARAM_READWRITE);
+
+    properties[PROP_ADDRESS] =
+        g_param_spec_string ("address",
+            "Local address to bind to",
+            "Local address to bind to",
+            "0.0.0.0",
+            G_PARAM_READWRITE);
+
+    properties[PROP_PORT] =
+        g_param_spec_uint ("port",
+            "Local port to bind to",
+            "Local port to bind to",
+            1, 65535, 5556,
+            G_PARAM_READWRITE);
+
+    properties[PROP_WIDTH] =
+        g_param_spec_uint ("width",
+            "Width of received frames",
+            "Width of received frames",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_HEIGHT] =
+        g_param_spec_uint ("height",
+            "Height of received frames",
+            "Height of received frames",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_BITDEPTH] =
+        g_param_spec_uint ("bitdepth",
+            "Bitdepth of received frames",
+            "Bitdepth of received frames",
+            8, 32, 32,
+            G_PARAM_READWRITE);
+
+    properties[PROP_CONVERT] =
+        g_param_spec_boolean ("convert",
+            "Enable automatic conversion",
+            "Enable automatic conversion of input data types to float",
+            TRUE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_NUMBER] =
+        g_param_spec_uint ("number",
+            "Number of frames to receive, 0 receives until the stream ends",
+            "Number of frames to receive, 0 receives until the stream ends",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_TIMEOUT] =
+        g_param_spec_uint ("timeout",
+            "Seconds without data after which the stream ends, 0 waits forever",
+            "Seconds without data after which the stream ends, 0 waits forever",
+            0, G_MAXUINT, 5,
+            G_PARAM_READWRITE);
+
+    properties[PROP_NUM_BUFFERS] =
+        g_param_spec_uint ("number-buffers",
+            "Number of UDP frame reassembly buffers",
+            "Number of UDP frame reassembly buffers",
+            1, 1024, 4,
+            G_PARAM_READWRITE);
+
+    properties[PROP_BATCH_SIZE] =
+        g_param_spec_uint ("batch-size",
+            "Maximum number of UDP packets received with one call",
+            "Maximum number of UDP packets received with one call",
+            1, 1024, 64,
+            G_PARAM_READWRITE);
+
+    properties[PROP_RECEIVED_PACKETS] =
+        g_param_spec_uint64 ("received-packets",
+            "Number of received packets",
+            "Number of received packets",
+            0, G_MAXUINT64, 0,
+            G_PARAM_READABLE);
+
+    properties[PROP_LOST_PACKETS] =
+        g_param_spec_uint64 ("lost-packets",
+            "Number of packets missing from incomplete frames",
+            "Number of packets missing from incomplete frames",
+            0, G_MAXUINT64, 0,
+            G_PARAM_READABLE);
+
+    properties[PROP_LOST_FRAMES] =
+        g_param_spec_uint64 ("lost-frames",
+            "Number of frames that were never completed",
+            "Number of frames that were never completed",
+            0, G_MAXUINT64, 0,
+            G_PARAM_READABLE);
+
+    for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
+        g_object_class_install_property (oclass, i, properties[i]);
+
+    g_type_class_add_private (oclass, sizeof(UfoNetRecvTaskPrivate));
+}
+
+static void
+ufo_net_recv_task_init(UfoNetRecvTask *self)
+{
+    self->priv = UFO_NET_RECV_TASK_GET_PRIVATE(self);
+    self->priv->protocol = PROTOCOL_TCP;
+    self->priv->address = g_strdup ("0.0.0.0");
+    self->priv->port = 5556;
+    self->priv->width = 0;
+    self->priv->height = 0;
+    self->priv->bitdepth = UFO_BUFFER_DEPTH_32F;
+    self->priv->bytes_per_pixel = 4;
+    self->priv->convert = TRUE;
+    self->priv->number = 0;
+    self->priv->timeout = 5;
+    self->priv->n_slots = 4;
+    self->priv->batch_size = 64;
+    self->priv->fd = -1;
+    self->priv->slots = NULL;
+    self->priv->packets = NULL;
+#ifdef __linux__
+    self->priv->msgs = NULL;
+    self->priv->iovecs = NULL;
+#endif
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2011-2017 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UFO_NET_RECV_TASK_H
+#define __UFO_NET_RECV_TASK_H
+
+#include <ufo/ufo.h>
+
+G_BEGIN_DECLS
+
+#define UFO_TYPE_NET_RECV_TASK             (ufo_net_recv_task_get_type())
+#define UFO_NET_RECV_TASK(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj), UFO_TYPE_NET_RECV_TASK, UfoNetRecvTask))
+#define UFO_IS_NET_RECV_TASK(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj), UFO_TYPE_NET_RECV_TASK))
+#define UFO_NET_RECV_TASK_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass), UFO_TYPE_NET_RECV_TASK, UfoNetRecvTaskClass))
+#define UFO_IS_NET_RECV_TASK_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass), UFO_TYPE_NET_RECV_TASK))
+#define UFO_NET_RECV_TASK_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj), UFO_TYPE_NET_RECV_TASK, UfoNetRecvTaskClass))
+
+typedef struct _UfoNetRecvTask           UfoNetRecvTask;
+typedef struct _UfoNetRecvTaskClass      UfoNetRecvTaskClass;
+typedef struct _UfoNetRecvTaskPrivate    UfoNetRecvTaskPrivate;
+
+struct _UfoNetRecvTask {
+    UfoTaskNode parent_instance;
+
+    UfoNetRecvTaskPrivate *priv;
+};
+
+struct _UfoNetRecvTaskClass {
+    UfoTaskNodeClass parent_class;
+};
+
+UfoNode  *ufo_net_recv_task_new       (void);
+GType     ufo_net_recv_task_get_type  (void);
+
+G_END_DECLS
+
+#endif
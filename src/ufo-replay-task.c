@@ -0,0 +1,645 @@
+/*
+ * Copyright (C) 2011-2015 Karlsruhe Institute of Technology
+ *
+ * This file is part of Ufo.
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <glob.h>
+
+#include "config.h"
+#include "ufo-replay-task.h"
+
+#include "readers/ufo-reader.h"
+#include "readers/ufo-edf-reader.h"
+
+#ifdef HAVE_TIFF
+#include "readers/ufo-tiff-reader.h"
+#endif
+
+#ifdef WITH_HDF5
+#include "readers/ufo-hdf5-reader.h"
+#endif
+
+/**
+ * SECTION:ufo-replay-task
+ * @Short_description: Replay a recorded dataset at a given rate
+ * @Title: replay
+ *
+ * Loads a recorded dataset into memory, either with the regular readers or by
+ * memory-mapping a raw file, and emits its frames at #UfoReplayTask:fps or
+ * #UfoReplayTask:bandwidth, optionally with a normally distributed jitter of
+ * the inter-frame interval. Every frame carries its emission time in the
+ * "ts" metadata, which #UfoNullTask reports as end-to-end latency if its
+ * durations property is set.
+ */
+
+struct _UfoReplayTaskPrivate {
+    gchar *path;
+    guint number;
+    guint loops;
+    gdouble fps;
+    gdouble bandwidth;
+    gdouble jitter;
+    gboolean convert;
+    guint raw_width;
+    guint raw_height;
+    guint raw_bitdepth;
+    gulong raw_offset;
+
+    /* Frames loaded by readers */
+    GPtrArray *frames;
+    UfoBufferDepth depth;
+
+    /* Frames of a memory-mapped raw file */
+    GMappedFile *mapped;
+    const gchar *raw_data;
+    gsize raw_frame_size;
+    guint n_frames;
+
+    guint current;
+    gint64 deadline;
+    GRand *rand;
+    guint64 late;
+};
+
+static void ufo_task_interface_init (UfoTaskIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (UfoReplayTask, ufo_replay_task, UFO_TYPE_TASK_NODE,
+                         G_IMPLEMENT_INTERFACE (UFO_TYPE_TASK,
+                                                ufo_task_interface_init))
+
+#define UFO_REPLAY_TASK_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), UFO_TYPE_REPLAY_TASK, UfoReplayTaskPrivate))
+
+enum {
+    PROP_0,
+    PROP_PATH,
+    PROP_NUMBER,
+    PROP_LOOPS,
+    PROP_FPS,
+    PROP_BANDWIDTH,
+    PROP_JITTER,
+    PROP_CONVERT,
+    PROP_RAW_WIDTH,
+    PROP_RAW_HEIGHT,
+    PROP_RAW_BITDEPTH,
+    PROP_RAW_OFFSET,
+    PROP_LATE_FRAMES,
+    N_PROPERTIES
+};
+
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+UfoNode *
+ufo_replay_task_new (void)
+{
+    return UFO_NODE (g_object_new (UFO_TYPE_REPLAY_TASK, NULL));
+}
+
+static void
+free_frames (UfoReplayTaskPrivate *priv)
+{
+    if (priv->frames != NULL) {
+        g_ptr_array_free (priv->frames, TRUE);
+        priv->frames = NULL;
+    }
+
+    if (priv->mapped != NULL) {
+        g_mapped_file_unref (priv->mapped);
+        priv->mapped = NULL;
+        priv->raw_data = NULL;
+    }
+
+    priv->n_frames = 0;
+}
+
+static gboolean
+map_raw_file (UfoReplayTaskPrivate *priv, GError **error)
+{
+    gsize length;
+
+    priv->mapped = g_mapped_file_new (priv->path, FALSE, error);
+
+    if (priv->mapped == NULL)
+        return FALSE;
+
+    length = g_mapped_file_get_length (priv->mapped);
+    priv->raw_data = g_mapped_file_get_contents (priv->mapped) + priv->raw_offset;
+    priv->raw_frame_size = ((gsize) priv->raw_width) * priv->raw_height * (priv->raw_bitdepth / 8);
+    priv->n_frames = length > priv->raw_offset ? (length - priv->raw_offset) / priv->raw_frame_size : 0;
+    priv->n_frames = MIN (priv->n_frames, priv->number);
+
+    switch (priv->raw_bitdepth) {
+        case 8:
+            priv->depth = UFO_BUFFER_DEPTH_8U;
+            break;
+        case 16:
+            priv->depth = UFO_BUFFER_DEPTH_16U;
+            break;
+        default:
+            priv->depth = UFO_BUFFER_DEPTH_32F;
+    }
+
+    return TRUE;
+}
+
+static UfoReader *
+get_reader (GList *readers, const gchar *filename)
+{
+    GList *it;
+
+    for (it = g_list_first (readers); it != NULL; it = g_list_next (it)) {
+        if (ufo_reader_can_open (UFO_READER (it->data), filename))
+            return UFO_READER (it->data);
+    }
+
+    return NULL;
+}
+
+static gboolean
+load_file (UfoReplayTaskPrivate *priv, UfoReader *reader, const gchar *filename, GError **error)
+{
+    if (!ufo_reader_open (reader, filename, 0, error))
+        return FALSE;
+
+    while (priv->frames->len < priv->number && ufo_reader_data_available (reader)) {
+        UfoRequisition requisition;
+        UfoBuffer *buffer;
+
+        if (!ufo_reader_get_meta (reader, &requisition, &priv->depth, error)) {
+            ufo_reader_close (reader);
+            return FALSE;
+        }
+
+        if (priv->depth > 32)
+            priv->depth = UFO_BUFFER_DEPTH_32F;
+
+        buffer = ufo_buffer_new (&requisition, NULL);
+        ufo_reader_read (reader, buffer, &requisition, 0, requisition.dims[1], 1);
+        g_ptr_array_add (priv->frames, buffer);
+    }
+
+    ufo_reader_close (reader);
+    return TRUE;
+}
+
+static gboolean
+load_frames (UfoReplayTaskPrivate *priv, GError **error)
+{
+    GList *readers = NULL;
+    gchar *pattern;
+    glob_t filenames;
+    gboolean success = TRUE;
+
+    readers = g_list_append (readers, ufo_edf_reader_new ());
+#ifdef HAVE_TIFF
+    readers = g_list_append (readers, ufo_tiff_reader_new ());
+#endif
+#ifdef WITH_HDF5
+    readers = g_list_append (readers, ufo_hdf5_reader_new ());
+#endif
+
+    priv->frames = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+
+    if (get_reader (readers, priv->path) != NULL)
+        success = load_file (priv, get_reader (readers, priv->path), priv->path, error);
+    else {
+        pattern = strstr (priv->path, "*") != NULL ? g_strdup (priv->path) : g_build_filename (priv->path, "*", NULL);
+        glob (pattern, GLOB_MARK | GLOB_TILDE, NULL, &filenames);
+
+        for (guint i = 0; success && i < filenames.gl_pathc && priv->frames->len < priv->number; i++) {
+            UfoReader *reader = get_reader (readers, filenames.gl_pathv[i]);
+
+            if (reader != NULL)
+                success = load_file (priv, reader, filenames.gl_pathv[i], error);
+        }
+
+        globfree (&filenames);
+        g_free (pattern);
+    }
+
+    g_list_free_full (readers, (GDestroyNotify) g_object_unref);
+    priv->n_frames = priv->frames->len;
+    return success;
+}
+
+static void
+ufo_replay_task_setup (UfoTask *task,
+                       UfoResources *resources,
+                       GError **error)
+{
+    UfoReplayTaskPrivate *priv;
+    gboolean success;
+
+    priv = UFO_REPLAY_TASK_GET_PRIVATE (task);
+    free_frames (priv);
+
+    if (priv->raw_width > 0 && priv->raw_height > 0)
+        success = map_raw_file (priv, error);
+    else
+        success = load_frames (priv, error);
+
+    if (!success)
+        return;
+
+    if (priv->n_frames == 0) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "replay: `%s' does not contain any frames", priv->path);
+        return;
+    }
+
+    g_debug ("replay: loaded %u frames", priv->n_frames);
+
+    if (priv->rand != NULL)
+        g_rand_free (priv->rand);
+
+    priv->rand = g_rand_new_with_seed (0);
+    priv->current = 0;
+    priv->deadline = 0;
+    priv->late = 0;
+}
+
+static void
+ufo_replay_task_get_requisition (UfoTask *task,
+                                 UfoBuffer **inputs,
+                                 UfoRequisition *requisition,
+                                 GError **error)
+{
+    UfoReplayTaskPrivate *priv;
+
+    priv = UFO_REPLAY_TASK_GET_PRIVATE (task);
+
+    if (priv->mapped != NULL) {
+        requisition->n_dims = 2;
+        requisition->dims[0] = priv->raw_width;
+        requisition->dims[1] = priv->raw_height;
+    }
+    else {
+        UfoBuffer *frame = g_ptr_array_index (priv->frames, priv->current % priv->n_frames);
+        ufo_buffer_get_requisition (frame, requisition);
+    }
+}
+
+static guint
+ufo_replay_task_get_num_inputs (UfoTask *task)
+{
+    return 0;
+}
+
+static guint
+ufo_replay_task_get_num_dimensions (UfoTask *task,
+                                    guint input)
+{
+    return 0;
+}
+
+static UfoTaskMode
+ufo_replay_task_get_mode (UfoTask *task)
+{
+    return UFO_TASK_MODE_GENERATOR | UFO_TASK_MODE_CPU;
+}
+
+static gdouble
+next_interval (UfoReplayTaskPrivate *priv, gsize frame_size)
+{
+    gdouble interval = 0.0;
+
+    if (priv->bandwidth > 0.0)
+        interval = frame_size / (priv->bandwidth * 1024.0 * 1024.0);
+    else if (priv->fps > 0.0)
+        interval = 1.0 / priv->fps;
+
+    if (interval > 0.0 && priv->jitter > 0.0) {
+        /* Box-Muller transform of two uniform samples */
+        gdouble u = 1.0 - g_rand_double (priv->rand);
+        gdouble v = g_rand_double (priv->rand);
+        gdouble normal = sqrt (-2.0 * log (u)) * cos (2.0 * G_PI * v);
+
+        interval = MAX (0.0, interval * (1.0 + priv->jitter * normal));
+    }
+
+    return interval;
+}
+
+static void
+wait_for_deadline (UfoReplayTaskPrivate *priv, gsize frame_size)
+{
+    gint64 now;
+
+    now = g_get_monotonic_time ();
+
+    if (priv->deadline == 0) {
+        priv->deadline = now;
+        return;
+    }
+
+    priv->deadline += (gint64) (next_interval (priv, frame_size) * G_USEC_PER_SEC);
+
+    if (priv->deadline > now) {
+        g_usleep (priv->deadline - now);
+    }
+    else if (priv->fps > 0.0 || priv->bandwidth > 0.0) {
+        /* Downstream could not keep up, do not try to catch up with bursts */
+        priv->late++;
+        priv->deadline = now;
+    }
+}
+
+static gboolean
+ufo_replay_task_generate (UfoTask *task,
+                          UfoBuffer *output,
+                          UfoRequisition *requisition)
+{
+    UfoReplayTaskPrivate *priv;
+    GValue timestamp = G_VALUE_INIT;
+    guint index;
+    gsize frame_size;
+
+    priv = UFO_REPLAY_TASK_GET_PRIVATE (task);
+
+    if (priv->loops > 0 && priv->current >= priv->n_frames * priv->loops) {
+        g_debug ("replay: %" G_GUINT64_FORMAT " of %u frames were late", priv->late, priv->current);
+        return FALSE;
+    }
+
+    index = priv->current % priv->n_frames;
+    frame_size = priv->mapped != NULL ? priv->raw_frame_size : ufo_buffer_get_size (output);
+    wait_for_deadline (priv, frame_size);
+
+    if (priv->mapped != NULL)
+        memcpy (ufo_buffer_get_host_array (output, NULL), priv->raw_data + index * priv->raw_frame_size, priv->raw_frame_size);
+    else
+        ufo_buffer_copy (g_ptr_array_index (priv->frames, index), output);
+
+    if (priv->depth != UFO_BUFFER_DEPTH_32F && priv->convert)
+        ufo_buffer_convert (output, priv->depth);
+
+    g_value_init (&timestamp, G_TYPE_INT64);
+    g_value_set_int64 (&timestamp, g_get_real_time ());
+    ufo_buffer_set_metadata (output, "ts", &timestamp);
+    g_value_unset (&timestamp);
+
+    priv->current++;
+    return TRUE;
+}
+
+static void
+ufo_replay_task_set_property (GObject *object,
+                              guint property_id,
+                              const GValue *value,
+                              GParamSpec *pspec)
+{
+    UfoReplayTaskPrivate *priv = UFO_REPLAY_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_PATH:
+            g_free (priv->path);
+            priv->path = g_value_dup_string (value);
+            break;
+        case PROP_NUMBER:
+            priv->number = g_value_get_uint (value);
+            break;
+        case PROP_LOOPS:
+            priv->loops = g_value_get_uint (value);
+            break;
+        case PROP_FPS:
+            priv->fps = g_value_get_double (value);
+            break;
+        case PROP_BANDWIDTH:
+            priv->bandwidth = g_value_get_double (value);
+            break;
+        case PROP_JITTER:
+            priv->jitter = g_value_get_double (value);
+            break;
+        case PROP_CONVERT:
+            priv->convert = g_value_get_boolean (value);
+            break;
+        case PROP_RAW_WIDTH:
+            priv->raw_width = g_value_get_uint (value);
+            break;
+        case PROP_RAW_HEIGHT:
+            priv->raw_height = g_value_get_uint (value);
+            break;
+        case PROP_RAW_BITDEPTH:
+            priv->raw_bitdepth = g_value_get_uint (value);
+            break;
+        case PROP_RAW_OFFSET:
+            priv->raw_offset = g_value_get_ulong (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_replay_task_get_property (GObject *object,
+                              guint property_id,
+                              GValue *value,
+                              GParamSpec *pspec)
+{
+    UfoReplayTaskPrivate *priv = UFO_REPLAY_TASK_GET_PRIVATE (object);
+
+    switch (property_id) {
+        case PROP_PATH:
+            g_value_set_string (value, priv->path);
+            break;
+        case PROP_NUMBER:
+            g_value_set_uint (value, priv->number);
+            break;
+        case PROP_LOOPS:
+            g_value_set_uint (value, priv->loops);
+            break;
+        case PROP_FPS:
+            g_value_set_double (value, priv->fps);
+            break;
+        case PROP_BANDWIDTH:
+            g_value_set_double (value, priv->bandwidth);
+            break;
+        case PROP_JITTER:
+            g_value_set_double (value, priv->jitter);
+            break;
+        case PROP_CONVERT:
+            g_value_set_boolean (value, priv->convert);
+            break;
+        case PROP_RAW_WIDTH:
+            g_value_set_uint (value, priv->raw_width);
+            break;
+        case PROP_RAW_HEIGHT:
+            g_value_set_uint (value, priv->raw_height);
+            break;
+        case PROP_RAW_BITDEPTH:
+            g_value_set_uint (value, priv->raw_bitdepth);
+            break;
+        case PROP_RAW_OFFSET:
+            g_value_set_ulong (value, priv->raw_offset);
+            break;
+        case PROP_LATE_FRAMES:
+            g_value_set_uint64 (value, priv->late);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+            break;
+    }
+}
+
+static void
+ufo_replay_task_finalize (GObject *object)
+{
+    UfoReplayTaskPrivate *priv;
+
+    priv = UFO_REPLAY_TASK_GET_PRIVATE (object);
+    free_frames (priv);
+    g_free (priv->path);
+
+    if (priv->rand != NULL)
+        g_rand_free (priv->rand);
+
+    G_OBJECT_CLASS (ufo_replay_task_parent_class)->finalize (object);
+}
+
+static void
+ufo_task_interface_init (UfoTaskIface *iface)
+{
+    iface->setup = ufo_replay_task_setup;
+    iface->get_num_inputs = ufo_replay_task_get_num_inputs;
+    iface->get_num_dimensions = ufo_replay_task_get_num_dimensions;
+    iface->get_mode = ufo_replay_task_get_mode;
+    iface->get_requisition = ufo_replay_task_get_requisition;
+    iface->generate = ufo_replay_task_generate;
+}
+
+static void
+ufo_replay_task_class_init (UfoReplayTaskClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS (klass);
+
+    oclass->set_property = ufo_replay_task_set_property;
+    oclass->get_property = ufo_replay_task_get_property;
+    oclass->finalize = ufo_replay_task_finalize;
+
+    properties[PROP_PATH] =
+        g_param_spec_string ("path",
+            "Glob-style pattern or file of the recorded dataset",
+            "Glob-style pattern or file of the recorded dataset",
+            ".",
+            G_PARAM_READWRITE);
+
+    properties[PROP_NUMBER] =
+        g_param_spec_uint ("number",
+            "Maximum number of frames to load",
+            "Maximum number of frames to load",
+            1, G_MAXUINT, G_MAXUINT,
+            G_PARAM_READWRITE);
+
+    properties[PROP_LOOPS] =
+        g_param_spec_uint ("loops",
+            "How often the dataset is replayed, 0 replays forever",
+            "How often the dataset is replayed, 0 replays forever",
+            0, G_MAXUINT, 1,
+            G_PARAM_READWRITE);
+
+    properties[PROP_FPS] =
+        g_param_spec_double ("fps",
+            "Target frame rate, 0 emits as fast as possible",
+            "Target frame rate, 0 emits as fast as possible",
+            0.0, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_BANDWIDTH] =
+        g_param_spec_double ("bandwidth",
+            "Target bandwidth in MB/s, overrides fps",
+            "Target bandwidth in MB/s, overrides fps",
+            0.0, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_JITTER] =
+        g_param_spec_double ("jitter",
+            "Standard deviation of the frame interval relative to its mean",
+            "Standard deviation of the frame interval relative to its mean",
+            0.0, G_MAXDOUBLE, 0.0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_CONVERT] =
+        g_param_spec_boolean ("convert",
+            "Enable automatic conversion",
+            "Enable automatic conversion of input data types to float",
+            TRUE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_RAW_WIDTH] =
+        g_param_spec_uint ("raw-width",
+            "Width of frames in a memory-mapped raw file",
+            "Width of frames in a memory-mapped raw file",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_RAW_HEIGHT] =
+        g_param_spec_uint ("raw-height",
+            "Height of frames in a memory-mapped raw file",
+            "Height of frames in a memory-mapped raw file",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_RAW_BITDEPTH] =
+        g_param_spec_uint ("raw-bitdepth",
+            "Bitdepth of frames in a memory-mapped raw file",
+            "Bitdepth of frames in a memory-mapped raw file",
+            8, 32, 32,
+            G_PARAM_READWRITE);
+
+    properties[PROP_RAW_OFFSET] =
+        g_param_spec_ulong ("raw-offset",
+            "Offset in bytes of the first frame in a raw file",
+            "Offset in bytes of the first frame in a raw file",
+            0, G_MAXULONG, 0,
+            G_PARAM_READWRITE);
+
+    properties[PROP_LATE_FRAMES] =
+        g_param_spec_uint64 ("late-frames",
+            "Number of frames emitted after their deadline",
+            "Number of frames emitted after their deadline",
+            0, G_MAXUINT64, 0,
+            G_PARAM_READABLE);
+
+    for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
+        g_object_class_install_property (oclass, i, properties[i]);
+
+    g_type_class_add_private (oclass, sizeof(UfoReplayTaskPrivate));
+}
+
+static void
+ufo_replay_task_init(UfoReplayTask *self)
+{
+    self->priv = UFO_REPLAY_TASK_GET_PRIVATE(self);
+    self->priv->path = g_strdup (".");
+    self->priv->number = G_MAXUINT;
+    self->priv->loops = 1;
+    self->priv->fps = 0.0;
+    self->priv->bandwidth = 0.0;
+    self->priv->jitter = 0.0;
+    self->priv->convert = TRUE;
+    self->priv->raw_width = 0;
+    self->priv->raw_height = 0;
+    self->priv->raw_bitdepth = 32;
+    self->priv->raw_offset = 0;
+    self->priv->frames = NULL;
+    self->priv->mapped = NULL;
+    self->priv->raw_data = NULL;
+    self->priv->depth = UFO_BUFFER_DEPTH_32F;
+    self->priv->rand = NULL;
+}
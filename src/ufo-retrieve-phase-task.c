@@ -24,6 +24,7 @@
 #endif
 
 #include "ufo-retrieve-phase-task.h"
+#include "common/ufo-fft.h"
 
 #define IS_POW_OF_2(x) !(x & (x - 1))
 
@@ -52,12 +53,25 @@ struct _UfoRetrievePhaseTaskPrivate {
     gfloat binary_filter;
     gfloat frequency_cutoff;
     gboolean output_filter;
+    gboolean batched;
+    gboolean smooth;
 
     gfloat prefac;
     cl_kernel *kernels;
     cl_kernel mult_by_value_kernel;
     cl_context context;
     UfoBuffer *filter_buffer;
+
+    /* Batched mode */
+    cl_kernel pad_kernel;
+    cl_kernel mult_by_filter_kernel;
+    cl_kernel pack_kernel;
+    cl_mem padded;
+    cl_mem spectrum;
+    UfoFft *forward;
+    UfoFft *backward;
+    gboolean real;
+    gsize size[3];
 };
 
 static void ufo_task_interface_init (UfoTaskIface *iface);
@@ -79,6 +93,8 @@ enum {
     PROP_BINARY_FILTER_THRESHOLDING,
     PROP_FREQUENCY_CUTOFF,
     PROP_OUTPUT_FILTER,
+    PROP_BATCHED,
+    PROP_SMOOTH_PADDING,
     N_PROPERTIES
 };
 
@@ -131,6 +147,150 @@ ufo_retrieve_phase_task_setup (UfoTask *task,
     if (priv->mult_by_value_kernel != NULL) {
         UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->mult_by_value_kernel), error);
     }
+
+    if (priv->batched) {
+        /* Without real transforms the projections are spread into complex numbers */
+        priv->real = ufo_fft_supports_real ();
+        priv->forward = ufo_fft_new ();
+        priv->backward = ufo_fft_new ();
+
+        priv->pad_kernel = ufo_resources_get_kernel (resources, "fft.cl", priv->real ? "fft_pad_real" : "fft_spread", NULL, error);
+
+        if (priv->pad_kernel != NULL)
+            UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->pad_kernel), error);
+
+        priv->pack_kernel = ufo_resources_get_kernel (resources, "fft.cl", priv->real ? "fft_pack_real" : "fft_pack", NULL, error);
+
+        if (priv->pack_kernel != NULL)
+            UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->pack_kernel), error);
+
+        priv->mult_by_filter_kernel = ufo_resources_get_kernel (resources, "phase-retrieval.cl", "mult_by_filter", NULL, error);
+
+        if (priv->mult_by_filter_kernel != NULL)
+            UFO_RESOURCES_CHECK_SET_AND_RETURN (clRetainKernel (priv->mult_by_filter_kernel), error);
+    }
+}
+
+static void
+release_batch_buffers (UfoRetrievePhaseTaskPrivate *priv)
+{
+    if (priv->padded) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->padded));
+        priv->padded = NULL;
+    }
+
+    if (priv->spectrum) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseMemObject (priv->spectrum));
+        priv->spectrum = NULL;
+    }
+}
+
+static cl_mem
+create_batch_buffer (UfoRetrievePhaseTaskPrivate *priv, gsize num_floats, GError **error)
+{
+    cl_mem mem;
+    cl_int cl_error;
+
+    mem = clCreateBuffer (priv->context, CL_MEM_READ_WRITE, num_floats * sizeof (gfloat), NULL, &cl_error);
+    UFO_RESOURCES_CHECK_AND_SET (cl_error, error);
+
+    return cl_error == CL_SUCCESS ? mem : NULL;
+}
+
+static void
+compute_filter (UfoRetrievePhaseTaskPrivate *priv,
+                cl_command_queue cmd_queue,
+                UfoProfiler *profiler,
+                gsize width,
+                gsize height)
+{
+    cl_kernel method_kernel;
+    cl_mem filter_mem;
+    gsize global_work_size[2];
+
+    filter_mem = ufo_buffer_get_device_array (priv->filter_buffer, cmd_queue);
+    method_kernel = priv->kernels[(gint)priv->method];
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 0, sizeof (gfloat), &priv->prefac));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 1, sizeof (gfloat), &priv->regularization_rate));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 2, sizeof (gfloat), &priv->binary_filter));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 3, sizeof (gfloat), &priv->frequency_cutoff));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 4, sizeof (cl_mem), &filter_mem));
+    global_work_size[0] = width;
+    global_work_size[1] = height;
+    ufo_profiler_call (profiler, cmd_queue, method_kernel, 2, global_work_size, NULL);
+}
+
+static void
+update_batch (UfoTask *task,
+              UfoRequisition *requisition,
+              GError **error)
+{
+    UfoRetrievePhaseTaskPrivate *priv;
+    UfoFftParameter param = { 0, };
+    UfoRequisition filter_requisition;
+    cl_command_queue cmd_queue;
+    gsize size[3];
+    gsize num_values;
+
+    priv = UFO_RETRIEVE_PHASE_TASK_GET_PRIVATE (task);
+
+    size[0] = ufo_fft_get_padded_size (requisition->dims[0], priv->smooth);
+    size[1] = ufo_fft_get_padded_size (requisition->dims[1], priv->smooth);
+    size[2] = requisition->n_dims == 3 ? requisition->dims[2] : 1;
+
+    if (size[0] == priv->size[0] && size[1] == priv->size[1] && size[2] == priv->size[2])
+        return;
+
+    release_batch_buffers (priv);
+    priv->size[0] = size[0];
+    priv->size[1] = size[1];
+    priv->size[2] = size[2];
+
+    /* All projections of the stack are one batch of 2D transforms */
+    param.dimensions = UFO_FFT_2D;
+    param.size[0] = size[0];
+    param.size[1] = size[1];
+    param.size[2] = 1;
+    param.batch = size[2];
+    param.zeropad = TRUE;
+    param.type = priv->real ? UFO_FFT_REAL_TO_COMPLEX : UFO_FFT_COMPLEX_TO_COMPLEX;
+
+    cmd_queue = ufo_gpu_node_get_cmd_queue (UFO_GPU_NODE (ufo_task_node_get_proc_node (UFO_TASK_NODE (task))));
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (ufo_fft_update (priv->forward, priv->context, cmd_queue, &param), error);
+
+    param.type = priv->real ? UFO_FFT_COMPLEX_TO_REAL : UFO_FFT_COMPLEX_TO_COMPLEX;
+    UFO_RESOURCES_CHECK_SET_AND_RETURN (ufo_fft_update (priv->backward, priv->context, cmd_queue, &param), error);
+
+    num_values = size[0] * size[1] * size[2];
+    priv->padded = create_batch_buffer (priv, priv->real ? num_values : 2 * num_values, error);
+
+    if (priv->padded == NULL)
+        return;
+
+    if (priv->real) {
+        priv->spectrum = create_batch_buffer (priv, 2 * (size[0] / 2 + 1) * size[1] * size[2], error);
+
+        if (priv->spectrum == NULL)
+            return;
+    }
+
+    /* One filter for all projections */
+    filter_requisition.n_dims = 2;
+    filter_requisition.dims[0] = size[0];
+    filter_requisition.dims[1] = size[1];
+    ufo_buffer_resize (priv->filter_buffer, &filter_requisition);
+    compute_filter (priv, cmd_queue, ufo_task_node_get_profiler (UFO_TASK_NODE (task)), size[0], size[1]);
+}
+
+static gboolean
+is_half_spectrum (UfoBuffer *buffer)
+{
+    GValue *value;
+
+    value = ufo_buffer_get_metadata (buffer, UFO_FFT_METADATA_HERMITIAN);
+
+    return value != NULL && g_value_get_boolean (value);
 }
 
 static void
@@ -143,6 +303,25 @@ ufo_retrieve_phase_task_get_requisition (UfoTask *task,
 
     priv = UFO_RETRIEVE_PHASE_TASK_GET_PRIVATE (task);
     ufo_buffer_get_requisition (inputs[0], requisition);
+
+    if (priv->batched) {
+        if (priv->output_filter) {
+            g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                                 "retrieve-phase: output-filter cannot be used in batched mode");
+            return;
+        }
+
+        /* Real projections in and out, padding and transforms are internal */
+        update_batch (task, requisition, error);
+        return;
+    }
+
+    if (is_half_spectrum (inputs[0])) {
+        g_set_error_literal (error, UFO_TASK_ERROR, UFO_TASK_ERROR_GET_REQUISITION,
+                             "retrieve-phase: input is a half spectrum, use fft with hermitian=false");
+        return;
+    }
+
     if (priv->output_filter) {
         requisition->dims[0] >>= 1;
     }
@@ -163,7 +342,7 @@ static guint
 ufo_filter_task_get_num_dimensions (UfoTask *task, guint input)
 {
     g_return_val_if_fail (input == 0, 0);
-    return 2;
+    return UFO_RETRIEVE_PHASE_TASK_GET_PRIVATE (task)->batched ? 3 : 2;
 }
 
 static UfoTaskMode
@@ -172,6 +351,78 @@ ufo_filter_task_get_mode (UfoTask *task)
     return UFO_TASK_MODE_PROCESSOR | UFO_TASK_MODE_GPU;
 }
 
+static gboolean
+process_batch (UfoRetrievePhaseTaskPrivate *priv,
+               cl_command_queue cmd_queue,
+               UfoProfiler *profiler,
+               UfoBuffer *input,
+               UfoBuffer *output,
+               UfoRequisition *requisition)
+{
+    cl_mem in_mem, out_mem, filter_mem, spectrum;
+    cl_int width, height, padded_width, padded_height;
+    gfloat scale;
+    gsize global_work_size[3];
+
+    in_mem = ufo_buffer_get_device_array (input, cmd_queue);
+    out_mem = ufo_buffer_get_device_array (output, cmd_queue);
+    filter_mem = ufo_buffer_get_device_array (priv->filter_buffer, cmd_queue);
+    spectrum = priv->real ? priv->spectrum : priv->padded;
+
+    width = (cl_int) requisition->dims[0];
+    height = (cl_int) requisition->dims[1];
+    padded_width = (cl_int) priv->size[0];
+    padded_height = (cl_int) priv->size[1];
+
+    /* Zero-pad all projections */
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pad_kernel, 0, sizeof (cl_mem), &priv->padded));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pad_kernel, 1, sizeof (cl_mem), &in_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pad_kernel, 2, sizeof (cl_int), &width));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pad_kernel, 3, sizeof (cl_int), &height));
+    ufo_profiler_call (profiler, cmd_queue, priv->pad_kernel, 3, priv->size, NULL);
+
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->forward, cmd_queue, profiler, priv->padded, spectrum,
+                                                UFO_FFT_FORWARD, 0, NULL, NULL));
+
+    /* Filter, a Hermitian spectrum holds only the first size / 2 + 1 columns */
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->mult_by_filter_kernel, 0, sizeof (cl_mem), &spectrum));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->mult_by_filter_kernel, 1, sizeof (cl_mem), &filter_mem));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->mult_by_filter_kernel, 2, sizeof (cl_int), &padded_width));
+
+    global_work_size[0] = priv->real ? priv->size[0] / 2 + 1 : priv->size[0];
+    global_work_size[1] = priv->size[1];
+    global_work_size[2] = priv->size[2];
+    ufo_profiler_call (profiler, cmd_queue, priv->mult_by_filter_kernel, 3, global_work_size, NULL);
+
+    UFO_RESOURCES_CHECK_CLERR (ufo_fft_execute (priv->backward, cmd_queue, profiler, spectrum, priv->padded,
+                                                UFO_FFT_BACKWARD, 0, NULL, NULL));
+
+    /* Crop and scale like ifft */
+    scale = 1.0f / (priv->size[0] * priv->size[1]);
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 0, sizeof (cl_mem), &priv->padded));
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 1, sizeof (cl_mem), &out_mem));
+
+    if (priv->real) {
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 2, sizeof (cl_int), &padded_width));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 3, sizeof (cl_int), &padded_height));
+        global_work_size[0] = requisition->dims[0];
+        global_work_size[1] = requisition->dims[1];
+    }
+    else {
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 2, sizeof (cl_int), &width));
+        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 3, sizeof (cl_int), &height));
+        global_work_size[0] = priv->size[0];
+        global_work_size[1] = priv->size[1];
+    }
+
+    UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (priv->pack_kernel, 4, sizeof (gfloat), &scale));
+    ufo_profiler_call (profiler, cmd_queue, priv->pack_kernel, 3, global_work_size, NULL);
+    ufo_buffer_set_layout (output, UFO_BUFFER_LAYOUT_REAL);
+
+    return TRUE;
+}
+
 static gboolean
 ufo_retrieve_phase_task_process (UfoTask *task,
                                  UfoBuffer **inputs,
@@ -181,10 +432,8 @@ ufo_retrieve_phase_task_process (UfoTask *task,
     UfoRetrievePhaseTaskPrivate *priv;
     UfoGpuNode *node;
     UfoProfiler *profiler;
-    gsize global_work_size[3];
 
     cl_mem in_mem, out_mem, filter_mem;
-    cl_kernel method_kernel;
     cl_command_queue cmd_queue;
 
     priv = UFO_RETRIEVE_PHASE_TASK_GET_PRIVATE (task);
@@ -193,29 +442,20 @@ ufo_retrieve_phase_task_process (UfoTask *task,
     cmd_queue = ufo_gpu_node_get_cmd_queue (node);
     profiler = ufo_task_node_get_profiler (UFO_TASK_NODE (task));
 
+    if (priv->batched)
+        return process_batch (priv, cmd_queue, profiler, inputs[0], output, requisition);
+
     if (ufo_buffer_cmp_dimensions (priv->filter_buffer, requisition) != 0) {
         ufo_buffer_resize (priv->filter_buffer, requisition);
-        filter_mem = ufo_buffer_get_device_array (priv->filter_buffer, cmd_queue);
 
-        method_kernel = priv->kernels[(gint)priv->method];
-
-        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 0, sizeof (gfloat), &priv->prefac));
-        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 1, sizeof (gfloat), &priv->regularization_rate));
-        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 2, sizeof (gfloat), &priv->binary_filter));
-        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 3, sizeof (gfloat), &priv->frequency_cutoff));
-        UFO_RESOURCES_CHECK_CLERR (clSetKernelArg (method_kernel, 4, sizeof (cl_mem), &filter_mem));
-        global_work_size[0] = requisition->dims[0];
-        global_work_size[1] = requisition->dims[1];
-        if (!priv->output_filter) {
-            /* Filter is real as opposed to the complex input, so the width is only half of the interleaved input */
-            global_work_size[0] >>= 1;
-        }
-        ufo_profiler_call (profiler, cmd_queue, method_kernel, requisition->n_dims, global_work_size, NULL);
-    }
-    else {
-        filter_mem = ufo_buffer_get_device_array (priv->filter_buffer, cmd_queue);
+        /* Filter is real as opposed to the complex input, so the width is only half of the interleaved input */
+        compute_filter (priv, cmd_queue, profiler,
+                        priv->output_filter ? requisition->dims[0] : requisition->dims[0] >> 1,
+                        requisition->dims[1]);
     }
 
+    filter_mem = ufo_buffer_get_device_array (priv->filter_buffer, cmd_queue);
+
     if (priv->output_filter) {
         ufo_buffer_copy (priv->filter_buffer, output);
     }
@@ -264,6 +504,12 @@ ufo_retrieve_phase_task_get_property (GObject *object,
         case PROP_OUTPUT_FILTER:
             g_value_set_boolean (value, priv->output_filter);
             break;
+        case PROP_BATCHED:
+            g_value_set_boolean (value, priv->batched);
+            break;
+        case PROP_SMOOTH_PADDING:
+            g_value_set_boolean (value, priv->smooth);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -303,6 +549,12 @@ ufo_retrieve_phase_task_set_property (GObject *object,
         case PROP_OUTPUT_FILTER:
             priv->output_filter = g_value_get_boolean (value);
             break;
+        case PROP_BATCHED:
+            priv->batched = g_value_get_boolean (value);
+            break;
+        case PROP_SMOOTH_PADDING:
+            priv->smooth = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -331,6 +583,33 @@ ufo_retrieve_phase_task_finalize (GObject *object)
         priv->mult_by_value_kernel = NULL;
     }
 
+    if (priv->pad_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->pad_kernel));
+        priv->pad_kernel = NULL;
+    }
+
+    if (priv->mult_by_filter_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->mult_by_filter_kernel));
+        priv->mult_by_filter_kernel = NULL;
+    }
+
+    if (priv->pack_kernel) {
+        UFO_RESOURCES_CHECK_CLERR (clReleaseKernel (priv->pack_kernel));
+        priv->pack_kernel = NULL;
+    }
+
+    release_batch_buffers (priv);
+
+    if (priv->forward) {
+        ufo_fft_destroy (priv->forward);
+        priv->forward = NULL;
+    }
+
+    if (priv->backward) {
+        ufo_fft_destroy (priv->backward);
+        priv->backward = NULL;
+    }
+
     if (priv->context) {
         UFO_RESOURCES_CHECK_CLERR (clReleaseContext (priv->context));
         priv->context = NULL;
@@ -420,6 +699,20 @@ ufo_retrieve_phase_task_class_init (UfoRetrievePhaseTaskClass *klass)
             FALSE,
             G_PARAM_READWRITE);
 
+    properties[PROP_BATCHED] =
+        g_param_spec_boolean ("batched",
+            "Filter real projections or stacks of them including the transforms",
+            "Filter real projections or stacks of them including the transforms",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_SMOOTH_PADDING] =
+        g_param_spec_boolean ("smooth-padding",
+            "Pad to sizes with small prime factors instead of powers of two in batched mode",
+            "Pad to sizes with small prime factors instead of powers of two in batched mode",
+            FALSE,
+            G_PARAM_READWRITE);
+
     for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (gobject_class, i, properties[i]);
 
@@ -441,4 +734,6 @@ ufo_retrieve_phase_task_init(UfoRetrievePhaseTask *self)
     priv->kernels = (cl_kernel *) g_malloc0(N_METHODS * sizeof(cl_kernel));
     priv->filter_buffer = NULL;
     priv->output_filter = FALSE;
+    priv->batched = FALSE;
+    priv->smooth = FALSE;
 }
@@ -18,15 +18,95 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "config.h"
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
 #include "ufo-stdin-task.h"
 
+/**
+ * SECTION:ufo-stdin-task
+ * @Short_description: Read raw, optionally compressed frames from stdin
+ * @Title: stdin
+ *
+ * Reads frames of #UfoStdinTask:width times #UfoStdinTask:height pixels from
+ * stdin. Frames may be compressed with zstd or LZ4 frame format. If each frame
+ * is prefixed with a 32 bit little endian length header, up to
+ * #UfoStdinTask:number-threads frames are read ahead and decompressed in
+ * parallel, and frames which cannot be decompressed are skipped. Without
+ * headers a corrupt frame ends the stream because the next frame cannot be
+ * found.
+ */
+
+typedef enum {
+    COMPRESSION_NONE = 0,
+    COMPRESSION_LZ4,
+    COMPRESSION_ZSTD,
+} Compression;
+
+static GEnumValue compression_values[] = {
+    { COMPRESSION_NONE, "COMPRESSION_NONE", "none" },
+    { COMPRESSION_LZ4,  "COMPRESSION_LZ4",  "lz4" },
+    { COMPRESSION_ZSTD, "COMPRESSION_ZSTD", "zstd" },
+    { 0, NULL, NULL}
+};
+
+typedef struct {
+    gchar *compressed;
+    gsize size;
+    gsize capacity;
+    gboolean valid;
+#ifdef HAVE_ZSTD
+    ZSTD_DCtx *zstd;
+#endif
+#ifdef HAVE_LZ4
+    LZ4F_dctx *lz4;
+#endif
+} Slot;
 
 struct _UfoStdinTaskPrivate {
     gsize width;
     gsize height;
     gsize bytes_per_pixel;
+    gsize frame_size;
     UfoBufferDepth bitdepth;
     gboolean convert;
+    Compression compression;
+    gboolean frame_header;
+    guint num_threads;
+
+    /* Read-ahead batch, used when frames carry a length header */
+    Slot *slots;
+    guint n_slots;
+    gchar *decoded;
+    guint n_decoded;
+    guint current;
+    gsize max_length;
+    gboolean corrupt;
+
+    /* Streaming state, used without length headers */
+    gchar *in;
+    gsize in_capacity;
+    gsize in_size;
+    gsize in_pos;
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zstd_stream;
+#endif
+#ifdef HAVE_LZ4
+    LZ4F_dctx *lz4_stream;
+#endif
 };
 
 static void ufo_task_interface_init (UfoTaskIface *iface);
@@ -43,6 +123,9 @@ enum {
     PROP_HEIGHT,
     PROP_BITDEPTH,
     PROP_CONVERT,
+    PROP_COMPRESSION,
+    PROP_FRAME_HEADER,
+    PROP_NUM_THREADS,
     N_PROPERTIES
 };
 
@@ -54,11 +137,150 @@ ufo_stdin_task_new (void)
     return UFO_NODE (g_object_new (UFO_TYPE_STDIN_TASK, NULL));
 }
 
+static void
+free_decompression_state (UfoStdinTaskPrivate *priv)
+{
+    for (guint i = 0; i < priv->n_slots; i++) {
+        g_free (priv->slots[i].compressed);
+#ifdef HAVE_ZSTD
+        if (priv->slots[i].zstd != NULL)
+            ZSTD_freeDCtx (priv->slots[i].zstd);
+#endif
+#ifdef HAVE_LZ4
+        if (priv->slots[i].lz4 != NULL)
+            LZ4F_freeDecompressionContext (priv->slots[i].lz4);
+#endif
+    }
+
+    g_free (priv->slots);
+    g_free (priv->decoded);
+    g_free (priv->in);
+    priv->slots = NULL;
+    priv->n_slots = 0;
+    priv->decoded = NULL;
+    priv->in = NULL;
+
+#ifdef HAVE_ZSTD
+    if (priv->zstd_stream != NULL) {
+        ZSTD_freeDStream (priv->zstd_stream);
+        priv->zstd_stream = NULL;
+    }
+#endif
+#ifdef HAVE_LZ4
+    if (priv->lz4_stream != NULL) {
+        LZ4F_freeDecompressionContext (priv->lz4_stream);
+        priv->lz4_stream = NULL;
+    }
+#endif
+}
+
+static gboolean
+check_compression_support (Compression compression, GError **error)
+{
+#ifndef HAVE_LZ4
+    if (compression == COMPRESSION_LZ4) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "stdin was built without LZ4 support");
+        return FALSE;
+    }
+#endif
+#ifndef HAVE_ZSTD
+    if (compression == COMPRESSION_ZSTD) {
+        g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                     "stdin was built without zstd support");
+        return FALSE;
+    }
+#endif
+    return TRUE;
+}
+
 static void
 ufo_stdin_task_setup (UfoTask *task,
                       UfoResources *resources,
                       GError **error)
 {
+    UfoStdinTaskPrivate *priv;
+
+    priv = UFO_STDIN_TASK_GET_PRIVATE (task);
+    priv->frame_size = priv->bytes_per_pixel * priv->width * priv->height;
+
+    if (!check_compression_support (priv->compression, error))
+        return;
+
+    free_decompression_state (priv);
+
+    if (priv->frame_header) {
+        priv->n_slots = priv->num_threads;
+
+#ifdef _OPENMP
+        /* Leave half of the cores to the rest of the pipeline */
+        if (priv->n_slots == 0)
+            priv->n_slots = (guint) omp_get_max_threads () / 2;
+#endif
+        priv->n_slots = MAX (1, priv->n_slots);
+        priv->slots = g_new0 (Slot, priv->n_slots);
+        priv->decoded = g_malloc (priv->n_slots * priv->frame_size);
+
+        /* Longer frames are corrupt, the header must not size allocations */
+        priv->max_length = priv->frame_size;
+
+        for (guint i = 0; i < priv->n_slots; i++) {
+#ifdef HAVE_ZSTD
+            if (priv->compression == COMPRESSION_ZSTD) {
+                priv->slots[i].zstd = ZSTD_createDCtx ();
+                priv->max_length = ZSTD_compressBound (priv->frame_size);
+            }
+#endif
+#ifdef HAVE_LZ4
+            if (priv->compression == COMPRESSION_LZ4) {
+                LZ4F_errorCode_t lz4_error;
+
+                lz4_error = LZ4F_createDecompressionContext (&priv->slots[i].lz4, LZ4F_VERSION);
+
+                if (LZ4F_isError (lz4_error)) {
+                    g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                                 "stdin: could not create LZ4 context: %s", LZ4F_getErrorName (lz4_error));
+                    priv->slots[i].lz4 = NULL;
+                    return;
+                }
+
+                priv->max_length = LZ4F_compressFrameBound (priv->frame_size, NULL);
+            }
+#endif
+        }
+    }
+    else if (priv->compression != COMPRESSION_NONE) {
+        priv->in_capacity = 1 << 20;
+
+#ifdef HAVE_ZSTD
+        if (priv->compression == COMPRESSION_ZSTD) {
+            priv->zstd_stream = ZSTD_createDStream ();
+            ZSTD_initDStream (priv->zstd_stream);
+            priv->in_capacity = ZSTD_DStreamInSize ();
+        }
+#endif
+#ifdef HAVE_LZ4
+        if (priv->compression == COMPRESSION_LZ4) {
+            LZ4F_errorCode_t lz4_error;
+
+            lz4_error = LZ4F_createDecompressionContext (&priv->lz4_stream, LZ4F_VERSION);
+
+            if (LZ4F_isError (lz4_error)) {
+                g_set_error (error, UFO_TASK_ERROR, UFO_TASK_ERROR_SETUP,
+                             "stdin: could not create LZ4 context: %s", LZ4F_getErrorName (lz4_error));
+                priv->lz4_stream = NULL;
+                return;
+            }
+        }
+#endif
+        priv->in = g_malloc (priv->in_capacity);
+    }
+
+    priv->n_decoded = 0;
+    priv->current = 0;
+    priv->corrupt = FALSE;
+    priv->in_size = 0;
+    priv->in_pos = 0;
 }
 
 static void
@@ -94,6 +316,210 @@ ufo_stdin_task_get_mode (UfoTask *task)
     return UFO_TASK_MODE_GENERATOR | UFO_TASK_MODE_CPU;
 }
 
+#ifdef HAVE_LZ4
+static gboolean
+decompress_lz4 (UfoStdinTaskPrivate *priv, Slot *slot, gchar *dst)
+{
+    gsize filled = 0;
+    gsize consumed = 0;
+    gsize result = 1;
+
+    while (result != 0 && consumed < slot->size && filled < priv->frame_size) {
+        gsize dst_size = priv->frame_size - filled;
+        gsize src_size = slot->size - consumed;
+
+        result = LZ4F_decompress (slot->lz4, dst + filled, &dst_size,
+                                  slot->compressed + consumed, &src_size, NULL);
+
+        if (LZ4F_isError (result)) {
+            g_warning ("stdin: %s", LZ4F_getErrorName (result));
+            return FALSE;
+        }
+
+        filled += dst_size;
+        consumed += src_size;
+    }
+
+    /* The frame must end exactly after frame_size bytes */
+    return result == 0 && filled == priv->frame_size;
+}
+#endif
+
+static gboolean
+decompress_slot (UfoStdinTaskPrivate *priv, Slot *slot, gchar *dst)
+{
+#ifdef HAVE_ZSTD
+    if (priv->compression == COMPRESSION_ZSTD) {
+        gsize size;
+
+        size = ZSTD_decompressDCtx (slot->zstd, dst, priv->frame_size, slot->compressed, slot->size);
+
+        if (ZSTD_isError (size)) {
+            g_warning ("stdin: %s", ZSTD_getErrorName (size));
+            return FALSE;
+        }
+
+        return size == priv->frame_size;
+    }
+#endif
+#ifdef HAVE_LZ4
+    if (priv->compression == COMPRESSION_LZ4) {
+        if (decompress_lz4 (priv, slot, dst))
+            return TRUE;
+
+        /* Forget the partial frame, otherwise all following frames fail */
+        LZ4F_resetDecompressionContext (slot->lz4);
+        return FALSE;
+    }
+#endif
+    if (slot->size != priv->frame_size)
+        return FALSE;
+
+    memcpy (dst, slot->compressed, priv->frame_size);
+    return TRUE;
+}
+
+static gboolean
+read_batch (UfoStdinTaskPrivate *priv)
+{
+    guint n_read = 0;
+    guint n_failed = 0;
+
+    for (guint i = 0; i < priv->n_slots && !priv->corrupt; i++) {
+        Slot *slot = &priv->slots[i];
+        guint32 length;
+
+        if (fread (&length, sizeof (guint32), 1, stdin) != 1)
+            break;
+
+        length = GUINT32_FROM_LE (length);
+
+        /* The next header cannot be found after a bogus length */
+        if (length > priv->max_length) {
+            g_warning ("stdin: corrupt frame header of %u bytes, at most %zu expected, stopping",
+                       length, priv->max_length);
+            priv->corrupt = TRUE;
+            break;
+        }
+
+        if (length > slot->capacity) {
+            slot->compressed = g_realloc (slot->compressed, length);
+            slot->capacity = length;
+        }
+
+        if (fread (slot->compressed, length, 1, stdin) != 1) {
+            g_warning ("stdin: truncated frame of %u bytes", length);
+            break;
+        }
+
+        slot->size = length;
+        n_read++;
+    }
+
+    /* One thread per frame read ahead, i.e. at most number-threads */
+#pragma omp parallel for num_threads(MAX (1, n_read)) reduction(+:n_failed)
+    for (gint i = 0; i < (gint) n_read; i++) {
+        priv->slots[i].valid = decompress_slot (priv, &priv->slots[i], priv->decoded + i * priv->frame_size);
+        n_failed += priv->slots[i].valid ? 0 : 1;
+    }
+
+    if (n_failed > 0)
+        g_warning ("stdin: skipping %u frames which do not decompress to %zu bytes", n_failed, priv->frame_size);
+
+    priv->n_decoded = n_read;
+    priv->current = 0;
+
+    return n_read > 0;
+}
+
+static gboolean
+read_decoded (UfoStdinTaskPrivate *priv, gchar *dst)
+{
+    do {
+        while (priv->current < priv->n_decoded) {
+            const guint index = priv->current++;
+
+            if (priv->slots[index].valid) {
+                memcpy (dst, priv->decoded + index * priv->frame_size, priv->frame_size);
+                return TRUE;
+            }
+        }
+    } while (read_batch (priv));
+
+    return FALSE;
+}
+
+static gboolean
+fill_input (UfoStdinTaskPrivate *priv)
+{
+    if (priv->in_pos < priv->in_size)
+        return TRUE;
+
+    priv->in_size = fread (priv->in, 1, priv->in_capacity, stdin);
+    priv->in_pos = 0;
+    return priv->in_size > 0;
+}
+
+static gboolean
+read_stream (UfoStdinTaskPrivate *priv, gchar *dst)
+{
+#ifdef HAVE_ZSTD
+    if (priv->compression == COMPRESSION_ZSTD) {
+        ZSTD_outBuffer out = { dst, priv->frame_size, 0 };
+
+        while (out.pos < out.size) {
+            ZSTD_inBuffer in;
+            gsize result;
+
+            if (!fill_input (priv))
+                return FALSE;
+
+            in.src = priv->in;
+            in.size = priv->in_size;
+            in.pos = priv->in_pos;
+            result = ZSTD_decompressStream (priv->zstd_stream, &out, &in);
+            priv->in_pos = in.pos;
+
+            if (ZSTD_isError (result)) {
+                g_warning ("stdin: %s", ZSTD_getErrorName (result));
+                return FALSE;
+            }
+        }
+
+        return TRUE;
+    }
+#endif
+#ifdef HAVE_LZ4
+    if (priv->compression == COMPRESSION_LZ4) {
+        gsize filled = 0;
+
+        while (filled < priv->frame_size) {
+            gsize dst_size = priv->frame_size - filled;
+            gsize src_size;
+            gsize result;
+
+            if (!fill_input (priv))
+                return FALSE;
+
+            src_size = priv->in_size - priv->in_pos;
+            result = LZ4F_decompress (priv->lz4_stream, dst + filled, &dst_size,
+                                      priv->in + priv->in_pos, &src_size, NULL);
+
+            if (LZ4F_isError (result)) {
+                g_warning ("stdin: %s", LZ4F_getErrorName (result));
+                return FALSE;
+            }
+
+            filled += dst_size;
+            priv->in_pos += src_size;
+        }
+
+        return TRUE;
+    }
+#endif
+    return fread (dst, priv->frame_size, 1, stdin) == 1;
+}
+
 static gboolean
 ufo_stdin_task_generate (UfoTask *task,
                          UfoBuffer *output,
@@ -105,7 +531,11 @@ ufo_stdin_task_generate (UfoTask *task,
 
     priv = UFO_STDIN_TASK_GET_PRIVATE (task);
     data = (gchar *) ufo_buffer_get_host_array (output, NULL);
-    succeeded = fread (data, priv->bytes_per_pixel * priv->width * priv->height, 1, stdin) == 1;
+
+    if (priv->frame_header)
+        succeeded = read_decoded (priv, data);
+    else
+        succeeded = read_stream (priv, data);
 
     if (succeeded && priv->convert && priv->bitdepth != UFO_BUFFER_DEPTH_32F)
         ufo_buffer_convert (output, priv->bitdepth);
@@ -149,6 +579,15 @@ ufo_stdin_task_set_property (GObject *object,
         case PROP_CONVERT:
             priv->convert = g_value_get_boolean (value);
             break;
+        case PROP_COMPRESSION:
+            priv->compression = g_value_get_enum (value);
+            break;
+        case PROP_FRAME_HEADER:
+            priv->frame_header = g_value_get_boolean (value);
+            break;
+        case PROP_NUM_THREADS:
+            priv->num_threads = g_value_get_uint (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -176,6 +615,15 @@ ufo_stdin_task_get_property (GObject *object,
         case PROP_CONVERT:
             g_value_set_boolean (value, priv->convert);
             break;
+        case PROP_COMPRESSION:
+            g_value_set_enum (value, priv->compression);
+            break;
+        case PROP_FRAME_HEADER:
+            g_value_set_boolean (value, priv->frame_header);
+            break;
+        case PROP_NUM_THREADS:
+            g_value_set_uint (value, priv->num_threads);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -185,6 +633,8 @@ ufo_stdin_task_get_property (GObject *object,
 static void
 ufo_stdin_task_finalize (GObject *object)
 {
+    free_decompression_state (UFO_STDIN_TASK_GET_PRIVATE (object));
+
     G_OBJECT_CLASS (ufo_stdin_task_parent_class)->finalize (object);
 }
 
@@ -236,6 +686,28 @@ ufo_stdin_task_class_init (UfoStdinTaskClass *klass)
             TRUE,
             G_PARAM_READWRITE);
 
+    properties[PROP_COMPRESSION] =
+        g_param_spec_enum ("compression",
+            "Compression of input frames (none, lz4, zstd)",
+            "Compression of input frames (none, lz4, zstd)",
+            g_enum_register_static ("stdin-compression", compression_values),
+            COMPRESSION_NONE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_FRAME_HEADER] =
+        g_param_spec_boolean ("frame-header",
+            "Frames are prefixed with a 32 bit little endian length",
+            "Frames are prefixed with a 32 bit little endian length, which enables parallel decompression",
+            FALSE,
+            G_PARAM_READWRITE);
+
+    properties[PROP_NUM_THREADS] =
+        g_param_spec_uint ("number-threads",
+            "Number of frames decompressed in parallel by as many threads, 0 uses half of the cores",
+            "Number of frames decompressed in parallel by as many threads, 0 uses half of the cores",
+            0, G_MAXUINT, 0,
+            G_PARAM_READWRITE);
+
     for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (oclass, i, properties[i]);
 
@@ -249,5 +721,19 @@ ufo_stdin_task_init(UfoStdinTask *self)
     self->priv->width = 0;
     self->priv->height = 0;
     self->priv->bitdepth = UFO_BUFFER_DEPTH_32F;
+    self->priv->bytes_per_pixel = 4;
     self->priv->convert = TRUE;
+    self->priv->compression = COMPRESSION_NONE;
+    self->priv->frame_header = FALSE;
+    self->priv->num_threads = 0;
+    self->priv->slots = NULL;
+    self->priv->n_slots = 0;
+    self->priv->decoded = NULL;
+    self->priv->in = NULL;
+#ifdef HAVE_ZSTD
+    self->priv->zstd_stream = NULL;
+#endif
+#ifdef HAVE_LZ4
+    self->priv->lz4_stream = NULL;
+#endif
 }
@@ -24,8 +24,8 @@
 #endif
 
 #include <stdio.h>
-#include <math.h>
 #include "ufo-zeropad-task.h"
+#include "common/ufo-fft.h"
 
 /**
  * SECTION:ufo-zeropad-task
@@ -42,6 +42,7 @@ struct _UfoZeropadTaskPrivate {
     cl_kernel zeropad_kernel;
     guint oversampling;
     gfloat center_rot;
+    gboolean smooth;
 };
 
 static void ufo_task_interface_init (UfoTaskIface *iface);
@@ -56,6 +57,7 @@ enum {
     PROP_0,
     PROP_OVERSAMPLING,
     PROP_CENTER_ROT,
+    PROP_SMOOTH_PADDING,
     N_PROPERTIES
 };
 
@@ -89,7 +91,10 @@ ufo_zeropad_task_get_requisition (UfoTask *task,
     ufo_buffer_get_requisition (inputs[0], &input_requisition);
 
     requisition->n_dims = input_requisition.n_dims;
-    requisition->dims[0] = (gsize)(2 * pow(2, ceil(log2f((gfloat)input_requisition.dims[0]))) * priv->oversampling);
+    if (priv->smooth)
+        requisition->dims[0] = 2 * ufo_fft_get_padded_size (input_requisition.dims[0] * priv->oversampling, TRUE);
+    else
+        requisition->dims[0] = 2 * ufo_fft_get_padded_size (input_requisition.dims[0], FALSE) * priv->oversampling;
     requisition->dims[1] = input_requisition.dims[1];
 }
 
@@ -168,6 +173,9 @@ ufo_zeropad_task_set_property (GObject *object,
         case PROP_CENTER_ROT:
             priv->center_rot = g_value_get_float (value);
             break;
+        case PROP_SMOOTH_PADDING:
+            priv->smooth = g_value_get_boolean (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -189,6 +197,9 @@ ufo_zeropad_task_get_property (GObject *object,
         case PROP_CENTER_ROT:
             g_value_set_float (value, priv->center_rot);
             break;
+        case PROP_SMOOTH_PADDING:
+            g_value_set_boolean (value, priv->smooth);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
             break;
@@ -235,6 +246,13 @@ ufo_zeropad_task_class_init (UfoZeropadTaskClass *klass)
             -1, G_MAXFLOAT, -1,
             G_PARAM_READWRITE);
 
+    properties[PROP_SMOOTH_PADDING] =
+        g_param_spec_boolean ("smooth-padding",
+            "Pad to the next size with prime factors 2, 3, 5 and 7",
+            "Pad to the next size with prime factors 2, 3, 5 and 7 instead of the next power of 2, requires clFFT",
+            FALSE,
+            G_PARAM_READWRITE);
+
     for (guint i = PROP_0 + 1; i < N_PROPERTIES; i++)
         g_object_class_install_property (gobject_class, i, properties[i]);
 
@@ -247,4 +265,5 @@ ufo_zeropad_task_init(UfoZeropadTask *self)
     self->priv = UFO_ZEROPAD_TASK_GET_PRIVATE(self);
     self->priv->oversampling = 1;
     self->priv->center_rot = -1;
+    self->priv->smooth = FALSE;
 }
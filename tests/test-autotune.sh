@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# Autotuned backproject and general-backproject must reconstruct the same
+# slices as the untuned filters. The first run writes the tuning cache, the
+# second one must take its parameters from there without rewriting it.
+
+export XDG_CACHE_HOME=$(mktemp -d)
+trap "rm -rf $XDG_CACHE_HOME" EXIT
+CACHE=$XDG_CACHE_HOME/ufo/kernel-tuning.ini
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(128) - 63.5
+t = numpy.arange(96) * numpy.pi / 96
+c = 20 * numpy.cos(t)[:, numpy.newaxis]
+p = 2 * numpy.sqrt(numpy.clip(30 ** 2 - (s - c) ** 2, 0, None))
+z = 1 + 0.1 * numpy.arange(4)[:, numpy.newaxis]
+tifffile.imsave('autotune-sinogram.tif', p.astype(numpy.float32))
+tifffile.imsave('autotune-projections.tif', (p[:, numpy.newaxis, :] * z).astype(numpy.float32))
+"
+
+BP="backproject axis-pos=63.5"
+GBP="general-backproject center-position-x=63.5 center-position-z=2 num-projections=96 region=-2,2,1"
+
+reconstruct () {
+    ufo-launch -q read path=autotune-sinogram.tif ! $BP $1 ! \
+        write filename=autotune-bp-$2.tif || exit 1
+    ufo-launch -q read path=autotune-projections.tif ! $GBP $1 ! \
+        write filename=autotune-gbp-$2.tif || exit 1
+}
+
+reconstruct "" untuned
+[ ! -e $CACHE ] || exit 1
+
+reconstruct autotune=true tuned
+grep -q "^\[backproject@" $CACHE && grep -q "^\[general-backproject@" $CACHE || exit 1
+STAMP=$(stat -c %y $CACHE)
+cp $CACHE autotune-cache.ini
+
+reconstruct autotune=true cached
+[ "$(stat -c %y $CACHE)" == "$STAMP" ] && cmp -s $CACHE autotune-cache.ini || exit 1
+
+python -c "
+import sys, numpy, tifffile
+ok = True
+for name in ('bp', 'gbp'):
+    ref = tifffile.imread('autotune-%s-untuned.tif' % name)
+    for run in ('tuned', 'cached'):
+        result = tifffile.imread('autotune-%s-%s.tif' % (name, run))
+        ok = ok and result.shape == ref.shape and numpy.allclose(result, ref, atol=1e-5 * numpy.abs(ref).max())
+sys.exit(int(not ok))
+"
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+# Reconstructing a stack of sinograms in one launch must give the same slices
+# as reconstructing every sinogram on its own. The region of interest is
+# narrower than the sinograms, so that the sinograms must be addressed by their
+# own width rather than by the slice width.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(64) + 0.5 - 32
+t = numpy.arange(96) * numpy.pi / 96
+sinograms = []
+for i in range(3):
+    c = (4 + 4 * i) * numpy.cos(t)[:, numpy.newaxis]
+    sinograms.append(2 * numpy.sqrt(numpy.clip((10 + 2 * i) ** 2 - (s - c) ** 2, 0, None)))
+tifffile.imsave('bp-stack-sinograms.tif', numpy.array(sinograms, dtype=numpy.float32))
+"
+
+for mode in nearest texture; do
+    ufo-launch -q read path=bp-stack-sinograms.tif ! \
+        backproject axis-pos=32 mode=$mode roi-x=8 roi-y=8 roi-width=48 roi-height=48 ! \
+        write filename=bp-stack-single-$mode.tif || exit 1
+
+    ufo-launch -q read path=bp-stack-sinograms.tif ! stack number=3 ! \
+        backproject axis-pos=32 mode=$mode roi-x=8 roi-y=8 roi-width=48 roi-height=48 ! \
+        write filename=bp-stack-stacked-$mode.tif || exit 1
+done
+
+python -c "
+import sys, numpy, tifffile
+for mode in ('nearest', 'texture'):
+    ref = tifffile.imread('bp-stack-single-%s.tif' % mode)
+    result = tifffile.imread('bp-stack-stacked-%s.tif' % mode).reshape(ref.shape)
+    error = numpy.abs(result - ref).max() / numpy.abs(ref).max()
+    print('%s: max. relative error %g' % (mode, error))
+    if ref.shape != (3, 48, 48) or error > 1e-5:
+        sys.exit(1)
+"
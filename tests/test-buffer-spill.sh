@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Buffering more than memory-limit spills pages to a scratch file. 64 frames of
+# 128 x 128 floats, i.e. 4 MB, are buffered with a limit of 1 MB and replayed
+# as they are, with every frame duplicated and with the whole stream looped
+# twice. All outputs must equal the accordingly repeated input.
+
+python -c "
+import numpy, tifffile
+numpy.random.seed(30)
+tifffile.imsave('buffer-spill-input.tif', numpy.random.random((64, 128, 128)).astype(numpy.float32))
+"
+
+ufo-launch -q read path=buffer-spill-input.tif ! \
+    buffer memory-limit=1 spill-path=. ! \
+    write filename=buffer-spill-plain.tif || exit 1
+
+ufo-launch -q read path=buffer-spill-input.tif ! \
+    buffer memory-limit=1 spill-path=. dup-count=2 ! \
+    write filename=buffer-spill-dup.tif || exit 1
+
+ufo-launch -q read path=buffer-spill-input.tif ! \
+    buffer memory-limit=1 spill-path=. dup-count=2 loop=true ! \
+    write filename=buffer-spill-loop.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+data = tifffile.imread('buffer-spill-input.tif')
+refs = (('plain', data), ('dup', numpy.repeat(data, 2, axis=0)), ('loop', numpy.concatenate((data, data))))
+failed = False
+for name, ref in refs:
+    result = tifffile.imread('buffer-spill-%s.tif' % name)
+    equal = result.shape == ref.shape and (result == ref).all()
+    print('%s: %s' % (name, 'ok' if equal else 'mismatch'))
+    failed |= not equal
+sys.exit(int(failed))
+"
@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# Slow consumer behind a buffered mock camera must still receive all frames
+ufo-launch -q camera name=mock number=20 ring-size=4 properties="roi-width=128 roi-height=64" ! sleep time=0.05 ! write filename=camera-ring-check.tif || exit 1
+
+python -c "import sys; import tifffile; a = tifffile.imread('camera-ring-check.tif'); sys.exit(int(a.shape != (20, 64, 128)))" || exit 1
+
+# A much slower consumer overflows the ring, every grabbed frame must be either
+# delivered or accounted as dropped
+python -c "
+import sys
+from gi.repository import Ufo
+
+pm = Ufo.PluginManager()
+camera = pm.get_task('camera')
+sleep = pm.get_task('sleep')
+sink = pm.get_task('null')
+camera.set_properties(name='mock', number=6, ring_size=2, properties='roi-width=128 roi-height=64')
+sleep.set_properties(time=0.5)
+
+graph = Ufo.TaskGraph()
+graph.connect_nodes(camera, sleep)
+graph.connect_nodes(sleep, sink)
+Ufo.Scheduler().run(graph)
+
+grabbed = camera.get_property('grabbed-frames')
+dropped = camera.get_property('dropped-frames')
+fill_level = camera.get_property('max-fill-level')
+sys.exit(int(dropped == 0 or grabbed != 6 + dropped or fill_level != 2))
+"
@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Accuracy check of dfi-gridding on the sinogram of an off-center disk of unit
+# density. The reconstruction must be close to one inside and close to zero
+# outside of the disk, away from its edge.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(64) + 0.5 - 32
+t = numpy.arange(96) * numpy.pi / 96
+c = 6 * numpy.cos(t)[:, numpy.newaxis] - 4 * numpy.sin(t)[:, numpy.newaxis]
+p = 2 * numpy.sqrt(numpy.clip(16 ** 2 - (s - c) ** 2, 0, None))
+tifffile.imsave('dfi-sinogram.tif', p.astype(numpy.float32))
+"
+
+ufo-launch -q read path=dfi-sinogram.tif ! dfi-gridding axis-pos=32 ! write filename=dfi-slice.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+slice = tifffile.imread('dfi-slice.tif')
+y, x = numpy.mgrid[:64, :64] + 0.5 - 32
+r = numpy.hypot(x - 6, y + 4)
+inner = slice[r < 14].mean()
+outer = numpy.abs(slice[(r > 18) & (numpy.hypot(x, y) < 30)]).mean()
+print('inner mean %g, outer mean %g' % (inner, outer))
+if abs(inner - 1) > 0.03 or outer > 0.05:
+    sys.exit(1)
+"
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+# The projection at 180 degrees is the projection at 0 degrees mirrored about
+# the rotation axis. A synthetic projection of three gaussians is sampled at
+# pixel centers x + 0.5 for an axis which moves by 0.05 pixels per row from
+# 60.3 on, i.e. with the edge pixel convention center = 0.5 (s + width) of
+# estimate-center. The estimates of rows 4, 6, ..., 22 selected with y, height
+# and y-step and their mean in the center property must be within 0.1 pixels.
+
+python -c "
+import numpy, tifffile
+x = numpy.arange(128) + 0.5
+centers = 60.3 + 0.05 * numpy.arange(32)
+
+def profile(u):
+    return (numpy.exp(-(u + 9) ** 2 / 18.0) + 0.5 * numpy.exp(-(u - 4) ** 2 / 8.0) +
+            0.8 * numpy.exp(-(u - 17) ** 2 / 32.0))
+
+tifffile.imsave('estimate-center-0.tif', numpy.array([profile(x - c) for c in centers], dtype=numpy.float32))
+tifffile.imsave('estimate-center-180.tif', numpy.array([profile(c - x) for c in centers], dtype=numpy.float32))
+"
+
+python -c "
+import sys, numpy, tifffile
+from gi.repository import Ufo
+
+pm = Ufo.PluginManager()
+read_0 = pm.get_task('read')
+read_180 = pm.get_task('read')
+estimate = pm.get_task('estimate-center')
+write = pm.get_task('write')
+read_0.set_properties(path='estimate-center-0.tif')
+read_180.set_properties(path='estimate-center-180.tif')
+estimate.set_properties(y=4, height=20, y_step=2)
+write.set_properties(filename='estimate-center-result.tif')
+
+graph = Ufo.TaskGraph()
+graph.connect_nodes_full(read_0, estimate, 0)
+graph.connect_nodes_full(read_180, estimate, 1)
+graph.connect_nodes(estimate, write)
+Ufo.Scheduler().run(graph)
+
+ref = 60.3 + 0.05 * numpy.arange(4, 24, 2)
+centers = tifffile.imread('estimate-center-result.tif').ravel()
+center = estimate.get_property('center')
+print('max. row error %g, center error %g' % (numpy.abs(centers - ref).max(), abs(center - ref.mean())))
+sys.exit(int(centers.shape != ref.shape or numpy.abs(centers - ref).max() > 0.1 or abs(center - ref.mean()) > 0.1))
+"
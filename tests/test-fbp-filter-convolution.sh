@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Direct convolution in fbp-filter must give the same result as filtering in
+# Fourier space. Two 96 pixel wide sinograms are filtered with the default
+# convolution-width of 512, which convolves in real space, and with
+# convolution-width=0, which forces the FFT path. The maximum deviation must
+# stay below 0.01 % of the maximum of the FFT result.
+
+python -c "
+import numpy, tifffile
+numpy.random.seed(49)
+tifffile.imsave('fbp-filter-convolution-sinograms.tif', numpy.random.random((2, 64, 96)).astype(numpy.float32))
+"
+
+for filter in ramp-fromreal shepp-logan; do
+    ufo-launch -q read path=fbp-filter-convolution-sinograms.tif ! \
+        fbp-filter filter=$filter ! \
+        write filename=fbp-filter-convolution-direct-$filter.tif || exit 1
+
+    ufo-launch -q read path=fbp-filter-convolution-sinograms.tif ! \
+        fbp-filter filter=$filter convolution-width=0 ! \
+        write filename=fbp-filter-convolution-fft-$filter.tif || exit 1
+done
+
+python -c "
+import sys, numpy, tifffile
+failed = False
+for name in ('ramp-fromreal', 'shepp-logan'):
+    ref = tifffile.imread('fbp-filter-convolution-fft-%s.tif' % name)
+    result = tifffile.imread('fbp-filter-convolution-direct-%s.tif' % name)
+    error = numpy.abs(result - ref).max() / numpy.abs(ref).max()
+    print('%s: max. relative error %g' % (name, error))
+    failed |= result.shape != (2, 64, 96) or error > 1e-4
+sys.exit(int(failed))
+"
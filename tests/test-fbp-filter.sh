@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# fbp-filter must give the same result as the explicit chain of zeropad, fft,
+# filter, ifft and crop. The 96 pixel wide sinogram is padded to 256 by both.
+# With center-of-rotation=0, zeropad puts each row at the right end of the
+# padded row, so that the filtered row is cropped from x=160. Direct
+# convolution is disabled to test the Fourier path. The maximum deviation must
+# stay below 0.01 % of the maximum of the chain.
+
+python -c "
+import numpy, tifffile
+numpy.random.seed(46)
+tifffile.imsave('fbp-filter-sinogram.tif', numpy.random.random((64, 96)).astype(numpy.float32))
+"
+
+for filter in ramp-fromreal shepp-logan butterworth; do
+    ufo-launch -q read path=fbp-filter-sinogram.tif ! \
+        zeropad oversampling=2 center-of-rotation=0 ! \
+        fft auto-zeropadding=false ! \
+        filter filter=$filter ! \
+        ifft ! \
+        crop x=160 width=96 ! \
+        write filename=fbp-filter-chain-$filter.tif || exit 1
+
+    ufo-launch -q read path=fbp-filter-sinogram.tif ! \
+        fbp-filter filter=$filter convolution-width=0 ! \
+        write filename=fbp-filter-fused-$filter.tif || exit 1
+done
+
+python -c "
+import sys, numpy, tifffile
+for name in ('ramp-fromreal', 'shepp-logan', 'butterworth'):
+    ref = tifffile.imread('fbp-filter-chain-%s.tif' % name)
+    result = tifffile.imread('fbp-filter-fused-%s.tif' % name)
+    error = numpy.abs(result - ref).max() / numpy.abs(ref).max()
+    print('%s: max. relative error %g' % (name, error))
+    if result.shape != (64, 96) or error > 1e-4:
+        sys.exit(1)
+"
@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# FFTs on an OpenCL CPU device are computed by FFTW on the mapped buffers. The
+# spectra of complex and real-to-complex transforms must match numpy and the
+# round trips through ifft must restore the input, in 1D on a stack of rows and
+# in 2D. The test is skipped if clinfo finds no CPU device.
+
+if command -v clinfo > /dev/null && ! clinfo --raw | grep -q CL_DEVICE_TYPE_CPU; then
+    echo "No OpenCL CPU device, skipping"
+    exit 0
+fi
+
+export UFO_DEVICE_TYPE=cpu
+
+python -c "
+import numpy, tifffile
+numpy.random.seed(47)
+tifffile.imsave('fft-cpu-input.tif', numpy.random.random((32, 64)).astype(numpy.float32))
+"
+
+for hermitian in false true; do
+    for dimensions in 1 2; do
+        name=fft-cpu-$dimensions-$hermitian
+
+        ufo-launch -q read path=fft-cpu-input.tif ! \
+            fft dimensions=$dimensions hermitian=$hermitian ! \
+            write filename=$name-spectrum.tif || exit 1
+
+        ufo-launch -q read path=fft-cpu-input.tif ! \
+            fft dimensions=$dimensions hermitian=$hermitian ! \
+            ifft dimensions=$dimensions hermitian=$hermitian ! \
+            write filename=$name-output.tif || exit 1
+    done
+done
+
+python -c "
+import sys, numpy, tifffile
+data = tifffile.imread('fft-cpu-input.tif')
+failed = False
+
+for hermitian in ('false', 'true'):
+    for dimensions in (1, 2):
+        name = 'fft-cpu-%d-%s' % (dimensions, hermitian)
+        transform = numpy.fft.rfftn if hermitian == 'true' else numpy.fft.fftn
+        ref = transform(data.astype(numpy.float64), axes=(1,) if dimensions == 1 else (0, 1))
+        ref = numpy.stack((ref.real, ref.imag), axis=-1).reshape(32, -1)
+        spectrum_error = numpy.abs(tifffile.imread(name + '-spectrum.tif') - ref).max() / numpy.abs(ref).max()
+        output_error = numpy.abs(tifffile.imread(name + '-output.tif') - data).max()
+        print('%s: spectrum error %g, round trip error %g' % (name, spectrum_error, output_error))
+        failed |= spectrum_error > 1e-5 or output_error > 1e-5
+
+sys.exit(int(failed))
+"
@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# Real-to-complex transforms with fft hermitian=true. The half spectrum of a
+# stack of random rows must match numpy.fft.rfft with interleaved real and
+# imaginary parts and the round trip through ifft hermitian=true must restore
+# the input. The 100 pixel wide rows are padded to 128 and cropped again. The
+# frequency filters must refuse half spectra instead of misinterpreting them.
+
+python -c "
+import numpy, tifffile
+numpy.random.seed(43)
+tifffile.imsave('fft-hermitian-input.tif', numpy.random.random((16, 128)).astype(numpy.float32))
+tifffile.imsave('fft-hermitian-padded.tif', numpy.random.random((16, 100)).astype(numpy.float32))
+"
+
+ufo-launch -q read path=fft-hermitian-input.tif ! \
+    fft hermitian=true ! \
+    write filename=fft-hermitian-spectrum.tif || exit 1
+
+ufo-launch -q read path=fft-hermitian-input.tif ! \
+    fft hermitian=true ! \
+    ifft hermitian=true ! \
+    write filename=fft-hermitian-output.tif || exit 1
+
+ufo-launch -q read path=fft-hermitian-padded.tif ! \
+    fft hermitian=true ! \
+    ifft hermitian=true crop-width=100 ! \
+    write filename=fft-hermitian-padded-output.tif || exit 1
+
+if ufo-launch -q read path=fft-hermitian-input.tif ! fft hermitian=true ! filter ! null 2>/dev/null; then
+    exit 1
+fi
+
+python -c "
+import sys, numpy, tifffile
+data = tifffile.imread('fft-hermitian-input.tif')
+spectrum = tifffile.imread('fft-hermitian-spectrum.tif')
+ref = numpy.fft.rfft(data.astype(numpy.float64), axis=1)
+ref = numpy.stack((ref.real, ref.imag), axis=-1).reshape(16, -1)
+errors = (
+    ('spectrum', numpy.abs(spectrum - ref).max() / numpy.abs(ref).max()),
+    ('round trip', numpy.abs(tifffile.imread('fft-hermitian-output.tif') - data).max()),
+    ('padded round trip', numpy.abs(tifffile.imread('fft-hermitian-padded-output.tif') -
+                                    tifffile.imread('fft-hermitian-padded.tif')).max()),
+)
+for name, error in errors:
+    print('%s: max. error %g' % (name, error))
+if spectrum.shape != (16, 130) or max(error for name, error in errors) > 1e-5:
+    sys.exit(1)
+"
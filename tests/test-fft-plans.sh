@@ -0,0 +1,63 @@
+#!/bin/bash
+
+# FFT plans are shared between tasks with the same transform and kept around
+# when a task switches to another size. Two fft ! ifft branches with the same
+# shape run concurrently in one graph and share a plan, both must restore
+# their own input. A stream of frames with twelve different heights, i.e. batch
+# sizes, is then transformed twice in a row, so that plans are reused from the
+# cache and more than the maximum number of unused plans are evicted.
+
+rm -rf fft-plans-frames fft-plans-output
+mkdir -p fft-plans-frames fft-plans-output
+
+python -c "
+import numpy, tifffile
+numpy.random.seed(44)
+tifffile.imsave('fft-plans-a.tif', numpy.random.random((16, 32, 64)).astype(numpy.float32))
+tifffile.imsave('fft-plans-b.tif', numpy.random.random((16, 32, 64)).astype(numpy.float32))
+for i in range(24):
+    height = i % 12 + 1
+    tifffile.imsave('fft-plans-frames/frame-%02i.tif' % i, numpy.random.random((height, 64)).astype(numpy.float32))
+"
+
+python -c "
+from gi.repository import Ufo
+
+pm = Ufo.PluginManager()
+graph = Ufo.TaskGraph()
+
+for name in ('a', 'b'):
+    read = pm.get_task('read')
+    fft = pm.get_task('fft')
+    ifft = pm.get_task('ifft')
+    write = pm.get_task('write')
+    read.set_properties(path='fft-plans-%s.tif' % name)
+    write.set_properties(filename='fft-plans-%s-output.tif' % name)
+    graph.connect_nodes(read, fft)
+    graph.connect_nodes(fft, ifft)
+    graph.connect_nodes(ifft, write)
+
+Ufo.Scheduler().run(graph)
+" || exit 1
+
+ufo-launch -q read path=fft-plans-frames/frame-*.tif ! \
+    fft ! \
+    ifft ! \
+    write filename=fft-plans-output/frame-%02i.tif || exit 1
+
+python -c "
+import sys, glob, numpy, tifffile
+errors = [numpy.abs(tifffile.imread('fft-plans-%s-output.tif' % name) - tifffile.imread('fft-plans-%s.tif' % name)).max()
+          for name in ('a', 'b')]
+inputs = sorted(glob.glob('fft-plans-frames/*.tif'))
+outputs = sorted(glob.glob('fft-plans-output/*.tif'))
+
+if len(inputs) != len(outputs):
+    sys.exit(1)
+
+for i, o in zip(inputs, outputs):
+    errors.append(numpy.abs(tifffile.imread(o).reshape(-1, 64) - tifffile.imread(i).reshape(-1, 64)).max())
+
+print('max. error %g' % max(errors))
+sys.exit(int(max(errors) > 1e-5))
+"
@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Filtering rows padded to smooth sizes must match numpy. Rows of 1280 pixels
+# oversampled twice give an even transform size of 2560, rows of 1201 pixels
+# give an odd size of 1215 which also covers the mirrored negative frequencies
+# of the filter. The reference pads the rows like zeropad, i.e. wrapped around
+# index 0, and takes the transform size from the output, so that it also holds
+# with oclFFT which pads to powers of two instead.
+
+python -c "
+import numpy, tifffile
+numpy.random.seed(45)
+tifffile.imsave('fft-smooth-even.tif', numpy.random.random((8, 1280)).astype(numpy.float32))
+tifffile.imsave('fft-smooth-odd.tif', numpy.random.random((8, 1201)).astype(numpy.float32))
+"
+
+ufo-launch -q read path=fft-smooth-even.tif ! \
+    zeropad oversampling=2 smooth-padding=true ! \
+    fft auto-zeropadding=false smooth-padding=true ! \
+    filter filter=ramp ! \
+    ifft ! \
+    write filename=fft-smooth-even-output.tif || exit 1
+
+ufo-launch -q read path=fft-smooth-odd.tif ! \
+    zeropad smooth-padding=true ! \
+    fft auto-zeropadding=false smooth-padding=true ! \
+    filter filter=ramp ! \
+    ifft ! \
+    write filename=fft-smooth-odd-output.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+for name in ('even', 'odd'):
+    data = tifffile.imread('fft-smooth-%s.tif' % name).astype(numpy.float64)
+    result = tifffile.imread('fft-smooth-%s-output.tif' % name)
+    n, width = result.shape[1], data.shape[1]
+    index = (numpy.arange(n) - (n - width // 2)) % n
+    padded = numpy.where(index < width, data[:, numpy.minimum(index, width - 1)], 0)
+    k = numpy.arange(n)
+    ramp = numpy.minimum(k, n - k) / float(n)
+    ramp[0] = 0.25 / n
+    ref = numpy.fft.ifft(numpy.fft.fft(padded, axis=1) * ramp, axis=1).real
+    error = numpy.abs(result - ref).max() / numpy.abs(ref).max()
+    print('%s: size %d, max. relative error %g' % (name, n, error))
+    if result.shape[0] != 8 or error > 1e-4:
+        sys.exit(1)
+"
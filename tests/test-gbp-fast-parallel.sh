@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# The separable parallel beam kernel of general-backproject must reconstruct
+# the same slices as the general kernel. Per-projection center positions with
+# all the same value select the general, vectorized kernel for the reference.
+# The 48 slices are split over several work groups along z.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(64) - 31.5
+t = numpy.arange(96) * numpy.pi / 96
+c = 8 * numpy.cos(t)[:, numpy.newaxis]
+p = 2 * numpy.sqrt(numpy.clip(16 ** 2 - (s - c) ** 2, 0, None))
+z = 1 + 0.02 * numpy.arange(48)[:, numpy.newaxis]
+tifffile.imsave('gbp-fast-projections.tif', (p[:, numpy.newaxis, :] * z).astype(numpy.float32))
+"
+
+CENTERS=$(python -c "print(','.join(['31.5'] * 96))")
+
+ufo-launch -q read path=gbp-fast-projections.tif ! \
+    general-backproject center-position-x=31.5 center-position-z=24 num-projections=96 region=-24,24,1 ! \
+    write filename=gbp-fast-parallel.tif || exit 1
+
+ufo-launch -q read path=gbp-fast-projections.tif ! \
+    general-backproject center-position-x=$CENTERS center-position-z=24 num-projections=96 region=-24,24,1 ! \
+    write filename=gbp-fast-general.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+ref = tifffile.imread('gbp-fast-general.tif')
+result = tifffile.imread('gbp-fast-parallel.tif')
+error = numpy.abs(result - ref).max() / numpy.abs(ref).max()
+print('max. relative error %g' % error)
+if result.shape != (48, 64, 64) or error > 1e-4:
+    sys.exit(1)
+"
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# Distributing the volume over all devices must give the single-device
+# reconstruction. This also holds with only one device, which still goes
+# through the staged asynchronous uploads. 70 projections in bursts of 16 give
+# four full bursts and a remainder of six.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(128) - 63.5
+t = numpy.arange(70) * numpy.pi / 70
+c = 20 * numpy.cos(t)[:, numpy.newaxis]
+p = 2 * numpy.sqrt(numpy.clip(30 ** 2 - (s - c) ** 2, 0, None))
+z = 1 + 0.1 * numpy.arange(16)[:, numpy.newaxis]
+tifffile.imsave('gbp-multi-device-projections.tif', (p[:, numpy.newaxis, :] * z).astype(numpy.float32))
+"
+
+GBP="general-backproject center-position-x=63.5 center-position-z=8 num-projections=70 region=-8,8,1 burst=16"
+
+ufo-launch -q read path=gbp-multi-device-projections.tif ! $GBP ! \
+    write filename=gbp-multi-device-single.tif || exit 1
+
+ufo-launch -q read path=gbp-multi-device-projections.tif ! $GBP multi-device=true ! \
+    write filename=gbp-multi-device-multi.tif || exit 1
+
+ufo-launch -q read path=gbp-multi-device-projections.tif ! $GBP multi-device=true overlap=true ! \
+    write filename=gbp-multi-device-overlap.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+ref = tifffile.imread('gbp-multi-device-single.tif')
+ok = ref.shape == (16, 128, 128)
+for name in ('gbp-multi-device-multi.tif', 'gbp-multi-device-overlap.tif'):
+    result = tifffile.imread(name)
+    ok = ok and result.shape == ref.shape and numpy.allclose(result, ref, atol=1e-5 * numpy.abs(ref).max())
+sys.exit(int(not ok))
+"
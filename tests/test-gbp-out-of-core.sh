@@ -0,0 +1,31 @@
+#!/bin/bash
+
+# Out-of-core reconstruction of general-backproject must equal the in-core
+# one. 16 slices of 256 x 256 pixels need 4 MB, a memory budget of 1 MB forces
+# at least five passes over the cached projections.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(256) - 127.5
+t = numpy.arange(64) * numpy.pi / 64
+c = 40 * numpy.cos(t)[:, numpy.newaxis]
+p = 2 * numpy.sqrt(numpy.clip(60 ** 2 - (s - c) ** 2, 0, None))
+z = 1 + 0.1 * numpy.arange(16)[:, numpy.newaxis]
+tifffile.imsave('gbp-ooc-projections.tif', (p[:, numpy.newaxis, :] * z).astype(numpy.float32))
+"
+
+ufo-launch -q read path=gbp-ooc-projections.tif ! \
+    general-backproject center-position-x=127.5 center-position-z=8 num-projections=64 region=-8,8,1 ! \
+    write filename=gbp-ooc-in-core.tif || exit 1
+
+ufo-launch -q read path=gbp-ooc-projections.tif ! \
+    general-backproject center-position-x=127.5 center-position-z=8 num-projections=64 region=-8,8,1 \
+        out-of-core=true memory-budget=1 ! \
+    write filename=gbp-ooc-out-of-core.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+ref = tifffile.imread('gbp-ooc-in-core.tif')
+result = tifffile.imread('gbp-ooc-out-of-core.tif')
+sys.exit(int(ref.shape != (16, 256, 256) or result.shape != ref.shape or not numpy.allclose(result, ref, atol=1e-5 * numpy.abs(ref).max())))
+"
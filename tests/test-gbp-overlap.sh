@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# Double-buffered uploads in general-backproject must not change the
+# reconstruction, neither with a separate upload queue nor without one. 70
+# projections in bursts of 16 give four full bursts and a remainder of six.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(128) - 63.5
+t = numpy.arange(70) * numpy.pi / 70
+c = 20 * numpy.cos(t)[:, numpy.newaxis]
+p = 2 * numpy.sqrt(numpy.clip(30 ** 2 - (s - c) ** 2, 0, None))
+z = 1 + 0.1 * numpy.arange(8)[:, numpy.newaxis]
+tifffile.imsave('gbp-overlap-projections.tif', (p[:, numpy.newaxis, :] * z).astype(numpy.float32))
+"
+
+GBP="general-backproject center-position-x=63.5 center-position-z=4 num-projections=70 region=-4,4,1 burst=16"
+
+ufo-launch -q read path=gbp-overlap-projections.tif ! $GBP ! \
+    write filename=gbp-overlap-default.tif || exit 1
+
+ufo-launch -q read path=gbp-overlap-projections.tif ! $GBP overlap=true ! \
+    write filename=gbp-overlap-queue.tif || exit 1
+
+ufo-launch -q read path=gbp-overlap-projections.tif ! $GBP overlap=true upload-queue=false ! \
+    write filename=gbp-overlap-no-queue.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+ref = tifffile.imread('gbp-overlap-default.tif')
+ok = ref.shape == (8, 128, 128)
+for name in ('gbp-overlap-queue.tif', 'gbp-overlap-no-queue.tif'):
+    result = tifffile.imread(name)
+    ok = ok and result.shape == ref.shape and numpy.allclose(result, ref, atol=1e-5 * numpy.abs(ref).max())
+sys.exit(int(not ok))
+"
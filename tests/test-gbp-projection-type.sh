@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Accuracy check of the reduced projection types of general-backproject
+# against the float path. The projections of a centered disk (at most 40 in
+# value) are backprojected with float, half and unorm16 textures. The maximum
+# deviation from the float reconstruction must stay below 0.1 % of its maximum,
+# i.e. well within the resolution of half floats (11 bit mantissa) and of the
+# 16 bit quantization of the value range given by projection-scale.
+#
+# The second run shifts the disk by -5, so that the detector contains negative
+# values, and stores it with projection-offset=-10. The corners of the slice
+# project outside of the detector, where the samples must stay 0 like with
+# float textures instead of turning into the offset. The value range is 1.5
+# times larger, hence the tolerance is relaxed to 0.2 %.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(64) - 31.5
+p = 2 * numpy.sqrt(numpy.clip(20 ** 2 - s ** 2, 0, None))
+tifffile.imsave('gbp-projections.tif', numpy.tile(p, (128, 4, 1)).astype(numpy.float32))
+tifffile.imsave('gbp-projections-offset.tif', numpy.tile(p - 5, (128, 4, 1)).astype(numpy.float32))
+"
+
+for type in float half unorm16; do
+    ufo-launch -q read path=gbp-projections.tif ! \
+        general-backproject center-position-x=31.5 center-position-z=1.5 num-projections=128 \
+            projection-type=$type projection-scale=40 ! \
+        write filename=gbp-$type.tif || exit 1
+
+    ufo-launch -q read path=gbp-projections-offset.tif ! \
+        general-backproject center-position-x=31.5 center-position-z=1.5 num-projections=128 \
+            projection-type=$type projection-scale=60 projection-offset=-10 ! \
+        write filename=gbp-offset-$type.tif || exit 1
+done
+
+python -c "
+import sys, numpy, tifffile
+for prefix, tolerance in (('gbp-', 1e-3), ('gbp-offset-', 2e-3)):
+    ref = tifffile.imread(prefix + 'float.tif')
+    for name in ('half', 'unorm16'):
+        error = numpy.abs(tifffile.imread(prefix + name + '.tif') - ref).max() / numpy.abs(ref).max()
+        print('%s%s: max. relative error %g' % (prefix, name, error))
+        if error > tolerance:
+            sys.exit(1)
+"
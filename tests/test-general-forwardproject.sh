@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# Forward projection of a centered gaussian blob (sigma of 6 pixels) in
+# parallel beam against its analytic line integral sqrt(2 pi) sigma
+# exp(-s^2 / (2 sigma^2)). The detector is wider than the slice, so that rays
+# passing beside the volume must sum up to zero. The maximum deviation must
+# stay below 1 % of the peak.
+
+python -c "
+import numpy, tifffile
+y, x = numpy.mgrid[:64, :64] + 0.5 - 32
+tifffile.imsave('gfp-slice.tif', numpy.exp(-(x ** 2 + y ** 2) / (2 * 6.0 ** 2)).astype(numpy.float32))
+"
+
+ufo-launch -q read path=gfp-slice.tif ! \
+    general-forwardproject num-projections=90 detector-width=96 center-position-x=48 ! \
+    write filename=gfp-sinogram.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+sinogram = tifffile.imread('gfp-sinogram.tif')
+s = numpy.arange(96) + 0.5 - 48
+ref = numpy.sqrt(2 * numpy.pi) * 6.0 * numpy.exp(-s ** 2 / (2 * 6.0 ** 2))
+error = numpy.abs(sinogram - ref).max() / ref.max()
+print('max. relative error %g' % error)
+if sinogram.shape != (90, 96) or error > 1e-2:
+    sys.exit(1)
+"
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Accuracy check of hierarchical-backproject against backproject. The sinogram
+# of an off-center disk is backprojected by both tasks and the maximum
+# deviation must stay below 2 % of the maximum of the direct backprojection.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(64) + 0.5 - 32
+t = numpy.arange(96) * numpy.pi / 96
+c = 8 * numpy.cos(t)[:, numpy.newaxis]
+p = 2 * numpy.sqrt(numpy.clip(16 ** 2 - (s - c) ** 2, 0, None))
+tifffile.imsave('hbp-sinogram.tif', p.astype(numpy.float32))
+"
+
+ufo-launch -q read path=hbp-sinogram.tif ! backproject axis-pos=32 ! write filename=hbp-direct.tif || exit 1
+ufo-launch -q read path=hbp-sinogram.tif ! hierarchical-backproject axis-pos=32 ! write filename=hbp-hierarchical.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+ref = tifffile.imread('hbp-direct.tif')
+error = numpy.abs(tifffile.imread('hbp-hierarchical.tif') - ref).max() / numpy.abs(ref).max()
+print('max. relative error %g' % error)
+if error > 2e-2:
+    sys.exit(1)
+"
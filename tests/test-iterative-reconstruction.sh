@@ -0,0 +1,38 @@
+#!/bin/bash
+
+# Iterative reconstruction of a disk phantom of value 1 and radius 16 from its
+# analytic parallel beam sinogram. For every method, the mean of the disk
+# interior must be within 5 % of 1 and the background around the disk within
+# 0.05 of 0.
+
+python -c "
+import numpy, tifffile
+s = numpy.arange(64) + 0.5 - 32
+p = 2 * numpy.sqrt(numpy.clip(16 ** 2 - s ** 2, 0, None))
+tifffile.imsave('ir-sinogram.tif', numpy.tile(p, (90, 1)).astype(numpy.float32))
+"
+
+ufo-launch -q read path=ir-sinogram.tif ! \
+    iterative-reconstruction method=sirt num-iterations=20 num-subsets=10 axis-pos=32 ! \
+    write filename=ir-sirt.tif || exit 1
+
+ufo-launch -q read path=ir-sinogram.tif ! \
+    iterative-reconstruction method=sart num-iterations=5 axis-pos=32 ! \
+    write filename=ir-sart.tif || exit 1
+
+ufo-launch -q read path=ir-sinogram.tif ! \
+    iterative-reconstruction method=cgls num-iterations=20 axis-pos=32 ! \
+    write filename=ir-cgls.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+y, x = numpy.mgrid[:64, :64] + 0.5 - 32
+r = numpy.sqrt(x ** 2 + y ** 2)
+for method in ('sirt', 'sart', 'cgls'):
+    slice = tifffile.imread('ir-%s.tif' % method)
+    inside = slice[r < 12].mean()
+    outside = numpy.abs(slice[(r > 20) & (r < 28)]).mean()
+    print('%s: interior %g, background %g' % (method, inside, outside))
+    if slice.shape != (64, 64) or abs(inside - 1) > 0.05 or outside > 0.05:
+        sys.exit(1)
+"
@@ -0,0 +1,87 @@
+#!/bin/bash
+
+# Frames of 64 x 32 16 bit pixels are sent over UDP in four packets each and
+# over TCP in one piece, frame i holds the pixel indices plus i. Over UDP, frame
+# 5 is announced as a single packet which covers only a part of the frame. It
+# must be dropped instead of being emitted with stale data of an earlier frame
+# in the reused buffer. A TCP receiver without a sender must give up after its
+# timeout.
+
+PORT=25556
+
+# Wait until the receiver listens without taking the port ourselves
+wait_for_port () {
+    python -c "
+import sys, time
+for i in range(200):
+    for name in ('/proc/net/$1', '/proc/net/${1}6'):
+        try:
+            lines = open(name).readlines()[1:]
+        except IOError:
+            continue
+        for line in lines:
+            fields = line.split()
+            if fields[1].endswith(':%04X' % $PORT) and ('$1' == 'udp' or fields[3] == '0A'):
+                sys.exit(0)
+    time.sleep(0.05)
+sys.exit(1)
+"
+}
+
+ufo-launch -q net-recv protocol=udp port=$PORT width=64 height=32 bitdepth=16 number=10 ! \
+    write filename=net-recv-udp.tif &
+PID=$!
+
+wait_for_port udp || { kill $PID; exit 1; }
+
+python -c "
+import socket, struct, numpy
+sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+n_packets = 4
+for i in range(11):
+    frame = (numpy.arange(64 * 32) + i).astype(numpy.uint16).tobytes()
+    if i == 5:
+        header = struct.pack('<6I', 0x4e4f4655, i, 0, 1, 0, 256)
+        sock.sendto(header + frame[:256], ('127.0.0.1', $PORT))
+        continue
+    size = len(frame) // n_packets
+    for p in range(n_packets):
+        header = struct.pack('<6I', 0x4e4f4655, i, p, n_packets, p * size, size)
+        sock.sendto(header + frame[p * size:(p + 1) * size], ('127.0.0.1', $PORT))
+"
+
+wait $PID || exit 1
+
+ufo-launch -q net-recv protocol=tcp port=$PORT width=64 height=32 bitdepth=16 ! \
+    write filename=net-recv-tcp.tif &
+PID=$!
+
+wait_for_port tcp || { kill $PID; exit 1; }
+
+python -c "
+import socket, struct, numpy
+sock = socket.create_connection(('127.0.0.1', $PORT))
+for i in range(10):
+    frame = (numpy.arange(64 * 32) + i).astype(numpy.uint16).tobytes()
+    sock.sendall(struct.pack('<6I', 0x4e4f4655, i, 0, 1, 0, len(frame)) + frame)
+sock.close()
+"
+
+wait $PID || exit 1
+
+timeout 30 ufo-launch -q net-recv protocol=tcp port=$PORT width=64 height=32 timeout=1 ! null
+STATUS=$?
+
+if [ $STATUS -eq 0 ] || [ $STATUS -eq 124 ]; then
+    exit 1
+fi
+
+python -c "
+import sys, numpy, tifffile
+ref = numpy.arange(64 * 32).reshape(32, 64)
+udp = tifffile.imread('net-recv-udp.tif')
+tcp = tifffile.imread('net-recv-tcp.tif')
+udp_ok = udp.shape == (10, 32, 64) and all((udp[j] == ref + i).all() for j, i in enumerate([0, 1, 2, 3, 4, 6, 7, 8, 9, 10]))
+tcp_ok = tcp.shape == (10, 32, 64) and all((tcp[i] == ref + i).all() for i in range(10))
+sys.exit(int(not (udp_ok and tcp_ok)))
+"
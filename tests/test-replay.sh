@@ -0,0 +1,31 @@
+#!/bin/bash
+
+# Replaying a recorded stack twice at a fixed rate must emit every frame of
+# both loops unchanged and not faster than requested
+python -c "
+import numpy, tifffile
+numpy.random.seed(0)
+tifffile.imwrite('replay-stack.tif', numpy.random.random((5, 32, 48)).astype(numpy.float32))
+frames = numpy.arange(4 * 32 * 48, dtype=numpy.uint16).reshape(4, 32, 48)
+with open('replay-raw.bin', 'wb') as f:
+    f.write(b'\x00' * 16)
+    f.write(frames.tobytes())
+"
+
+START=$(date +%s.%N)
+ufo-launch -q replay path=replay-stack.tif loops=2 fps=20 ! write filename=replay-check.tif || exit 1
+END=$(date +%s.%N)
+
+ufo-launch -q replay path=replay-raw.bin raw-width=48 raw-height=32 raw-bitdepth=16 raw-offset=16 number=3 ! write filename=replay-raw-check.tif || exit 1
+
+python -c "
+import sys, numpy, tifffile
+stack = tifffile.imread('replay-stack.tif')
+a = tifffile.imread('replay-check.tif')
+b = tifffile.imread('replay-raw-check.tif')
+raw = numpy.arange(3 * 32 * 48, dtype=numpy.float32).reshape(3, 32, 48)
+ok = a.shape == (10, 32, 48) and numpy.array_equal(a, numpy.concatenate((stack, stack)))
+ok = ok and b.shape == (3, 32, 48) and numpy.array_equal(b, raw)
+ok = ok and $END - $START >= 9 / 20.0
+sys.exit(int(not ok))
+"
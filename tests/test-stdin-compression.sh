@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# Compressed input of the stdin generator. Six frames are compressed one by
+# one with the zstd and lz4 command line tools and prefixed with their length,
+# the third frame is corrupted. All other frames must come out unchanged, also
+# those decompressed later with the context that failed. A length header far
+# beyond the compressed size bound of a frame ends the stream after the frames
+# before it. Without headers, the concatenated compressed frames are decoded as
+# one stream.
+
+python -c "
+import numpy
+frames = numpy.random.RandomState(7).rand(6, 16, 32).astype(numpy.float32)
+frames.tofile('stdin-frames.raw')
+for i, frame in enumerate(frames):
+    frame.tofile('stdin-frame-%d.raw' % i)
+"
+
+for codec in zstd lz4; do
+    if ! command -v $codec > /dev/null; then
+        echo "$codec not found, skipping"
+        continue
+    fi
+
+    for i in 0 1 2 3 4 5; do
+        $codec -q -c stdin-frame-$i.raw > stdin-frame-$i.$codec || exit 1
+    done
+
+    python -c "
+import struct
+with open('stdin-$codec-header.bin', 'wb') as f:
+    for i in range(6):
+        data = bytearray(open('stdin-frame-%d.$codec' % i, 'rb').read())
+        if i == 2:
+            data[len(data) // 2:] = b'\xff' * (len(data) - len(data) // 2)
+        f.write(struct.pack('<I', len(data)) + data)
+with open('stdin-$codec-bogus.bin', 'wb') as f:
+    for i in range(4):
+        data = open('stdin-frame-%d.$codec' % i, 'rb').read()
+        f.write(struct.pack('<I', len(data)) + data)
+    f.write(struct.pack('<I', 0xfffffff0) + b'\x00' * 64)
+"
+
+    ufo-launch -q stdin width=32 height=16 bitdepth=32 compression=$codec frame-header=true number-threads=2 ! \
+        write filename=stdin-$codec-header.tif < stdin-$codec-header.bin || exit 1
+
+    ufo-launch -q stdin width=32 height=16 bitdepth=32 compression=$codec frame-header=true number-threads=2 ! \
+        write filename=stdin-$codec-bogus.tif < stdin-$codec-bogus.bin || exit 1
+
+    $codec -q -c stdin-frames.raw | \
+        ufo-launch -q stdin width=32 height=16 bitdepth=32 compression=$codec ! \
+        write filename=stdin-$codec-stream.tif || exit 1
+
+    python -c "
+import sys, numpy, tifffile
+frames = numpy.fromfile('stdin-frames.raw', dtype=numpy.float32).reshape(6, 16, 32)
+header = tifffile.imread('stdin-$codec-header.tif')
+stream = tifffile.imread('stdin-$codec-stream.tif')
+bogus = tifffile.imread('stdin-$codec-bogus.tif')
+print('$codec: %d frames with header, %d frames as stream' % (len(header), len(stream)))
+if header.shape != (5, 16, 32) or (header != frames[[0, 1, 3, 4, 5]]).any():
+    sys.exit(1)
+if stream.shape != (6, 16, 32) or (stream != frames).any():
+    sys.exit(1)
+if bogus.shape != (4, 16, 32) or (bogus != frames[:4]).any():
+    sys.exit(1)
+" || exit 1
+done